@@ -0,0 +1,127 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file assembler.h
+ * @brief Token assembler.
+ */
+
+#ifndef NESLA_ASSEMBLER_H_
+#define NESLA_ASSEMBLER_H_
+
+#include <expression.h>
+#include <lexer.h>
+#include <listing.h>
+#include <page.h>
+#include <stack.h>
+#include <timing.h>
+
+/*!
+ * @struct nesla_assembler_t
+ * @brief Assembler context.
+ */
+typedef struct {
+    nesla_context_t *context;   /*!< Assembler context handle */
+    nesla_lexer_t *lexer;       /*!< Current lexer context */
+    nesla_list_t source;        /*!< Source lexer list */
+    nesla_image_t image;        /*!< Image context */
+    nesla_encoder_t encoder;    /*!< Encoder context */
+    nesla_list_t path;          /*!< Resolved path list */
+    nesla_resolve resolve;      /*!< Include resolver, or NULL to resolve includes from disk */
+    void *user;                 /*!< Include resolver caller context */
+    size_t depth;               /*!< Include depth */
+    size_t bank;                /*!< Current bank */
+    uint16_t origin;            /*!< Current origin address */
+} nesla_assembler_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Initialize assembler context, assembling the file at path.
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in,out] context Pointer to assembler context handle
+ * @param[in] path Constant pointer to file path
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_assembler_initialize(nesla_assembler_t *assembler, nesla_context_t *context, const char *path);
+
+/*!
+ * @brief Initialize assembler context, assembling a source buffer.
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in,out] context Pointer to assembler context handle
+ * @param[in] source Constant pointer to source buffer context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_assembler_initialize_buffer(nesla_assembler_t *assembler, nesla_context_t *context, const nesla_source_t *source);
+
+/*!
+ * @brief Get assembler context image size.
+ * @param[in] assembler Constant pointer to assembler context
+ * @return Image size in bytes
+ */
+size_t nesla_assembler_get_size(const nesla_assembler_t *assembler);
+
+/*!
+ * @brief Uninitialize assembler context.
+ * @param[in,out] assembler Pointer to assembler context
+ */
+void nesla_assembler_uninitialize(nesla_assembler_t *assembler);
+
+/*!
+ * @brief Write assembler context image to file.
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in] path Constant pointer to file path
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_assembler_write(nesla_assembler_t *assembler, const char *path);
+
+/*!
+ * @brief Write assembler context listing to file.
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in] path Constant pointer to file path
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_assembler_write_listing(nesla_assembler_t *assembler, const char *path);
+
+/*!
+ * @brief Write assembler context tile map to file, once tiles are merged (see nesla_image_merge_tiles).
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in] path Constant pointer to file path
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_assembler_write_map(nesla_assembler_t *assembler, const char *path);
+
+/*!
+ * @brief Write assembler context image to a caller owned buffer.
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in,out] data Pointer to buffer data
+ * @param[in] capacity Buffer capacity in bytes
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_assembler_write_buffer(nesla_assembler_t *assembler, uint8_t *data, size_t capacity);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* NESLA_ASSEMBLER_H_ */
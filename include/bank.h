@@ -0,0 +1,58 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*!
+ * @file bank.h
+ * @brief Program bank placement.
+ */
+
+#ifndef NESLA_BANK_H_
+#define NESLA_BANK_H_
+
+#include <encoder.h>
+
+#define BANK_FIXED 0xC000               /*!< Address of the last program bank, fixed in place by most mappers */
+#define BANK_LENGTH 0x4000              /*!< Program bank length in bytes */
+#define BANK_SWITCHED 0x8000            /*!< Address of the other program banks, switched in place */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Place encoder context relocatable sections (.RELOC) in program banks, once their lengths are known and before layout.
+ *        Sections placed with a label are kept in the bank of that label, and sections given a bank in that bank. Each
+ *        group of sections is then placed, pinned groups first and then the longest, in the bank with room that leaves the
+ *        fewest calls (JSR/JMP) crossing into a switched bank, and the least room unused. A call into the last (fixed) bank
+ *        never crosses. Sections are placed in the last bank at BANK_FIXED, and in the others at BANK_SWITCHED, each at its
+ *        alignment, or within a page (.ALIGN), leaving the bytes skipped free for the sections placed after it. The calls
+ *        crossing, and those avoided over placing each section in the first bank with room, are reported as a note.
+ * @param[in,out] encoder Pointer to encoder context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_bank_place(nesla_encoder_t *encoder);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* NESLA_BANK_H_ */
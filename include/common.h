@@ -27,9 +27,13 @@
 #ifndef NESLA_COMMON_H_
 #define NESLA_COMMON_H_
 
+#include <define.h>
 #include <nesla.h>
+#include <binary.h>
+#include <context.h>
 #include <list.h>
 #include <reader.h>
+#include <table.h>
 #include <token.h>
 #include <writer.h>
 
@@ -0,0 +1,118 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file binary.h
+ * @brief Common binary file.
+ */
+
+#ifndef NESLA_BINARY_H_
+#define NESLA_BINARY_H_
+
+#include <error.h>
+
+/*!
+ * @struct nesla_binary_t
+ * @brief Binary context.
+ */
+typedef struct {
+    int descriptor;         /*!< File descriptor owned by the assembler context, or -1 for a caller owned buffer */
+    const uint8_t *data;    /*!< Binary data */
+    size_t offset;          /*!< Binary offset into file in bytes */
+    size_t length;          /*!< Binary length in bytes */
+    const char *path;       /*!< File path */
+} nesla_binary_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Close binary context.
+ * @param[in,out] binary Pointer to binary context
+ */
+void nesla_binary_close(nesla_binary_t *binary);
+
+/*!
+ * @brief Get binary context data.
+ * @param[in] binary Constant pointer to binary context
+ * @return Constant pointer to binary data
+ */
+const uint8_t *nesla_binary_get(const nesla_binary_t *binary);
+
+/*!
+ * @brief Get binary context file descriptor.
+ * @param[in] binary Constant pointer to binary context
+ * @return File descriptor, or -1 for a caller owned buffer
+ */
+int nesla_binary_get_descriptor(const nesla_binary_t *binary);
+
+/*!
+ * @brief Get binary context length.
+ * @param[in] binary Constant pointer to binary context
+ * @return Binary length in bytes
+ */
+size_t nesla_binary_get_length(const nesla_binary_t *binary);
+
+/*!
+ * @brief Get binary context offset into file.
+ * @param[in] binary Constant pointer to binary context
+ * @return Binary offset in bytes
+ */
+size_t nesla_binary_get_offset(const nesla_binary_t *binary);
+
+/*!
+ * @brief Get binary context file path.
+ * @param[in] binary Constant pointer to binary context
+ * @return File path
+ */
+const char *nesla_binary_get_path(const nesla_binary_t *binary);
+
+/*!
+ * @brief Open binary context with a path, viewing a slice of the file mapped by the assembler context.
+ * @param[in,out] binary Pointer to binary context
+ * @param[in,out] context Pointer to assembler context
+ * @param[in] path Constant pointer to file path
+ * @param[in] offset Slice offset into file in bytes
+ * @param[in] length Slice length in bytes, or 0 to map until end of file
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_binary_open(nesla_binary_t *binary, nesla_context_t *context, const char *path, size_t offset, size_t length);
+
+/*!
+ * @brief Open binary context with a slice of a caller owned buffer.
+ * @param[in,out] binary Pointer to binary context
+ * @param[in,out] context Pointer to assembler context
+ * @param[in] path Constant pointer to buffer name, used as the file path
+ * @param[in] data Constant pointer to buffer data
+ * @param[in] length Buffer length in bytes
+ * @param[in] offset Slice offset into buffer in bytes
+ * @param[in] slice Slice length in bytes, or 0 to use until end of buffer
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_binary_open_buffer(nesla_binary_t *binary, nesla_context_t *context, const char *path, const uint8_t *data,
+    size_t length, size_t offset, size_t slice);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* NESLA_BINARY_H_ */
@@ -0,0 +1,130 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file context.h
+ * @brief Common assembler context.
+ */
+
+#ifndef NESLA_CONTEXT_H_
+#define NESLA_CONTEXT_H_
+
+#include <list.h>
+
+#define CONTEXT_DIAGNOSTIC_MAX 64   /*!< Maximum number of diagnostics kept */
+#define CONTEXT_NOTE_MAX 32         /*!< Maximum number of notes and warnings kept, leaving the rest for errors */
+
+/*!
+ * @struct nesla_context_s
+ * @brief Assembler context, owning the error, allocator and file mapping cache of a run.
+ */
+struct nesla_context_s {
+    nesla_allocator_t allocator;    /*!< Allocator context */
+    nesla_list_t map;               /*!< Mapped file cache */
+    char error[256];                /*!< Error string */
+    nesla_diagnostic_t diagnostic[CONTEXT_DIAGNOSTIC_MAX]; /*!< Diagnostics kept */
+    size_t stored;                  /*!< Number of diagnostics kept */
+    size_t noted;                   /*!< Number of notes and warnings kept */
+    size_t count[NESLA_DIAGNOSTIC_MAX]; /*!< Number of diagnostics reported, per level */
+    nesla_statistics_t statistics;  /*!< Assembly statistics */
+    uint32_t flags;                 /*!< Assembly flags */
+    const char *cache;              /*!< Compression cache directory, or NULL */
+    uint8_t *tile;                  /*!< Tile map of the last assembly, or NULL */
+    size_t tile_length;             /*!< Tile map length in bytes */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Allocate zeroed memory with assembler context allocator.
+ * @param[in,out] context Pointer to assembler context
+ * @param[in] length Memory length in bytes
+ * @return Pointer to memory, or NULL
+ */
+void *nesla_context_allocate(nesla_context_t *context, size_t length);
+
+/*!
+ * @brief Clear assembler context error and diagnostics, before a run.
+ * @param[in,out] context Pointer to assembler context
+ */
+void nesla_context_clear(nesla_context_t *context);
+
+/*!
+ * @brief Duplicate string with assembler context allocator.
+ * @param[in,out] context Pointer to assembler context
+ * @param[in] string Constant pointer to string
+ * @return Pointer to string, or NULL
+ */
+char *nesla_context_duplicate(nesla_context_t *context, const char *string);
+
+/*!
+ * @brief Free memory with assembler context allocator.
+ * @param[in,out] context Pointer to assembler context
+ * @param[in,out] data Pointer to memory, or NULL
+ */
+void nesla_context_free(nesla_context_t *context, void *data);
+
+/*!
+ * @brief Check if assembler context diagnostic storage is full. Notes and warnings only fill part of it, so it is only
+ *        full once errors fill the rest.
+ * @param[in] context Constant pointer to assembler context
+ * @return true if full, false otherwise
+ */
+bool nesla_context_is_full(const nesla_context_t *context);
+
+/*!
+ * @brief Map file into memory, reusing an earlier mapping of the same file.
+ * @param[in,out] context Pointer to assembler context
+ * @param[in] path Constant pointer to file path
+ * @param[in,out] data Pointer to mapped data, or NULL for an empty file
+ * @param[in,out] length Pointer to mapped length in bytes
+ * @param[in,out] descriptor Pointer to file descriptor, owned by the assembler context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_context_map(nesla_context_t *context, const char *path, const uint8_t **data, size_t *length, int *descriptor);
+
+/*!
+ * @brief Grow array with assembler context allocator, so it holds at least one more entry.
+ * @param[in,out] context Pointer to assembler context
+ * @param[in,out] data Pointer to array, or NULL
+ * @param[in,out] capacity Pointer to array capacity in entries
+ * @param[in] count Array entry count
+ * @param[in] size Array entry size in bytes
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_context_reserve(nesla_context_t *context, void **data, size_t *capacity, size_t count, size_t size);
+
+/*!
+ * @brief Reallocate memory with assembler context allocator.
+ * @param[in,out] context Pointer to assembler context
+ * @param[in,out] data Pointer to memory, or NULL
+ * @param[in] length Memory length in bytes
+ * @return Pointer to memory, or NULL
+ */
+void *nesla_context_reallocate(nesla_context_t *context, void *data, size_t length);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* NESLA_CONTEXT_H_ */
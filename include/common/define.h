@@ -27,15 +27,24 @@
 #ifndef NESLA_DEFINE_H_
 #define NESLA_DEFINE_H_
 
-#define _POSIX_SOURCE
+#define _GNU_SOURCE
 
 #include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <libgen.h>
+#include <math.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <threads.h>
 #include <unistd.h>
 
 #endif /* NESLA_DEFINE_H_ */
@@ -30,26 +30,85 @@
 #include <define.h>
 
 /*!
- * @brief Set global error macro.
+ * @brief Set context error macro.
+ * @param[in] _CONTEXT_ Pointer to assembler context
  * @param[in] _FORMAT_ Error string format, followed by some number of arguments
  * @return NESLA_FAILURE
  */
-#define SET_ERROR(_FORMAT_, ...) \
-    nesla_set_error(__FILE__, __FUNCTION__, __LINE__, _FORMAT_, __VA_ARGS__)
+#define SET_ERROR(_CONTEXT_, _FORMAT_, ...) \
+    nesla_set_error(_CONTEXT_, __FILE__, __FUNCTION__, __LINE__, _FORMAT_, __VA_ARGS__)
+
+/*!
+ * @brief Report positioned context error macro.
+ * @param[in] _CONTEXT_ Pointer to assembler context
+ * @param[in] _PATH_ Constant pointer to source path
+ * @param[in] _LINE_ Source line
+ * @param[in] _COLUMN_ Source column
+ * @param[in] ... Error string format, followed by some number of arguments
+ * @return NESLA_FAILURE
+ */
+#define SET_ERROR_AT(_CONTEXT_, _PATH_, _LINE_, _COLUMN_, ...) \
+    nesla_set_diagnostic(_CONTEXT_, __FILE__, __FUNCTION__, __LINE__, NESLA_DIAGNOSTIC_ERROR, \
+        _PATH_, _LINE_, _COLUMN_, __VA_ARGS__)
+
+/*!
+ * @brief Report positioned context note macro.
+ * @param[in] _CONTEXT_ Pointer to assembler context
+ * @param[in] _PATH_ Constant pointer to source path
+ * @param[in] _LINE_ Source line
+ * @param[in] _COLUMN_ Source column
+ * @param[in] ... Note string format, followed by some number of arguments
+ * @return NESLA_SUCCESS
+ */
+#define SET_NOTE_AT(_CONTEXT_, _PATH_, _LINE_, _COLUMN_, ...) \
+    nesla_set_diagnostic(_CONTEXT_, __FILE__, __FUNCTION__, __LINE__, NESLA_DIAGNOSTIC_NOTE, \
+        _PATH_, _LINE_, _COLUMN_, __VA_ARGS__)
+
+/*!
+ * @brief Report positioned context warning macro.
+ * @param[in] _CONTEXT_ Pointer to assembler context
+ * @param[in] _PATH_ Constant pointer to source path
+ * @param[in] _LINE_ Source line
+ * @param[in] _COLUMN_ Source column
+ * @param[in] ... Warning string format, followed by some number of arguments
+ * @return NESLA_SUCCESS
+ */
+#define SET_WARNING_AT(_CONTEXT_, _PATH_, _LINE_, _COLUMN_, ...) \
+    nesla_set_diagnostic(_CONTEXT_, __FILE__, __FUNCTION__, __LINE__, NESLA_DIAGNOSTIC_WARNING, \
+        _PATH_, _LINE_, _COLUMN_, __VA_ARGS__)
 
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
 
 /*!
- * @brief Set global error.
+ * @brief Set context error.
+ * @param[in,out] context Pointer to assembler context
  * @param[in] file Constant pointer to file string
  * @param[in] function Constant pointer to function string
  * @param[in] line File line
  * @param[in] format Error string format, followed by some number of arguments
  * @return NESLA_FAILURE
  */
-nesla_error_e nesla_set_error(const char *file, const char *function, int line, const char *format, ...);
+nesla_error_e nesla_set_error(nesla_context_t *context, const char *file, const char *function, int line, const char *format, ...);
+
+/*!
+ * @brief Report positioned context diagnostic. Diagnostics are kept in fixed storage, so reporting never allocates;
+ *        once the storage is full, diagnostics are counted but not kept. Notes and warnings are kept in part of the storage
+ *        only, so they never push out errors. Errors also set the context error.
+ * @param[in,out] context Pointer to assembler context
+ * @param[in] file Constant pointer to file string
+ * @param[in] function Constant pointer to function string
+ * @param[in] line File line
+ * @param[in] level Diagnostic level
+ * @param[in] path Constant pointer to source path
+ * @param[in] source_line Source line
+ * @param[in] source_column Source column
+ * @param[in] format Diagnostic string format, followed by some number of arguments
+ * @return NESLA_FAILURE for errors, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_set_diagnostic(nesla_context_t *context, const char *file, const char *function, int line, nesla_diagnostic_e level,
+    const char *path, size_t source_line, size_t source_column, const char *format, ...);
 
 #ifdef __cplusplus
 }
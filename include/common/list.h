@@ -56,11 +56,12 @@ extern "C" {
 /*!
  * @brief Get list entry context at index.
  * @param[in] list Pointer to list context
+ * @param[in,out] context Pointer to assembler context
  * @param[in] index Entry index
  * @param[in,out] entry Pointer to list entry context, or NULL
  * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
  */
-nesla_error_e nesla_list_get(const nesla_list_t *list, size_t index, nesla_list_entry_t **entry);
+nesla_error_e nesla_list_get(const nesla_list_t *list, nesla_context_t *context, size_t index, nesla_list_entry_t **entry);
 
 /*!
  * @brief Get list entry context at head.
@@ -86,18 +87,20 @@ nesla_list_entry_t *nesla_list_get_tail(const nesla_list_t *list);
 /*!
  * @brief Insert context into list context after list entry context.
  * @param[in,out] list Pointer to list context
+ * @param[in,out] context Pointer to assembler context
  * @param[in,out] entry Pointer to list entry context to insert after, or NULL
- * @param[in] context Pointer to context
+ * @param[in] data Pointer to entry context
  * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
  */
-nesla_error_e nesla_list_insert(nesla_list_t *list, nesla_list_entry_t *entry, void *context);
+nesla_error_e nesla_list_insert(nesla_list_t *list, nesla_context_t *context, nesla_list_entry_t *entry, void *data);
 
 /*!
  * @brief Remove list entry context from list context.
  * @param[in,out] list Pointer to list context
+ * @param[in,out] context Pointer to assembler context
  * @param[in,out] entry Pointer to list entry context
  */
-void nesla_list_remove(nesla_list_t *list, nesla_list_entry_t *entry);
+void nesla_list_remove(nesla_list_t *list, nesla_context_t *context, nesla_list_entry_t *entry);
 
 #ifdef __cplusplus
 }
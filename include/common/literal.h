@@ -46,16 +46,18 @@ export "C" {
 /*!
  * @brief Append character to literal context.
  * @param[in,out] literal Pointer to literal context
+ * @param[in,out] context Pointer to assembler context
  * @param[in] value Character to append
  * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
  */
-nesla_error_e nesla_literal_append(nesla_literal_t *literal, uint8_t value);
+nesla_error_e nesla_literal_append(nesla_literal_t *literal, nesla_context_t *context, uint8_t value);
 
 /*!
  * @brief Free literal context.
  * @param[in,out] literal Pointer to literal context
+ * @param[in,out] context Pointer to assembler context
  */
-void nesla_literal_free(nesla_literal_t *literal);
+void nesla_literal_free(nesla_literal_t *literal, nesla_context_t *context);
 
 /*!
  * @brief Get literal context character string.
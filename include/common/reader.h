@@ -27,16 +27,23 @@
 #ifndef NESLA_READER_H_
 #define NESLA_READER_H_
 
-#include <error.h>
+#include <list.h>
 
 /*!
  * @struct nesla_reader_t
  * @brief Reader context.
  */
 typedef struct {
-    FILE *base;         /*!< File handle base */
-    FILE *offset;       /*!< File handle offset */
-    const char *path;   /*!< File path */
+    nesla_context_t *context;   /*!< Assembler context */
+    int descriptor;             /*!< File descriptor, or -1 when closed or reading a caller owned buffer */
+    const char *path;           /*!< File path */
+    const uint8_t *data;        /*!< Current data (caller owned buffer, or current chunk) */
+    size_t length;              /*!< Current data length in bytes */
+    size_t index;               /*!< Current data index */
+    nesla_list_t chunk;         /*!< Chunk list, retained so the reader can be reset without seeking */
+    nesla_list_entry_t *entry;  /*!< Current chunk entry */
+    bool end;                   /*!< File end reached */
+    bool failed;                /*!< File read failed */
 } nesla_reader_t;
 
 #ifdef __cplusplus
@@ -54,12 +61,12 @@ void nesla_reader_close(nesla_reader_t *reader);
  * @param[in,out] reader Pointer to reader context
  * @param[in,out] data String from reader context
  * @param[in] length String length in bytes
- * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ * @return NESLA_ERROR at end of file or on failure, NESLA_SUCCESS otherwise
  */
 nesla_error_e nesla_reader_get(nesla_reader_t *reader, uint8_t *data, size_t length);
 
 /*!
- * @brief Get reader context file length.
+ * @brief Get reader context file length. Fails for pipes, whose length is unknown until read.
  * @param[in,out] reader Pointer to reader context
  * @param[in,out] length File length in bytes
  * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
@@ -74,12 +81,32 @@ nesla_error_e nesla_reader_get_length(nesla_reader_t *reader, size_t *length);
 const char *nesla_reader_get_path(const nesla_reader_t *reader);
 
 /*!
- * @brief Open reader context with a path.
+ * @brief Determine if reader context failed to read its file, rather than reaching its end.
+ * @param[in] reader Constant pointer to reader context
+ * @return true if a read failed, false otherwise
+ */
+bool nesla_reader_is_failed(const nesla_reader_t *reader);
+
+/*!
+ * @brief Open reader context with a path. Data is read in chunks as it arrives, so pipes are supported.
+ * @param[in,out] reader Pointer to reader context
+ * @param[in,out] context Pointer to assembler context
+ * @param[in] path Constant pointer to file path, or "-" for standard input
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_reader_open(nesla_reader_t *reader, nesla_context_t *context, const char *path);
+
+/*!
+ * @brief Open reader context with a caller owned buffer.
  * @param[in,out] reader Pointer to reader context
- * @param[in] path Constant pointer to file path
+ * @param[in,out] context Pointer to assembler context
+ * @param[in] path Constant pointer to buffer name, used as the file path
+ * @param[in] data Constant pointer to buffer data
+ * @param[in] length Buffer length in bytes
  * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
  */
-nesla_error_e nesla_reader_open(nesla_reader_t *reader, const char *path);
+nesla_error_e nesla_reader_open_buffer(nesla_reader_t *reader, nesla_context_t *context, const char *path, const uint8_t *data,
+    size_t length);
 
 /*!
  * @brief Reset reader context.
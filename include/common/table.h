@@ -0,0 +1,117 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file table.h
+ * @brief Common hash table.
+ */
+
+#ifndef NESLA_TABLE_H_
+#define NESLA_TABLE_H_
+
+#include <error.h>
+
+/*!
+ * @struct nesla_table_entry_t
+ * @brief Hash table entry context.
+ */
+typedef struct {
+    const char *name;           /*!< Entry name (not owned) */
+    uint32_t hash;              /*!< Entry name hash */
+    uint32_t scope;             /*!< Entry scope */
+    size_t value;               /*!< Entry value */
+    uint32_t distance;          /*!< Entry probe distance, plus one, or 0 if empty */
+} nesla_table_entry_t;
+
+/*!
+ * @struct nesla_table_t
+ * @brief Hash table context, an open-addressing table with Robin Hood probing.
+ */
+typedef struct {
+    nesla_table_entry_t *entry; /*!< Entry array */
+    size_t capacity;            /*!< Entry array capacity, a power of two */
+    size_t count;               /*!< Entry count */
+} nesla_table_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Find hash table entry.
+ * @param[in] table Constant pointer to table context
+ * @param[in] name Constant pointer to entry name
+ * @param[in] hash Entry name hash
+ * @param[in] scope Entry scope
+ * @return Pointer to entry context, or NULL if not found
+ */
+nesla_table_entry_t *nesla_table_find(const nesla_table_t *table, const char *name, uint32_t hash, uint32_t scope);
+
+/*!
+ * @brief Free hash table context.
+ * @param[in,out] table Pointer to table context
+ * @param[in,out] context Pointer to assembler context
+ */
+void nesla_table_free(nesla_table_t *table, nesla_context_t *context);
+
+/*!
+ * @brief Get hash table entry count.
+ * @param[in] table Constant pointer to table context
+ * @return Entry count
+ */
+size_t nesla_table_get_count(const nesla_table_t *table);
+
+/*!
+ * @brief Hash entry name (FNV-1a).
+ * @param[in] name Constant pointer to entry name
+ * @param[in] length Entry name length in bytes
+ * @return Entry name hash
+ */
+uint32_t nesla_table_hash(const char *name, size_t length);
+
+/*!
+ * @brief Insert hash table entry, which must not already be present. The table grows past a 3/4 load.
+ * @param[in,out] table Pointer to table context
+ * @param[in,out] context Pointer to assembler context
+ * @param[in] name Constant pointer to entry name, which must outlive the entry
+ * @param[in] hash Entry name hash
+ * @param[in] scope Entry scope
+ * @param[in] value Entry value
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_table_insert(nesla_table_t *table, nesla_context_t *context, const char *name, uint32_t hash, uint32_t scope,
+    size_t value);
+
+/*!
+ * @brief Remove hash table entry.
+ * @param[in,out] table Pointer to table context
+ * @param[in] name Constant pointer to entry name
+ * @param[in] hash Entry name hash
+ * @param[in] scope Entry scope
+ * @return true if the entry was removed, false if not found
+ */
+bool nesla_table_remove(nesla_table_t *table, const char *name, uint32_t hash, uint32_t scope);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* NESLA_TABLE_H_ */
@@ -34,17 +34,31 @@
  * @brief Token directive type.
  */
 typedef enum {
-    DIRECTIVE_BANK = 0,         /*!< Bank directive */
+    DIRECTIVE_ALIGN = 0,        /*!< Align directive */
+    DIRECTIVE_BANK,             /*!< Bank directive */
+    DIRECTIVE_BUDGET,           /*!< Cycle budget directive */
     DIRECTIVE_BYTE,             /*!< Byte directive */
     DIRECTIVE_CHARACTER,        /*!< Character directive */
     DIRECTIVE_DEFINE,           /*!< Define directive */
+    DIRECTIVE_FAR,              /*!< Far call directive */
+    DIRECTIVE_HOT,              /*!< Hot call directive */
     DIRECTIVE_INCLUDE,          /*!< Include directive */
     DIRECTIVE_INCLUDE_BINARY,   /*!< Include binary directive */
+    DIRECTIVE_JUMP,             /*!< Jump table directive */
+    DIRECTIVE_KEEP,             /*!< Keep label directive */
+    DIRECTIVE_LOOP,             /*!< Loop bound directive */
     DIRECTIVE_MAPPER,           /*!< Mapper directive */
     DIRECTIVE_MIRROR,           /*!< Mirror directive */
+    DIRECTIVE_NO_OPTIMIZE,      /*!< No optimize directive */
+    DIRECTIVE_OPTIMIZE,         /*!< Optimize directive */
     DIRECTIVE_ORIGIN,           /*!< Origin directive */
+    DIRECTIVE_PACK,             /*!< Packed data directive */
     DIRECTIVE_PROGRAM,          /*!< Program directive */
+    DIRECTIVE_RELOCATE,         /*!< Relocatable section directive */
     DIRECTIVE_RESERVE,          /*!< Reserve directive */
+    DIRECTIVE_STRUCTURE,        /*!< Structure of arrays directive */
+    DIRECTIVE_STACK,            /*!< Stack budget directive */
+    DIRECTIVE_TABLE,            /*!< Generated table directive */
     DIRECTIVE_UNDEFINE,         /*!< Undefine directive */
     DIRECTIVE_WORD,             /*!< Word directive */
     DIRECTIVE_MAX,              /*!< Max directive */
@@ -134,6 +148,8 @@ typedef enum {
     SYMBOL_IMMEDIATE,       /*!< Immediate symbol */
     SYMBOL_INDIRECT_CLOSE,  /*!< Close indirection symbol */
     SYMBOL_INDIRECT_OPEN,   /*!< Open indirection symbol */
+    SYMBOL_HIGH,            /*!< High byte symbol */
+    SYMBOL_LOW,             /*!< Low byte symbol */
     SYMBOL_MAX,             /*!< Max symbol */
 } nesla_symbol_e;
 
@@ -162,7 +178,9 @@ typedef struct {
     int subtype;                /*!< Token subtype */
     const char *path;           /*!< Token file path */
     size_t line;                /*!< Token file line */
+    size_t column;              /*!< Token file column */
     nesla_literal_t literal;    /*!< Token literal context */
+    uint32_t hash;              /*!< Token literal hash */
     uint16_t scalar;            /*!< Token scalar value */
 } nesla_token_t;
 
@@ -173,8 +191,23 @@ extern "C" {
 /*!
  * @brief Free token context.
  * @param[in,out] token Pointer to token context
+ * @param[in,out] context Pointer to assembler context
  */
-void nesla_token_free(nesla_token_t *token);
+void nesla_token_free(nesla_token_t *token, nesla_context_t *context);
+
+/*!
+ * @brief Get token context file column.
+ * @param[in] token Constant pointer to token context
+ * @return File column
+ */
+size_t nesla_token_get_column(const nesla_token_t *token);
+
+/*!
+ * @brief Get token context literal hash, computed once when the literal is set.
+ * @param[in] token Constant pointer to token context
+ * @return Literal hash
+ */
+uint32_t nesla_token_get_hash(const nesla_token_t *token);
 
 /*!
  * @brief Get token context file line.
@@ -225,16 +258,18 @@ nesla_token_e nesla_token_get_type(const nesla_token_t *token);
  * @param[in] subtype Token subtype
  * @param[in] path Constant pointer to token file path
  * @param[in] line Token file line
+ * @param[in] column Token file column
  */
-void nesla_token_set(nesla_token_t *token, nesla_token_e type, int subtype, const char *path, size_t line);
+void nesla_token_set(nesla_token_t *token, nesla_token_e type, int subtype, const char *path, size_t line, size_t column);
 
 /*!
  * @brief Set token context literal value.
  * @param[in,out] token Pointer to token context
+ * @param[in,out] context Pointer to assembler context
  * @param[in] literal Constant pointer to literal context
  * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
  */
-nesla_error_e nesla_token_set_literal(nesla_token_t *token, const nesla_literal_t *literal);
+nesla_error_e nesla_token_set_literal(nesla_token_t *token, nesla_context_t *context, const nesla_literal_t *literal);
 
 /*!
  * @brief Set token context scalar value.
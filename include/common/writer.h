@@ -27,16 +27,23 @@
 #ifndef NESLA_WRITER_H_
 #define NESLA_WRITER_H_
 
-#include <error.h>
+#include <binary.h>
 
 /*!
  * @struct nesla_writer_t
  * @brief Writer context.
  */
 typedef struct {
+    nesla_context_t *context;   /*!< Assembler context */
     FILE *base;         /*!< File handle base */
     FILE *offset;       /*!< File handle offset */
     const char *path;   /*!< File path */
+
+    struct {
+        uint8_t *data;          /*!< Buffer data, or NULL when writing a file */
+        size_t capacity;        /*!< Buffer capacity in bytes */
+        size_t length;          /*!< Buffer length in bytes */
+    } buffer;
 } nesla_writer_t;
 
 #ifdef __cplusplus
@@ -67,11 +74,24 @@ const char *nesla_writer_get_path(const nesla_writer_t *writer);
 /*!
  * @brief Open writer context with a path.
  * @param[in,out] writer Pointer to writer context
+ * @param[in,out] context Pointer to assembler context
  * @param[in] path Constant pointer to file path
  * @param[in] create Create file if none exists
  * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
  */
-nesla_error_e nesla_writer_open(nesla_writer_t *writer, const char *path, bool create);
+nesla_error_e nesla_writer_open(nesla_writer_t *writer, nesla_context_t *context, const char *path, bool create);
+
+/*!
+ * @brief Open writer context with a caller owned buffer.
+ * @param[in,out] writer Pointer to writer context
+ * @param[in,out] context Pointer to assembler context
+ * @param[in] path Constant pointer to buffer name, used as the file path
+ * @param[in,out] data Pointer to buffer data
+ * @param[in] capacity Buffer capacity in bytes
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_writer_open_buffer(nesla_writer_t *writer, nesla_context_t *context, const char *path, uint8_t *data,
+    size_t capacity);
 
 /*!
  * @brief Put string into writer context.
@@ -82,6 +102,14 @@ nesla_error_e nesla_writer_open(nesla_writer_t *writer, const char *path, bool c
  */
 nesla_error_e nesla_writer_put(nesla_writer_t *writer, const uint8_t *data, size_t length);
 
+/*!
+ * @brief Put binary context into writer context, copying file-to-file inside the kernel where possible.
+ * @param[in,out] writer Pointer to writer context
+ * @param[in] binary Constant pointer to binary context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_writer_put_binary(nesla_writer_t *writer, const nesla_binary_t *binary);
+
 /*!
  * @brief Reset writer context.
  * @param[in,out] writer Pointer to writer context
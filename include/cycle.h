@@ -0,0 +1,80 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*!
+ * @file cycle.h
+ * @brief Instruction cycle analysis.
+ */
+
+#ifndef NESLA_CYCLE_H_
+#define NESLA_CYCLE_H_
+
+#include <encoder.h>
+
+/*!
+ * @enum nesla_cross_e
+ * @brief Page crossing type.
+ */
+typedef enum {
+    CROSS_NONE = 0,                     /*!< Never crosses a page */
+    CROSS_MAY,                          /*!< Indexed access may cross a page, depending on the index */
+    CROSS_WILL,                         /*!< Branch crosses a page when taken */
+    CROSS_MAX,                          /*!< Max page crossing */
+} nesla_cross_e;
+
+/*!
+ * @struct nesla_cycle_t
+ * @brief Cycle context, the cycle counts of an encoded instruction.
+ */
+typedef struct {
+    uint8_t minimum;                    /*!< Cycles, without penalties (branches not taken) */
+    uint8_t maximum;                    /*!< Cycles, with every penalty that can apply */
+    uint8_t cross;                      /*!< Page crossing type */
+} nesla_cycle_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Get encoder statement cycles, once fixups are patched. Indexed reads whose base address is not page aligned may
+ *        pay a cycle to cross a page. Branches pay a cycle when taken, and another if the target is on another page.
+ *        Data statements take no cycles.
+ * @param[in] encoder Constant pointer to encoder context
+ * @param[in] index Statement index
+ * @param[in,out] cycle Pointer to cycle context
+ */
+void nesla_cycle_get(const nesla_encoder_t *encoder, size_t index, nesla_cycle_t *cycle);
+
+/*!
+ * @brief Check if an encoder statement ends a basic block, by transferring control (branches, jumps, returns and BRK).
+ * @param[in] encoder Constant pointer to encoder context
+ * @param[in] index Statement index
+ * @return true if the statement ends a basic block, false otherwise
+ */
+bool nesla_cycle_is_terminal(const nesla_encoder_t *encoder, size_t index);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* NESLA_CYCLE_H_ */
@@ -0,0 +1,56 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*!
+ * @file dead.h
+ * @brief Unreachable code and data removal.
+ */
+
+#ifndef NESLA_DEAD_H_
+#define NESLA_DEAD_H_
+
+#include <encoder.h>
+
+#define DEAD_VECTOR 0xFFFA              /*!< Address of the NMI, reset and IRQ vectors, always kept */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Remove encoder context code and data unreachable from the vectors, once all symbols are bound and before placement.
+ *        Statements are split into units at each global label, and at each origin. A unit is reachable if it holds the
+ *        vectors (from DEAD_VECTOR), has no global label of its own, holds a statement under .NOOPT, or starts at a label kept
+ *        (.KEEP), read by a constant (.DEF) or given a cycle budget (.BUDGET). A unit referenced by a reachable unit is
+ *        reachable, as is the unit a reachable unit runs into, unless it ends in a JMP, RTS or RTI, or holds only data.
+ *        Every other unit is removed, by giving its statements a length of zero, and its labels are recorded with the bytes
+ *        removed. The removal is reported as a note.
+ * @param[in,out] encoder Pointer to encoder context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_dead_remove(nesla_encoder_t *encoder);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* NESLA_DEAD_H_ */
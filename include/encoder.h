@@ -0,0 +1,784 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*!
+ * @file encoder.h
+ * @brief Instruction encoder.
+ */
+
+#ifndef NESLA_ENCODER_H_
+#define NESLA_ENCODER_H_
+
+#include <image.h>
+#include <opcode.h>
+
+#define ENCODER_ALIGN_MAX 0x4000       /*!< Maximum alignment in bytes, a program bank (.ALIGN) */
+#define ENCODER_CHANGE_MAX 2           /*!< Maximum addressing mode changes per statement, before it is kept absolute */
+#define ENCODER_RELOCATE_BANK 0x8000   /*!< First provisional bank index, one per relocatable section until it is placed */
+#define ENCODER_RELOCATE_ORIGIN 0x8000 /*!< Provisional origin of relocatable sections, until they are placed */
+#define ENCODER_JUMP_MAX 256           /*!< Maximum jump table entries, indexed by X (.JUMP) */
+#define ENCODER_PACK_THREAD_MAX 32     /*!< Maximum packed block worker threads, one per online processor up to the maximum */
+#define ENCODER_PASS_MAX 64            /*!< Maximum layout passes */
+#define ENCODER_SHADOW "FAR_BANK"       /*!< Bank shadow variable name, added by the first far call (.FAR) */
+#define ENCODER_STRUCTURE_MAX 256      /*!< Maximum structure entries, indexed by X or Y (.SOA) */
+#define ENCODER_UNRESOLVED UINT32_MAX   /*!< Unresolved symbol index */
+
+/*!
+ * @enum nesla_fixup_e
+ * @brief Fixup type.
+ */
+typedef enum {
+    FIXUP_BYTE = 0,                     /*!< Byte fixup */
+    FIXUP_RELATIVE,                     /*!< Relative branch fixup */
+    FIXUP_WORD,                         /*!< Word fixup */
+    FIXUP_JUMP,                         /*!< Expanded branch fixup, patching the jump that follows an inverted branch */
+    FIXUP_LOW,                          /*!< Low byte fixup */
+    FIXUP_HIGH,                         /*!< High byte fixup */
+    FIXUP_LOW_RETURN,                   /*!< Low byte fixup, of the address less one (pushed for RTS) */
+    FIXUP_HIGH_RETURN,                  /*!< High byte fixup, of the address less one (pushed for RTS) */
+    FIXUP_MAX,                          /*!< Max fixup */
+} nesla_fixup_e;
+
+/*!
+ * @enum nesla_jump_e
+ * @brief Jump table name, generated from the name of the table (.JUMP).
+ */
+typedef enum {
+    JUMP_LOW = 0,                       /*!< Low byte table label (<name>_LO) */
+    JUMP_HIGH,                          /*!< High byte table label (<name>_HI) */
+    JUMP_COUNT,                         /*!< Entry count constant (<name>_COUNT) */
+    JUMP_MAX,                           /*!< Max jump table name */
+} nesla_jump_e;
+
+/*!
+ * @enum nesla_unpack_e
+ * @brief Decompressor name, of the labels and variables added for packed blocks (.PACK). The decompressor labels come first,
+ *        one per compression mode, followed by the labels of their block address tables, added once blocks are linked.
+ */
+typedef enum {
+    UNPACK_RLE = 0,                     /*!< Run-length decompressor label (UNPACK_RLE) */
+    UNPACK_LZ,                          /*!< LZ decompressor label (UNPACK_LZ) */
+    UNPACK_RLE_TABLE,                   /*!< Run-length block address table label (UNPACK_RLE_TABLE), kept out of the symbol table */
+    UNPACK_LZ_TABLE,                    /*!< LZ block address table label (UNPACK_LZ_TABLE), kept out of the symbol table */
+    UNPACK_DESTINATION,                 /*!< Destination pointer variable (UNPACK_DST), set by the caller */
+    UNPACK_DESTINATION_HIGH,            /*!< Destination pointer high byte (UNPACK_DST_HI) */
+    UNPACK_SOURCE,                      /*!< Source pointer variable (UNPACK_SRC) */
+    UNPACK_SOURCE_HIGH,                 /*!< Source pointer high byte (UNPACK_SRC_HI) */
+    UNPACK_REFERENCE,                   /*!< Match pointer variable (UNPACK_REF), added for LZ */
+    UNPACK_REFERENCE_HIGH,              /*!< Match pointer high byte (UNPACK_REF_HI) */
+    UNPACK_MAX,                         /*!< Max decompressor name */
+} nesla_unpack_e;
+
+/*!
+ * @struct nesla_statement_t
+ * @brief Encoded statement context, an instruction or data item.
+ */
+typedef struct {
+    const nesla_token_t *token;         /*!< Statement token */
+    size_t offset;                      /*!< Encoded data offset in bytes */
+    uint32_t section;                   /*!< Section index */
+    uint16_t bank;                      /*!< Bank index */
+    uint16_t address;                   /*!< Address */
+    uint16_t length;                    /*!< Encoded data length in bytes */
+    uint8_t instruction;                /*!< Instruction type, or INSTRUCTION_MAX for data */
+    uint8_t mode;                       /*!< Addressing mode, or for data MODE_ABSOLUTE if listed as words (.WORD) */
+    bool preserve;                      /*!< Statement is left alone by the optimizer (.NOOPT) */
+    bool hot;                           /*!< Call is run often, and may be inlined (.HOT) */
+    bool far;                           /*!< Call may cross into another program bank, through a trampoline (.FAR) */
+    uint16_t bound;                     /*!< Times the branch may loop back, per loop entry (.LOOP), or 0 if unbounded */
+} nesla_statement_t;
+
+/*!
+ * @struct nesla_section_t
+ * @brief Section context, a run of statements placed contiguously from a fixed origin.
+ */
+typedef struct {
+    uint32_t first;                     /*!< First statement index */
+    uint32_t count;                     /*!< Statement count */
+    bool dirty;                         /*!< Statement lengths changed, since the last layout */
+    bool aligned;                       /*!< Section is aligned, or kept within a page (.ALIGN), and its page crossings reported */
+} nesla_section_t;
+
+/*!
+ * @struct nesla_fixup_t
+ * @brief Fixup context, recording a symbol reference to patch once layout is final.
+ */
+typedef struct {
+    const nesla_token_t *symbol;        /*!< Symbol token */
+    uint32_t statement;                 /*!< Statement index */
+    uint32_t scope;                     /*!< Symbol scope */
+    uint32_t index;                     /*!< Symbol index, or ENCODER_UNRESOLVED for forward references */
+    uint32_t chained;                   /*!< Symbol index of a branch before jump chain retargeting, or ENCODER_UNRESOLVED */
+    uint8_t saved;                      /*!< Cycles saved by jump chain retargeting */
+    uint8_t type;                       /*!< Fixup type */
+    bool forward;                       /*!< Reference preceded its symbol definition */
+} nesla_fixup_t;
+
+/*!
+ * @struct nesla_layout_t
+ * @brief Layout context, the worklist of fixups to evaluate in the next relaxation pass.
+ */
+typedef struct {
+    uint8_t *change;                    /*!< Addressing mode change count, per statement */
+    uint8_t *queued;                    /*!< Fixup is in the worklist, per fixup */
+    uint32_t *work;                     /*!< Worklist of fixup indices */
+    size_t work_count;                  /*!< Worklist count */
+    uint32_t *reference;                /*!< Fixup indices, grouped by symbol */
+    uint32_t *first;                    /*!< First reference index, per symbol (and one past the last) */
+} nesla_layout_t;
+
+/*!
+ * @struct nesla_budget_t
+ * @brief Cycle budget context, the most cycles a handler may take (.BUDGET).
+ */
+typedef struct {
+    const nesla_token_t *token;         /*!< Directive token */
+    const nesla_token_t *symbol;        /*!< Handler label token, or NULL for the handler the NMI vector points to */
+    uint32_t scope;                     /*!< Handler label scope */
+    uint32_t cycles;                    /*!< Cycle budget */
+} nesla_budget_t;
+
+/*!
+ * @struct nesla_inlined_t
+ * @brief Inlined call context, a call replaced by a copy of the subroutine it calls.
+ */
+typedef struct {
+    const nesla_token_t *token;         /*!< Call token */
+    uint32_t symbol;                    /*!< Subroutine label symbol index */
+    uint32_t first;                     /*!< First copied statement index, or the call statement index until inlined */
+    uint32_t entry;                     /*!< First subroutine statement index */
+    uint32_t count;                     /*!< Copied statement count, up to the subroutine RTS */
+    int32_t bytes;                      /*!< Bytes added, or negative if bytes were saved */
+    uint32_t cycles;                    /*!< Cycles saved per call */
+    uint32_t weight;                    /*!< Estimated calls, each time the code around the call runs */
+} nesla_inlined_t;
+
+/*!
+ * @struct nesla_keep_t
+ * @brief Kept label context, a label reached through a computed address, kept by unreachable code removal (.KEEP).
+ */
+typedef struct {
+    const nesla_token_t *token;         /*!< Label token */
+    uint32_t scope;                     /*!< Label scope */
+} nesla_keep_t;
+
+/*!
+ * @struct nesla_removed_t
+ * @brief Removed label context, a label starting code or data removed as unreachable.
+ */
+typedef struct {
+    uint32_t symbol;                    /*!< Label symbol index */
+    uint32_t length;                    /*!< Bytes removed, up to the next global label */
+} nesla_removed_t;
+
+/*!
+ * @struct nesla_variable_t
+ * @brief Variable context, RAM reserved without a fixed address (.RESV), placed once every reference is known.
+ */
+typedef struct {
+    const nesla_token_t *token;         /*!< Variable name token */
+    uint32_t symbol;                    /*!< Symbol index */
+    uint16_t size;                      /*!< Size in bytes */
+    uint16_t address;                   /*!< Address, once allocated */
+    uint32_t references;                /*!< References to the variable, and to the names of its bytes */
+    bool pointer;                       /*!< Variable is referenced as a pointer, through (zp),Y or (zp,X) */
+    bool zero_page;                     /*!< Variable must be placed in zero page (.SOA field marked ZP) */
+    bool page;                          /*!< Variable must not cross a page (.SOA field marked PAGE) */
+} nesla_variable_t;
+
+/*!
+ * @struct nesla_field_t
+ * @brief Structure field context, an array with one element per structure entry (.SOA).
+ */
+typedef struct {
+    const nesla_token_t *token;         /*!< Field name token */
+    uint16_t width;                     /*!< Element width in bytes, 1 or 2 */
+    bool zero_page;                     /*!< Field must be placed in zero page */
+    bool page;                          /*!< Field must not cross a page */
+} nesla_field_t;
+
+/*!
+ * @struct nesla_region_t
+ * @brief RAM region context, a range of addresses variables may be placed in (.RESV).
+ */
+typedef struct {
+    const nesla_token_t *token;         /*!< Directive token */
+    uint16_t first;                     /*!< First address */
+    uint16_t last;                      /*!< Last address */
+} nesla_region_t;
+
+/*!
+ * @struct nesla_relocation_t
+ * @brief Relocatable section context, code placed in a program bank once its length is known (.RELOC).
+ */
+typedef struct {
+    const nesla_token_t *token;         /*!< Directive token */
+    const nesla_token_t *affinity;      /*!< Label token of the code the section is placed with, or NULL */
+    uint32_t scope;                     /*!< Affinity label scope */
+    uint16_t pin;                       /*!< Bank the section must be placed in, or ENCODER_RELOCATE_BANK for any bank */
+    uint16_t align;                     /*!< Alignment of the section address in bytes (.ALIGN), or 1 */
+    bool page;                          /*!< Section is kept within a page (.ALIGN PAGE) */
+    uint16_t bank;                      /*!< Bank, once placed */
+    uint16_t address;                   /*!< Address, once placed */
+    uint16_t length;                    /*!< Length in bytes, once placed */
+} nesla_relocation_t;
+
+/*!
+ * @struct nesla_packed_t
+ * @brief Packed block context, data compressed at assembly time (.PACK), on a worker thread or from the compression cache.
+ */
+typedef struct nesla_packed_s {
+    const nesla_token_t *token;         /*!< Directive token */
+    const nesla_token_t *name;          /*!< Block name token */
+    uint8_t mode;                       /*!< Compression mode (UNPACK_RLE or UNPACK_LZ) */
+    uint16_t bank;                      /*!< Bank index */
+    uint16_t address;                   /*!< Address */
+    uint8_t *input;                     /*!< Uncompressed data */
+    size_t input_length;                /*!< Uncompressed data length in bytes */
+    size_t input_capacity;              /*!< Uncompressed data capacity in bytes */
+    uint8_t *output;                    /*!< Compressed data, sized for the worst case */
+    size_t output_length;               /*!< Compressed data length in bytes, once compressed */
+    char *path;                         /*!< Compression cache file path, or NULL if not cached */
+    char *temporary;                    /*!< Compression cache temporary file path, written before it is renamed */
+    struct nesla_packed_s *queued;      /*!< Next block queued for a worker thread, or NULL */
+    bool cached;                        /*!< Compressed data was read from the compression cache */
+    uint32_t statement;                 /*!< Compressed data statement index */
+    uint32_t label;                     /*!< Compressed data label symbol index */
+} nesla_packed_t;
+
+/*!
+ * @struct nesla_pack_pool_t
+ * @brief Packed block worker thread pool, started by the first block compressed, with its workers taking queued blocks in
+ *        source order until the pool is closed.
+ */
+typedef struct {
+    mtx_t lock;                         /*!< Queue lock */
+    cnd_t signal;                       /*!< Signalled once a block is queued, or the pool is closed */
+    thrd_t thread[ENCODER_PACK_THREAD_MAX]; /*!< Worker threads */
+    size_t thread_count;                /*!< Worker thread count, or 0 to compress on the calling thread */
+    nesla_packed_t *head;               /*!< First queued block, or NULL */
+    nesla_packed_t *tail;               /*!< Last queued block, or NULL */
+    bool started;                       /*!< Pool is started, until closed */
+    bool closed;                        /*!< No more blocks are queued, so workers return once the queue is empty */
+} nesla_pack_pool_t;
+
+/*!
+ * @struct nesla_symbol_t
+ * @brief Symbol context, a label or constant. Symbols named with a leading underscore are local to the preceding label.
+ */
+typedef struct {
+    const nesla_token_t *token;         /*!< Symbol token */
+    size_t bank;                        /*!< Bank index */
+    uint16_t address;                   /*!< Address, or value for constants, or byte offset into its variable until allocated */
+    uint32_t scope;                     /*!< Symbol scope, or 0 if global */
+    uint32_t anchor;                    /*!< Index plus one of the statement the label follows, or 0 if fixed */
+    uint32_t variable;                  /*!< Index plus one of the variable the symbol names a byte of (.RESV), or 0 */
+    bool constant;                      /*!< Symbol is a constant (.DEF), or a variable */
+    bool removed;                       /*!< Label is in code or data removed as unreachable */
+} nesla_symbol_t;
+
+/*!
+ * @struct nesla_encoder_t
+ * @brief Encoder context.
+ */
+typedef struct {
+    nesla_context_t *context;           /*!< Assembler context */
+    uint8_t *data;                      /*!< Encoded data */
+    size_t length;                      /*!< Encoded data length in bytes */
+    size_t capacity;                    /*!< Encoded data capacity in bytes */
+    nesla_statement_t *statement;       /*!< Statement array */
+    size_t statement_count;             /*!< Statement count */
+    size_t statement_capacity;          /*!< Statement array capacity */
+    nesla_section_t *section;           /*!< Section array */
+    size_t section_count;               /*!< Section count */
+    size_t section_capacity;            /*!< Section array capacity */
+    nesla_fixup_t *fixup;               /*!< Fixup array */
+    size_t fixup_count;                 /*!< Fixup count */
+    size_t fixup_capacity;              /*!< Fixup array capacity */
+    nesla_symbol_t *symbol;             /*!< Symbol array */
+    size_t symbol_count;                /*!< Symbol count */
+    size_t symbol_capacity;             /*!< Symbol array capacity */
+    nesla_budget_t *budget;             /*!< Cycle budget array */
+    size_t budget_count;                /*!< Cycle budget count */
+    size_t budget_capacity;             /*!< Cycle budget array capacity */
+    nesla_variable_t *variable;         /*!< Variable array */
+    size_t variable_count;              /*!< Variable count */
+    size_t variable_capacity;           /*!< Variable array capacity */
+    nesla_region_t *region;             /*!< RAM region array */
+    size_t region_count;                /*!< RAM region count */
+    size_t region_capacity;             /*!< RAM region array capacity */
+    nesla_relocation_t *relocation;     /*!< Relocatable section array, indexed by provisional bank */
+    size_t relocation_count;            /*!< Relocatable section count */
+    size_t relocation_capacity;         /*!< Relocatable section array capacity */
+    nesla_keep_t *keep;                 /*!< Kept label array */
+    size_t keep_count;                  /*!< Kept label count */
+    size_t keep_capacity;               /*!< Kept label array capacity */
+    nesla_removed_t *removed;           /*!< Removed label array */
+    size_t removed_count;               /*!< Removed label count */
+    size_t removed_capacity;            /*!< Removed label array capacity */
+    nesla_inlined_t *inlined;           /*!< Inlined call array, ordered by first copied statement */
+    size_t inlined_count;               /*!< Inlined call count */
+    size_t inlined_capacity;            /*!< Inlined call array capacity */
+    nesla_list_t packed;                /*!< Packed block list, of nesla_packed_t, in source order */
+    nesla_packed_t *pack;               /*!< Packed block open for data (.PACK), or NULL */
+    nesla_pack_pool_t pool;             /*!< Packed block worker thread pool */
+    size_t pack_count[UNPACK_LZ + 1];   /*!< Packed block count, per compression mode */
+    uint32_t unpack[UNPACK_MAX];        /*!< Index plus one of each decompressor name symbol, once added, or 0 */
+    nesla_token_t unpack_name[UNPACK_MAX]; /*!< Decompressor name tokens, once added */
+    nesla_list_t derived;               /*!< Derived name token list, of nesla_token_t, named after source names (.JUMP) */
+    nesla_table_t table;                /*!< Symbol table, mapping names to symbol indices */
+    uint32_t scope;                     /*!< Current local symbol scope */
+    uint32_t scope_count;               /*!< Local symbol scope count */
+    bool preserve;                      /*!< Statements appended are left alone by the optimizer (.NOOPT) */
+    uint16_t bound;                     /*!< Loop bound of the next statement appended (.LOOP), or 0 if unbounded */
+    bool hot;                           /*!< Next statement appended is a call run often (.HOT) */
+    bool far;                           /*!< Next statement appended is a call that may cross program banks (.FAR) */
+    bool align;                         /*!< Next statement appended is in an aligned section (.ALIGN) */
+    uint32_t shadow;                    /*!< Index plus one of the bank shadow variable symbol, kept by far calls, or 0 */
+    nesla_token_t shadow_name;          /*!< Bank shadow variable name token (ENCODER_SHADOW), once added */
+    const nesla_token_t *stack;         /*!< Stack budget directive token (.STACK), or NULL if no budget is set */
+    uint16_t stack_size;                /*!< Stack budget in bytes */
+    uint16_t program;                   /*!< Program bank count (.PRG) */
+    uint16_t mapper;                    /*!< Mapper type (.MAP) */
+} nesla_encoder_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Define encoder context label. A global label opens a new scope for the local labels that follow it.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to label token context
+ * @param[in] bank Bank index
+ * @param[in] address Address
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_define(nesla_encoder_t *encoder, const nesla_token_t *token, size_t bank, uint16_t address);
+
+/*!
+ * @brief Define encoder context constant (.DEF).
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to identifier token context
+ * @param[in] operand Constant pointer to scalar or identifier token context, which must already be defined
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_define_constant(nesla_encoder_t *encoder, const nesla_token_t *token, const nesla_token_t *operand);
+
+/*!
+ * @brief Close encoder context packed block (.PACK), once a statement other than its data follows. An empty statement is
+ *        placed for the compressed data, behind a label named after the block, and the block is compressed (see
+ *        nesla_pack_start). Does nothing if no packed block is open.
+ * @param[in,out] encoder Pointer to encoder context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_end_pack(nesla_encoder_t *encoder);
+
+/*!
+ * @brief Get encoder context constant value (.DEF), by name, such as a name in a table expression (.TABLE).
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to token context, the name is reported at
+ * @param[in] name Constant pointer to constant name
+ * @param[in,out] value Pointer to constant value
+ * @return NESLA_ERROR on failure, such as an undefined or non-constant symbol, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_get_constant(nesla_encoder_t *encoder, const nesla_token_t *token, const char *name, uint16_t *value);
+
+/*!
+ * @brief Get encoder context fixup, for a statement.
+ * @param[in] encoder Constant pointer to encoder context
+ * @param[in] index Statement index
+ * @return Pointer to fixup context, or NULL if the statement has no fixup bound to a symbol
+ */
+nesla_fixup_t *nesla_encoder_get_fixup(const nesla_encoder_t *encoder, size_t index);
+
+/*!
+ * @brief Get encoder context symbol.
+ * @param[in] encoder Constant pointer to encoder context
+ * @param[in] token Constant pointer to label or identifier token context
+ * @param[in] scope Symbol scope
+ * @return Pointer to symbol context, or NULL if undefined
+ */
+nesla_symbol_t *nesla_encoder_get_symbol(const nesla_encoder_t *encoder, const nesla_token_t *token, uint32_t scope);
+
+/*!
+ * @brief Initialize encoder context.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in,out] context Pointer to assembler context
+ */
+void nesla_encoder_initialize(nesla_encoder_t *encoder, nesla_context_t *context);
+
+/*!
+ * @brief Check if encoder context has a packed block open (.PACK), which data items are added to.
+ * @param[in] encoder Constant pointer to encoder context
+ * @return true if a packed block is open, false otherwise
+ */
+bool nesla_encoder_is_packing(const nesla_encoder_t *encoder);
+
+/*!
+ * @brief Add encoder context cycle budget (.BUDGET), checked once fixups are patched (see nesla_timing_check).
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to directive token context
+ * @param[in] symbol Constant pointer to handler label token context, or NULL for the handler the NMI vector points to
+ * @param[in] cycles Cycle budget
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_put_budget(nesla_encoder_t *encoder, const nesla_token_t *token, const nesla_token_t *symbol, uint32_t cycles);
+
+/*!
+ * @brief Inline encoder context calls, replacing each call statement with a copy of the subroutine statements before its RTS.
+ *        Branches and jumps between copied statements are retargeted to the copies, through labels placed in each copy. The
+ *        inlined calls are recorded, with the index of their first copied statement.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] inlined Constant pointer to inlined call array, ordered by call statement
+ * @param[in] count Inlined call count
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_put_inlined(nesla_encoder_t *encoder, const nesla_inlined_t *inlined, size_t count);
+
+/*!
+ * @brief Encode generated statement, an instruction or data byte emitted by the assembler rather than parsed from source, such
+ *        as a far call trampoline (see nesla_far_link). A symbol operand is recorded as a resolved fixup, relative for a branch.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to token context the statement is reported at
+ * @param[in] bank Bank index
+ * @param[in] address Address
+ * @param[in] instruction Instruction type, or INSTRUCTION_MAX for a data byte
+ * @param[in] mode Addressing mode, or MODE_ABSOLUTE for a data word
+ * @param[in] value Operand value, or data byte
+ * @param[in] symbol Operand symbol index, or ENCODER_UNRESOLVED if the operand is the value given
+ * @param[in,out] length Pointer to encoded length in bytes
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_put_code(nesla_encoder_t *encoder, const nesla_token_t *token, size_t bank, uint16_t address,
+    nesla_instruction_e instruction, nesla_mode_e mode, uint16_t value, uint32_t symbol, size_t *length);
+
+/*!
+ * @brief Place encoder context generated label, before the next generated statement. The label is kept out of the symbol
+ *        table, so it may share the name of the label it is generated for.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to label name token context
+ * @param[in] bank Bank index
+ * @param[in] address Address
+ * @param[in,out] index Pointer to symbol index
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_put_label(nesla_encoder_t *encoder, const nesla_token_t *token, size_t bank, uint16_t address,
+    uint32_t *index);
+
+/*!
+ * @brief Place encoder context generated local label, named after the label it is generated for followed by a suffix (such
+ *        as UNPACK_RLE_DONE), so each local label is listed under its own name.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to label name token context, the name is derived from
+ * @param[in] suffix Constant pointer to name suffix
+ * @param[in] bank Bank index
+ * @param[in] address Address
+ * @param[in,out] index Pointer to symbol index
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_put_local(nesla_encoder_t *encoder, const nesla_token_t *token, const char *suffix, size_t bank,
+    uint16_t address, uint32_t *index);
+
+/*!
+ * @brief Encode jump table (.JUMP), as split tables of the low bytes (<name>_LO) and high bytes (<name>_HI) of each entry,
+ *        with the entry count defined as a constant (<name>_COUNT). A dispatch table holds each address less one, and is
+ *        placed after a stub (<name>) that pushes the entry in X and returns into it (RTS).
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to directive token context
+ * @param[in] bank Bank index
+ * @param[in] address Address
+ * @param[in] dispatch Place a dispatch stub, and tables for it
+ * @param[in] name Constant pointer to table name token context
+ * @param[in] entry Constant pointer to entry token context array, of scalars or identifiers
+ * @param[in] count Entry count
+ * @param[in,out] length Pointer to encoded length in bytes
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_put_jump(nesla_encoder_t *encoder, const nesla_token_t *token, size_t bank, uint16_t address, bool dispatch,
+    const nesla_token_t *name, const nesla_token_t **entry, size_t count, size_t *length);
+
+/*!
+ * @brief Add encoder context kept label (.KEEP), kept by unreachable code removal (see nesla_dead_remove). Labels read by a
+ *        constant (.DEF) are kept as well.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to label token context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_put_keep(nesla_encoder_t *encoder, const nesla_token_t *token);
+
+/*!
+ * @brief Add encoder context RAM region (.RESV), which variables may be placed in (see nesla_ram_allocate).
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to directive token context
+ * @param[in] first First address
+ * @param[in] last Last address
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_put_region(nesla_encoder_t *encoder, const nesla_token_t *token, uint16_t first, uint16_t last);
+
+/*!
+ * @brief Add data to encoder context packed block (.PACK), such as an included binary (.INCB).
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to directive token context
+ * @param[in] data Constant pointer to data
+ * @param[in] length Data length in bytes
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_put_packed(nesla_encoder_t *encoder, const nesla_token_t *token, const uint8_t *data, size_t length);
+
+/*!
+ * @brief Add encoder context removed label, starting code or data removed as unreachable (see nesla_dead_remove).
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] symbol Label symbol index
+ * @param[in] length Bytes removed
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_put_removed(nesla_encoder_t *encoder, uint32_t symbol, uint32_t length);
+
+/*!
+ * @brief Add encoder context relocatable section (.RELOC), placed in a program bank once its length is known (see
+ *        nesla_bank_place). Statements and labels that follow it are given a provisional bank until then.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to directive token context
+ * @param[in] pin Bank the section must be placed in, or ENCODER_RELOCATE_BANK for any bank
+ * @param[in] affinity Constant pointer to label token context of the code the section is placed with, or NULL
+ * @param[in,out] bank Pointer to provisional bank index
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_put_relocation(nesla_encoder_t *encoder, const nesla_token_t *token, uint16_t pin,
+    const nesla_token_t *affinity, size_t *bank);
+
+/*!
+ * @brief Add encoder context structure (.SOA), laid out as one variable per field (<name>_<field>), each holding the field of
+ *        every entry, so entry X of a field is read with <name>_<field>,X. The high bytes of a 2 byte field follow its low
+ *        bytes, named <name>_<field>_HI, and the entry count is defined as <name>_COUNT.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to directive token context
+ * @param[in] name Constant pointer to structure name token context
+ * @param[in] count Entry count
+ * @param[in] field Constant pointer to field context array
+ * @param[in] field_count Field count
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_put_structure(nesla_encoder_t *encoder, const nesla_token_t *token, const nesla_token_t *name,
+    uint16_t count, const nesla_field_t *field, size_t field_count);
+
+/*!
+ * @brief Encode generated table statement (.TABLE), from data evaluated when parsed.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to directive token context
+ * @param[in] bank Bank index
+ * @param[in] address Address
+ * @param[in] data Constant pointer to table data
+ * @param[in] length Table data length in bytes
+ * @param[in] width Table entry width in bytes (1 or 2)
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_put_table(nesla_encoder_t *encoder, const nesla_token_t *token, size_t bank, uint16_t address,
+    const uint8_t *data, size_t length, size_t width);
+
+/*!
+ * @brief Add encoder context variable (.RESV), placed in RAM once every reference is known (see nesla_ram_allocate).
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to identifier token context
+ * @param[in] size Size in bytes
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_put_variable(nesla_encoder_t *encoder, const nesla_token_t *token, uint16_t size);
+
+/*!
+ * @brief Name encoder context byte of the last variable added (.RESV).
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to identifier token context
+ * @param[in] offset Byte offset into the variable
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_put_variable_byte(nesla_encoder_t *encoder, const nesla_token_t *token, uint16_t offset);
+
+/*!
+ * @brief Encode data statement (.BYTE/.WORD item), recording a fixup if it references an undefined symbol. While a packed
+ *        block is open (.PACK), the item is added to the block instead, and must be constant.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to directive token context
+ * @param[in] bank Bank index
+ * @param[in] address Address
+ * @param[in] operand Constant pointer to literal, scalar or identifier token context
+ * @param[in] width Item width in bytes (1 or 2)
+ * @param[in,out] length Pointer to encoded length in bytes
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_put_data(nesla_encoder_t *encoder, const nesla_token_t *token, size_t bank, uint16_t address,
+    const nesla_token_t *operand, size_t width, size_t *length);
+
+/*!
+ * @brief Encode instruction statement, recording a fixup if it references an undefined symbol. Direct operands
+ *        (MODE_ABSOLUTE, MODE_ABSOLUTE_X, MODE_ABSOLUTE_Y) are narrowed to relative or zero-page modes where possible.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to instruction token context
+ * @param[in] bank Bank index
+ * @param[in] address Address
+ * @param[in] mode Addressing mode, as written
+ * @param[in] operand Constant pointer to scalar or identifier token context, or NULL
+ * @param[in] type Immediate operand fixup type, as FIXUP_BYTE, or FIXUP_LOW/FIXUP_HIGH for its low/high byte
+ * @param[in,out] length Pointer to encoded length in bytes
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_put_instruction(nesla_encoder_t *encoder, const nesla_token_t *token, size_t bank, uint16_t address,
+    nesla_mode_e mode, const nesla_token_t *operand, nesla_fixup_e type, size_t *length);
+
+/*!
+ * @brief Resolve encoder context fixups, once all symbols are defined. Every undefined symbol is reported. Packed blocks are
+ *        then linked with their decompressors (see nesla_pack_link), and variables are placed in RAM (see nesla_ram_allocate).
+ *        If NESLA_FLAG_PEEPHOLE is set, the instruction stream is then optimized (see nesla_peephole_optimize), and if
+ *        NESLA_FLAG_INLINE is set, small leaf subroutines are inlined at hot call sites (see nesla_inline_expand), and if
+ *        NESLA_FLAG_DEAD is set, code and data unreachable from the vectors are removed (see nesla_dead_remove). Relocatable
+ *        sections are then placed in program banks (see nesla_bank_place), and if NESLA_FLAG_MERGE is set, identical data
+ *        blocks are merged (see nesla_merge_data). Far calls that cross banks are then routed through trampolines (see
+ *        nesla_far_link). Direct operands are then relaxed to zero-page wherever their final value is below $100, and, if
+ *        NESLA_FLAG_RELAX_BRANCH is set, out-of-range branches are expanded into an inverted branch over a jump. The sections
+ *        whose lengths changed are re-laid out until no statement changes, before every fixup is patched.
+ * @param[in,out] encoder Pointer to encoder context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_resolve(nesla_encoder_t *encoder);
+
+/*!
+ * @brief Set encoder context alignment (.ALIGN), of the statements that follow. In a section placed by hand, the origin is
+ *        moved up to the next multiple of the alignment. In a relocatable section (.RELOC), before its first statement, the
+ *        section is placed at a multiple of the alignment, or anywhere it is kept within a page (see nesla_bank_place).
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to directive token context
+ * @param[in] bank Bank index
+ * @param[in] align Alignment in bytes, a power of two up to ENCODER_ALIGN_MAX, ignored if the section is kept within a page
+ * @param[in] page Keep the relocatable section within a page
+ * @param[in,out] address Pointer to address, moved up to the alignment
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_set_align(nesla_encoder_t *encoder, const nesla_token_t *token, size_t bank, uint16_t align, bool page,
+    uint16_t *address);
+
+/*!
+ * @brief Set encoder context loop bound (.LOOP), for the next statement appended, which must be a branch or jump.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] bound Times the branch may loop back, each time the loop is entered
+ */
+void nesla_encoder_set_bound(nesla_encoder_t *encoder, uint16_t bound);
+
+/*!
+ * @brief Mark encoder context far call (.FAR), for the next statement appended, which must be a JSR. The first far call adds
+ *        the bank shadow variable (ENCODER_SHADOW), a byte of RAM holding the program bank last switched to by a far call,
+ *        unless the source already defined it (.DEF or .RESV), in which case that symbol is kept.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to directive token context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_set_far(nesla_encoder_t *encoder, const nesla_token_t *token);
+
+/*!
+ * @brief Mark encoder context hot call (.HOT), for the next statement appended, which must be a JSR.
+ * @param[in,out] encoder Pointer to encoder context
+ */
+void nesla_encoder_set_hot(nesla_encoder_t *encoder);
+
+/*!
+ * @brief Set encoder context mapper type (.MAP), which far call trampolines switch banks through.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] mapper Mapper type
+ */
+void nesla_encoder_set_mapper(nesla_encoder_t *encoder, uint16_t mapper);
+
+/*!
+ * @brief Set whether encoder context statements appended from now on are left alone by the optimizer (.NOOPT/.OPT).
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] preserve Statements are left alone if true, optimized otherwise
+ */
+void nesla_encoder_set_preserve(nesla_encoder_t *encoder, bool preserve);
+
+/*!
+ * @brief Open encoder context packed block (.PACK), closing the block open before it. The data items that follow are
+ *        compressed with the compression mode (RLE or LZ), and the block name is defined as a constant, the index of the block
+ *        among those of its mode. The first block of each mode adds its decompressor label (UNPACK_RLE or UNPACK_LZ), and the
+ *        first block adds the pointer variables the decompressors use.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to directive token context
+ * @param[in] bank Bank index
+ * @param[in] address Address
+ * @param[in] mode Constant pointer to compression mode identifier token context
+ * @param[in] name Constant pointer to block name identifier token context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_set_pack(nesla_encoder_t *encoder, const nesla_token_t *token, size_t bank, uint16_t address,
+    const nesla_token_t *mode, const nesla_token_t *name);
+
+/*!
+ * @brief Set encoder context program bank count (.PRG), which relocatable sections are placed in.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] count Program bank count
+ */
+void nesla_encoder_set_program(nesla_encoder_t *encoder, uint16_t count);
+
+/*!
+ * @brief Set encoder context stack budget (.STACK), checked once fixups are patched (see nesla_stack_check).
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to directive token context
+ * @param[in] size Stack budget in bytes
+ */
+void nesla_encoder_set_stack(nesla_encoder_t *encoder, const nesla_token_t *token, uint16_t size);
+
+/*!
+ * @brief Set encoder context statement data, such as compressed data, marking its section for layout.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] index Statement index
+ * @param[in] data Constant pointer to data
+ * @param[in] length Data length in bytes
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_set_statement(nesla_encoder_t *encoder, size_t index, const uint8_t *data, size_t length);
+
+/*!
+ * @brief Undefine encoder context symbol (.UNDEF). The name may be defined again afterwards.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to identifier token context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_undefine(nesla_encoder_t *encoder, const nesla_token_t *token);
+
+/*!
+ * @brief Uninitialize encoder context.
+ * @param[in,out] encoder Pointer to encoder context
+ */
+void nesla_encoder_uninitialize(nesla_encoder_t *encoder);
+
+/*!
+ * @brief Write encoder context statements into image context.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in,out] image Pointer to image context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_encoder_write(nesla_encoder_t *encoder, nesla_image_t *image);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* NESLA_ENCODER_H_ */
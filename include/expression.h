@@ -0,0 +1,127 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*!
+ * @file expression.h
+ * @brief Constant expressions, compiled once and evaluated per table index.
+ */
+
+#ifndef NESLA_EXPRESSION_H_
+#define NESLA_EXPRESSION_H_
+
+#include <encoder.h>
+
+#define EXPRESSION_DEPTH_MAX 32         /*!< Maximum expression nesting, and evaluation stack depth */
+
+/*!
+ * @enum nesla_expression_e
+ * @brief Expression operation type, in postfix order.
+ */
+typedef enum {
+    EXPRESSION_VALUE = 0,               /*!< Push value */
+    EXPRESSION_INDEX,                   /*!< Push table index */
+    EXPRESSION_NEGATE,                  /*!< Negate top value */
+    EXPRESSION_NOT,                     /*!< Complement top value */
+    EXPRESSION_MULTIPLY,                /*!< Multiply top values */
+    EXPRESSION_DIVIDE,                  /*!< Divide top values, rounding toward zero */
+    EXPRESSION_MODULO,                  /*!< Remainder of top values */
+    EXPRESSION_ADD,                     /*!< Add top values */
+    EXPRESSION_SUBTRACT,                /*!< Subtract top values */
+    EXPRESSION_SHIFT_LEFT,              /*!< Shift left */
+    EXPRESSION_SHIFT_RIGHT,             /*!< Shift right, keeping the sign */
+    EXPRESSION_AND,                     /*!< Bitwise and of top values */
+    EXPRESSION_XOR,                     /*!< Bitwise exclusive or of top values */
+    EXPRESSION_OR,                      /*!< Bitwise or of top values */
+    EXPRESSION_SINE,                    /*!< Sine of angle (256ths of a turn), scaled by amplitude */
+    EXPRESSION_COSINE,                  /*!< Cosine of angle (256ths of a turn), scaled by amplitude */
+    EXPRESSION_MAX,                     /*!< Maximum expression operation */
+} nesla_expression_e;
+
+/*!
+ * @enum nesla_expression_table_e
+ * @brief Generated table layout (.TABLE).
+ */
+typedef enum {
+    EXPRESSION_TABLE_BYTE = 0,          /*!< Byte per index */
+    EXPRESSION_TABLE_WORD,              /*!< Word per index, low byte first */
+    EXPRESSION_TABLE_SPLIT,             /*!< Low byte per index, then high byte per index */
+    EXPRESSION_TABLE_MAX,               /*!< Maximum table layout */
+} nesla_expression_table_e;
+
+/*!
+ * @struct nesla_operation_t
+ * @brief Expression operation context.
+ */
+typedef struct {
+    nesla_expression_e type;            /*!< Operation type */
+    int64_t value;                      /*!< Pushed value (EXPRESSION_VALUE) */
+} nesla_operation_t;
+
+/*!
+ * @struct nesla_expression_t
+ * @brief Expression context, compiled into postfix operations.
+ */
+typedef struct {
+    nesla_operation_t *operation;       /*!< Operations, in postfix order */
+    size_t count;                       /*!< Operation count */
+    size_t capacity;                    /*!< Operation capacity */
+} nesla_expression_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Compile expression from literal token (.TABLE). Operands are scalars (decimal or hexadecimal), the table index
+ *        (I) and constants already defined (.DEF), combined with the unary (- + ~) and binary (* / % + - << >> & ^ |)
+ *        operators, at C precedence, parentheses, and the functions SIN and COS.
+ * @param[in,out] expression Pointer to expression context
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to literal token context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_expression_compile(nesla_expression_t *expression, nesla_encoder_t *encoder, const nesla_token_t *token);
+
+/*!
+ * @brief Evaluate compiled expression at a table index, with 64-bit signed intermediates.
+ * @param[in] expression Constant pointer to expression context
+ * @param[in,out] context Pointer to context
+ * @param[in] token Constant pointer to literal token context
+ * @param[in] index Table index
+ * @param[in,out] value Pointer to expression value
+ * @return NESLA_ERROR on failure, such as a division by zero, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_expression_evaluate(const nesla_expression_t *expression, nesla_context_t *context, const nesla_token_t *token,
+    uint16_t index, int64_t *value);
+
+/*!
+ * @brief Free expression context.
+ * @param[in,out] expression Pointer to expression context
+ * @param[in,out] context Pointer to context
+ */
+void nesla_expression_free(nesla_expression_t *expression, nesla_context_t *context);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* NESLA_EXPRESSION_H_ */
@@ -0,0 +1,68 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*!
+ * @file far.h
+ * @brief Far call trampolines.
+ */
+
+#ifndef NESLA_FAR_H_
+#define NESLA_FAR_H_
+
+#include <bank.h>
+
+#define FAR_MMC1_PROGRAM 0xE000         /*!< MMC1 program bank register, loaded a bit at a time */
+#define FAR_MMC3_DATA 0x8001            /*!< MMC3 bank data register */
+#define FAR_MMC3_SELECT 0x8000          /*!< MMC3 bank select register */
+
+/*!
+ * @enum nesla_far_mapper_e
+ * @brief Far call mapper type, of the mappers trampolines switch banks through.
+ */
+typedef enum {
+    FAR_MAPPER_NROM = 0,                /*!< No bank switching, both banks always mapped */
+    FAR_MAPPER_MMC1,                    /*!< MMC1 (SxROM), in the mode fixing the last bank at $C000 */
+    FAR_MAPPER_UXROM,                   /*!< UxROM, with bus conflicts */
+    FAR_MAPPER_MMC3 = 4,                /*!< MMC3 (TxROM), in the mode switching $8000-$BFFF */
+} nesla_far_mapper_e;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Link encoder context far calls (.FAR), once program banks are placed and before layout. A far call into its own bank,
+ *        or into the last (fixed) bank, is left a direct JSR. Any other far call is routed through a trampoline, shared by
+ *        the calls to the same label from the same bank, which switches to the bank of the label through the mapper (.MAP),
+ *        calls it, and switches back. Calls from the fixed bank switch back to the bank held in the bank shadow variable,
+ *        which every trampoline keeps once such a call exists. Trampolines are placed in the fixed bank, after a bus conflict
+ *        table for UxROM, and the calls routed are reported as a note.
+ * @param[in,out] encoder Pointer to encoder context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_far_link(nesla_encoder_t *encoder);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* NESLA_FAR_H_ */
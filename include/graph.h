@@ -0,0 +1,207 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*!
+ * @file graph.h
+ * @brief Control-flow graph, over encoded instructions.
+ */
+
+#ifndef NESLA_GRAPH_H_
+#define NESLA_GRAPH_H_
+
+#include <encoder.h>
+
+#define GRAPH_EDGE_MAX 2                /*!< Maximum number of edges leaving an instruction */
+#define GRAPH_VECTOR_IRQ 0xFFFE         /*!< IRQ (and BRK) vector address */
+#define GRAPH_VECTOR_NMI 0xFFFA         /*!< NMI vector address */
+#define GRAPH_VECTOR_RESET 0xFFFC       /*!< Reset vector address */
+
+/*!
+ * @enum nesla_edge_e
+ * @brief Edge type.
+ */
+typedef enum {
+    EDGE_NEXT = 0,                      /*!< Falls through to the next instruction (or returns there from a call) */
+    EDGE_BRANCH,                        /*!< Branches or jumps to a target */
+    EDGE_CALL,                          /*!< Calls a subroutine (JSR) */
+    EDGE_INDIRECT,                      /*!< Jumps to a target only known at runtime (JMP (ind)) */
+    EDGE_MAX,                           /*!< Max edge */
+} nesla_edge_e;
+
+/*!
+ * @struct nesla_edge_t
+ * @brief Edge context.
+ */
+typedef struct {
+    uint32_t statement;                 /*!< Target statement index, or ENCODER_UNRESOLVED if no instruction is placed there */
+    uint16_t address;                   /*!< Target address */
+    uint8_t type;                       /*!< Edge type */
+} nesla_edge_t;
+
+/*!
+ * @enum nesla_call_e
+ * @brief Subroutine call state.
+ */
+typedef enum {
+    CALL_NONE = 0,                      /*!< Subroutine not measured */
+    CALL_ACTIVE,                        /*!< Subroutine is being measured, waiting on the subroutines it calls */
+    CALL_DONE,                          /*!< Subroutine measured */
+    CALL_FAILED,                        /*!< Subroutine could not be measured */
+} nesla_call_e;
+
+/*!
+ * @enum nesla_visit_e
+ * @brief Statement visit state, during a walk.
+ */
+typedef enum {
+    VISIT_ACTIVE = 0,                   /*!< Statement is on the walk stack */
+    VISIT_DONE,                         /*!< Statement and its successors are walked */
+} nesla_visit_e;
+
+/*!
+ * @struct nesla_graph_frame_t
+ * @brief Graph walk frame context.
+ */
+typedef struct {
+    uint32_t statement;                 /*!< Statement index */
+    uint32_t edge;                      /*!< Next edge index */
+} nesla_graph_frame_t;
+
+/*!
+ * @struct nesla_graph_loop_t
+ * @brief Graph loop context, an edge back to a statement on the walk stack.
+ */
+typedef struct {
+    uint32_t source;                    /*!< Statement index, looping back */
+    uint32_t target;                    /*!< Statement index, at the loop head */
+    uint32_t span;                      /*!< Statements between them, in walk order */
+} nesla_graph_loop_t;
+
+/*!
+ * @struct nesla_graph_entry_t
+ * @brief Graph entry context, placing an instruction.
+ */
+typedef struct {
+    uint16_t address;                   /*!< Address */
+    uint16_t bank;                      /*!< Bank index */
+    uint32_t statement;                 /*!< Statement index */
+} nesla_graph_entry_t;
+
+/*!
+ * @struct nesla_graph_t
+ * @brief Graph context.
+ */
+typedef struct {
+    const nesla_encoder_t *encoder;     /*!< Encoder context */
+    nesla_graph_entry_t *entry;         /*!< Instructions, sorted by address and bank */
+    size_t entry_count;                 /*!< Instruction count */
+    uint32_t generation;                /*!< Walk generation */
+    uint32_t *stamp;                    /*!< Generation of the last walk to visit, per statement */
+    uint8_t *state;                     /*!< Visit state, per statement */
+    uint32_t *position;                 /*!< Position in walk order, per statement */
+    uint32_t *order;                    /*!< Statements visited by the last walk, in reverse postorder */
+    size_t order_count;                 /*!< Statements visited count */
+    nesla_graph_frame_t *frame;         /*!< Walk stack */
+    uint8_t *call;                      /*!< Call state, per entry statement */
+    nesla_graph_loop_t *loop;           /*!< Loop array, of the last walk, innermost first */
+    size_t loop_count;                  /*!< Loop count */
+    size_t loop_capacity;               /*!< Loop array capacity */
+    uint32_t *pending;                  /*!< Subroutines to measure, last first */
+    size_t pending_count;               /*!< Subroutines to measure count */
+    size_t pending_capacity;            /*!< Subroutines to measure capacity */
+} nesla_graph_t;
+
+/*!
+ * @brief Measure a subroutine, once the subroutines it calls are measured, over the statements of the last walk.
+ * @param[in,out] context Pointer to caller context
+ * @param[in] entry Entry statement index
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+typedef nesla_error_e (*nesla_measure)(void *context, uint32_t entry);
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Find graph context instruction, placed at an address. Instructions placed in the bank given are preferred, so that
+ *        code in a fixed bank is found from any other bank.
+ * @param[in] graph Constant pointer to graph context
+ * @param[in] bank Bank index
+ * @param[in] address Address
+ * @return Statement index, or ENCODER_UNRESOLVED if no instruction is placed at the address
+ */
+uint32_t nesla_graph_find(const nesla_graph_t *graph, size_t bank, uint16_t address);
+
+/*!
+ * @brief Get graph context edges, leaving an instruction, once fixups are patched. Targets bound to a symbol are found in the
+ *        bank of that symbol. BRK, RTI and RTS have no edges.
+ * @param[in] graph Constant pointer to graph context
+ * @param[in] index Statement index
+ * @param[in,out] edge Pointer to edge array, of GRAPH_EDGE_MAX entries
+ * @return Edge count
+ */
+size_t nesla_graph_get_edges(const nesla_graph_t *graph, size_t index, nesla_edge_t *edge);
+
+/*!
+ * @brief Get graph context interrupt vector, placed with .WORD. If the vector is placed in more than one bank, the last bank
+ *        is used, since it is the bank fixed at $C000-$FFFF by most mappers.
+ * @param[in] graph Constant pointer to graph context
+ * @param[in] vector Vector address (GRAPH_VECTOR_NMI, GRAPH_VECTOR_RESET or GRAPH_VECTOR_IRQ)
+ * @param[in,out] bank Pointer to handler bank index
+ * @param[in,out] address Pointer to handler address
+ * @return true if the vector is placed, false otherwise
+ */
+bool nesla_graph_get_vector(const nesla_graph_t *graph, uint16_t vector, size_t *bank, uint16_t *address);
+
+/*!
+ * @brief Initialize graph context, placing every encoded instruction.
+ * @param[in,out] graph Pointer to graph context
+ * @param[in] encoder Constant pointer to encoder context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_graph_initialize(nesla_graph_t *graph, const nesla_encoder_t *encoder);
+
+/*!
+ * @brief Measure graph context subroutine, measuring the subroutines it calls first. Each subroutine is walked from its entry,
+ *        without following calls, placing the statements reached in reverse postorder and recording the edges that loop back,
+ *        before it is measured. Subroutines already measured are not measured again. Recursion, indirect jumps and targets
+ *        that are not instructions are reported as errors.
+ * @param[in,out] graph Pointer to graph context
+ * @param[in] entry Entry statement index
+ * @param[in] measure Subroutine measure callback
+ * @param[in,out] context Pointer to caller context, passed to the callback
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_graph_measure(nesla_graph_t *graph, uint32_t entry, nesla_measure measure, void *context);
+
+/*!
+ * @brief Uninitialize graph context.
+ * @param[in,out] graph Pointer to graph context
+ */
+void nesla_graph_uninitialize(nesla_graph_t *graph);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* NESLA_GRAPH_H_ */
@@ -0,0 +1,188 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file image.h
+ * @brief Output image.
+ */
+
+#ifndef NESLA_IMAGE_H_
+#define NESLA_IMAGE_H_
+
+#include <common.h>
+
+/*!
+ * @enum nesla_bank_e
+ * @brief Image bank type.
+ */
+typedef enum {
+    BANK_PROGRAM = 0,                   /*!< Program bank */
+    BANK_CHARACTER,                     /*!< Character bank */
+    BANK_MAX,                           /*!< Max bank */
+} nesla_bank_e;
+
+/*!
+ * @enum nesla_header_e
+ * @brief Image header field.
+ */
+typedef enum {
+    HEADER_PROGRAM = 0,                 /*!< Program bank count */
+    HEADER_CHARACTER,                   /*!< Character bank count */
+    HEADER_MAPPER,                      /*!< Mapper type */
+    HEADER_MIRROR,                      /*!< Mirror type */
+    HEADER_MAX,                         /*!< Max header field */
+} nesla_header_e;
+
+/*!
+ * @struct nesla_image_binary_t
+ * @brief Image binary context, placed into a bank without being copied.
+ */
+typedef struct {
+    size_t offset;                      /*!< Bank offset in bytes */
+    nesla_binary_t binary;              /*!< Binary context */
+} nesla_image_binary_t;
+
+/*!
+ * @struct nesla_image_bank_t
+ * @brief Image bank context.
+ */
+typedef struct {
+    nesla_bank_e type;                  /*!< Bank type */
+    uint8_t *data;                      /*!< Bank data */
+    uint8_t *used;                      /*!< Bank used bitmap */
+    size_t length;                      /*!< Bank length in bytes */
+    nesla_list_t binary;                /*!< Bank binary list, sorted by offset */
+} nesla_image_bank_t;
+
+/*!
+ * @struct nesla_image_t
+ * @brief Image context.
+ */
+typedef struct {
+    nesla_context_t *context;           /*!< Assembler context */
+    uint8_t header[HEADER_MAX];         /*!< Image header */
+    nesla_image_bank_t *bank;           /*!< Image banks */
+    size_t count;                       /*!< Image bank count */
+} nesla_image_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Get image context bank count.
+ * @param[in] image Constant pointer to image context
+ * @return Bank count
+ */
+size_t nesla_image_get_count(const nesla_image_t *image);
+
+/*!
+ * @brief Get image context header field.
+ * @param[in] image Constant pointer to image context
+ * @param[in] type Header field type
+ * @return Header field value, or 0 if undefined
+ */
+uint8_t nesla_image_get_header(const nesla_image_t *image, nesla_header_e type);
+
+/*!
+ * @brief Get image context bank length.
+ * @param[in] image Constant pointer to image context
+ * @param[in] bank Bank index
+ * @return Bank length in bytes, or 0 if the bank does not exist
+ */
+size_t nesla_image_get_length(const nesla_image_t *image, size_t bank);
+
+/*!
+ * @brief Get image context size, once written.
+ * @param[in] image Constant pointer to image context
+ * @return Image size in bytes
+ */
+size_t nesla_image_get_size(const nesla_image_t *image);
+
+/*!
+ * @brief Initialize image context.
+ * @param[in,out] image Pointer to image context
+ * @param[in,out] context Pointer to assembler context
+ */
+void nesla_image_initialize(nesla_image_t *image, nesla_context_t *context);
+
+/*!
+ * @brief Merge identical image context tiles, in each character pattern table (4 KB, 256 tiles of 16 bytes). Tiles are
+ *        hashed, and each tile equal to an earlier tile is mapped to that tile. Tiles keep their place, so the character
+ *        banks are unchanged, and the tile map records the index of each tile's first copy, for nametables and sprites to
+ *        be remapped, leaving the tiles no longer referenced free.
+ * @param[in,out] image Pointer to image context
+ * @param[out] map Pointer to tile map, 256 bytes per character pattern table (release with nesla_context_free)
+ * @param[out] length Pointer to tile map length in bytes
+ * @param[out] merged Pointer to merged tile count, of the tiles placed that map to an earlier tile
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_image_merge_tiles(nesla_image_t *image, uint8_t **map, size_t *length, size_t *merged);
+
+/*!
+ * @brief Put data into image context bank.
+ * @param[in,out] image Pointer to image context
+ * @param[in] bank Bank index
+ * @param[in] address Address, mapped into the bank by its length
+ * @param[in] data Constant pointer to data
+ * @param[in] length Data length in bytes
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_image_put(nesla_image_t *image, size_t bank, uint16_t address, const uint8_t *data, size_t length);
+
+/*!
+ * @brief Put binary context into image context bank, taking ownership of the binary context.
+ * @param[in,out] image Pointer to image context
+ * @param[in] bank Bank index
+ * @param[in] address Address, mapped into the bank by its length
+ * @param[in,out] binary Pointer to binary context, cleared on success
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_image_put_binary(nesla_image_t *image, size_t bank, uint16_t address, nesla_binary_t *binary);
+
+/*!
+ * @brief Set image context header field.
+ * @param[in,out] image Pointer to image context
+ * @param[in] type Header field type
+ * @param[in] value Header field value
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_image_set_header(nesla_image_t *image, nesla_header_e type, uint16_t value);
+
+/*!
+ * @brief Uninitialize image context.
+ * @param[in,out] image Pointer to image context
+ */
+void nesla_image_uninitialize(nesla_image_t *image);
+
+/*!
+ * @brief Write image context into writer context.
+ * @param[in,out] image Pointer to image context
+ * @param[in,out] writer Pointer to writer context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_image_write(nesla_image_t *image, nesla_writer_t *writer);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* NESLA_IMAGE_H_ */
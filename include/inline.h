@@ -0,0 +1,60 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*!
+ * @file inline.h
+ * @brief Leaf subroutine inliner.
+ */
+
+#ifndef NESLA_INLINE_H_
+#define NESLA_INLINE_H_
+
+#include <encoder.h>
+
+#define INLINE_BYTE_CYCLES 4            /*!< Cycles an inlined call must save over its estimated calls, per byte it adds */
+#define INLINE_SIZE_MAX 16              /*!< Maximum subroutine length in bytes, without its RTS */
+#define INLINE_WEIGHT_HOT 4             /*!< Estimated calls of a call marked hot (.HOT), outside of a loop */
+#define INLINE_WEIGHT_LOOP 8            /*!< Estimated calls of a call in a loop without a bound (.LOOP) */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Inline encoder context leaf subroutines at hot call sites, once all symbols are bound and before layout. A call site is
+ *        hot if it is marked (.HOT), or if it lies in a loop, which runs the call once more than the loop bound (.LOOP), or
+ *        INLINE_WEIGHT_LOOP times if unbounded. A subroutine is inlined if it runs straight to an RTS in at most INLINE_SIZE_MAX
+ *        bytes, in the bank of the call, and only branches within itself. It must not call, return from an interrupt, touch
+ *        the stack pointer or pull more than it pushes. The JSR and RTS saved on each estimated call must repay the bytes
+ *        added, at INLINE_BYTE_CYCLES per byte. Calls are inlined in order of cycles saved per byte added, while the code that
+ *        grows still fits before the next section in its bank. Each inlined call is reported as a note. Statements under
+ *        .NOOPT are left alone.
+ * @param[in,out] encoder Pointer to encoder context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_inline_expand(nesla_encoder_t *encoder);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* NESLA_INLINE_H_ */
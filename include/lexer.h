@@ -34,9 +34,13 @@
  * @brief Lexer context.
  */
 typedef struct {
-    nesla_stream_t stream;  /*!< Stream context */
-    nesla_list_t token;     /*!< Token list context */
-    size_t index;           /*!< Token list index */
+    nesla_context_t *context;   /*!< Assembler context */
+    nesla_stream_t stream;      /*!< Stream context */
+    nesla_token_t *token;       /*!< Token array */
+    size_t count;               /*!< Token count */
+    size_t capacity;            /*!< Token array capacity */
+    size_t index;               /*!< Token array index */
+    bool end;                   /*!< Stream end reached */
 } nesla_lexer_t;
 
 #ifdef __cplusplus
@@ -52,20 +56,41 @@ extern "C" {
 nesla_error_e nesla_lexer_get(const nesla_lexer_t *lexer, nesla_token_t **token);
 
 /*!
- * @brief Initialize lexer context.
+ * @brief Initialize lexer context. Malformed lines are reported as context diagnostics and dropped.
  * @param[in,out] lexer Pointer to lexer context
+ * @param[in,out] context Pointer to assembler context
  * @param[in] path Constant pointer to file path
  * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
  */
-nesla_error_e nesla_lexer_initialize(nesla_lexer_t *lexer, const char *path);
+nesla_error_e nesla_lexer_initialize(nesla_lexer_t *lexer, nesla_context_t *context, const char *path);
 
 /*!
- * @brief Move lexer context to next character.
+ * @brief Initialize lexer context with a caller owned buffer. Malformed lines are reported as context diagnostics and dropped.
+ * @param[in,out] lexer Pointer to lexer context
+ * @param[in,out] context Pointer to assembler context
+ * @param[in] path Constant pointer to buffer name, used as the file path
+ * @param[in] data Constant pointer to buffer data
+ * @param[in] length Buffer length in bytes
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_lexer_initialize_buffer(nesla_lexer_t *lexer, nesla_context_t *context, const char *path, const uint8_t *data,
+    size_t length);
+
+/*!
+ * @brief Move lexer context to next token.
  * @param[in,out] lexer Pointer to lexer context
  * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
  */
 nesla_error_e nesla_lexer_next(nesla_lexer_t *lexer);
 
+/*!
+ * @brief Get lexer context token following the current token, without moving the lexer context.
+ * @param[in,out] lexer Constant pointer to lexer context
+ * @param[in,out] token Pointer to token context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_lexer_peek(const nesla_lexer_t *lexer, nesla_token_t **token);
+
 /*!
  * @brief Reset lexer context.
  * @param[in,out] lexer Pointer to lexer context
@@ -0,0 +1,56 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*!
+ * @file listing.h
+ * @brief Assembly listing.
+ */
+
+#ifndef NESLA_LISTING_H_
+#define NESLA_LISTING_H_
+
+#include <bank.h>
+#include <cycle.h>
+#include <writer.h>
+
+#define LISTING_DATA_MAX 4              /*!< Maximum data bytes listed per line, longer data continues on the lines that follow */
+#define LISTING_LINE_MAX 256            /*!< Maximum listing line length, longer lines are truncated */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Write encoder context listing, once fixups are patched. Each instruction is listed with its address, encoding, cycles
+ *        and page crossing, and source position. Each label is listed with the cycles up to the next label, and each basic
+ *        block is followed by its cycles.
+ * @param[in] encoder Constant pointer to encoder context
+ * @param[in,out] writer Pointer to writer context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_listing_write(const nesla_encoder_t *encoder, nesla_writer_t *writer);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* NESLA_LISTING_H_ */
@@ -27,18 +27,81 @@
 #ifndef NESLA_H_
 #define NESLA_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
 #define NESLA_API_VERSION_1 1                   /*!< Interface version 1 */
-#define NESLA_API_VERSION NESLA_API_VERSION_1   /*!< Current interface version */
+#define NESLA_API_VERSION_2 2                   /*!< Interface version 2 */
+#define NESLA_API_VERSION NESLA_API_VERSION_2   /*!< Current interface version */
+
+#define NESLA_MESSAGE_MAX 192                   /*!< Maximum diagnostic message length, including terminator */
+#define NESLA_PATH_MAX 128                      /*!< Maximum diagnostic path length, including terminator */
 
 /*!
  * @enum nesla_error_e
  * @brief Error code.
  */
 typedef enum {
-    NESLA_FAILURE = -1,                         /*!< Operation failed, call nesla_get_error */
+    NESLA_FAILURE = -1,                         /*!< Operation failed, call nesla_get_error/nesla_context_get_error */
     NESLA_SUCCESS,                              /*!< Operation succeeded */
 } nesla_error_e;
 
+/*!
+ * @enum nesla_diagnostic_e
+ * @brief Diagnostic level.
+ */
+typedef enum {
+    NESLA_DIAGNOSTIC_ERROR = 0,                 /*!< Error diagnostic, the assembly fails */
+    NESLA_DIAGNOSTIC_WARNING,                   /*!< Warning diagnostic */
+    NESLA_DIAGNOSTIC_NOTE,                      /*!< Note diagnostic, reporting a change made to the source */
+    NESLA_DIAGNOSTIC_MAX,                       /*!< Maximum diagnostic level */
+} nesla_diagnostic_e;
+
+/*!
+ * @enum nesla_flag_e
+ * @brief Assembly flag, combined into a bitmask.
+ */
+typedef enum {
+    NESLA_FLAG_NONE = 0,                        /*!< No flags */
+    NESLA_FLAG_RELAX_BRANCH = 1 << 0,           /*!< Relax out-of-range branches into an inverted branch over a JMP */
+    NESLA_FLAG_PEEPHOLE = 1 << 1,               /*!< Optimize wasteful instruction sequences, outside of .NOOPT */
+    NESLA_FLAG_LISTING = 1 << 2,                /*!< Write a listing with cycle counts next to the output file (.lst) */
+    NESLA_FLAG_INLINE = 1 << 3,                 /*!< Inline small leaf subroutines at hot call sites */
+    NESLA_FLAG_DEAD = 1 << 4,                   /*!< Remove code and data unreachable from the vectors and kept labels (.KEEP) */
+    NESLA_FLAG_MERGE = 1 << 5,                  /*!< Merge identical data blocks, aliasing their labels to a single copy */
+    NESLA_FLAG_TILE = 1 << 6,                   /*!< Map identical CHR tiles to their first copy, left in place, in a tile map (.map) */
+} nesla_flag_e;
+
+/*!
+ * @struct nesla_diagnostic_t
+ * @brief NESLA diagnostic context.
+ */
+typedef struct {
+    nesla_diagnostic_e level;                   /*!< Diagnostic level */
+    char path[NESLA_PATH_MAX];                  /*!< Source path, truncated if longer */
+    size_t line;                                /*!< Source line */
+    size_t column;                              /*!< Source column */
+    char message[NESLA_MESSAGE_MAX];            /*!< Diagnostic message, truncated if longer */
+} nesla_diagnostic_t;
+
+/*!
+ * @struct nesla_allocator_t
+ * @brief NESLA allocator context.
+ */
+typedef struct {
+    void *(*allocate)(size_t length, void *context);                /*!< Allocate memory */
+    void *(*reallocate)(void *data, size_t length, void *context);  /*!< Reallocate memory */
+    void (*free)(void *data, void *context);                        /*!< Free memory */
+    void *context;                                                  /*!< Caller defined allocator context */
+} nesla_allocator_t;
+
+/*!
+ * @struct nesla_context_t
+ * @brief NESLA assembler context handle, owning the error state, allocator and caches of its runs. Runs using
+ *        different handles may proceed concurrently.
+ */
+typedef struct nesla_context_s nesla_context_t;
+
 /*!
  * @struct nesla_t
  * @brief NESLA context.
@@ -48,6 +111,57 @@ typedef struct {
     const char *output;                         /*!< Output directory */
 } nesla_t;
 
+/*!
+ * @brief Include resolver, called for each .INC/.INCB path in a source buffer.
+ * @param[in] path Constant pointer to include path, as written in the source
+ * @param[in,out] data Pointer to include data, owned by the caller until the assembly completes
+ * @param[in,out] length Pointer to include data length in bytes
+ * @param[in] context Pointer to caller defined resolver context
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+typedef nesla_error_e (*nesla_resolve)(const char *path, const uint8_t **data, size_t *length, void *context);
+
+/*!
+ * @struct nesla_source_t
+ * @brief NESLA source buffer context.
+ */
+typedef struct {
+    const char *name;                           /*!< Source name, used in errors */
+    const uint8_t *data;                        /*!< Source data */
+    size_t length;                              /*!< Source length in bytes */
+    nesla_resolve resolve;                      /*!< Include resolver, or NULL to resolve includes from disk */
+    void *context;                              /*!< Caller defined resolver context */
+} nesla_source_t;
+
+/*!
+ * @struct nesla_statistics_t
+ * @brief NESLA assembly statistics.
+ */
+typedef struct {
+    size_t pass;                                /*!< Passes over the source tokens, and layout passes over the statements */
+    size_t statement;                           /*!< Instructions and data statements encoded */
+    size_t symbol;                              /*!< Symbols defined */
+    size_t reference;                           /*!< Symbol references */
+    size_t fixup;                               /*!< Forward references, recorded as fixups */
+    size_t patched;                             /*!< Fixups patched, once their symbols resolved */
+    size_t relaxed;                             /*!< Statements relaxed to zero-page during layout */
+    size_t expanded;                            /*!< Branches expanded into an inverted branch over a JMP */
+    size_t optimized;                           /*!< Rewrites made by the peephole optimizer */
+    size_t saved_bytes;                         /*!< Bytes saved by the peephole optimizer */
+    size_t saved_cycles;                        /*!< Cycles saved by the peephole optimizer, once per rewrite */
+    size_t inlined;                             /*!< Calls inlined */
+    ptrdiff_t inlined_bytes;                    /*!< Bytes added by inlining, or negative if inlining saved bytes */
+    size_t inlined_cycles;                      /*!< Cycles saved by inlining, once per call */
+    size_t removed;                             /*!< Labels removed as unreachable, with the code and data up to the next label */
+    size_t removed_bytes;                       /*!< Bytes removed as unreachable */
+    size_t merged;                              /*!< Data blocks merged into an identical block */
+    size_t merged_bytes;                        /*!< Bytes saved by merging data blocks */
+    size_t merged_tiles;                        /*!< CHR tiles merged into an identical tile */
+    size_t packed;                              /*!< Data blocks compressed */
+    ptrdiff_t packed_bytes;                     /*!< Bytes added by compression, or negative if compression saved bytes */
+    size_t cached;                              /*!< Data blocks read from the compression cache */
+} nesla_statistics_t;
+
 /*!
  * @struct nesla_version_t
  * @brief Version context.
@@ -70,7 +184,119 @@ extern "C" {
 nesla_error_e nesla(const nesla_t *context);
 
 /*!
- * @brief Get error string.
+ * @brief Assemble source buffer into an image buffer, without any disk I/O when a resolver is provided.
+ * @param[in] source Constant pointer to source buffer context
+ * @param[in,out] output Pointer to caller owned image buffer, or pointer to NULL to have one allocated (release with free)
+ * @param[in,out] length Pointer to image buffer capacity in bytes, set to the image length on success
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_buffer(const nesla_source_t *source, uint8_t **output, size_t *length);
+
+/*!
+ * @brief Create assembler context handle.
+ * @param[in,out] context Pointer to assembler context handle
+ * @param[in] allocator Constant pointer to allocator context, or NULL to use the standard allocator
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_context_create(nesla_context_t **context, const nesla_allocator_t *allocator);
+
+/*!
+ * @brief Destroy assembler context handle.
+ * @param[in,out] context Pointer to assembler context handle
+ */
+void nesla_context_destroy(nesla_context_t *context);
+
+/*!
+ * @brief Assemble source files defined in caller defined context, using an assembler context handle.
+ * @param[in,out] context Pointer to assembler context handle
+ * @param[in] input Constant pointer to caller defined context
+ * @return NESLA_FAILURE on failure, call nesla_context_get_error, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_context_assemble(nesla_context_t *context, const nesla_t *input);
+
+/*!
+ * @brief Assemble source buffer into an image buffer, using an assembler context handle.
+ * @param[in,out] context Pointer to assembler context handle
+ * @param[in] source Constant pointer to source buffer context
+ * @param[in,out] output Pointer to caller owned image buffer, or pointer to NULL to have one allocated
+ *                       (release with nesla_context_release)
+ * @param[in,out] length Pointer to image buffer capacity in bytes, set to the image length on success
+ * @return NESLA_FAILURE on failure, call nesla_context_get_error, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_context_assemble_buffer(nesla_context_t *context, const nesla_source_t *source, uint8_t **output,
+    size_t *length);
+
+/*!
+ * @brief Get assembler context handle error string.
+ * @param[in] context Constant pointer to assembler context handle
+ * @return Constant pointer to error string
+ */
+const char *nesla_context_get_error(const nesla_context_t *context);
+
+/*!
+ * @brief Get assembler context handle diagnostic, in the order reported.
+ * @param[in] context Constant pointer to assembler context handle
+ * @param[in] index Diagnostic index, less than nesla_context_get_diagnostic_count
+ * @return Constant pointer to diagnostic context, or NULL
+ */
+const nesla_diagnostic_t *nesla_context_get_diagnostic(const nesla_context_t *context, size_t index);
+
+/*!
+ * @brief Get assembler context handle diagnostic count. Storage is bounded, so once it is full, the assembly stops
+ *        and later diagnostics are counted but not kept.
+ * @param[in] context Constant pointer to assembler context handle
+ * @param[in] level Diagnostic level, or NESLA_DIAGNOSTIC_MAX for the number of diagnostics kept
+ * @return Diagnostic count
+ */
+size_t nesla_context_get_diagnostic_count(const nesla_context_t *context, nesla_diagnostic_e level);
+
+/*!
+ * @brief Get assembler context handle flags.
+ * @param[in] context Constant pointer to assembler context handle
+ * @return Assembly flags (nesla_flag_e bitmask)
+ */
+uint32_t nesla_context_get_flags(const nesla_context_t *context);
+
+/*!
+ * @brief Get assembler context handle tile map, for the last assembly with NESLA_FLAG_TILE: 256 bytes per character pattern
+ *        table, the index of the first copy of each tile, as written to the .map file.
+ * @param[in] context Constant pointer to assembler context handle
+ * @param[out] length Pointer to tile map length in bytes
+ * @return Constant pointer to tile map, owned by the context handle, or NULL if tiles were not merged
+ */
+const uint8_t *nesla_context_get_map(const nesla_context_t *context, size_t *length);
+
+/*!
+ * @brief Get assembler context handle statistics, for the last assembly.
+ * @param[in] context Constant pointer to assembler context handle
+ * @return Constant pointer to statistics context
+ */
+const nesla_statistics_t *nesla_context_get_statistics(const nesla_context_t *context);
+
+/*!
+ * @brief Release memory allocated by an assembler context handle.
+ * @param[in,out] context Pointer to assembler context handle
+ * @param[in,out] data Pointer to memory
+ */
+void nesla_context_release(nesla_context_t *context, void *data);
+
+/*!
+ * @brief Set assembler context handle compression cache directory, kept across assemblies. Blocks compressed by .PACK are
+ *        cached there by content, so later assemblies skip compressing them again.
+ * @param[in,out] context Pointer to assembler context handle
+ * @param[in] directory Constant pointer to cache directory string, owned by the caller, or NULL to disable the cache
+ */
+void nesla_context_set_cache(nesla_context_t *context, const char *directory);
+
+/*!
+ * @brief Set assembler context handle flags, kept across assemblies.
+ * @param[in,out] context Pointer to assembler context handle
+ * @param[in] flags Assembly flags (nesla_flag_e bitmask)
+ */
+void nesla_context_set_flags(nesla_context_t *context, uint32_t flags);
+
+/*!
+ * @brief Get error string, set by the last call to nesla or nesla_buffer on the calling thread, or empty if it succeeded.
  * @return Constant pointer to error string
  */
 const char *nesla_get_error(void);
@@ -0,0 +1,122 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file opcode.h
+ * @brief Opcode matrix.
+ */
+
+#ifndef NESLA_OPCODE_H_
+#define NESLA_OPCODE_H_
+
+#include <common.h>
+
+/*!
+ * @enum nesla_mode_e
+ * @brief Instruction addressing mode.
+ */
+typedef enum {
+    MODE_IMPLIED = 0,                   /*!< Implied mode */
+    MODE_ACCUMULATOR,                   /*!< Accumulator mode */
+    MODE_IMMEDIATE,                     /*!< Immediate mode */
+    MODE_ZERO_PAGE,                     /*!< Zero-page mode */
+    MODE_ZERO_PAGE_X,                   /*!< Zero-page index-x mode */
+    MODE_ZERO_PAGE_Y,                   /*!< Zero-page index-y mode */
+    MODE_ABSOLUTE,                      /*!< Absolute mode */
+    MODE_ABSOLUTE_X,                    /*!< Absolute index-x mode */
+    MODE_ABSOLUTE_Y,                    /*!< Absolute index-y mode */
+    MODE_INDIRECT,                      /*!< Indirect mode */
+    MODE_INDIRECT_X,                    /*!< Indexed indirect mode */
+    MODE_INDIRECT_Y,                    /*!< Indirect indexed mode */
+    MODE_RELATIVE,                      /*!< Relative mode */
+    MODE_MAX,                           /*!< Max mode */
+} nesla_mode_e;
+
+/*!
+ * @enum nesla_penalty_e
+ * @brief Opcode cycle penalty type.
+ */
+typedef enum {
+    PENALTY_NONE = 0,                   /*!< No penalty */
+    PENALTY_PAGE,                       /*!< One cycle if the indexed address crosses a page */
+    PENALTY_BRANCH,                     /*!< One cycle if taken, and another if the target is on another page */
+    PENALTY_MAX,                        /*!< Max penalty */
+} nesla_penalty_e;
+
+/*!
+ * @struct nesla_opcode_t
+ * @brief Opcode context, for one instruction and addressing mode.
+ */
+typedef struct {
+    uint8_t valid;                      /*!< Combination is valid */
+    uint8_t opcode;                     /*!< Opcode byte */
+    uint8_t length;                     /*!< Instruction length in bytes, including the opcode */
+    uint8_t cycles;                     /*!< Base cycle count */
+    uint8_t penalty;                    /*!< Cycle penalty type */
+} nesla_opcode_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Decode opcode byte into its instruction and addressing mode.
+ * @param[in] opcode Opcode byte
+ * @param[in,out] instruction Pointer to instruction type
+ * @param[in,out] mode Pointer to addressing mode
+ * @return true if the opcode is valid, false otherwise
+ */
+bool nesla_opcode_decode(uint8_t opcode, nesla_instruction_e *instruction, nesla_mode_e *mode);
+
+/*!
+ * @brief Get opcode context, for an instruction and addressing mode.
+ * @param[in] instruction Instruction type
+ * @param[in] mode Addressing mode
+ * @return Constant pointer to opcode context, which is not valid for unsupported combinations
+ */
+const nesla_opcode_t *nesla_opcode_get(nesla_instruction_e instruction, nesla_mode_e mode);
+
+/*!
+ * @brief Get instruction name.
+ * @param[in] instruction Instruction type
+ * @return Constant pointer to instruction name
+ */
+const char *nesla_opcode_get_instruction(nesla_instruction_e instruction);
+
+/*!
+ * @brief Get addressing mode name.
+ * @param[in] mode Addressing mode
+ * @return Constant pointer to addressing mode name
+ */
+const char *nesla_opcode_get_mode(nesla_mode_e mode);
+
+/*!
+ * @brief Invert branch instruction condition.
+ * @param[in] instruction Instruction type
+ * @return Branch instruction taken on the opposite condition, or INSTRUCTION_MAX if not a branch
+ */
+nesla_instruction_e nesla_opcode_invert(nesla_instruction_e instruction);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* NESLA_OPCODE_H_ */
@@ -0,0 +1,81 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*!
+ * @file pack.h
+ * @brief Packed data compression and decompressors.
+ */
+
+#ifndef NESLA_PACK_H_
+#define NESLA_PACK_H_
+
+#include <encoder.h>
+
+#define PACK_BLOCK_MAX 128              /*!< Maximum packed blocks per compression mode, indexed through a table of words */
+#define PACK_LITERAL_MAX 127            /*!< Maximum literal bytes per control byte */
+#define PACK_MATCH_MAX 130              /*!< Maximum LZ match length in bytes */
+#define PACK_MATCH_MIN 3                /*!< Minimum LZ match length in bytes */
+#define PACK_RUN_MAX 128                /*!< Maximum run length in bytes */
+#define PACK_RUN_MIN 3                  /*!< Minimum run length in bytes */
+#define PACK_WINDOW 256                 /*!< LZ match window in bytes, behind the next byte written */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Free encoder context packed blocks, joining their worker threads first.
+ * @param[in,out] encoder Pointer to encoder context
+ */
+void nesla_pack_free(nesla_encoder_t *encoder);
+
+/*!
+ * @brief Link encoder context packed blocks (.PACK), once every worker thread is joined and before RAM is allocated. The
+ *        compressed data of each block is set in its statement, and a relocatable section pinned to the last (fixed) bank
+ *        is added, holding a table of the block addresses and a decompressor for each compression mode used. A decompressor
+ *        takes the block index in X, and writes the block to the address in the destination pointer (UNPACK_DST), which must
+ *        be readable for LZ. The bank holding the block must be switched in by the caller. The blocks are reported as a note.
+ *        Fails if a block was never compressed, such as an empty block, which was reported when it was closed.
+ * @param[in,out] encoder Pointer to encoder context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_pack_link(nesla_encoder_t *encoder);
+
+/*!
+ * @brief Start compressing encoder context packed block. Both formats are a run of packets, each led by a control byte: 0
+ *        ends the block, 1 to 127 is followed by as many literal bytes, and $80 and up repeats bytes. For RLE, the low bits
+ *        plus one give a run length, of the byte that follows. For LZ, the low bits plus three give a match length, copied
+ *        from the distance plus one, held in the byte that follows, behind the next byte written. If a compression cache
+ *        directory is set (see nesla_context_set_cache), a block found there, under the hash of its data, is read back and
+ *        checked. Any other block is queued for the worker thread pool, started by the first block with a worker per online
+ *        processor, or compressed on the calling thread if no worker can be started, and written to the cache.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in,out] pack Pointer to packed block context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_pack_start(nesla_encoder_t *encoder, nesla_packed_t *pack);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* NESLA_PACK_H_ */
@@ -0,0 +1,60 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*!
+ * @file peephole.h
+ * @brief Peephole optimizer.
+ */
+
+#ifndef NESLA_PEEPHOLE_H_
+#define NESLA_PEEPHOLE_H_
+
+#include <encoder.h>
+
+#define PEEPHOLE_CHAIN_MAX 16           /*!< Maximum number of jumps followed through a jump chain */
+#define PEEPHOLE_RAM_END 0x2000         /*!< End of internal RAM (and its mirrors) */
+#define PEEPHOLE_WRAM_BEGIN 0x6000      /*!< Beginning of cartridge RAM */
+#define PEEPHOLE_WRAM_END 0x8000        /*!< End of cartridge RAM */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Optimize encoder context instruction stream, once all symbols are bound and before layout. Statements are rewritten
+ *        in place, or removed by giving them a length of zero, and each rewrite is reported as a note:
+ *        - JSR followed by RTS becomes JMP (tail call), dropping the RTS unless it is a label target.
+ *        - LDA/LDX/LDY of the RAM location just stored from the same register is dropped, if the flags already reflect it.
+ *        - CLC/SEC is dropped where the carry is already known to be clear/set.
+ *        - JMP, JSR and branches to a JMP (or to the same branch) are retargeted to the final destination.
+ *        Statements following a label are only entered through it, so no rewrite spans a label. Statements under .NOOPT are
+ *        left alone.
+ * @param[in,out] encoder Pointer to encoder context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_peephole_optimize(nesla_encoder_t *encoder);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* NESLA_PEEPHOLE_H_ */
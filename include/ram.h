@@ -0,0 +1,59 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*!
+ * @file ram.h
+ * @brief RAM variable allocator.
+ */
+
+#ifndef NESLA_RAM_H_
+#define NESLA_RAM_H_
+
+#include <encoder.h>
+
+#define RAM_END 0x0800                  /*!< End of internal RAM */
+#define RAM_PAGE_SIZE 0x0100            /*!< Page size, indexed reads past a page boundary take an extra cycle */
+#define RAM_STACK_BEGIN 0x0100          /*!< Beginning of the stack (page 1) */
+#define RAM_STACK_END 0x0200            /*!< End of the stack (page 1) */
+#define RAM_ZERO_PAGE_END 0x0100        /*!< End of zero page */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Place encoder context variables (.RESV) in RAM, once every reference is known and before layout. Variables are placed
+ *        in the RAM regions given (.RESV), or in internal RAM outside of the stack if none are. Variables referenced as a
+ *        pointer, through (zp),Y or (zp,X), are placed in zero page first. The others are placed in order of references per
+ *        byte, so the most referenced fill zero page, where each access saves a byte and a cycle, and the rest fill the
+ *        regions above it. The names of the variable bytes are then given their addresses, and the placement is reported as
+ *        a note.
+ * @param[in,out] encoder Pointer to encoder context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_ram_allocate(nesla_encoder_t *encoder);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* NESLA_RAM_H_ */
@@ -0,0 +1,57 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*!
+ * @file stack.h
+ * @brief Hardware stack depth analysis.
+ */
+
+#ifndef NESLA_STACK_H_
+#define NESLA_STACK_H_
+
+#include <graph.h>
+
+#define STACK_FRAME_CALL 2              /*!< Bytes pushed by JSR (return address) */
+#define STACK_FRAME_INTERRUPT 3         /*!< Bytes pushed by an interrupt or BRK (return address and status) */
+#define STACK_SIZE 256                  /*!< Stack size in bytes (page 1) */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Check encoder context stack budget (.STACK), once fixups are patched. The most bytes pushed is found from the reset,
+ *        NMI and IRQ vectors, through JSR calls (PHA/PHP push a byte, PLA/PLP pull one, JSR pushes a return address, BRK pushes
+ *        an interrupt frame and TXS starts an empty stack). The worst case is the deepest point of the reset code, interrupted
+ *        by the IRQ handler at its deepest point, interrupted in turn by the NMI handler. Usage over budget is reported as a
+ *        warning, and usage within budget as a note. Recursion, indirect jumps and loops that push on every pass are reported
+ *        as errors.
+ * @param[in,out] encoder Pointer to encoder context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_stack_check(nesla_encoder_t *encoder);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* NESLA_STACK_H_ */
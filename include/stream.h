@@ -45,9 +45,11 @@ typedef enum {
  * @brief Stream context.
  */
 typedef struct {
-    nesla_reader_t reader;  /*!< Reader context */
-    uint8_t character;      /*!< Current character */
-    size_t line;            /*!< Current line */
+    nesla_reader_t reader;      /*!< Reader context */
+    nesla_context_t *context;   /*!< Assembler context */
+    uint8_t character;          /*!< Current character */
+    size_t line;                /*!< Current line */
+    size_t column;              /*!< Current column */
 } nesla_stream_t;
 
 #ifdef __cplusplus
@@ -61,6 +63,13 @@ extern "C" {
  */
 uint8_t nesla_stream_get(const nesla_stream_t *stream);
 
+/*!
+ * @brief Get stream context column.
+ * @param[in,out] stream Constant pointer to stream context
+ * @return Stream column
+ */
+size_t nesla_stream_get_column(const nesla_stream_t *stream);
+
 /*!
  * @brief Get stream context line.
  * @param[in,out] stream Constant pointer to stream context
@@ -85,10 +94,30 @@ nesla_character_e nesla_stream_get_type(const nesla_stream_t *stream);
 /*!
  * @brief Initialize stream context.
  * @param[in,out] stream Pointer to stream context
+ * @param[in,out] context Pointer to assembler context
  * @param[in] path Constant pointer to file path
  * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
  */
-nesla_error_e nesla_stream_initialize(nesla_stream_t *stream, const char *path);
+nesla_error_e nesla_stream_initialize(nesla_stream_t *stream, nesla_context_t *context, const char *path);
+
+/*!
+ * @brief Initialize stream context with a caller owned buffer.
+ * @param[in,out] stream Pointer to stream context
+ * @param[in,out] context Pointer to assembler context
+ * @param[in] path Constant pointer to buffer name, used as the file path
+ * @param[in] data Constant pointer to buffer data
+ * @param[in] length Buffer length in bytes
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+nesla_error_e nesla_stream_initialize_buffer(nesla_stream_t *stream, nesla_context_t *context, const char *path, const uint8_t *data,
+    size_t length);
+
+/*!
+ * @brief Determine if stream context failed to read its file, rather than reaching its end.
+ * @param[in] stream Constant pointer to stream context
+ * @return true if a read failed, false otherwise
+ */
+bool nesla_stream_is_failed(const nesla_stream_t *stream);
 
 /*!
  * @brief Move stream context to next character.
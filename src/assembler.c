@@ -0,0 +1,1441 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file assembler.c
+ * @brief Token assembler.
+ */
+
+#include <assembler.h>
+
+#define ASSEMBLER_DEPTH_MAX 32  /*!< Maximum include depth */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Move assembler context to the next token on the same line, and verify its type.
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in] type Expected token type
+ * @param[in,out] token Pointer to token context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_assembler_expect(nesla_assembler_t *assembler, nesla_token_e type, nesla_token_t **token)
+{
+    nesla_token_t *current;
+    nesla_error_e result;
+
+    if((result = nesla_lexer_get(assembler->lexer, &current)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if(((result = nesla_lexer_peek(assembler->lexer, token)) == NESLA_FAILURE)
+            || (nesla_token_get_type(*token) != type)
+            || (nesla_token_get_line(*token) != nesla_token_get_line(current))) {
+        result = SET_ERROR_AT(assembler->context, nesla_token_get_path(current), nesla_token_get_line(current),
+            nesla_token_get_column(current), "Expecting token: %i", type);
+        goto exit;
+    }
+
+    result = nesla_lexer_next(assembler->lexer);
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Check if the next assembler context token on the same line has a given type and subtype, moving past it if found.
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in] type Token type
+ * @param[in] subtype Token subtype, or -1 for any subtype
+ * @param[in,out] token Pointer to token context
+ * @return true if a matching token was found, false otherwise
+ */
+static bool nesla_assembler_match(nesla_assembler_t *assembler, nesla_token_e type, int subtype, nesla_token_t **token)
+{
+    bool result = false;
+    nesla_token_t *current, *next;
+
+    if((nesla_lexer_get(assembler->lexer, &current) == NESLA_SUCCESS)
+            && (nesla_lexer_peek(assembler->lexer, &next) == NESLA_SUCCESS)
+            && (nesla_token_get_type(next) == type)
+            && ((subtype < 0) || (nesla_token_get_subtype(next) == subtype))
+            && (nesla_token_get_line(next) == nesla_token_get_line(current))) {
+
+        if((result = (nesla_lexer_next(assembler->lexer) == NESLA_SUCCESS))) {
+            *token = next;
+        }
+    }
+
+    return result;
+}
+
+/*!
+ * @brief Move assembler context to the next token on the same line, and verify its type and subtype.
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in] type Expected token type
+ * @param[in] subtype Expected token subtype
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_assembler_expect_subtype(nesla_assembler_t *assembler, nesla_token_e type, int subtype)
+{
+    nesla_token_t *token;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(!nesla_assembler_match(assembler, type, subtype, &token)
+            && (nesla_lexer_get(assembler->lexer, &token) == NESLA_SUCCESS)) {
+        result = SET_ERROR_AT(assembler->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Expecting token: %i (subtype %i)", type, subtype);
+    }
+
+    return result;
+}
+
+/*!
+ * @brief Move assembler context to the next token on the same line, and verify it is a value (scalar or identifier).
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in,out] token Pointer to token context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_assembler_expect_value(nesla_assembler_t *assembler, nesla_token_t **token)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(!nesla_assembler_match(assembler, TOKEN_SCALAR, -1, token)
+            && !nesla_assembler_match(assembler, TOKEN_IDENTIFIER, -1, token)) {
+        result = nesla_assembler_expect(assembler, TOKEN_SCALAR, token);
+    }
+
+    return result;
+}
+
+/*!
+ * @brief Check if the next assembler context token is a seperator on the same line, moving past it if found.
+ * @param[in,out] assembler Pointer to assembler context
+ * @return true if a seperator was found, false otherwise
+ */
+static bool nesla_assembler_expect_seperator(nesla_assembler_t *assembler)
+{
+    nesla_token_t *token;
+
+    return nesla_assembler_match(assembler, TOKEN_SYMBOL, SYMBOL_SEPERATOR, &token);
+}
+
+/*!
+ * @brief Advance assembler context origin past placed data.
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in] token Constant pointer to statement token context
+ * @param[in] length Placed data length in bytes
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_assembler_advance(nesla_assembler_t *assembler, const nesla_token_t *token, size_t length)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(length > (UINT16_MAX - assembler->origin) + 1) {
+        result = SET_ERROR_AT(assembler->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Origin overflow: %04X+%zu", assembler->origin, length);
+        goto exit;
+    }
+
+    assembler->origin += length;
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Resolve include path, either through the caller defined resolver, or relative to the directory of the file
+ *        containing a token.
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in] token Constant pointer to token context
+ * @param[in] path Constant pointer to path
+ * @param[in,out] resolved Pointer to resolved path
+ * @param[in,out] data Pointer to resolved data, or NULL if the path should be read from disk
+ * @param[in,out] length Pointer to resolved data length in bytes
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_assembler_resolve(nesla_assembler_t *assembler, const nesla_token_t *token, const char *path,
+    const char **resolved, const uint8_t **data, size_t *length)
+{
+    size_t size;
+    char *directory = NULL, *buffer = NULL;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    *data = NULL;
+    *length = 0;
+
+    if(assembler->resolve) {
+
+        if(assembler->resolve(path, data, length, assembler->user) == NESLA_FAILURE) {
+            result = SET_ERROR_AT(assembler->context, nesla_token_get_path(token), nesla_token_get_line(token),
+                nesla_token_get_column(token), "Failed to resolve include: %s", path);
+            goto exit;
+        }
+
+        if(!(buffer = nesla_context_duplicate(assembler->context, path))) {
+            result = SET_ERROR(assembler->context, "Failed to allocate path: %s", path);
+            goto exit;
+        }
+    } else {
+
+        if(!(directory = nesla_context_duplicate(assembler->context, nesla_token_get_path(token)))) {
+            result = SET_ERROR(assembler->context, "Failed to allocate path: %s", path);
+            goto exit;
+        }
+
+        size = strlen(directory) + strlen(path) + 2;
+
+        if(!(buffer = nesla_context_allocate(assembler->context, size * sizeof(*buffer)))) {
+            result = SET_ERROR(assembler->context, "Failed to allocate path: %s", path);
+            goto exit;
+        }
+
+        if(path[0] == '/') {
+            snprintf(buffer, size, "%s", path);
+        } else {
+            snprintf(buffer, size, "%s/%s", dirname(directory), path);
+        }
+    }
+
+    if((result = nesla_list_insert(&assembler->path, assembler->context, nesla_list_get_tail(&assembler->path), buffer)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    *resolved = buffer;
+    buffer = NULL;
+
+exit:
+    nesla_context_free(assembler->context, directory);
+    nesla_context_free(assembler->context, buffer);
+
+    return result;
+}
+
+/*!
+ * @brief Parse assembler align directive (.ALIGN <alignment>|PAGE), aligning the statements that follow, or keeping the
+ *        relocatable section within a page.
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in] directive Constant pointer to directive token context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_assembler_parse_align(nesla_assembler_t *assembler, const nesla_token_t *directive)
+{
+    uint16_t align = 0;
+    bool page = false;
+    nesla_token_t *token;
+    nesla_error_e result;
+
+    if(nesla_assembler_match(assembler, TOKEN_SCALAR, -1, &token)) {
+        align = nesla_token_get_scalar(token);
+    } else if((result = nesla_assembler_expect(assembler, TOKEN_IDENTIFIER, &token)) == NESLA_FAILURE) {
+        goto exit;
+    } else if(!(page = !strcmp((const char *)nesla_literal_get(nesla_token_get_literal(token)), "PAGE"))) {
+        result = SET_ERROR_AT(assembler->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Unsupported alignment: %s", nesla_literal_get(nesla_token_get_literal(token)));
+        goto exit;
+    }
+
+    result = nesla_encoder_set_align(&assembler->encoder, token, assembler->bank, align, page, &assembler->origin);
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Parse assembler budget directive (.BUDGET <cycles>[, <label>]).
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in] directive Constant pointer to directive token context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_assembler_parse_budget(nesla_assembler_t *assembler, const nesla_token_t *directive)
+{
+    nesla_token_t *cycles, *symbol = NULL;
+    nesla_error_e result;
+
+    if((result = nesla_assembler_expect(assembler, TOKEN_SCALAR, &cycles)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if(nesla_assembler_expect_seperator(assembler)
+            && ((result = nesla_assembler_expect(assembler, TOKEN_IDENTIFIER, &symbol)) == NESLA_FAILURE)) {
+        goto exit;
+    }
+
+    result = nesla_encoder_put_budget(&assembler->encoder, directive, symbol, nesla_token_get_scalar(cycles));
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Parse assembler data directive (.BYTE/.WORD <value>[, <value>...]).
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in] directive Constant pointer to directive token context
+ * @param[in] width Item width in bytes (1 or 2)
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_assembler_parse_data(nesla_assembler_t *assembler, const nesla_token_t *directive, size_t width)
+{
+    nesla_error_e result;
+
+    do {
+        size_t length = 0;
+        nesla_token_t *token;
+
+        if(!nesla_assembler_match(assembler, TOKEN_LITERAL, -1, &token)
+                && ((result = nesla_assembler_expect_value(assembler, &token)) == NESLA_FAILURE)) {
+            goto exit;
+        }
+
+        if((result = nesla_encoder_put_data(&assembler->encoder, directive, assembler->bank, assembler->origin, token, width, &length))
+                == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        if((result = nesla_assembler_advance(assembler, directive, length)) == NESLA_FAILURE) {
+            goto exit;
+        }
+    } while(nesla_assembler_expect_seperator(assembler));
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Parse assembler define directive (.DEF <identifier> <value>).
+ * @param[in,out] assembler Pointer to assembler context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_assembler_parse_define(nesla_assembler_t *assembler)
+{
+    nesla_token_t *operand, *token;
+    nesla_error_e result;
+
+    if((result = nesla_assembler_expect(assembler, TOKEN_IDENTIFIER, &token)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if((result = nesla_assembler_expect_value(assembler, &operand)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    result = nesla_encoder_define_constant(&assembler->encoder, token, operand);
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Parse assembler header directive (.CHR, .MAP, .MIR, .PRG).
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in] type Header field type
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_assembler_parse_header(nesla_assembler_t *assembler, nesla_header_e type)
+{
+    uint8_t value;
+    nesla_token_t *token;
+    nesla_error_e result;
+
+    if((result = nesla_assembler_expect(assembler, TOKEN_SCALAR, &token)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if((value = nesla_image_get_header(&assembler->image, type)) && (value != nesla_token_get_scalar(token))) {
+        SET_WARNING_AT(assembler->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Header redefined: %u (was %u)", nesla_token_get_scalar(token), value);
+    }
+
+    if((result = nesla_image_set_header(&assembler->image, type, nesla_token_get_scalar(token))) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Parse assembler include binary directive (.INCB "path"[, offset[, length]]).
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in] directive Constant pointer to directive token context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_assembler_parse_include_binary(nesla_assembler_t *assembler, const nesla_token_t *directive)
+{
+    const char *path;
+    nesla_token_t *token;
+    nesla_binary_t binary = {};
+    const uint8_t *data = NULL;
+    size_t length = 0, offset = 0, placed = 0, size = 0;
+    nesla_error_e result;
+
+    if((result = nesla_assembler_expect(assembler, TOKEN_LITERAL, &token)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if((result = nesla_assembler_resolve(assembler, directive, (const char *)nesla_literal_get(nesla_token_get_literal(token)),
+            &path, &data, &size)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if(nesla_assembler_expect_seperator(assembler)) {
+
+        if((result = nesla_assembler_expect(assembler, TOKEN_SCALAR, &token)) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        offset = nesla_token_get_scalar(token);
+
+        if(nesla_assembler_expect_seperator(assembler)) {
+
+            if((result = nesla_assembler_expect(assembler, TOKEN_SCALAR, &token)) == NESLA_FAILURE) {
+                goto exit;
+            }
+
+            if(!(length = nesla_token_get_scalar(token))) {
+                result = SET_ERROR_AT(assembler->context, nesla_token_get_path(token), nesla_token_get_line(token),
+                    nesla_token_get_column(token), "Invalid length: %zu", length);
+                goto exit;
+            }
+        }
+    }
+
+    if(data) {
+        result = nesla_binary_open_buffer(&binary, assembler->context, path, data, size, offset, length);
+    } else {
+        result = nesla_binary_open(&binary, assembler->context, path, offset, length);
+    }
+
+    if(result == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    placed = nesla_binary_get_length(&binary);
+
+    if(nesla_encoder_is_packing(&assembler->encoder)) {
+        result = nesla_encoder_put_packed(&assembler->encoder, directive, nesla_binary_get(&binary), placed);
+        goto exit;
+    }
+
+    if((result = nesla_image_put_binary(&assembler->image, assembler->bank, assembler->origin, &binary)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if((result = nesla_assembler_advance(assembler, directive, placed)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+exit:
+    nesla_binary_close(&binary);
+
+    return result;
+}
+
+static nesla_error_e nesla_assembler_open(nesla_assembler_t *assembler, const char *path, const uint8_t *data, size_t length);
+
+/*!
+ * @brief Parse assembler include directive (.INC "path").
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in] directive Constant pointer to directive token context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_assembler_parse_include(nesla_assembler_t *assembler, const nesla_token_t *directive)
+{
+    const char *path;
+    nesla_token_t *token;
+    const uint8_t *data = NULL;
+    size_t length = 0;
+    nesla_error_e result;
+
+    if((result = nesla_assembler_expect(assembler, TOKEN_LITERAL, &token)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if((result = nesla_assembler_resolve(assembler, directive, (const char *)nesla_literal_get(nesla_token_get_literal(token)),
+            &path, &data, &length)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if(assembler->depth >= ASSEMBLER_DEPTH_MAX) {
+        result = SET_ERROR_AT(assembler->context, nesla_token_get_path(directive), nesla_token_get_line(directive),
+            nesla_token_get_column(directive), "Include depth exceeded: %s", path);
+        goto exit;
+    }
+
+    if((result = nesla_assembler_open(assembler, path, data, length)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Parse assembler instruction (INSTRUCTION [A|#[<|>]<value>|<value>[, X|Y]|(<value>)|(<value>, X)|(<value>), Y]).
+ *        The immediate value is taken whole, or as its low (<) or high (>) byte.
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in] instruction Constant pointer to instruction token context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_assembler_parse_instruction(nesla_assembler_t *assembler, const nesla_token_t *instruction)
+{
+    size_t length = 0;
+    nesla_mode_e mode = MODE_IMPLIED;
+    nesla_fixup_e type = FIXUP_BYTE;
+    nesla_token_t *operand = NULL, *token;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(nesla_assembler_match(assembler, TOKEN_OPERAND, OPERAND_ACCUMULATOR, &token)) {
+        mode = MODE_ACCUMULATOR;
+    } else if(nesla_assembler_match(assembler, TOKEN_SYMBOL, SYMBOL_IMMEDIATE, &token)) {
+        mode = MODE_IMMEDIATE;
+
+        if(nesla_assembler_match(assembler, TOKEN_SYMBOL, SYMBOL_LOW, &token)) {
+            type = FIXUP_LOW;
+        } else if(nesla_assembler_match(assembler, TOKEN_SYMBOL, SYMBOL_HIGH, &token)) {
+            type = FIXUP_HIGH;
+        }
+
+        result = nesla_assembler_expect_value(assembler, &operand);
+    } else if(nesla_assembler_match(assembler, TOKEN_SYMBOL, SYMBOL_INDIRECT_OPEN, &token)) {
+
+        if((result = nesla_assembler_expect_value(assembler, &operand)) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        if(nesla_assembler_expect_seperator(assembler)) {
+            mode = MODE_INDIRECT_X;
+
+            if((result = nesla_assembler_expect_subtype(assembler, TOKEN_OPERAND, OPERAND_INDEX_X)) == NESLA_FAILURE) {
+                goto exit;
+            }
+
+            result = nesla_assembler_expect_subtype(assembler, TOKEN_SYMBOL, SYMBOL_INDIRECT_CLOSE);
+        } else {
+            mode = MODE_INDIRECT;
+
+            if((result = nesla_assembler_expect_subtype(assembler, TOKEN_SYMBOL, SYMBOL_INDIRECT_CLOSE)) == NESLA_FAILURE) {
+                goto exit;
+            }
+
+            if(nesla_assembler_expect_seperator(assembler)) {
+                mode = MODE_INDIRECT_Y;
+                result = nesla_assembler_expect_subtype(assembler, TOKEN_OPERAND, OPERAND_INDEX_Y);
+            }
+        }
+    } else if(nesla_assembler_match(assembler, TOKEN_SCALAR, -1, &operand)
+            || nesla_assembler_match(assembler, TOKEN_IDENTIFIER, -1, &operand)) {
+        mode = MODE_ABSOLUTE;
+
+        if(nesla_assembler_expect_seperator(assembler)) {
+
+            if((result = nesla_assembler_expect(assembler, TOKEN_OPERAND, &token)) == NESLA_FAILURE) {
+                goto exit;
+            }
+
+            mode = (nesla_token_get_subtype(token) == OPERAND_INDEX_Y) ? MODE_ABSOLUTE_Y : MODE_ABSOLUTE_X;
+        }
+    }
+
+    if(result == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if((result = nesla_encoder_put_instruction(&assembler->encoder, instruction, assembler->bank, assembler->origin, mode, operand,
+            type, &length)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if((result = nesla_assembler_advance(assembler, instruction, length)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Parse assembler keep directive (.KEEP <label>[, <label>...]).
+ * @param[in,out] assembler Pointer to assembler context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_assembler_parse_keep(nesla_assembler_t *assembler)
+{
+    nesla_error_e result;
+
+    do {
+        nesla_token_t *token;
+
+        if((result = nesla_assembler_expect(assembler, TOKEN_IDENTIFIER, &token)) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        if((result = nesla_encoder_put_keep(&assembler->encoder, token)) == NESLA_FAILURE) {
+            goto exit;
+        }
+    } while(nesla_assembler_expect_seperator(assembler));
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Parse assembler jump table directive (.JUMP [RTS] <identifier> <entry>[, <entry>...]).
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in] directive Constant pointer to directive token context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_assembler_parse_jump(nesla_assembler_t *assembler, const nesla_token_t *directive)
+{
+    size_t capacity = 0, count = 0, length = 0;
+    const nesla_token_t **entry = NULL;
+    nesla_token_t *name, *token;
+    bool dispatch;
+    nesla_error_e result;
+
+    dispatch = nesla_assembler_match(assembler, TOKEN_INSTRUCTION, INSTRUCTION_RTS, &token);
+
+    if((result = nesla_assembler_expect(assembler, TOKEN_IDENTIFIER, &name)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    do {
+
+        if((result = nesla_assembler_expect_value(assembler, &token)) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        if((result = nesla_context_reserve(assembler->context, (void **)&entry, &capacity, count, sizeof(*entry))) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        entry[count++] = token;
+    } while(nesla_assembler_expect_seperator(assembler));
+
+    if((result = nesla_encoder_put_jump(&assembler->encoder, directive, assembler->bank, assembler->origin, dispatch, name, entry,
+            count, &length)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    result = nesla_assembler_advance(assembler, directive, length);
+
+exit:
+    nesla_context_free(assembler->context, entry);
+
+    return result;
+}
+
+/*!
+ * @brief Parse assembler pack directive (.PACK <mode> <identifier>).
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in] directive Constant pointer to directive token context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_assembler_parse_pack(nesla_assembler_t *assembler, const nesla_token_t *directive)
+{
+    nesla_token_t *mode, *name;
+    nesla_error_e result;
+
+    if(((result = nesla_assembler_expect(assembler, TOKEN_IDENTIFIER, &mode)) == NESLA_FAILURE)
+            || ((result = nesla_assembler_expect(assembler, TOKEN_IDENTIFIER, &name)) == NESLA_FAILURE)) {
+        goto exit;
+    }
+
+    result = nesla_encoder_set_pack(&assembler->encoder, directive, assembler->bank, assembler->origin, mode, name);
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Parse assembler relocate directive (.RELOC [<bank>|<label>]), starting a relocatable section.
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in] directive Constant pointer to directive token context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_assembler_parse_relocate(nesla_assembler_t *assembler, const nesla_token_t *directive)
+{
+    uint16_t pin = ENCODER_RELOCATE_BANK;
+    nesla_token_t *affinity = NULL, *token;
+    nesla_error_e result;
+
+    if(nesla_assembler_match(assembler, TOKEN_IDENTIFIER, -1, &token)) {
+        affinity = token;
+    } else if(nesla_assembler_match(assembler, TOKEN_SCALAR, -1, &token)
+            && ((pin = nesla_token_get_scalar(token)) >= ENCODER_RELOCATE_BANK)) {
+        result = SET_ERROR_AT(assembler->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Invalid bank: %u", pin);
+        goto exit;
+    }
+
+    if((result = nesla_encoder_put_relocation(&assembler->encoder, directive, pin, affinity, &assembler->bank)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    assembler->origin = ENCODER_RELOCATE_ORIGIN;
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Parse assembler reserve directive (.RESV <identifier> <size>[, <identifier>...] or .RESV <first>, <last>).
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in] directive Constant pointer to directive token context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_assembler_parse_reserve(nesla_assembler_t *assembler, const nesla_token_t *directive)
+{
+    uint16_t offset = 0;
+    nesla_token_t *size, *token;
+    nesla_error_e result;
+
+    if(nesla_assembler_match(assembler, TOKEN_SCALAR, -1, &token)) {
+
+        if(!nesla_assembler_expect_seperator(assembler)) {
+            result = nesla_assembler_expect_subtype(assembler, TOKEN_SYMBOL, SYMBOL_SEPERATOR);
+            goto exit;
+        }
+
+        if((result = nesla_assembler_expect(assembler, TOKEN_SCALAR, &size)) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        result = nesla_encoder_put_region(&assembler->encoder, directive, nesla_token_get_scalar(token), nesla_token_get_scalar(size));
+        goto exit;
+    }
+
+    if((result = nesla_assembler_expect(assembler, TOKEN_IDENTIFIER, &token)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if((result = nesla_assembler_expect(assembler, TOKEN_SCALAR, &size)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if(!nesla_token_get_scalar(size)) {
+        result = SET_ERROR_AT(assembler->context, nesla_token_get_path(size), nesla_token_get_line(size), nesla_token_get_column(size),
+            "Invalid variable size: %u", nesla_token_get_scalar(size));
+        goto exit;
+    }
+
+    if((result = nesla_encoder_put_variable(&assembler->encoder, token, nesla_token_get_scalar(size))) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    while(nesla_assembler_expect_seperator(assembler)) {
+
+        if((result = nesla_assembler_expect(assembler, TOKEN_IDENTIFIER, &token)) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        if((result = nesla_encoder_put_variable_byte(&assembler->encoder, token, ++offset)) == NESLA_FAILURE) {
+            goto exit;
+        }
+    }
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Parse assembler structure directive (.SOA <identifier> <count> <field>[, <field>...]), each field an identifier,
+ *        followed by its width in bytes (1 or 2), then by ZP to place it in zero page, or PAGE to keep it within a page.
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in] directive Constant pointer to directive token context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_assembler_parse_structure(nesla_assembler_t *assembler, const nesla_token_t *directive)
+{
+    size_t capacity = 0, count = 0;
+    nesla_field_t *field = NULL;
+    nesla_token_t *entries, *name, *token;
+    nesla_error_e result;
+
+    if(((result = nesla_assembler_expect(assembler, TOKEN_IDENTIFIER, &name)) == NESLA_FAILURE)
+            || ((result = nesla_assembler_expect(assembler, TOKEN_SCALAR, &entries)) == NESLA_FAILURE)) {
+        goto exit;
+    }
+
+    do {
+        nesla_field_t *entry;
+
+        if((result = nesla_context_reserve(assembler->context, (void **)&field, &capacity, count, sizeof(*field))) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        entry = &field[count++];
+        memset(entry, 0, sizeof(*entry));
+        entry->width = 1;
+
+        if((result = nesla_assembler_expect(assembler, TOKEN_IDENTIFIER, &token)) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        entry->token = token;
+
+        if(nesla_assembler_match(assembler, TOKEN_SCALAR, -1, &token)
+                && (((entry->width = nesla_token_get_scalar(token)) < 1) || (entry->width > 2))) {
+            result = SET_ERROR_AT(assembler->context, nesla_token_get_path(token), nesla_token_get_line(token),
+                nesla_token_get_column(token), "Invalid field width: %u", entry->width);
+            goto exit;
+        }
+
+        while(nesla_assembler_match(assembler, TOKEN_IDENTIFIER, -1, &token)) {
+            const char *attribute = (const char *)nesla_literal_get(nesla_token_get_literal(token));
+
+            if(!strcmp(attribute, "ZP")) {
+                entry->zero_page = true;
+            } else if(!strcmp(attribute, "PAGE")) {
+                entry->page = true;
+            } else {
+                result = SET_ERROR_AT(assembler->context, nesla_token_get_path(token), nesla_token_get_line(token),
+                    nesla_token_get_column(token), "Unsupported field attribute: %s", attribute);
+                goto exit;
+            }
+        }
+    } while(nesla_assembler_expect_seperator(assembler));
+
+    result = nesla_encoder_put_structure(&assembler->encoder, directive, name, nesla_token_get_scalar(entries), field, count);
+
+exit:
+    nesla_context_free(assembler->context, field);
+
+    return result;
+}
+
+/*!
+ * @brief Parse assembler table directive (.TABLE <mode> <identifier>[, <identifier>] <first>, <last>, <expression>), placing
+ *        the expression evaluated at each index from first to last. A split table places the low bytes, then the high bytes
+ *        under the second identifier.
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in] directive Constant pointer to directive token context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_assembler_parse_table(nesla_assembler_t *assembler, const nesla_token_t *directive)
+{
+    static const char *MODE[] = { "BYTE", "WORD", "SPLIT", };
+    static const int64_t MINIMUM[] = { INT8_MIN, INT16_MIN, INT16_MIN, };
+    static const int64_t MAXIMUM[] = { UINT8_MAX, UINT16_MAX, UINT16_MAX, };
+    size_t count, length, width;
+    uint8_t *data = NULL;
+    nesla_expression_table_e type = EXPRESSION_TABLE_BYTE;
+    nesla_expression_t expression = {};
+    nesla_token_t *first, *high = NULL, *last, *low, *mode, *source;
+    nesla_error_e result;
+
+    if(((result = nesla_assembler_expect(assembler, TOKEN_IDENTIFIER, &mode)) == NESLA_FAILURE)
+            || ((result = nesla_assembler_expect(assembler, TOKEN_IDENTIFIER, &low)) == NESLA_FAILURE)) {
+        goto exit;
+    }
+
+    while((type < EXPRESSION_TABLE_MAX) && strcmp((const char *)nesla_literal_get(nesla_token_get_literal(mode)), MODE[type])) {
+        ++type;
+    }
+
+    if(type == EXPRESSION_TABLE_MAX) {
+        result = SET_ERROR_AT(assembler->context, nesla_token_get_path(mode), nesla_token_get_line(mode), nesla_token_get_column(mode),
+            "Unsupported table mode: %s", nesla_literal_get(nesla_token_get_literal(mode)));
+        goto exit;
+    }
+
+    if(nesla_assembler_expect_seperator(assembler)
+            && ((result = nesla_assembler_expect(assembler, TOKEN_IDENTIFIER, &high)) == NESLA_FAILURE)) {
+        goto exit;
+    }
+
+    if(!high != (type != EXPRESSION_TABLE_SPLIT)) {
+        result = SET_ERROR_AT(assembler->context, nesla_token_get_path(low), nesla_token_get_line(low), nesla_token_get_column(low),
+            "%s: %s", high ? "High byte name on a table that is not split" : "Split table without a high byte name",
+            nesla_literal_get(nesla_token_get_literal(low)));
+        goto exit;
+    }
+
+    if(((result = nesla_assembler_expect(assembler, TOKEN_SCALAR, &first)) == NESLA_FAILURE)
+            || ((result = nesla_assembler_expect_subtype(assembler, TOKEN_SYMBOL, SYMBOL_SEPERATOR)) == NESLA_FAILURE)
+            || ((result = nesla_assembler_expect(assembler, TOKEN_SCALAR, &last)) == NESLA_FAILURE)
+            || ((result = nesla_assembler_expect_subtype(assembler, TOKEN_SYMBOL, SYMBOL_SEPERATOR)) == NESLA_FAILURE)
+            || ((result = nesla_assembler_expect(assembler, TOKEN_LITERAL, &source)) == NESLA_FAILURE)) {
+        goto exit;
+    }
+
+    if(nesla_token_get_scalar(first) > nesla_token_get_scalar(last)) {
+        result = SET_ERROR_AT(assembler->context, nesla_token_get_path(last), nesla_token_get_line(last), nesla_token_get_column(last),
+            "Invalid table range: %u-%u", nesla_token_get_scalar(first), nesla_token_get_scalar(last));
+        goto exit;
+    }
+
+    if((result = nesla_expression_compile(&expression, &assembler->encoder, source)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    count = (nesla_token_get_scalar(last) - nesla_token_get_scalar(first)) + 1;
+    width = (type == EXPRESSION_TABLE_WORD) ? 2 : 1;
+    length = count * width;
+
+    if(!(data = nesla_context_allocate(assembler->context, count * 2))) {
+        result = SET_ERROR(assembler->context, "Failed to allocate table: %zu", count);
+        goto exit;
+    }
+
+    for(size_t index = 0; index < count; ++index) {
+        int64_t value;
+        uint16_t current = nesla_token_get_scalar(first) + index;
+
+        if((result = nesla_expression_evaluate(&expression, assembler->context, source, current, &value)) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        if((value < MINIMUM[type]) || (value > MAXIMUM[type])) {
+            result = SET_ERROR_AT(assembler->context, nesla_token_get_path(source), nesla_token_get_line(source),
+                nesla_token_get_column(source), "Table value out of range at index %u: %" PRId64, current, value);
+            goto exit;
+        }
+
+        switch(type) {
+            case EXPRESSION_TABLE_BYTE:
+                data[index] = value;
+                break;
+            case EXPRESSION_TABLE_WORD:
+                data[index * 2] = value;
+                data[(index * 2) + 1] = value >> 8;
+                break;
+            default:
+                data[index] = value;
+                data[count + index] = value >> 8;
+                break;
+        }
+    }
+
+    if(((result = nesla_encoder_define(&assembler->encoder, low, assembler->bank, assembler->origin)) == NESLA_FAILURE)
+            || ((result = nesla_encoder_put_table(&assembler->encoder, directive, assembler->bank, assembler->origin, data, length,
+                width)) == NESLA_FAILURE)
+            || ((result = nesla_assembler_advance(assembler, directive, length)) == NESLA_FAILURE)) {
+        goto exit;
+    }
+
+    if(high && (((result = nesla_encoder_define(&assembler->encoder, high, assembler->bank, assembler->origin)) == NESLA_FAILURE)
+            || ((result = nesla_encoder_put_table(&assembler->encoder, directive, assembler->bank, assembler->origin, data + count,
+                count, 1)) == NESLA_FAILURE)
+            || ((result = nesla_assembler_advance(assembler, directive, count)) == NESLA_FAILURE))) {
+        goto exit;
+    }
+
+exit:
+    nesla_context_free(assembler->context, data);
+    nesla_expression_free(&expression, assembler->context);
+
+    return result;
+}
+
+/*!
+ * @brief Parse assembler directive.
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in] directive Constant pointer to directive token context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_assembler_parse_directive(nesla_assembler_t *assembler, const nesla_token_t *directive)
+{
+    nesla_token_t *token;
+    nesla_error_e result;
+
+    switch(nesla_token_get_subtype(directive)) {
+        case DIRECTIVE_ALIGN:
+            result = nesla_assembler_parse_align(assembler, directive);
+            break;
+        case DIRECTIVE_BANK:
+
+            if((result = nesla_assembler_expect(assembler, TOKEN_SCALAR, &token)) == NESLA_FAILURE) {
+                goto exit;
+            }
+
+            if(nesla_token_get_scalar(token) >= ENCODER_RELOCATE_BANK) {
+                result = SET_ERROR_AT(assembler->context, nesla_token_get_path(token), nesla_token_get_line(token),
+                    nesla_token_get_column(token), "Invalid bank: %u", nesla_token_get_scalar(token));
+                goto exit;
+            }
+
+            assembler->bank = nesla_token_get_scalar(token);
+            break;
+        case DIRECTIVE_BUDGET:
+            result = nesla_assembler_parse_budget(assembler, directive);
+            break;
+        case DIRECTIVE_BYTE:
+            result = nesla_assembler_parse_data(assembler, directive, 1);
+            break;
+        case DIRECTIVE_CHARACTER:
+            result = nesla_assembler_parse_header(assembler, HEADER_CHARACTER);
+            break;
+        case DIRECTIVE_DEFINE:
+            result = nesla_assembler_parse_define(assembler);
+            break;
+        case DIRECTIVE_FAR:
+            result = nesla_encoder_set_far(&assembler->encoder, directive);
+            break;
+        case DIRECTIVE_HOT:
+            nesla_encoder_set_hot(&assembler->encoder);
+            result = NESLA_SUCCESS;
+            break;
+        case DIRECTIVE_INCLUDE:
+            result = nesla_assembler_parse_include(assembler, directive);
+            break;
+        case DIRECTIVE_INCLUDE_BINARY:
+            result = nesla_assembler_parse_include_binary(assembler, directive);
+            break;
+        case DIRECTIVE_JUMP:
+            result = nesla_assembler_parse_jump(assembler, directive);
+            break;
+        case DIRECTIVE_KEEP:
+            result = nesla_assembler_parse_keep(assembler);
+            break;
+        case DIRECTIVE_LOOP:
+
+            if((result = nesla_assembler_expect(assembler, TOKEN_SCALAR, &token)) == NESLA_FAILURE) {
+                goto exit;
+            }
+
+            if(!nesla_token_get_scalar(token)) {
+                result = SET_ERROR_AT(assembler->context, nesla_token_get_path(token), nesla_token_get_line(token),
+                    nesla_token_get_column(token), "Invalid loop bound: %u", nesla_token_get_scalar(token));
+                goto exit;
+            }
+
+            nesla_encoder_set_bound(&assembler->encoder, nesla_token_get_scalar(token));
+            break;
+        case DIRECTIVE_MAPPER:
+            result = nesla_assembler_parse_header(assembler, HEADER_MAPPER);
+            break;
+        case DIRECTIVE_MIRROR:
+            result = nesla_assembler_parse_header(assembler, HEADER_MIRROR);
+            break;
+        case DIRECTIVE_NO_OPTIMIZE:
+        case DIRECTIVE_OPTIMIZE:
+            nesla_encoder_set_preserve(&assembler->encoder, nesla_token_get_subtype(directive) == DIRECTIVE_NO_OPTIMIZE);
+            result = NESLA_SUCCESS;
+            break;
+        case DIRECTIVE_ORIGIN:
+
+            if((result = nesla_assembler_expect(assembler, TOKEN_SCALAR, &token)) == NESLA_FAILURE) {
+                goto exit;
+            }
+
+            if(assembler->bank >= ENCODER_RELOCATE_BANK) {
+                result = SET_ERROR_AT(assembler->context, nesla_token_get_path(directive), nesla_token_get_line(directive),
+                    nesla_token_get_column(directive), "Origin in a relocatable section, without a bank");
+                goto exit;
+            }
+
+            assembler->origin = nesla_token_get_scalar(token);
+            break;
+        case DIRECTIVE_PACK:
+            result = nesla_assembler_parse_pack(assembler, directive);
+            break;
+        case DIRECTIVE_PROGRAM:
+            result = nesla_assembler_parse_header(assembler, HEADER_PROGRAM);
+            break;
+        case DIRECTIVE_RELOCATE:
+            result = nesla_assembler_parse_relocate(assembler, directive);
+            break;
+        case DIRECTIVE_RESERVE:
+            result = nesla_assembler_parse_reserve(assembler, directive);
+            break;
+        case DIRECTIVE_STRUCTURE:
+            result = nesla_assembler_parse_structure(assembler, directive);
+            break;
+        case DIRECTIVE_STACK:
+
+            if((result = nesla_assembler_expect(assembler, TOKEN_SCALAR, &token)) == NESLA_FAILURE) {
+                goto exit;
+            }
+
+            if(!nesla_token_get_scalar(token) || (nesla_token_get_scalar(token) > STACK_SIZE)) {
+                result = SET_ERROR_AT(assembler->context, nesla_token_get_path(token), nesla_token_get_line(token),
+                    nesla_token_get_column(token), "Invalid stack budget: %u", nesla_token_get_scalar(token));
+                goto exit;
+            }
+
+            nesla_encoder_set_stack(&assembler->encoder, directive, nesla_token_get_scalar(token));
+            break;
+        case DIRECTIVE_TABLE:
+            result = nesla_assembler_parse_table(assembler, directive);
+            break;
+        case DIRECTIVE_UNDEFINE:
+
+            if((result = nesla_assembler_expect(assembler, TOKEN_IDENTIFIER, &token)) == NESLA_FAILURE) {
+                goto exit;
+            }
+
+            result = nesla_encoder_undefine(&assembler->encoder, token);
+            break;
+        case DIRECTIVE_WORD:
+            result = nesla_assembler_parse_data(assembler, directive, 2);
+            break;
+        default:
+            result = SET_ERROR_AT(assembler->context, nesla_token_get_path(directive), nesla_token_get_line(directive),
+                nesla_token_get_column(directive), "Unsupported directive: %i", nesla_token_get_subtype(directive));
+            break;
+    }
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Check if assembler token adds data to an open packed block (.BYTE/.WORD/.INCB), rather than closing it.
+ * @param[in] token Constant pointer to token context
+ * @return true if the token adds packed data, false otherwise
+ */
+static bool nesla_assembler_is_packed(const nesla_token_t *token)
+{
+    int subtype = nesla_token_get_subtype(token);
+
+    return (nesla_token_get_type(token) == TOKEN_DIRECTIVE)
+        && ((subtype == DIRECTIVE_BYTE) || (subtype == DIRECTIVE_INCLUDE_BINARY) || (subtype == DIRECTIVE_WORD));
+}
+
+/*!
+ * @brief Recover assembler context from a failed statement, by skipping the remaining tokens on its line.
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in] errors Number of errors reported before the failed statement
+ * @param[in] token Constant pointer to statement token context
+ * @return NESLA_ERROR if no more diagnostics can be kept, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_assembler_recover(nesla_assembler_t *assembler, size_t errors, const nesla_token_t *token)
+{
+    nesla_token_t *next;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(nesla_context_get_diagnostic_count(assembler->context, NESLA_DIAGNOSTIC_ERROR) == errors) {
+        SET_ERROR_AT(assembler->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "%s", nesla_context_get_error(assembler->context));
+    }
+
+    if(nesla_context_is_full(assembler->context)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    while((nesla_lexer_peek(assembler->lexer, &next) == NESLA_SUCCESS)
+            && (nesla_token_get_type(next) != TOKEN_END)
+            && (nesla_token_get_line(next) == nesla_token_get_line(token))) {
+        nesla_lexer_next(assembler->lexer);
+    }
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Parse assembler tokens.
+ * @param[in,out] assembler Pointer to assembler context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_assembler_parse(nesla_assembler_t *assembler)
+{
+    nesla_error_e result;
+
+    do {
+        nesla_token_t *token;
+        size_t errors = nesla_context_get_diagnostic_count(assembler->context, NESLA_DIAGNOSTIC_ERROR);
+
+        if((result = nesla_lexer_get(assembler->lexer, &token)) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        if(!nesla_assembler_is_packed(token) && (nesla_encoder_end_pack(&assembler->encoder) == NESLA_FAILURE)
+                && nesla_context_is_full(assembler->context)) {
+            result = NESLA_FAILURE;
+            goto exit;
+        }
+
+        switch(nesla_token_get_type(token)) {
+            case TOKEN_END:
+                goto exit;
+            case TOKEN_DIRECTIVE:
+                result = nesla_assembler_parse_directive(assembler, token);
+                break;
+            case TOKEN_INSTRUCTION:
+                result = nesla_assembler_parse_instruction(assembler, token);
+                break;
+            case TOKEN_LABEL:
+                result = nesla_encoder_define(&assembler->encoder, token, assembler->bank, assembler->origin);
+                break;
+            default:
+                result = SET_ERROR_AT(assembler->context, nesla_token_get_path(token), nesla_token_get_line(token),
+                    nesla_token_get_column(token), "Unsupported token: %i", nesla_token_get_type(token));
+                break;
+        }
+
+        if((result == NESLA_FAILURE)
+                && ((result = nesla_assembler_recover(assembler, errors, token)) == NESLA_FAILURE)) {
+            goto exit;
+        }
+    } while(nesla_lexer_next(assembler->lexer) == NESLA_SUCCESS);
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Open assembler source, from a file or caller owned buffer, and parse its tokens.
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in] path Constant pointer to file path, or buffer name
+ * @param[in] data Constant pointer to buffer data, or NULL to read from file
+ * @param[in] length Buffer length in bytes
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_assembler_open(nesla_assembler_t *assembler, const char *path, const uint8_t *data, size_t length)
+{
+    nesla_lexer_t *lexer, *previous = assembler->lexer;
+    nesla_error_e result;
+
+    if(!(lexer = nesla_context_allocate(assembler->context, sizeof(*lexer)))) {
+        result = SET_ERROR(assembler->context, "Failed to allocate lexer: %s", path);
+        goto exit;
+    }
+
+    if((result = nesla_list_insert(&assembler->source, assembler->context, nesla_list_get_tail(&assembler->source), lexer))
+            == NESLA_FAILURE) {
+        nesla_context_free(assembler->context, lexer);
+        goto exit;
+    }
+
+    if(data) {
+        result = nesla_lexer_initialize_buffer(lexer, assembler->context, path, data, length);
+    } else {
+        result = nesla_lexer_initialize(lexer, assembler->context, path);
+    }
+
+    if(result == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    assembler->lexer = lexer;
+    ++assembler->depth;
+    result = nesla_assembler_parse(assembler);
+    --assembler->depth;
+    assembler->lexer = previous;
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Finish assembler context parse, patching fixups, checking cycle and stack budgets, reporting page crossings and
+ *        placing the encoded statements into the image. Fails if any errors were reported.
+ * @param[in,out] assembler Pointer to assembler context
+ * @param[in] result Parse result
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_assembler_finish(nesla_assembler_t *assembler, nesla_error_e result)
+{
+    size_t index = 0, errors;
+    const nesla_diagnostic_t *diagnostic;
+
+    if(nesla_encoder_end_pack(&assembler->encoder) == NESLA_FAILURE) {
+        result = NESLA_FAILURE;
+    }
+
+    if(result == NESLA_SUCCESS) {
+        ++assembler->context->statistics.pass;
+        nesla_encoder_set_program(&assembler->encoder, nesla_image_get_header(&assembler->image, HEADER_PROGRAM));
+        nesla_encoder_set_mapper(&assembler->encoder, nesla_image_get_header(&assembler->image, HEADER_MAPPER));
+
+        if(((result = nesla_encoder_resolve(&assembler->encoder)) == NESLA_SUCCESS)
+                && !nesla_context_get_diagnostic_count(assembler->context, NESLA_DIAGNOSTIC_ERROR)
+                && ((result = nesla_timing_check(&assembler->encoder)) == NESLA_SUCCESS)
+                && ((result = nesla_stack_check(&assembler->encoder)) == NESLA_SUCCESS)
+                && ((result = nesla_page_check(&assembler->encoder)) == NESLA_SUCCESS)) {
+            result = nesla_encoder_write(&assembler->encoder, &assembler->image);
+        }
+
+        if((result == NESLA_SUCCESS) && (assembler->context->flags & NESLA_FLAG_TILE)) {
+            result = nesla_image_merge_tiles(&assembler->image, &assembler->context->tile, &assembler->context->tile_length,
+                &assembler->context->statistics.merged_tiles);
+        }
+    }
+
+    if(!(errors = nesla_context_get_diagnostic_count(assembler->context, NESLA_DIAGNOSTIC_ERROR))) {
+        goto exit;
+    }
+
+    while((diagnostic = nesla_context_get_diagnostic(assembler->context, index++))) {
+
+        if(diagnostic->level == NESLA_DIAGNOSTIC_ERROR) {
+
+            if(errors > 1) {
+                result = SET_ERROR(assembler->context, "%s (%s@%zu:%zu), and %zu more error(s)", diagnostic->message, diagnostic->path,
+                    diagnostic->line, diagnostic->column, errors - 1);
+            } else {
+                result = SET_ERROR(assembler->context, "%s (%s@%zu:%zu)", diagnostic->message, diagnostic->path, diagnostic->line,
+                    diagnostic->column);
+            }
+            break;
+        }
+    }
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_assembler_initialize(nesla_assembler_t *assembler, nesla_context_t *context, const char *path)
+{
+    assembler->context = context;
+    nesla_context_clear(context);
+    nesla_image_initialize(&assembler->image, context);
+    nesla_encoder_initialize(&assembler->encoder, context);
+
+    return nesla_assembler_finish(assembler, nesla_assembler_open(assembler, path, NULL, 0));
+}
+
+nesla_error_e nesla_assembler_initialize_buffer(nesla_assembler_t *assembler, nesla_context_t *context, const nesla_source_t *source)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    assembler->context = context;
+    nesla_context_clear(context);
+    nesla_image_initialize(&assembler->image, context);
+    nesla_encoder_initialize(&assembler->encoder, context);
+
+    if(!source->data) {
+        result = SET_ERROR(assembler->context, "Invalid source buffer: %s", source->name);
+        goto exit;
+    }
+
+    assembler->resolve = source->resolve;
+    assembler->user = source->context;
+    result = nesla_assembler_finish(assembler, nesla_assembler_open(assembler, source->name ? source->name : "<buffer>", source->data,
+        source->length));
+
+exit:
+    return result;
+}
+
+size_t nesla_assembler_get_size(const nesla_assembler_t *assembler)
+{
+    return nesla_image_get_size(&assembler->image);
+}
+
+void nesla_assembler_uninitialize(nesla_assembler_t *assembler)
+{
+
+    while(nesla_list_get_length(&assembler->source)) {
+        nesla_list_entry_t *entry = nesla_list_get_head(&assembler->source);
+
+        nesla_lexer_uninitialize(entry->context);
+        nesla_context_free(assembler->context, entry->context);
+        nesla_list_remove(&assembler->source, assembler->context, entry);
+    }
+
+    while(nesla_list_get_length(&assembler->path)) {
+        nesla_list_entry_t *entry = nesla_list_get_head(&assembler->path);
+
+        nesla_context_free(assembler->context, entry->context);
+        nesla_list_remove(&assembler->path, assembler->context, entry);
+    }
+
+    nesla_encoder_uninitialize(&assembler->encoder);
+    nesla_image_uninitialize(&assembler->image);
+    memset(assembler, 0, sizeof(*assembler));
+}
+
+nesla_error_e nesla_assembler_write(nesla_assembler_t *assembler, const char *path)
+{
+    nesla_error_e result;
+    nesla_writer_t writer = {};
+
+    if((result = nesla_writer_open(&writer, assembler->context, path, true)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if((result = nesla_image_write(&assembler->image, &writer)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+exit:
+    nesla_writer_close(&writer);
+
+    return result;
+}
+
+nesla_error_e nesla_assembler_write_listing(nesla_assembler_t *assembler, const char *path)
+{
+    nesla_error_e result;
+    nesla_writer_t writer = {};
+
+    if((result = nesla_writer_open(&writer, assembler->context, path, true)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if((result = nesla_listing_write(&assembler->encoder, &writer)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+exit:
+    nesla_writer_close(&writer);
+
+    return result;
+}
+
+nesla_error_e nesla_assembler_write_map(nesla_assembler_t *assembler, const char *path)
+{
+    nesla_error_e result;
+    nesla_writer_t writer = {};
+
+    if((result = nesla_writer_open(&writer, assembler->context, path, true)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if(assembler->context->tile && ((result = nesla_writer_put(&writer, assembler->context->tile, assembler->context->tile_length))
+            == NESLA_FAILURE)) {
+        goto exit;
+    }
+
+exit:
+    nesla_writer_close(&writer);
+
+    return result;
+}
+
+nesla_error_e nesla_assembler_write_buffer(nesla_assembler_t *assembler, uint8_t *data, size_t capacity)
+{
+    nesla_error_e result;
+    nesla_writer_t writer = {};
+
+    if((result = nesla_writer_open_buffer(&writer, assembler->context, "<buffer>", data, capacity)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if((result = nesla_image_write(&assembler->image, &writer)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+exit:
+    nesla_writer_close(&writer);
+
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
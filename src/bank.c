@@ -0,0 +1,887 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file bank.c
+ * @brief Program bank placement.
+ */
+
+#include <bank.h>
+#include <page.h>
+
+#define BANK_UNPLACED UINT16_MAX        /*!< Group not placed in a bank yet */
+
+/*!
+ * @struct nesla_bank_span_t
+ * @brief Program bank span, of offsets into a bank.
+ */
+typedef struct {
+    uint32_t bank;                      /*!< Bank index */
+    uint32_t begin;                     /*!< First offset */
+    uint32_t end;                       /*!< Offset past the last offset */
+} nesla_bank_span_t;
+
+/*!
+ * @struct nesla_bank_call_t
+ * @brief Program bank calls, between two nodes: a relocatable section (by its index), or the code placed in a bank by hand
+ *        (by the relocatable section count, plus its bank index).
+ */
+typedef struct {
+    uint32_t source;                    /*!< Calling node */
+    uint32_t target;                    /*!< Called node */
+    uint32_t count;                     /*!< Call count */
+} nesla_bank_call_t;
+
+/*!
+ * @struct nesla_bank_group_t
+ * @brief Program bank group, of relocatable sections placed in the same bank.
+ */
+typedef struct {
+    uint32_t root;                      /*!< Root relocatable section index, the first of the group */
+    uint32_t length;                    /*!< Group length in bytes */
+    uint16_t pin;                       /*!< Bank the group must be placed in, or BANK_UNPLACED for any bank */
+} nesla_bank_group_t;
+
+/*!
+ * @struct nesla_bank_t
+ * @brief Program bank placement context.
+ */
+typedef struct {
+    nesla_encoder_t *encoder;           /*!< Encoder context */
+    size_t count;                       /*!< Relocatable section count */
+    size_t extra;                       /*!< Empty free spans added per bank, split off to align relocatable sections (.ALIGN) */
+    uint16_t fixed;                     /*!< Last (fixed) bank index */
+    uint32_t *section;                  /*!< Section index, or ENCODER_UNRESOLVED if empty, per relocatable section */
+    uint32_t *length;                   /*!< Length in bytes, per relocatable section */
+    uint32_t *parent;                   /*!< Parent in its group, per relocatable section */
+    uint32_t *total;                    /*!< Group length in bytes, per group root */
+    uint16_t *pin;                      /*!< Bank the group must be placed in, or BANK_UNPLACED, per group root */
+    nesla_bank_group_t *group;          /*!< Groups, in placement order */
+    size_t group_count;                 /*!< Group count */
+    nesla_bank_call_t *call;            /*!< Calls between nodes, by node */
+    nesla_bank_call_t *heavy;           /*!< Calls between nodes, the most frequent first */
+    size_t call_count;                  /*!< Call count */
+    nesla_bank_span_t *span;            /*!< Free spans, by bank and offset */
+    nesla_bank_span_t *free;            /*!< Free spans left, while placing */
+    nesla_bank_span_t *trial;           /*!< Free spans left in a bank, while fitting a group */
+    size_t *first;                      /*!< First free span index, per bank (and one past the last) */
+    uint32_t *room;                     /*!< Free bytes left, per bank, while placing */
+    uint32_t *gain;                     /*!< Crossing calls avoided, per bank, while choosing a bank */
+} nesla_bank_t;
+
+/*!
+ * @brief Find program bank group root of a relocatable section.
+ * @param[in,out] bank Pointer to placement context
+ * @param[in] index Relocatable section index
+ * @return Root relocatable section index
+ */
+static uint32_t nesla_bank_root(nesla_bank_t *bank, uint32_t index)
+{
+
+    while(bank->parent[index] != index) {
+        index = bank->parent[index] = bank->parent[bank->parent[index]];
+    }
+
+    return index;
+}
+
+/*!
+ * @brief Join program bank groups of two relocatable sections, under the first section of either.
+ * @param[in,out] bank Pointer to placement context
+ * @param[in] first First relocatable section index
+ * @param[in] second Second relocatable section index
+ */
+static void nesla_bank_union(nesla_bank_t *bank, uint32_t first, uint32_t second)
+{
+    uint32_t root = nesla_bank_root(bank, first), other = nesla_bank_root(bank, second);
+
+    if(root == other) {
+        return;
+    }
+
+    if(root > other) {
+        uint32_t swap = root;
+
+        root = other;
+        other = swap;
+    }
+
+    bank->parent[other] = root;
+    bank->total[root] += bank->total[other];
+
+    if(bank->pin[root] == BANK_UNPLACED) {
+        bank->pin[root] = bank->pin[other];
+    }
+}
+
+/*!
+ * @brief Find program bank node of code in a bank.
+ * @param[in] bank Constant pointer to placement context
+ * @param[in] index Bank index, or provisional bank index of a relocatable section
+ * @return Node index, or UINT32_MAX if the bank does not exist
+ */
+static uint32_t nesla_bank_node(const nesla_bank_t *bank, size_t index)
+{
+
+    if(index >= ENCODER_RELOCATE_BANK) {
+        return index - ENCODER_RELOCATE_BANK;
+    }
+
+    return (index < bank->encoder->program) ? (bank->count + index) : UINT32_MAX;
+}
+
+/*!
+ * @brief Compare program bank calls, by calling and called node.
+ * @param[in] first Constant pointer to first call context
+ * @param[in] second Constant pointer to second call context
+ * @return Negative if the first calls come first, positive if the second calls do, 0 otherwise
+ */
+static int nesla_bank_compare_call(const void *first, const void *second)
+{
+    const nesla_bank_call_t *left = first, *right = second;
+
+    if(left->source != right->source) {
+        return (left->source > right->source) - (left->source < right->source);
+    }
+
+    return (left->target > right->target) - (left->target < right->target);
+}
+
+/*!
+ * @brief Compare program bank groups: pinned groups first, then the longest.
+ * @param[in] first Constant pointer to first group context
+ * @param[in] second Constant pointer to second group context
+ * @return Negative if the first group is placed first, positive if the second group is, 0 otherwise
+ */
+static int nesla_bank_compare_group(const void *first, const void *second)
+{
+    const nesla_bank_group_t *left = first, *right = second;
+
+    if((left->pin == BANK_UNPLACED) != (right->pin == BANK_UNPLACED)) {
+        return (left->pin == BANK_UNPLACED) ? 1 : -1;
+    }
+
+    if(left->length != right->length) {
+        return (left->length > right->length) ? -1 : 1;
+    }
+
+    return (left->root > right->root) - (left->root < right->root);
+}
+
+/*!
+ * @brief Compare program bank calls, the most frequent first.
+ * @param[in] first Constant pointer to first call context
+ * @param[in] second Constant pointer to second call context
+ * @return Negative if the first calls come first, positive if the second calls do, 0 otherwise
+ */
+static int nesla_bank_compare_heavy(const void *first, const void *second)
+{
+    const nesla_bank_call_t *left = first, *right = second;
+
+    if(left->count != right->count) {
+        return (left->count > right->count) ? -1 : 1;
+    }
+
+    return nesla_bank_compare_call(first, second);
+}
+
+/*!
+ * @brief Compare program bank spans, by bank and offset.
+ * @param[in] first Constant pointer to first span context
+ * @param[in] second Constant pointer to second span context
+ * @return Negative if the first span comes first, positive if the second span does, 0 otherwise
+ */
+static int nesla_bank_compare_span(const void *first, const void *second)
+{
+    const nesla_bank_span_t *left = first, *right = second;
+
+    if(left->bank != right->bank) {
+        return (left->bank > right->bank) - (left->bank < right->bank);
+    }
+
+    return (left->begin > right->begin) - (left->begin < right->begin);
+}
+
+/*!
+ * @brief Measure program bank relocatable sections.
+ * @param[in,out] bank Pointer to placement context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_bank_measure(nesla_bank_t *bank)
+{
+    const nesla_encoder_t *encoder = bank->encoder;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(size_t index = 0; index < bank->count; ++index) {
+        bank->section[index] = ENCODER_UNRESOLVED;
+    }
+
+    for(size_t index = 0; index < encoder->section_count; ++index) {
+        const nesla_section_t *section = &encoder->section[index];
+        size_t relocation = encoder->statement[section->first].bank;
+
+        if(relocation < ENCODER_RELOCATE_BANK) {
+            continue;
+        }
+
+        relocation -= ENCODER_RELOCATE_BANK;
+        bank->section[relocation] = index;
+
+        for(size_t offset = section->first; offset < (section->first + section->count); ++offset) {
+            bank->length[relocation] += encoder->statement[offset].length;
+        }
+
+        if(bank->length[relocation] > BANK_LENGTH) {
+            const nesla_token_t *token = encoder->relocation[relocation].token;
+
+            result = SET_ERROR_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+                "Relocatable section longer than a bank: %u bytes", bank->length[relocation]);
+
+            if(nesla_context_is_full(encoder->context)) {
+                break;
+            }
+        } else if(encoder->relocation[relocation].page && (bank->length[relocation] > PAGE_LENGTH)) {
+            const nesla_token_t *token = encoder->relocation[relocation].token;
+
+            result = SET_ERROR_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+                "Relocatable section kept within a page longer than a page: %u bytes", bank->length[relocation]);
+
+            if(nesla_context_is_full(encoder->context)) {
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*!
+ * @brief Group program bank relocatable sections placed with a label, and pin each group to a bank.
+ * @param[in,out] bank Pointer to placement context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_bank_join(nesla_bank_t *bank)
+{
+    const nesla_encoder_t *encoder = bank->encoder;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(size_t index = 0; index < bank->count; ++index) {
+        bank->parent[index] = index;
+        bank->total[index] = bank->length[index];
+        bank->pin[index] = BANK_UNPLACED;
+    }
+
+    for(size_t index = 0; index < bank->count; ++index) {
+        const nesla_relocation_t *relocation = &encoder->relocation[index];
+        const nesla_symbol_t *symbol;
+
+        if(!relocation->affinity) {
+            continue;
+        }
+
+        if(!(symbol = nesla_encoder_get_symbol(encoder, relocation->affinity, relocation->scope)) || symbol->constant) {
+            result = SET_ERROR_AT(encoder->context, nesla_token_get_path(relocation->affinity), nesla_token_get_line(relocation->affinity),
+                nesla_token_get_column(relocation->affinity), "Undefined label: %s",
+                nesla_literal_get(nesla_token_get_literal(relocation->affinity)));
+
+            if(nesla_context_is_full(encoder->context)) {
+                goto exit;
+            }
+        } else if(symbol->bank >= ENCODER_RELOCATE_BANK) {
+            nesla_bank_union(bank, index, symbol->bank - ENCODER_RELOCATE_BANK);
+        }
+    }
+
+    for(size_t index = 0; index < bank->count; ++index) {
+        const nesla_relocation_t *relocation = &encoder->relocation[index];
+        const nesla_symbol_t *symbol;
+        uint16_t pin = relocation->pin, *root = &bank->pin[nesla_bank_root(bank, index)];
+
+        if(relocation->affinity && (symbol = nesla_encoder_get_symbol(encoder, relocation->affinity, relocation->scope))
+                && !symbol->constant && (symbol->bank < ENCODER_RELOCATE_BANK)) {
+            pin = symbol->bank;
+        }
+
+        if(pin == ENCODER_RELOCATE_BANK) {
+            continue;
+        }
+
+        if((pin >= encoder->program) || ((*root != BANK_UNPLACED) && (*root != pin))) {
+            result = SET_ERROR_AT(encoder->context, nesla_token_get_path(relocation->token), nesla_token_get_line(relocation->token),
+                nesla_token_get_column(relocation->token), (pin >= encoder->program) ? "Invalid bank: %u" : "Conflicting bank: %u, not %u",
+                pin, *root);
+
+            if(nesla_context_is_full(encoder->context)) {
+                goto exit;
+            }
+
+            continue;
+        }
+
+        *root = pin;
+    }
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Find program bank free spans, around the code placed in each bank by hand, followed by the empty spans of each bank
+ *        that free spans split off to align relocatable sections are kept in.
+ * @param[in,out] bank Pointer to placement context
+ */
+static void nesla_bank_find(nesla_bank_t *bank)
+{
+    const nesla_encoder_t *encoder = bank->encoder;
+    size_t count = 0, used = 0;
+
+    for(size_t index = 0; index < encoder->section_count; ++index) {
+        const nesla_section_t *section = &encoder->section[index];
+        const nesla_statement_t *statement = &encoder->statement[section->first];
+        uint32_t end = statement->address % BANK_LENGTH;
+
+        if(statement->bank >= encoder->program) {
+            continue;
+        }
+
+        bank->trial[used].bank = statement->bank;
+        bank->trial[used].begin = end;
+
+        for(size_t offset = section->first; offset < (section->first + section->count); ++offset) {
+            end += encoder->statement[offset].length;
+        }
+
+        bank->trial[used++].end = (end < BANK_LENGTH) ? end : BANK_LENGTH;
+    }
+
+    qsort(bank->trial, used, sizeof(*bank->trial), nesla_bank_compare_span);
+
+    for(size_t index = 0, offset = 0; index < encoder->program; ++index) {
+        uint32_t cursor = 0;
+
+        bank->first[index] = count;
+
+        for(; (offset < used) && (bank->trial[offset].bank == index); ++offset) {
+
+            if(bank->trial[offset].begin > cursor) {
+                bank->span[count].bank = index;
+                bank->span[count].begin = cursor;
+                bank->span[count++].end = bank->trial[offset].begin;
+            }
+
+            if(bank->trial[offset].end > cursor) {
+                cursor = bank->trial[offset].end;
+            }
+        }
+
+        if(cursor < BANK_LENGTH) {
+            bank->span[count].bank = index;
+            bank->span[count].begin = cursor;
+            bank->span[count++].end = BANK_LENGTH;
+        }
+
+        for(size_t empty = 0; empty < bank->extra; ++empty) {
+            bank->span[count].bank = index;
+            bank->span[count].begin = BANK_LENGTH;
+            bank->span[count++].end = BANK_LENGTH;
+        }
+    }
+
+    bank->first[encoder->program] = count;
+}
+
+/*!
+ * @brief Find program bank calls (JSR/JMP) between nodes, counting the calls between each pair.
+ * @param[in,out] bank Pointer to placement context
+ */
+static void nesla_bank_link(nesla_bank_t *bank)
+{
+    const nesla_encoder_t *encoder = bank->encoder;
+    size_t count = 0;
+
+    for(size_t index = 0; index < encoder->fixup_count; ++index) {
+        const nesla_fixup_t *fixup = &encoder->fixup[index];
+        const nesla_statement_t *statement = &encoder->statement[fixup->statement];
+        const nesla_symbol_t *symbol;
+        uint32_t source, target;
+
+        if((fixup->index == ENCODER_UNRESOLVED) || ((statement->instruction != INSTRUCTION_JSR)
+                && ((statement->instruction != INSTRUCTION_JMP) || (statement->mode != MODE_ABSOLUTE)))
+                || (symbol = &encoder->symbol[fixup->index])->constant) {
+            continue;
+        }
+
+        if(((source = nesla_bank_node(bank, statement->bank)) == UINT32_MAX)
+                || ((target = nesla_bank_node(bank, symbol->bank)) == UINT32_MAX) || (source == target)) {
+            continue;
+        }
+
+        bank->call[bank->call_count].source = source;
+        bank->call[bank->call_count].target = target;
+        bank->call[bank->call_count++].count = 1;
+    }
+
+    qsort(bank->call, bank->call_count, sizeof(*bank->call), nesla_bank_compare_call);
+
+    for(size_t index = 0; index < bank->call_count; ++index) {
+
+        if(count && !nesla_bank_compare_call(&bank->call[count - 1], &bank->call[index])) {
+            ++bank->call[count - 1].count;
+        } else {
+            bank->call[count++] = bank->call[index];
+        }
+    }
+
+    bank->call_count = count;
+}
+
+/*!
+ * @brief Gather program bank groups, from the group root of each relocatable section, in the order they were declared.
+ * @param[in,out] bank Pointer to placement context
+ */
+static void nesla_bank_gather(nesla_bank_t *bank)
+{
+    bank->group_count = 0;
+
+    for(size_t index = 0; index < bank->count; ++index) {
+
+        if(bank->parent[index] == index) {
+            nesla_bank_group_t *group = &bank->group[bank->group_count++];
+
+            group->root = index;
+            group->length = bank->total[index];
+            group->pin = bank->pin[index];
+        }
+    }
+}
+
+/*!
+ * @brief Cluster program bank groups that call each other, the most frequent calls first, while each cluster still fits in
+ *        the longest free span of a bank it may be placed in.
+ * @param[in,out] bank Pointer to placement context
+ */
+static void nesla_bank_cluster(nesla_bank_t *bank)
+{
+    const nesla_encoder_t *encoder = bank->encoder;
+
+    memcpy(bank->heavy, bank->call, bank->call_count * sizeof(*bank->heavy));
+    qsort(bank->heavy, bank->call_count, sizeof(*bank->heavy), nesla_bank_compare_heavy);
+
+    for(size_t index = 0; index < bank->call_count; ++index) {
+        const nesla_bank_call_t *call = &bank->heavy[index];
+        uint32_t root, other, longest = 0;
+        uint16_t pin;
+
+        if((call->source >= bank->count) || (call->target >= bank->count)
+                || ((root = nesla_bank_root(bank, call->source)) == (other = nesla_bank_root(bank, call->target)))) {
+            continue;
+        }
+
+        if((bank->pin[root] != BANK_UNPLACED) && (bank->pin[other] != BANK_UNPLACED) && (bank->pin[root] != bank->pin[other])) {
+            continue;
+        }
+
+        pin = (bank->pin[root] != BANK_UNPLACED) ? bank->pin[root] : bank->pin[other];
+
+        for(size_t span = 0; span < bank->first[encoder->program]; ++span) {
+
+            if(((pin == BANK_UNPLACED) || (bank->span[span].bank == pin)) && ((bank->span[span].end - bank->span[span].begin) > longest)) {
+                longest = bank->span[span].end - bank->span[span].begin;
+            }
+        }
+
+        if((bank->total[root] + bank->total[other]) <= longest) {
+            nesla_bank_union(bank, root, other);
+        }
+    }
+}
+
+/*!
+ * @brief Align program bank relocatable section offset, up to its alignment, and past the end of the page if the section is
+ *        kept within a page and would cross it.
+ * @param[in] bank Constant pointer to placement context
+ * @param[in] index Relocatable section index
+ * @param[in] offset Offset into the bank
+ * @return Aligned offset into the bank
+ */
+static uint32_t nesla_bank_align(const nesla_bank_t *bank, size_t index, uint32_t offset)
+{
+    const nesla_relocation_t *relocation = &bank->encoder->relocation[index];
+
+    offset = (offset + relocation->align - 1) & ~(uint32_t)(relocation->align - 1);
+
+    if(relocation->page && (((offset % PAGE_LENGTH) + bank->length[index]) > PAGE_LENGTH)) {
+        offset += PAGE_LENGTH - (offset % PAGE_LENGTH);
+    }
+
+    return offset;
+}
+
+/*!
+ * @brief Fit program bank group into the free spans left in a bank, first fit, in the order its sections were declared. The
+ *        bytes a span skips to align a section are split off into a span of their own, left free for the sections that
+ *        follow, in place of padding.
+ * @param[in,out] bank Pointer to placement context
+ * @param[in] group Constant pointer to group context
+ * @param[in] index Bank index
+ * @param[in,out] where Pointer to bank, per node, set for the group sections if the group fits and is placed
+ * @param[in,out] offset Pointer to offset into the bank, per relocatable section, set if the group fits and is placed
+ * @param[in] place Place the group if it fits
+ * @return true if the group fits, false otherwise
+ */
+static bool nesla_bank_fit(nesla_bank_t *bank, const nesla_bank_group_t *group, uint16_t index, uint16_t *where, uint16_t *offset,
+    bool place)
+{
+    size_t count = bank->first[index + 1] - bank->first[index];
+
+    if(bank->room[index] < group->length) {
+        return false;
+    }
+
+    memcpy(bank->trial, &bank->free[bank->first[index]], count * sizeof(*bank->trial));
+
+    for(size_t relocation = group->root; relocation < bank->count; ++relocation) {
+        size_t span = 0;
+        uint32_t begin = 0;
+
+        if(nesla_bank_root(bank, relocation) != group->root) {
+            continue;
+        }
+
+        for(; span < count; ++span) {
+            begin = nesla_bank_align(bank, relocation, bank->trial[span].begin);
+
+            if((begin <= bank->trial[span].end) && ((bank->trial[span].end - begin) >= bank->length[relocation])) {
+                break;
+            }
+        }
+
+        if(span == count) {
+            return false;
+        }
+
+        if(begin > bank->trial[span].begin) {
+            memmove(&bank->trial[span + 1], &bank->trial[span], (count - span - 1) * sizeof(*bank->trial));
+            bank->trial[span++].end = begin;
+        }
+
+        if(place) {
+            where[relocation] = index;
+            offset[relocation] = begin;
+        }
+
+        bank->trial[span].begin = begin + bank->length[relocation];
+    }
+
+    if(place) {
+        memcpy(&bank->free[bank->first[index]], bank->trial, count * sizeof(*bank->trial));
+        bank->room[index] -= group->length;
+    }
+
+    return true;
+}
+
+/*!
+ * @brief Count program bank calls crossing into a switched bank.
+ * @param[in] bank Constant pointer to placement context
+ * @param[in] where Constant pointer to bank, per node
+ * @return Crossing call count
+ */
+static size_t nesla_bank_cross(const nesla_bank_t *bank, const uint16_t *where)
+{
+    size_t result = 0;
+
+    for(size_t index = 0; index < bank->call_count; ++index) {
+        uint16_t source = where[bank->call[index].source], target = where[bank->call[index].target];
+
+        if((source != target) && (target != bank->fixed)) {
+            result += bank->call[index].count;
+        }
+    }
+
+    return result;
+}
+
+/*!
+ * @brief Choose program bank for a group, with room for it, that leaves the fewest calls crossing into a switched bank from
+ *        the code placed so far, then a switched bank over the fixed bank, and then the bank with the least room left.
+ * @param[in,out] bank Pointer to placement context
+ * @param[in] group Constant pointer to group context
+ * @param[in,out] where Pointer to bank, per node
+ * @param[in,out] offset Pointer to offset into the bank, per relocatable section
+ * @return Bank index, or BANK_UNPLACED if no bank has room
+ */
+static uint16_t nesla_bank_choose(nesla_bank_t *bank, const nesla_bank_group_t *group, uint16_t *where, uint16_t *offset)
+{
+    uint16_t result = BANK_UNPLACED;
+    uint32_t crossing = 0, best = 0;
+
+    memset(bank->gain, 0, bank->encoder->program * sizeof(*bank->gain));
+
+    for(size_t index = 0; index < bank->call_count; ++index) {
+        const nesla_bank_call_t *call = &bank->call[index];
+        bool source = (call->source < bank->count) && (nesla_bank_root(bank, call->source) == group->root),
+            target = (call->target < bank->count) && (nesla_bank_root(bank, call->target) == group->root);
+
+        if(source && !target && (where[call->target] != BANK_UNPLACED) && (where[call->target] != bank->fixed)) {
+            crossing += call->count;
+            bank->gain[where[call->target]] += call->count;
+        } else if(target && !source && (where[call->source] != BANK_UNPLACED)) {
+            crossing += call->count;
+            bank->gain[where[call->source]] += call->count;
+
+            if(where[call->source] != bank->fixed) {
+                bank->gain[bank->fixed] += call->count;
+            }
+        }
+    }
+
+    for(uint16_t index = 0; index < bank->encoder->program; ++index) {
+        uint32_t cost = crossing - bank->gain[index];
+
+        if(!nesla_bank_fit(bank, group, index, where, offset, false)) {
+            continue;
+        }
+
+        if((result == BANK_UNPLACED) || (cost < best) || ((cost == best) && ((result == bank->fixed)
+                || ((index != bank->fixed) && (bank->room[index] < bank->room[result]))))) {
+            result = index;
+            best = cost;
+        }
+    }
+
+    return result;
+}
+
+/*!
+ * @brief Place program bank groups, each in the first bank with room for it, or in the bank chosen by nesla_bank_choose.
+ * @param[in,out] bank Pointer to placement context
+ * @param[in] choose Choose each bank, instead of taking the first with room
+ * @param[in,out] where Pointer to bank, per node
+ * @param[in,out] offset Pointer to offset into the bank, per relocatable section
+ * @return Group root relocatable section index that does not fit, or the relocatable section count if every group fits
+ */
+static size_t nesla_bank_assign(nesla_bank_t *bank, bool choose, uint16_t *where, uint16_t *offset)
+{
+    const nesla_encoder_t *encoder = bank->encoder;
+
+    memcpy(bank->free, bank->span, bank->first[encoder->program] * sizeof(*bank->free));
+
+    for(size_t index = 0; index < bank->count; ++index) {
+        where[index] = BANK_UNPLACED;
+    }
+
+    for(uint16_t index = 0; index < encoder->program; ++index) {
+        bank->room[index] = 0;
+        where[bank->count + index] = index;
+
+        for(size_t span = bank->first[index]; span < bank->first[index + 1]; ++span) {
+            bank->room[index] += bank->span[span].end - bank->span[span].begin;
+        }
+    }
+
+    for(size_t index = 0; index < bank->group_count; ++index) {
+        const nesla_bank_group_t *group = &bank->group[index];
+        uint16_t chosen = group->pin;
+
+        if(chosen == BANK_UNPLACED) {
+
+            if(choose) {
+                chosen = nesla_bank_choose(bank, group, where, offset);
+            } else {
+                for(chosen = 0; (chosen < encoder->program) && !nesla_bank_fit(bank, group, chosen, where, offset, false); ++chosen);
+            }
+        }
+
+        if((chosen >= encoder->program) || !nesla_bank_fit(bank, group, chosen, where, offset, true)) {
+            return group->root;
+        }
+    }
+
+    return bank->count;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+nesla_error_e nesla_bank_place(nesla_encoder_t *encoder)
+{
+    nesla_bank_t bank = { encoder, encoder->relocation_count, };
+    size_t count = encoder->relocation_count + encoder->program, spans, first, chosen, crossing, banks = 0;
+    uint16_t *where = NULL, *offset = NULL;
+    const nesla_token_t *token = encoder->relocation[0].token;
+    uint32_t length = 0;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(!encoder->program) {
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Undefined program bank count");
+        goto exit;
+    }
+
+    bank.fixed = encoder->program - 1;
+
+    for(size_t index = 0; index < bank.count; ++index) {
+
+        if((encoder->relocation[index].align > 1) || encoder->relocation[index].page) {
+            ++bank.extra;
+        }
+    }
+
+    spans = encoder->section_count + count + (encoder->program * bank.extra);
+
+    if(!(bank.section = nesla_context_allocate(encoder->context, bank.count * sizeof(*bank.section)))
+            || !(bank.length = nesla_context_allocate(encoder->context, bank.count * sizeof(*bank.length)))
+            || !(bank.parent = nesla_context_allocate(encoder->context, bank.count * sizeof(*bank.parent)))
+            || !(bank.total = nesla_context_allocate(encoder->context, bank.count * sizeof(*bank.total)))
+            || !(bank.pin = nesla_context_allocate(encoder->context, bank.count * sizeof(*bank.pin)))
+            || !(bank.group = nesla_context_allocate(encoder->context, bank.count * sizeof(*bank.group)))
+            || !(bank.call = nesla_context_allocate(encoder->context, (encoder->fixup_count + 1) * sizeof(*bank.call)))
+            || !(bank.heavy = nesla_context_allocate(encoder->context, (encoder->fixup_count + 1) * sizeof(*bank.heavy)))
+            || !(bank.span = nesla_context_allocate(encoder->context, spans * sizeof(*bank.span)))
+            || !(bank.free = nesla_context_allocate(encoder->context, spans * sizeof(*bank.free)))
+            || !(bank.trial = nesla_context_allocate(encoder->context, spans * sizeof(*bank.trial)))
+            || !(bank.first = nesla_context_allocate(encoder->context, (encoder->program + 1) * sizeof(*bank.first)))
+            || !(bank.room = nesla_context_allocate(encoder->context, encoder->program * sizeof(*bank.room)))
+            || !(bank.gain = nesla_context_allocate(encoder->context, encoder->program * sizeof(*bank.gain)))
+            || !(where = nesla_context_allocate(encoder->context, count * 2 * sizeof(*where)))
+            || !(offset = nesla_context_allocate(encoder->context, bank.count * 2 * sizeof(*offset)))) {
+        result = SET_ERROR(encoder->context, "Failed to allocate bank placement: %zu", bank.count);
+        goto exit;
+    }
+
+    result = nesla_bank_measure(&bank);
+
+    if((nesla_bank_join(&bank) == NESLA_FAILURE) || (result == NESLA_FAILURE)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    nesla_bank_find(&bank);
+    nesla_bank_link(&bank);
+    nesla_bank_gather(&bank);
+
+    if((first = nesla_bank_assign(&bank, false, where + count, offset + bank.count)) < bank.count) {
+        length = bank.total[first];
+    }
+
+    nesla_bank_cluster(&bank);
+    nesla_bank_gather(&bank);
+    qsort(bank.group, bank.group_count, sizeof(*bank.group), nesla_bank_compare_group);
+
+    if((chosen = nesla_bank_assign(&bank, true, where, offset)) < bank.count) {
+
+        if(first < bank.count) {
+            token = encoder->relocation[first].token;
+            result = SET_ERROR_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+                "Out of program bank space: %u bytes", length);
+            goto exit;
+        }
+
+        memcpy(where, where + count, count * sizeof(*where));
+        memcpy(offset, offset + bank.count, bank.count * sizeof(*offset));
+    }
+
+    for(size_t index = 0; index < bank.count; ++index) {
+        nesla_relocation_t *relocation = &encoder->relocation[index];
+
+        relocation->bank = where[index];
+        relocation->address = ((relocation->bank == bank.fixed) ? BANK_FIXED : BANK_SWITCHED) + offset[index];
+        relocation->length = bank.length[index];
+
+        if(bank.section[index] != ENCODER_UNRESOLVED) {
+            nesla_section_t *section = &encoder->section[bank.section[index]];
+
+            for(size_t statement = section->first; statement < (section->first + section->count); ++statement) {
+                encoder->statement[statement].bank = relocation->bank;
+            }
+
+            encoder->statement[section->first].address = relocation->address;
+            section->dirty = true;
+        }
+    }
+
+    for(size_t index = 0; index < encoder->symbol_count; ++index) {
+        nesla_symbol_t *symbol = &encoder->symbol[index];
+        const nesla_relocation_t *relocation;
+
+        if(symbol->constant || (symbol->bank < ENCODER_RELOCATE_BANK)) {
+            continue;
+        }
+
+        relocation = &encoder->relocation[symbol->bank - ENCODER_RELOCATE_BANK];
+        symbol->bank = relocation->bank;
+
+        if(!symbol->anchor) {
+            symbol->address = relocation->address;
+        }
+    }
+
+    for(uint16_t index = 0; index < encoder->program; ++index) {
+
+        for(size_t relocation = 0; relocation < bank.count; ++relocation) {
+
+            if(where[relocation] == index) {
+                ++banks;
+                break;
+            }
+        }
+    }
+
+    crossing = nesla_bank_cross(&bank, where);
+
+    if(first < bank.count) {
+        SET_NOTE_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Sections placed: %zu in %zu bank(s), %zu call(s) into another switched bank, first fit runs out of space", bank.count,
+            banks, crossing);
+    } else {
+        size_t naive = nesla_bank_cross(&bank, where + count);
+
+        SET_NOTE_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Sections placed: %zu in %zu bank(s), %zu call(s) into another switched bank, %zu avoided over first fit", bank.count,
+            banks, crossing, (naive > crossing) ? (naive - crossing) : 0);
+    }
+
+exit:
+    nesla_context_free(encoder->context, offset);
+    nesla_context_free(encoder->context, where);
+    nesla_context_free(encoder->context, bank.gain);
+    nesla_context_free(encoder->context, bank.room);
+    nesla_context_free(encoder->context, bank.first);
+    nesla_context_free(encoder->context, bank.trial);
+    nesla_context_free(encoder->context, bank.free);
+    nesla_context_free(encoder->context, bank.span);
+    nesla_context_free(encoder->context, bank.heavy);
+    nesla_context_free(encoder->context, bank.call);
+    nesla_context_free(encoder->context, bank.group);
+    nesla_context_free(encoder->context, bank.pin);
+    nesla_context_free(encoder->context, bank.total);
+    nesla_context_free(encoder->context, bank.parent);
+    nesla_context_free(encoder->context, bank.length);
+    nesla_context_free(encoder->context, bank.section);
+
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
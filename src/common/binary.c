@@ -0,0 +1,127 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file binary.c
+ * @brief Common binary file.
+ */
+
+#include <common.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+void nesla_binary_close(nesla_binary_t *binary)
+{
+    memset(binary, 0, sizeof(*binary));
+    binary->descriptor = -1;
+}
+
+const uint8_t *nesla_binary_get(const nesla_binary_t *binary)
+{
+    return binary->data;
+}
+
+int nesla_binary_get_descriptor(const nesla_binary_t *binary)
+{
+    return binary->descriptor;
+}
+
+size_t nesla_binary_get_length(const nesla_binary_t *binary)
+{
+    return binary->length;
+}
+
+size_t nesla_binary_get_offset(const nesla_binary_t *binary)
+{
+    return binary->offset;
+}
+
+const char *nesla_binary_get_path(const nesla_binary_t *binary)
+{
+    return binary->path;
+}
+
+nesla_error_e nesla_binary_open(nesla_binary_t *binary, nesla_context_t *context, const char *path, size_t offset, size_t length)
+{
+    size_t size;
+    const uint8_t *data;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    binary->descriptor = -1;
+
+    if((result = nesla_context_map(context, path, &data, &size, &binary->descriptor)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if(offset >= size) {
+        result = SET_ERROR(context, "Invalid file offset: %s@%zu", path, offset);
+        goto exit;
+    }
+
+    if(!length) {
+        length = size - offset;
+    } else if(length > (size - offset)) {
+        result = SET_ERROR(context, "Invalid file length: %s@%zu+%zu", path, offset, length);
+        goto exit;
+    }
+
+    binary->data = data + offset;
+    binary->offset = offset;
+    binary->length = length;
+    binary->path = path;
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_binary_open_buffer(nesla_binary_t *binary, nesla_context_t *context, const char *path, const uint8_t *data,
+    size_t length, size_t offset, size_t slice)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    binary->descriptor = -1;
+
+    if(!data || (offset >= length)) {
+        result = SET_ERROR(context, "Invalid buffer offset: %s@%zu", path, offset);
+        goto exit;
+    }
+
+    if(!slice) {
+        slice = length - offset;
+    } else if(slice > (length - offset)) {
+        result = SET_ERROR(context, "Invalid buffer length: %s@%zu+%zu", path, offset, slice);
+        goto exit;
+    }
+
+    binary->data = data + offset;
+    binary->offset = offset;
+    binary->length = slice;
+    binary->path = path;
+
+exit:
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,336 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*!
+ * @file context.c
+ * @brief Common assembler context.
+ */
+
+#include <common.h>
+
+#define CONTEXT_CAPACITY 64 /*!< Initial array capacity in entries */
+
+/*!
+ * @struct nesla_context_map_t
+ * @brief Mapped file context.
+ */
+typedef struct {
+    dev_t device;               /*!< File device */
+    ino_t inode;                /*!< File inode */
+    struct timespec modified;   /*!< File modification time */
+    int descriptor;             /*!< File descriptor */
+    void *data;                 /*!< Mapped data, or NULL for an empty file */
+    size_t length;              /*!< Mapped length in bytes */
+} nesla_context_map_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Standard allocator allocate.
+ * @param[in] length Memory length in bytes
+ * @param[in] context Unused allocator context
+ * @return Pointer to memory, or NULL
+ */
+static void *nesla_context_standard_allocate(size_t length, void *context)
+{
+    return calloc(1, length);
+}
+
+/*!
+ * @brief Standard allocator free.
+ * @param[in,out] data Pointer to memory, or NULL
+ * @param[in] context Unused allocator context
+ */
+static void nesla_context_standard_free(void *data, void *context)
+{
+    free(data);
+}
+
+/*!
+ * @brief Standard allocator reallocate.
+ * @param[in,out] data Pointer to memory, or NULL
+ * @param[in] length Memory length in bytes
+ * @param[in] context Unused allocator context
+ * @return Pointer to memory, or NULL
+ */
+static void *nesla_context_standard_reallocate(void *data, size_t length, void *context)
+{
+    return realloc(data, length);
+}
+
+void *nesla_context_allocate(nesla_context_t *context, size_t length)
+{
+    void *result;
+
+    if((result = context->allocator.allocate(length, context->allocator.context))) {
+        memset(result, 0, length);
+    }
+
+    return result;
+}
+
+void nesla_context_clear(nesla_context_t *context)
+{
+    context->error[0] = '\0';
+    context->stored = 0;
+    context->noted = 0;
+    memset(context->count, 0, sizeof(context->count));
+    memset(&context->statistics, 0, sizeof(context->statistics));
+    nesla_context_free(context, context->tile);
+    context->tile = NULL;
+    context->tile_length = 0;
+}
+
+nesla_error_e nesla_context_create(nesla_context_t **context, const nesla_allocator_t *allocator)
+{
+    static const nesla_allocator_t g_allocator = {
+        .allocate = nesla_context_standard_allocate,
+        .reallocate = nesla_context_standard_reallocate,
+        .free = nesla_context_standard_free,
+        };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(!allocator) {
+        allocator = &g_allocator;
+    }
+
+    if(!context || !allocator->allocate || !allocator->reallocate || !allocator->free
+            || !(*context = allocator->allocate(sizeof(**context), allocator->context))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    memset(*context, 0, sizeof(**context));
+    (*context)->allocator = *allocator;
+
+exit:
+    return result;
+}
+
+void nesla_context_destroy(nesla_context_t *context)
+{
+
+    if(!context) {
+        return;
+    }
+
+    while(nesla_list_get_length(&context->map)) {
+        nesla_list_entry_t *entry = nesla_list_get_head(&context->map);
+        nesla_context_map_t *map = entry->context;
+
+        if(map->data) {
+            munmap(map->data, map->length);
+        }
+
+        close(map->descriptor);
+        nesla_context_free(context, map);
+        nesla_list_remove(&context->map, context, entry);
+    }
+
+    nesla_context_free(context, context->tile);
+    context->allocator.free(context, context->allocator.context);
+}
+
+char *nesla_context_duplicate(nesla_context_t *context, const char *string)
+{
+    char *result;
+    size_t length = strlen(string) + 1;
+
+    if((result = nesla_context_allocate(context, length))) {
+        memcpy(result, string, length);
+    }
+
+    return result;
+}
+
+void nesla_context_free(nesla_context_t *context, void *data)
+{
+
+    if(data) {
+        context->allocator.free(data, context->allocator.context);
+    }
+}
+
+const nesla_diagnostic_t *nesla_context_get_diagnostic(const nesla_context_t *context, size_t index)
+{
+    return (index < context->stored) ? &context->diagnostic[index] : NULL;
+}
+
+size_t nesla_context_get_diagnostic_count(const nesla_context_t *context, nesla_diagnostic_e level)
+{
+    return (level < NESLA_DIAGNOSTIC_MAX) ? context->count[level] : context->stored;
+}
+
+const char *nesla_context_get_error(const nesla_context_t *context)
+{
+    return context->error;
+}
+
+uint32_t nesla_context_get_flags(const nesla_context_t *context)
+{
+    return context->flags;
+}
+
+const uint8_t *nesla_context_get_map(const nesla_context_t *context, size_t *length)
+{
+    *length = context->tile_length;
+
+    return context->tile;
+}
+
+const nesla_statistics_t *nesla_context_get_statistics(const nesla_context_t *context)
+{
+    return &context->statistics;
+}
+
+bool nesla_context_is_full(const nesla_context_t *context)
+{
+    return context->stored >= CONTEXT_DIAGNOSTIC_MAX;
+}
+
+nesla_error_e nesla_context_map(nesla_context_t *context, const char *path, const uint8_t **data, size_t *length, int *descriptor)
+{
+    struct stat status;
+    nesla_list_entry_t *entry;
+    nesla_context_map_t *map = NULL;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(stat(path, &status)) {
+        result = SET_ERROR(context, "Failed to open file: %s", path);
+        goto exit;
+    }
+
+    for(entry = nesla_list_get_head(&context->map); entry; entry = entry->next) {
+        nesla_context_map_t *cached = entry->context;
+
+        if((cached->device == status.st_dev)
+                && (cached->inode == status.st_ino)
+                && (cached->length == (size_t)status.st_size)
+                && (cached->modified.tv_sec == status.st_mtim.tv_sec)
+                && (cached->modified.tv_nsec == status.st_mtim.tv_nsec)) {
+            *data = cached->data;
+            *length = cached->length;
+            *descriptor = cached->descriptor;
+            goto exit;
+        }
+    }
+
+    if(!(map = nesla_context_allocate(context, sizeof(*map)))) {
+        result = SET_ERROR(context, "Failed to allocate file mapping: %s", path);
+        goto exit;
+    }
+
+    if((map->descriptor = open(path, O_RDONLY)) < 0) {
+        result = SET_ERROR(context, "Failed to open file: %s", path);
+        goto exit;
+    }
+
+    if(fstat(map->descriptor, &status)) {
+        result = SET_ERROR(context, "Failed to stat file: %s", path);
+        goto exit;
+    }
+
+    map->device = status.st_dev;
+    map->inode = status.st_ino;
+    map->modified = status.st_mtim;
+    map->length = status.st_size;
+
+    if(map->length && ((map->data = mmap(NULL, map->length, PROT_READ, MAP_PRIVATE, map->descriptor, 0)) == MAP_FAILED)) {
+        map->data = NULL;
+        result = SET_ERROR(context, "Failed to map file: %s", path);
+        goto exit;
+    }
+
+    if((result = nesla_list_insert(&context->map, context, nesla_list_get_tail(&context->map), map)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    *data = map->data;
+    *length = map->length;
+    *descriptor = map->descriptor;
+    map = NULL;
+
+exit:
+
+    if(map) {
+
+        if(map->data) {
+            munmap(map->data, map->length);
+        }
+
+        if(map->descriptor >= 0) {
+            close(map->descriptor);
+        }
+
+        nesla_context_free(context, map);
+    }
+
+    return result;
+}
+
+void *nesla_context_reallocate(nesla_context_t *context, void *data, size_t length)
+{
+    return context->allocator.reallocate(data, length, context->allocator.context);
+}
+
+nesla_error_e nesla_context_reserve(nesla_context_t *context, void **data, size_t *capacity, size_t count, size_t size)
+{
+    void *grown;
+    size_t length = *capacity ? (*capacity * 2) : CONTEXT_CAPACITY;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(count < *capacity) {
+        goto exit;
+    }
+
+    if(!(grown = nesla_context_reallocate(context, *data, length * size))) {
+        result = SET_ERROR(context, "Failed to allocate array: %zu", length);
+        goto exit;
+    }
+
+    *data = grown;
+    *capacity = length;
+
+exit:
+    return result;
+}
+
+void nesla_context_release(nesla_context_t *context, void *data)
+{
+    nesla_context_free(context, data);
+}
+
+void nesla_context_set_cache(nesla_context_t *context, const char *directory)
+{
+    context->cache = directory;
+}
+
+void nesla_context_set_flags(nesla_context_t *context, uint32_t flags)
+{
+    context->flags = flags;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -26,39 +26,54 @@
 
 #include <common.h>
 
-/*!
- * @struct nesla_error_t
- * @brief Error context.
- */
-typedef struct {
-    char buffer[256];               /*!< Error string */
-} nesla_error_t;
-
-static nesla_error_t g_error = {};  /*!< Error context */
-
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
 
-const char *nesla_get_error(void)
-{
-    return g_error.buffer;
-}
-
-nesla_error_e nesla_set_error(const char *file, const char *function, int line, const char *format, ...)
+nesla_error_e nesla_set_error(nesla_context_t *context, const char *file, const char *function, int line, const char *format, ...)
 {
     va_list arguments;
 
     va_start(arguments, format);
-    vsnprintf(g_error.buffer, sizeof(g_error.buffer), format, arguments);
+    vsnprintf(context->error, sizeof(context->error), format, arguments);
 #ifdef DEBUG
-    snprintf(g_error.buffer + strlen(g_error.buffer), sizeof(g_error.buffer) - strlen(g_error.buffer), " (%s:%s@%i)", function, file, line);
+    snprintf(context->error + strlen(context->error), sizeof(context->error) - strlen(context->error), " (%s:%s@%i)", function, file, line);
 #endif /* DEBUG */
     va_end(arguments);
 
     return NESLA_FAILURE;
 }
 
+nesla_error_e nesla_set_diagnostic(nesla_context_t *context, const char *file, const char *function, int line, nesla_diagnostic_e level,
+    const char *path, size_t source_line, size_t source_column, const char *format, ...)
+{
+    va_list arguments;
+    nesla_diagnostic_t diagnostic = { .level = level, .line = source_line, .column = source_column };
+
+    va_start(arguments, format);
+    vsnprintf(diagnostic.message, sizeof(diagnostic.message), format, arguments);
+    va_end(arguments);
+    snprintf(diagnostic.path, sizeof(diagnostic.path), "%s", path ? path : "");
+    ++context->count[level];
+
+    if(level == NESLA_DIAGNOSTIC_ERROR) {
+
+        if(!nesla_context_is_full(context)) {
+            context->diagnostic[context->stored++] = diagnostic;
+        }
+    } else if(!nesla_context_is_full(context) && (context->noted < CONTEXT_NOTE_MAX)) {
+        context->diagnostic[context->stored++] = diagnostic;
+        ++context->noted;
+    }
+
+    if(level != NESLA_DIAGNOSTIC_ERROR) {
+        return NESLA_SUCCESS;
+    }
+
+    return nesla_set_error(context, file, function, line, "%s (%s@%zu:%zu)", diagnostic.message, diagnostic.path,
+        diagnostic.line, diagnostic.column);
+}
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -30,12 +30,12 @@
 extern "C" {
 #endif /* __cplusplus */
 
-nesla_error_e nesla_list_get(const nesla_list_t *list, size_t index, nesla_list_entry_t **entry)
+nesla_error_e nesla_list_get(const nesla_list_t *list, nesla_context_t *context, size_t index, nesla_list_entry_t **entry)
 {
     nesla_error_e result = NESLA_SUCCESS;
 
     if(index >= list->length) {
-        result = SET_ERROR("Invalid index: %zu", index);
+        result = SET_ERROR(context, "Invalid index: %zu", index);
         goto exit;
     }
 
@@ -64,17 +64,17 @@ nesla_list_entry_t *nesla_list_get_tail(const nesla_list_t *list)
     return list->tail;
 }
 
-nesla_error_e nesla_list_insert(nesla_list_t *list, nesla_list_entry_t *entry, void *context)
+nesla_error_e nesla_list_insert(nesla_list_t *list, nesla_context_t *context, nesla_list_entry_t *entry, void *data)
 {
-    nesla_list_entry_t *new_entry;
+    nesla_list_entry_t *new_entry = NULL;
     nesla_error_e result = NESLA_SUCCESS;
 
-    if(!(new_entry = calloc(1, sizeof(*new_entry)))) {
-        result = SET_ERROR("Failed to allocate list entry: %p", new_entry);
+    if(!(new_entry = nesla_context_allocate(context, sizeof(*new_entry)))) {
+        result = SET_ERROR(context, "Failed to allocate list entry: %p", new_entry);
         goto exit;
     }
 
-    new_entry->context = context;
+    new_entry->context = data;
 
     if(!entry) {
 
@@ -108,13 +108,13 @@ nesla_error_e nesla_list_insert(nesla_list_t *list, nesla_list_entry_t *entry, v
 exit:
 
     if((result == NESLA_FAILURE) && new_entry) {
-        free(new_entry);
+        nesla_context_free(context, new_entry);
     }
 
     return result;
 }
 
-void nesla_list_remove(nesla_list_t *list, nesla_list_entry_t *entry)
+void nesla_list_remove(nesla_list_t *list, nesla_context_t *context, nesla_list_entry_t *entry)
 {
 
     if(entry == list->head) {
@@ -136,7 +136,7 @@ void nesla_list_remove(nesla_list_t *list, nesla_list_entry_t *entry)
         entry->next->previous = entry->previous;
     }
 
-    free(entry);
+    nesla_context_free(context, entry);
     --list->length;
 }
 
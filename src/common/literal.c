@@ -33,16 +33,17 @@ export "C" {
 /*!
  * @brief Allocate literal context.
  * @param[in,out] literal Pointer to literal context
+ * @param[in,out] context Pointer to assembler context
  * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
  */
-static nesla_error_e nesla_literal_allocate(nesla_literal_t *literal)
+static nesla_error_e nesla_literal_allocate(nesla_literal_t *literal, nesla_context_t *context)
 {
     nesla_error_e result = NESLA_SUCCESS;
 
     literal->capacity = 16;
 
-    if(!(literal->buffer = calloc(literal->capacity, sizeof(uint8_t)))) {
-        result = SET_ERROR("Failed to allocate literal: %p", literal->buffer);
+    if(!(literal->buffer = nesla_context_allocate(context, literal->capacity * sizeof(uint8_t)))) {
+        result = SET_ERROR(context, "Failed to allocate literal: %p", literal->buffer);
         goto exit;
     }
 
@@ -52,35 +53,37 @@ exit:
     return result;
 }
 
-nesla_error_e nesla_literal_append(nesla_literal_t *literal, uint8_t value)
+nesla_error_e nesla_literal_append(nesla_literal_t *literal, nesla_context_t *context, uint8_t value)
 {
     nesla_error_e result = NESLA_SUCCESS;
 
-    if(!literal->buffer && ((result = nesla_literal_allocate(literal)) == NESLA_FAILURE)) {
+    if(!literal->buffer && ((result = nesla_literal_allocate(literal, context)) == NESLA_FAILURE)) {
         goto exit;
     }
 
     if(literal->length + 1 >= literal->capacity) {
-        literal->capacity *= 2;
+        uint8_t *buffer;
 
-        if(!(literal->buffer = realloc(literal->buffer, literal->capacity * sizeof(uint8_t)))) {
-            result = SET_ERROR("Failed to allocate literal: %p", literal->buffer);
+        if(!(buffer = nesla_context_reallocate(context, literal->buffer, literal->capacity * 2 * sizeof(uint8_t)))) {
+            result = SET_ERROR(context, "Failed to allocate literal: %p", literal->buffer);
             goto exit;
         }
+
+        literal->buffer = buffer;
+        literal->capacity *= 2;
     }
 
     literal->buffer[literal->length++] = value;
+    literal->buffer[literal->length] = '\0';
 
 exit:
     return result;
 }
 
-void nesla_literal_free(nesla_literal_t *literal)
+void nesla_literal_free(nesla_literal_t *literal, nesla_context_t *context)
 {
 
-    if(literal->buffer) {
-        free(literal->buffer);
-    }
+    nesla_context_free(context, literal->buffer);
 
     memset(literal, 0, sizeof(*literal));
 }
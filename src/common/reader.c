@@ -26,31 +26,123 @@
 
 #include <common.h>
 
+#define READER_CHUNK_LENGTH 4096    /*!< Reader chunk length in bytes */
+
+/*!
+ * @struct nesla_reader_chunk_t
+ * @brief Reader chunk context.
+ */
+typedef struct {
+    size_t length;                      /*!< Chunk length in bytes */
+    uint8_t data[READER_CHUNK_LENGTH];  /*!< Chunk data */
+} nesla_reader_chunk_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
 
+/*!
+ * @brief Move reader context to its next chunk, reading a new chunk from the file if none is retained.
+ * @param[in,out] reader Pointer to reader context
+ * @return NESLA_ERROR at end of file or on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_reader_fill(nesla_reader_t *reader)
+{
+    ssize_t count;
+    nesla_reader_chunk_t *chunk = NULL;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(reader->entry && reader->entry->next) {
+        reader->entry = reader->entry->next;
+        chunk = reader->entry->context;
+        reader->data = chunk->data;
+        reader->length = chunk->length;
+        reader->index = 0;
+        chunk = NULL;
+        goto exit;
+    }
+
+    if(reader->end) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(!(chunk = nesla_context_allocate(reader->context, sizeof(*chunk)))) {
+        result = SET_ERROR(reader->context, "Failed to allocate chunk: %s", reader->path);
+        goto exit;
+    }
+
+    do {
+        count = read(reader->descriptor, chunk->data, sizeof(chunk->data));
+    } while((count < 0) && (errno == EINTR));
+
+    if(count < 0) {
+        reader->end = true;
+        reader->failed = true;
+        result = SET_ERROR(reader->context, "Read failed: %s", strerror(errno));
+        goto exit;
+    } else if(!count) {
+        reader->end = true;
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    chunk->length = count;
+
+    if((result = nesla_list_insert(&reader->chunk, reader->context, nesla_list_get_tail(&reader->chunk), chunk)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    reader->entry = nesla_list_get_tail(&reader->chunk);
+    reader->data = chunk->data;
+    reader->length = chunk->length;
+    reader->index = 0;
+    chunk = NULL;
+
+exit:
+    nesla_context_free(reader->context, chunk);
+
+    return result;
+}
+
 void nesla_reader_close(nesla_reader_t *reader)
 {
 
-    if(reader->offset) {
-        fclose(reader->offset);
+    while(nesla_list_get_length(&reader->chunk)) {
+        nesla_list_entry_t *entry = nesla_list_get_head(&reader->chunk);
+
+        nesla_context_free(reader->context, entry->context);
+        nesla_list_remove(&reader->chunk, reader->context, entry);
     }
 
-    if(reader->base && (reader->base != reader->offset)) {
-        fclose(reader->base);
+    if(reader->descriptor >= 0) {
+        close(reader->descriptor);
     }
 
     memset(reader, 0, sizeof(*reader));
+    reader->descriptor = -1;
 }
 
 nesla_error_e nesla_reader_get(nesla_reader_t *reader, uint8_t *data, size_t length)
 {
     nesla_error_e result = NESLA_SUCCESS;
 
-    if(fread(data, sizeof(*data), length, reader->offset) != length) {
-        result = SET_ERROR("Failed to read file: %s", reader->path);
-        goto exit;
+    while(length) {
+        size_t count;
+
+        if((reader->index >= reader->length)
+                && ((result = nesla_reader_fill(reader)) == NESLA_FAILURE)) {
+            goto exit;
+        }
+
+        if((count = reader->length - reader->index) > length) {
+            count = length;
+        }
+
+        memcpy(data, reader->data + reader->index, count);
+        reader->index += count;
+        data += count;
+        length -= count;
     }
 
 exit:
@@ -59,20 +151,21 @@ exit:
 
 nesla_error_e nesla_reader_get_length(nesla_reader_t *reader, size_t *length)
 {
+    struct stat status;
     nesla_error_e result = NESLA_SUCCESS;
 
-    if(fseek(reader->base, 0, SEEK_END)) {
-        result = SET_ERROR("Failed to seek file end: %s", reader->path);
+    if(reader->descriptor < 0) {
+        *length = reader->length;
         goto exit;
     }
 
-    *length = ftell(reader->base);
-
-    if(fseek(reader->base, 0, SEEK_SET)) {
-        result = SET_ERROR("Failed to seek file end: %s", reader->path);
+    if(fstat(reader->descriptor, &status) || !S_ISREG(status.st_mode)) {
+        result = SET_ERROR(reader->context, "Unknown file length: %s", reader->path);
         goto exit;
     }
 
+    *length = status.st_size;
+
 exit:
     return result;
 }
@@ -82,13 +175,25 @@ const char *nesla_reader_get_path(const nesla_reader_t *reader)
     return reader->path;
 }
 
-nesla_error_e nesla_reader_open(nesla_reader_t *reader, const char *path)
+bool nesla_reader_is_failed(const nesla_reader_t *reader)
+{
+    return reader->failed;
+}
+
+nesla_error_e nesla_reader_open(nesla_reader_t *reader, nesla_context_t *context, const char *path)
 {
     nesla_error_e result = NESLA_SUCCESS;
 
-    if(!(reader->base = fopen(path, "rb"))
-            || !(reader->offset = freopen(path, "rb", reader->base))) {
-        result = SET_ERROR("Failed to open file: %s", path);
+    reader->context = context;
+
+    if(!strcmp(path, "-")) {
+        reader->descriptor = dup(STDIN_FILENO);
+    } else {
+        reader->descriptor = open(path, O_RDONLY);
+    }
+
+    if(reader->descriptor < 0) {
+        result = SET_ERROR(context, "Failed to open file: %s", path);
         goto exit;
     }
 
@@ -98,20 +203,45 @@ exit:
     return result;
 }
 
-nesla_error_e nesla_reader_reset(nesla_reader_t *reader)
+nesla_error_e nesla_reader_open_buffer(nesla_reader_t *reader, nesla_context_t *context, const char *path, const uint8_t *data,
+    size_t length)
 {
     nesla_error_e result = NESLA_SUCCESS;
 
-    if(fseek(reader->base, 0, SEEK_SET)
-            || fseek(reader->offset, 0, SEEK_SET)) {
-        result = SET_ERROR("Failed to seek file set: %s", reader->path);
+    reader->context = context;
+    reader->descriptor = -1;
+
+    if(!data) {
+        result = SET_ERROR(context, "Invalid buffer: %s", path);
         goto exit;
     }
 
+    reader->data = data;
+    reader->length = length;
+    reader->index = 0;
+    reader->end = true;
+    reader->path = path;
+
 exit:
     return result;
 }
 
+nesla_error_e nesla_reader_reset(nesla_reader_t *reader)
+{
+
+    if(reader->descriptor >= 0) {
+        nesla_list_entry_t *entry = nesla_list_get_head(&reader->chunk);
+
+        reader->entry = entry;
+        reader->data = entry ? ((nesla_reader_chunk_t *)entry->context)->data : NULL;
+        reader->length = entry ? ((nesla_reader_chunk_t *)entry->context)->length : 0;
+    }
+
+    reader->index = 0;
+
+    return NESLA_SUCCESS;
+}
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,200 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file table.c
+ * @brief Common hash table.
+ */
+
+#include <common.h>
+
+#define TABLE_CAPACITY 64   /*!< Initial table capacity in entries */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Get hash table home slot, mixing the entry scope into its name hash.
+ * @param[in] table Constant pointer to table context
+ * @param[in] hash Entry name hash
+ * @param[in] scope Entry scope
+ * @return Home slot index
+ */
+static size_t nesla_table_slot(const nesla_table_t *table, uint32_t hash, uint32_t scope)
+{
+    return (hash ^ (scope * 0x9E3779B1)) & (table->capacity - 1);
+}
+
+/*!
+ * @brief Place hash table entry, displacing entries closer to their home slot (Robin Hood).
+ * @param[in,out] table Pointer to table context
+ * @param[in] entry Entry context
+ */
+static void nesla_table_place(nesla_table_t *table, nesla_table_entry_t entry)
+{
+    size_t index = nesla_table_slot(table, entry.hash, entry.scope);
+
+    for(entry.distance = 1;; ++entry.distance, index = (index + 1) & (table->capacity - 1)) {
+        nesla_table_entry_t *slot = &table->entry[index];
+
+        if(!slot->distance) {
+            *slot = entry;
+            break;
+        }
+
+        if(slot->distance < entry.distance) {
+            nesla_table_entry_t displaced = *slot;
+
+            *slot = entry;
+            entry = displaced;
+        }
+    }
+
+    ++table->count;
+}
+
+/*!
+ * @brief Grow hash table, rehashing its entries.
+ * @param[in,out] table Pointer to table context
+ * @param[in,out] context Pointer to assembler context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_table_grow(nesla_table_t *table, nesla_context_t *context)
+{
+    nesla_table_entry_t *entry = table->entry;
+    size_t capacity = table->capacity, length = capacity ? (capacity * 2) : TABLE_CAPACITY;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(!(table->entry = nesla_context_allocate(context, length * sizeof(*entry)))) {
+        table->entry = entry;
+        result = SET_ERROR(context, "Failed to allocate table: %zu", length);
+        goto exit;
+    }
+
+    table->capacity = length;
+    table->count = 0;
+
+    for(size_t index = 0; index < capacity; ++index) {
+
+        if(entry[index].distance) {
+            nesla_table_place(table, entry[index]);
+        }
+    }
+
+    nesla_context_free(context, entry);
+
+exit:
+    return result;
+}
+
+nesla_table_entry_t *nesla_table_find(const nesla_table_t *table, const char *name, uint32_t hash, uint32_t scope)
+{
+    size_t index;
+
+    if(!table->count) {
+        return NULL;
+    }
+
+    index = nesla_table_slot(table, hash, scope);
+
+    for(uint32_t distance = 1;; ++distance, index = (index + 1) & (table->capacity - 1)) {
+        nesla_table_entry_t *slot = &table->entry[index];
+
+        if(slot->distance < distance) {
+            break;
+        }
+
+        if((slot->hash == hash) && (slot->scope == scope) && !strcmp(slot->name, name)) {
+            return slot;
+        }
+    }
+
+    return NULL;
+}
+
+void nesla_table_free(nesla_table_t *table, nesla_context_t *context)
+{
+    nesla_context_free(context, table->entry);
+    memset(table, 0, sizeof(*table));
+}
+
+size_t nesla_table_get_count(const nesla_table_t *table)
+{
+    return table->count;
+}
+
+uint32_t nesla_table_hash(const char *name, size_t length)
+{
+    uint32_t result = 0x811C9DC5;
+
+    for(size_t index = 0; index < length; ++index) {
+        result = (result ^ (uint8_t)name[index]) * 0x01000193;
+    }
+
+    return result;
+}
+
+nesla_error_e nesla_table_insert(nesla_table_t *table, nesla_context_t *context, const char *name, uint32_t hash, uint32_t scope,
+    size_t value)
+{
+    nesla_table_entry_t entry = { name, hash, scope, value, 0 };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(((table->count + 1) * 4) > (table->capacity * 3)) {
+
+        if((result = nesla_table_grow(table, context)) == NESLA_FAILURE) {
+            goto exit;
+        }
+    }
+
+    nesla_table_place(table, entry);
+
+exit:
+    return result;
+}
+
+bool nesla_table_remove(nesla_table_t *table, const char *name, uint32_t hash, uint32_t scope)
+{
+    size_t index, next;
+    nesla_table_entry_t *entry;
+
+    if(!(entry = nesla_table_find(table, name, hash, scope))) {
+        return false;
+    }
+
+    index = entry - table->entry;
+
+    for(next = (index + 1) & (table->capacity - 1); table->entry[next].distance > 1; next = (next + 1) & (table->capacity - 1)) {
+        table->entry[index] = table->entry[next];
+        --table->entry[index].distance;
+        index = next;
+    }
+
+    memset(&table->entry[index], 0, sizeof(*table->entry));
+    --table->count;
+
+    return true;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
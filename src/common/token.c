@@ -30,12 +30,22 @@
 extern "C" {
 #endif /* __cplusplus */
 
-void nesla_token_free(nesla_token_t *token)
+void nesla_token_free(nesla_token_t *token, nesla_context_t *context)
 {
-    nesla_literal_free(&token->literal);
+    nesla_literal_free(&token->literal, context);
     memset(token, 0, sizeof(*token));
 }
 
+size_t nesla_token_get_column(const nesla_token_t *token)
+{
+    return token->column;
+}
+
+uint32_t nesla_token_get_hash(const nesla_token_t *token)
+{
+    return token->hash;
+}
+
 size_t nesla_token_get_line(const nesla_token_t *token)
 {
     return token->line;
@@ -66,25 +76,28 @@ nesla_token_e nesla_token_get_type(const nesla_token_t *token)
     return token->type;
 }
 
-void nesla_token_set(nesla_token_t *token, nesla_token_e type, int subtype, const char *path, size_t line)
+void nesla_token_set(nesla_token_t *token, nesla_token_e type, int subtype, const char *path, size_t line, size_t column)
 {
     token->type = type;
     token->subtype = subtype;
     token->path = path;
     token->line = line;
+    token->column = column;
 }
 
-nesla_error_e nesla_token_set_literal(nesla_token_t *token, const nesla_literal_t *literal)
+nesla_error_e nesla_token_set_literal(nesla_token_t *token, nesla_context_t *context, const nesla_literal_t *literal)
 {
     nesla_error_e result = NESLA_SUCCESS;
 
     for(size_t index = 0; index < nesla_literal_get_length(literal); ++index) {
 
-        if((result = nesla_literal_append(&token->literal, nesla_literal_get(literal)[index])) == NESLA_FAILURE) {
+        if((result = nesla_literal_append(&token->literal, context, nesla_literal_get(literal)[index])) == NESLA_FAILURE) {
             goto exit;
         }
     }
 
+    token->hash = nesla_table_hash((const char *)nesla_literal_get(&token->literal), nesla_literal_get_length(&token->literal));
+
 exit:
     return result;
 }
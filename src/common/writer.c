@@ -48,15 +48,20 @@ nesla_error_e nesla_writer_get_length(nesla_writer_t *writer, size_t *length)
 {
     nesla_error_e result = NESLA_SUCCESS;
 
+    if(writer->buffer.data) {
+        *length = writer->buffer.length;
+        goto exit;
+    }
+
     if(fseek(writer->base, 0, SEEK_END)) {
-        result = SET_ERROR("Failed to seek file end: %s", writer->path);
+        result = SET_ERROR(writer->context, "Failed to seek file end: %s", writer->path);
         goto exit;
     }
 
     *length = ftell(writer->base);
 
     if(fseek(writer->base, 0, SEEK_SET)) {
-        result = SET_ERROR("Failed to seek file end: %s", writer->path);
+        result = SET_ERROR(writer->context, "Failed to seek file end: %s", writer->path);
         goto exit;
     }
 
@@ -69,16 +74,39 @@ const char *nesla_writer_get_path(const nesla_writer_t *writer)
     return writer->path;
 }
 
-nesla_error_e nesla_writer_open(nesla_writer_t *writer, const char *path, bool create)
+nesla_error_e nesla_writer_open(nesla_writer_t *writer, nesla_context_t *context, const char *path, bool create)
 {
     nesla_error_e result = NESLA_SUCCESS;
 
+    writer->context = context;
+
     if(!(writer->base = fopen(path, create ? "wb" : "wbx"))
             || !(writer->offset = freopen(path, create ? "wb" : "wbx", writer->base))) {
-        result = SET_ERROR("Failed to open file: %s", path);
+        result = SET_ERROR(writer->context, "Failed to open file: %s", path);
+        goto exit;
+    }
+
+    writer->path = path;
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_writer_open_buffer(nesla_writer_t *writer, nesla_context_t *context, const char *path, uint8_t *data,
+    size_t capacity)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    writer->context = context;
+
+    if(!data) {
+        result = SET_ERROR(writer->context, "Invalid buffer: %s", path);
         goto exit;
     }
 
+    writer->buffer.data = data;
+    writer->buffer.capacity = capacity;
+    writer->buffer.length = 0;
     writer->path = path;
 
 exit:
@@ -89,8 +117,74 @@ nesla_error_e nesla_writer_put(nesla_writer_t *writer, const uint8_t *data, size
 {
     nesla_error_e result = NESLA_SUCCESS;
 
-    if(fwrite(data, sizeof(*data), length, writer->offset) != length) {
-        result = SET_ERROR("Failed to write file: %s", writer->path);
+    if(writer->buffer.data) {
+
+        if(length > (writer->buffer.capacity - writer->buffer.length)) {
+            result = SET_ERROR(writer->context, "Failed to write buffer: %s", writer->path);
+            goto exit;
+        }
+
+        memcpy(writer->buffer.data + writer->buffer.length, data, length);
+        writer->buffer.length += length;
+    } else if(fwrite(data, sizeof(*data), length, writer->offset) != length) {
+        result = SET_ERROR(writer->context, "Failed to write file: %s", writer->path);
+        goto exit;
+    }
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_writer_put_binary(nesla_writer_t *writer, const nesla_binary_t *binary)
+{
+    off_t position;
+    int descriptor;
+    size_t length = nesla_binary_get_length(binary);
+    loff_t offset = nesla_binary_get_offset(binary);
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(writer->buffer.data || (nesla_binary_get_descriptor(binary) < 0)) {
+        result = nesla_writer_put(writer, nesla_binary_get(binary), length);
+        goto exit;
+    }
+
+    if(fflush(writer->offset)) {
+        result = SET_ERROR(writer->context, "Failed to flush file: %s", writer->path);
+        goto exit;
+    }
+
+    descriptor = fileno(writer->offset);
+
+    while(length) {
+        ssize_t copied;
+
+        if((copied = copy_file_range(nesla_binary_get_descriptor(binary), &offset, descriptor, NULL, length, 0)) <= 0) {
+            break;
+        }
+
+        length -= copied;
+    }
+
+    while(length) {
+        ssize_t copied;
+        off_t sent = offset;
+
+        if((copied = sendfile(descriptor, nesla_binary_get_descriptor(binary), &sent, length)) <= 0) {
+            break;
+        }
+
+        offset = sent;
+        length -= copied;
+    }
+
+    if(((position = lseek(descriptor, 0, SEEK_CUR)) < 0)
+            || fseek(writer->offset, position, SEEK_SET)) {
+        result = SET_ERROR(writer->context, "Failed to seek file: %s", writer->path);
+        goto exit;
+    }
+
+    if(length && ((result = nesla_writer_put(writer, nesla_binary_get(binary) + (nesla_binary_get_length(binary) - length),
+            length)) == NESLA_FAILURE)) {
         goto exit;
     }
 
@@ -102,9 +196,11 @@ nesla_error_e nesla_writer_reset(nesla_writer_t *writer)
 {
     nesla_error_e result = NESLA_SUCCESS;
 
-    if(fseek(writer->base, 0, SEEK_SET)
+    if(writer->buffer.data) {
+        writer->buffer.length = 0;
+    } else if(fseek(writer->base, 0, SEEK_SET)
             || fseek(writer->offset, 0, SEEK_SET)) {
-        result = SET_ERROR("Failed to seek file set: %s", writer->path);
+        result = SET_ERROR(writer->context, "Failed to seek file set: %s", writer->path);
         goto exit;
     }
 
@@ -0,0 +1,110 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file cycle.c
+ * @brief Instruction cycle analysis.
+ */
+
+#include <cycle.h>
+
+/*!
+ * @brief Check if two addresses are on different pages.
+ * @param[in] _FIRST_ First address
+ * @param[in] _SECOND_ Second address
+ * @return true if the addresses are on different pages, false otherwise
+ */
+#define CROSSES(_FIRST_, _SECOND_) \
+    ((((_FIRST_) ^ (_SECOND_)) & 0xFF00) != 0)
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+void nesla_cycle_get(const nesla_encoder_t *encoder, size_t index, nesla_cycle_t *cycle)
+{
+    const nesla_statement_t *statement = &encoder->statement[index];
+    const uint8_t *data = encoder->data + statement->offset;
+    const nesla_opcode_t *opcode;
+    uint16_t next = statement->address + 2, target;
+
+    memset(cycle, 0, sizeof(*cycle));
+
+    if((statement->instruction == INSTRUCTION_MAX) || !statement->length) {
+        return;
+    }
+
+    opcode = nesla_opcode_get(statement->instruction, statement->mode);
+    cycle->minimum = opcode->cycles;
+    cycle->maximum = opcode->cycles;
+
+    switch(opcode->penalty) {
+        case PENALTY_PAGE:
+
+            if((statement->mode == MODE_INDIRECT_Y) || data[1]) {
+                cycle->cross = CROSS_MAY;
+                ++cycle->maximum;
+            }
+            break;
+        case PENALTY_BRANCH:
+
+            if(statement->length != opcode->length) {
+                const nesla_opcode_t *inverse = nesla_opcode_get(nesla_opcode_invert(statement->instruction), MODE_RELATIVE),
+                    *jump = nesla_opcode_get(INSTRUCTION_JMP, MODE_ABSOLUTE);
+
+                target = next + (int8_t)data[1];
+                cycle->minimum = inverse->cycles + 1 + (CROSSES(next, target) ? 1 : 0);
+                cycle->maximum = inverse->cycles + jump->cycles;
+                cycle->cross = CROSSES(next, target) ? CROSS_WILL : CROSS_NONE;
+                break;
+            }
+
+            target = next + (int8_t)data[1];
+            ++cycle->maximum;
+
+            if(CROSSES(next, target)) {
+                cycle->cross = CROSS_WILL;
+                ++cycle->maximum;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+bool nesla_cycle_is_terminal(const nesla_encoder_t *encoder, size_t index)
+{
+    const nesla_statement_t *statement = &encoder->statement[index];
+
+    switch(statement->instruction) {
+        case INSTRUCTION_BRK:
+        case INSTRUCTION_JMP:
+        case INSTRUCTION_RTI:
+        case INSTRUCTION_RTS:
+            return true;
+        default:
+            return statement->mode == MODE_RELATIVE;
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
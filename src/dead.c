@@ -0,0 +1,373 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file dead.c
+ * @brief Unreachable code and data removal.
+ */
+
+#include <dead.h>
+
+/*!
+ * @struct nesla_dead_t
+ * @brief Unreachable code removal context. Statements are split into units, each running from a global label, or from an
+ *        origin, to the next.
+ */
+typedef struct {
+    nesla_encoder_t *encoder;           /*!< Encoder context */
+    uint32_t *label;                    /*!< Statement the label is placed before, or the statement count, per symbol */
+    uint32_t *unit;                     /*!< Unit index, per statement */
+    uint32_t *first;                    /*!< First statement index, per unit (and one past the last) */
+    uint32_t *name;                     /*!< First global label symbol index, or ENCODER_UNRESOLVED if unnamed, per unit */
+    uint8_t *live;                      /*!< Unit is reachable, per unit */
+    uint32_t *work;                     /*!< Worklist of reachable units, not yet walked */
+    size_t work_count;                  /*!< Worklist count */
+    size_t count;                       /*!< Unit count */
+} nesla_dead_t;
+
+/*!
+ * @brief Locate unreachable code removal labels, finding the statement each label is placed before.
+ * @param[in,out] dead Pointer to removal context
+ */
+static void nesla_dead_locate(nesla_dead_t *dead)
+{
+    const nesla_encoder_t *encoder = dead->encoder;
+
+    for(size_t index = 0; index < encoder->symbol_count; ++index) {
+        const nesla_symbol_t *label = &encoder->symbol[index];
+
+        dead->label[index] = encoder->statement_count;
+
+        if(label->constant) {
+            continue;
+        }
+
+        if(label->anchor) {
+
+            if((label->anchor < encoder->statement_count)
+                    && (encoder->statement[label->anchor].section == encoder->statement[label->anchor - 1].section)) {
+                dead->label[index] = label->anchor;
+            }
+
+            continue;
+        }
+
+        for(size_t section = 0; section < encoder->section_count; ++section) {
+            const nesla_statement_t *first = &encoder->statement[encoder->section[section].first];
+
+            if((first->bank == label->bank) && (first->address == label->address)) {
+                dead->label[index] = encoder->section[section].first;
+                break;
+            }
+        }
+    }
+}
+
+/*!
+ * @brief Split unreachable code removal units, at each global label and at each origin.
+ * @param[in,out] dead Pointer to removal context
+ */
+static void nesla_dead_split(nesla_dead_t *dead)
+{
+    const nesla_encoder_t *encoder = dead->encoder;
+
+    for(size_t index = 0; index < encoder->statement_count; ++index) {
+        dead->unit[index] = (encoder->section[encoder->statement[index].section].first == index) ? ENCODER_UNRESOLVED : 0;
+    }
+
+    for(size_t index = 0; index < encoder->symbol_count; ++index) {
+
+        if(!encoder->symbol[index].scope && (dead->label[index] < encoder->statement_count)) {
+            dead->unit[dead->label[index]] = ENCODER_UNRESOLVED;
+        }
+    }
+
+    for(size_t index = 0; index < encoder->statement_count; ++index) {
+
+        if(dead->unit[index] == ENCODER_UNRESOLVED) {
+            dead->name[dead->count] = ENCODER_UNRESOLVED;
+            dead->first[dead->count++] = index;
+        }
+
+        dead->unit[index] = dead->count - 1;
+    }
+
+    dead->first[dead->count] = encoder->statement_count;
+
+    for(size_t index = 0; index < encoder->symbol_count; ++index) {
+        uint32_t unit;
+
+        if(encoder->symbol[index].scope || (dead->label[index] >= encoder->statement_count)) {
+            continue;
+        }
+
+        unit = dead->unit[dead->label[index]];
+
+        if((dead->first[unit] == dead->label[index]) && (dead->name[unit] == ENCODER_UNRESOLVED)) {
+            dead->name[unit] = index;
+        }
+    }
+}
+
+/*!
+ * @brief Mark unreachable code removal unit reachable, queueing it to be walked.
+ * @param[in,out] dead Pointer to removal context
+ * @param[in] unit Unit index
+ */
+static void nesla_dead_mark(nesla_dead_t *dead, uint32_t unit)
+{
+
+    if(!dead->live[unit]) {
+        dead->live[unit] = true;
+        dead->work[dead->work_count++] = unit;
+    }
+}
+
+/*!
+ * @brief Mark unreachable code removal unit of a label reachable, if the label is placed before a statement.
+ * @param[in,out] dead Pointer to removal context
+ * @param[in] symbol Label symbol index
+ */
+static void nesla_dead_mark_label(nesla_dead_t *dead, uint32_t symbol)
+{
+
+    if(dead->label[symbol] < dead->encoder->statement_count) {
+        nesla_dead_mark(dead, dead->unit[dead->label[symbol]]);
+    }
+}
+
+/*!
+ * @brief Mark unreachable code removal roots: the vectors, unnamed units, units under .NOOPT, and labels kept (.KEEP, .DEF)
+ *        or given a cycle budget (.BUDGET).
+ * @param[in,out] dead Pointer to removal context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_dead_root(nesla_dead_t *dead)
+{
+    const nesla_encoder_t *encoder = dead->encoder;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(size_t index = 0; index < dead->count; ++index) {
+
+        if(dead->name[index] == ENCODER_UNRESOLVED) {
+            nesla_dead_mark(dead, index);
+        }
+    }
+
+    for(size_t index = 0; index < encoder->statement_count; ++index) {
+        const nesla_statement_t *statement = &encoder->statement[index];
+
+        if(statement->preserve || (statement->length && ((statement->address + statement->length) > DEAD_VECTOR))) {
+            nesla_dead_mark(dead, dead->unit[index]);
+        }
+    }
+
+    for(size_t index = 0; index < encoder->keep_count; ++index) {
+        const nesla_keep_t *keep = &encoder->keep[index];
+        const nesla_symbol_t *symbol;
+
+        if(!(symbol = nesla_encoder_get_symbol(encoder, keep->token, keep->scope))) {
+            result = SET_ERROR_AT(encoder->context, nesla_token_get_path(keep->token), nesla_token_get_line(keep->token),
+                nesla_token_get_column(keep->token), "Undefined symbol: %s", nesla_literal_get(nesla_token_get_literal(keep->token)));
+
+            if(nesla_context_is_full(encoder->context)) {
+                break;
+            }
+
+            continue;
+        }
+
+        nesla_dead_mark_label(dead, symbol - encoder->symbol);
+    }
+
+    for(size_t index = 0; index < encoder->budget_count; ++index) {
+        const nesla_budget_t *budget = &encoder->budget[index];
+        const nesla_symbol_t *symbol;
+
+        if(budget->symbol && (symbol = nesla_encoder_get_symbol(encoder, budget->symbol, budget->scope))) {
+            nesla_dead_mark_label(dead, symbol - encoder->symbol);
+        }
+    }
+
+    return result;
+}
+
+/*!
+ * @brief Check if an unreachable code removal unit runs into the unit that follows it.
+ * @param[in] dead Constant pointer to removal context
+ * @param[in] unit Unit index
+ * @return true if the unit runs into the next, false otherwise
+ */
+static bool nesla_dead_fall(const nesla_dead_t *dead, uint32_t unit)
+{
+    const nesla_encoder_t *encoder = dead->encoder;
+    const nesla_statement_t *last = NULL;
+    bool code = false;
+
+    if(((unit + 1) >= dead->count)
+            || (encoder->statement[dead->first[unit + 1]].section != encoder->statement[dead->first[unit + 1] - 1].section)) {
+        return false;
+    }
+
+    for(size_t index = dead->first[unit]; index < dead->first[unit + 1]; ++index) {
+        const nesla_statement_t *statement = &encoder->statement[index];
+
+        if(statement->length) {
+            last = statement;
+            code |= (statement->instruction != INSTRUCTION_MAX);
+        }
+    }
+
+    if(!last) {
+        return true;
+    }
+
+    return code && (last->instruction != INSTRUCTION_JMP) && (last->instruction != INSTRUCTION_RTS)
+        && (last->instruction != INSTRUCTION_RTI);
+}
+
+/*!
+ * @brief Walk unreachable code removal units, from the roots through the labels each reachable unit references, and into the
+ *        unit each runs into.
+ * @param[in,out] dead Pointer to removal context
+ */
+static void nesla_dead_walk(nesla_dead_t *dead)
+{
+    const nesla_encoder_t *encoder = dead->encoder;
+
+    while(dead->work_count) {
+        uint32_t unit = dead->work[--dead->work_count];
+
+        for(size_t index = dead->first[unit]; index < dead->first[unit + 1]; ++index) {
+            const nesla_fixup_t *fixup = nesla_encoder_get_fixup(encoder, index);
+
+            if(fixup && (fixup->index != ENCODER_UNRESOLVED)) {
+                nesla_dead_mark_label(dead, fixup->index);
+            }
+        }
+
+        if(nesla_dead_fall(dead, unit)) {
+            nesla_dead_mark(dead, unit + 1);
+        }
+    }
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+nesla_error_e nesla_dead_remove(nesla_encoder_t *encoder)
+{
+    nesla_dead_t dead = {};
+    const nesla_token_t *token = NULL;
+    size_t removed = 0, bytes = 0;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(!encoder->statement_count) {
+        goto exit;
+    }
+
+    dead.encoder = encoder;
+
+    if(!(dead.label = nesla_context_allocate(encoder->context, (encoder->symbol_count + 1) * sizeof(*dead.label)))
+            || !(dead.unit = nesla_context_allocate(encoder->context, encoder->statement_count * sizeof(*dead.unit)))
+            || !(dead.first = nesla_context_allocate(encoder->context, (encoder->statement_count + 1) * sizeof(*dead.first)))
+            || !(dead.name = nesla_context_allocate(encoder->context, encoder->statement_count * sizeof(*dead.name)))
+            || !(dead.live = nesla_context_allocate(encoder->context, encoder->statement_count * sizeof(*dead.live)))
+            || !(dead.work = nesla_context_allocate(encoder->context, encoder->statement_count * sizeof(*dead.work)))) {
+        result = SET_ERROR(encoder->context, "Failed to allocate unreachable code removal: %zu", encoder->statement_count);
+        goto exit;
+    }
+
+    nesla_dead_locate(&dead);
+    nesla_dead_split(&dead);
+
+    if(nesla_dead_root(&dead) == NESLA_FAILURE) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    nesla_dead_walk(&dead);
+
+    for(size_t unit = 0; unit < dead.count; ++unit) {
+        uint32_t length = 0;
+
+        if(dead.live[unit]) {
+            continue;
+        }
+
+        for(size_t index = dead.first[unit]; index < dead.first[unit + 1]; ++index) {
+            nesla_statement_t *statement = &encoder->statement[index];
+            nesla_fixup_t *fixup;
+
+            if(!statement->length) {
+                continue;
+            }
+
+            if((fixup = nesla_encoder_get_fixup(encoder, index))) {
+                fixup->index = ENCODER_UNRESOLVED;
+            }
+
+            encoder->section[statement->section].dirty = true;
+            length += statement->length;
+            statement->length = 0;
+        }
+
+        if((result = nesla_encoder_put_removed(encoder, dead.name[unit], length)) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        if(!removed++) {
+            token = encoder->symbol[dead.name[unit]].token;
+        }
+
+        bytes += length;
+    }
+
+    for(size_t index = 0; index < encoder->symbol_count; ++index) {
+
+        if((dead.label[index] < encoder->statement_count) && !dead.live[dead.unit[dead.label[index]]]) {
+            encoder->symbol[index].removed = true;
+        }
+    }
+
+    encoder->context->statistics.removed += removed;
+    encoder->context->statistics.removed_bytes += bytes;
+
+    if(removed) {
+        SET_NOTE_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Unreachable code and data removed: %zu label(s), %zu bytes", removed, bytes);
+    }
+
+exit:
+    nesla_context_free(encoder->context, dead.work);
+    nesla_context_free(encoder->context, dead.live);
+    nesla_context_free(encoder->context, dead.name);
+    nesla_context_free(encoder->context, dead.first);
+    nesla_context_free(encoder->context, dead.unit);
+    nesla_context_free(encoder->context, dead.label);
+
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,2137 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*!
+ * @file encoder.c
+ * @brief Instruction encoder.
+ */
+
+#include <bank.h>
+#include <dead.h>
+#include <far.h>
+#include <inline.h>
+#include <merge.h>
+#include <pack.h>
+#include <peephole.h>
+#include <ram.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Reserve encoder data, for a number of bytes past its end.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] length Data length in bytes
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_encoder_reserve(nesla_encoder_t *encoder, size_t length)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    while(encoder->length + length > encoder->capacity) {
+
+        if((result = nesla_context_reserve(encoder->context, (void **)&encoder->data, &encoder->capacity, encoder->capacity,
+                sizeof(*encoder->data))) == NESLA_FAILURE) {
+            goto exit;
+        }
+    }
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Append encoder statement.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to statement token context
+ * @param[in] bank Bank index
+ * @param[in] address Address
+ * @param[in] instruction Instruction type, or INSTRUCTION_MAX for data
+ * @param[in] mode Addressing mode
+ * @param[in] data Constant pointer to encoded data
+ * @param[in] length Encoded data length in bytes
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_encoder_append(nesla_encoder_t *encoder, const nesla_token_t *token, size_t bank, uint16_t address,
+    nesla_instruction_e instruction, nesla_mode_e mode, const uint8_t *data, size_t length)
+{
+    nesla_statement_t *statement;
+    const nesla_statement_t *previous;
+    nesla_error_e result;
+
+    if(length > UINT16_MAX) {
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Statement too long: %zu", length);
+        goto exit;
+    }
+
+    if(encoder->bound && (instruction != INSTRUCTION_JMP) && (mode != MODE_RELATIVE)) {
+        encoder->bound = 0;
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Loop bound on a statement that does not branch");
+        goto exit;
+    }
+
+    if(encoder->hot && (instruction != INSTRUCTION_JSR)) {
+        encoder->hot = false;
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Hot marker on a statement that is not a call");
+        goto exit;
+    }
+
+    if(encoder->far && (instruction != INSTRUCTION_JSR)) {
+        encoder->far = false;
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Far marker on a statement that is not a call");
+        goto exit;
+    }
+
+    if((result = nesla_context_reserve(encoder->context, (void **)&encoder->statement, &encoder->statement_capacity,
+            encoder->statement_count, sizeof(*statement))) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    previous = encoder->statement_count ? &encoder->statement[encoder->statement_count - 1] : NULL;
+
+    if(!previous || (previous->bank != bank) || ((previous->address + previous->length) != address)) {
+
+        if((result = nesla_context_reserve(encoder->context, (void **)&encoder->section, &encoder->section_capacity,
+                encoder->section_count, sizeof(*encoder->section))) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        encoder->section[encoder->section_count].first = encoder->statement_count;
+        encoder->section[encoder->section_count].count = 0;
+        encoder->section[encoder->section_count].dirty = false;
+        encoder->section[encoder->section_count++].aligned = false;
+    }
+
+    if((result = nesla_encoder_reserve(encoder, length)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    ++encoder->section[encoder->section_count - 1].count;
+    statement = &encoder->statement[encoder->statement_count++];
+    statement->token = token;
+    statement->offset = encoder->length;
+    statement->section = encoder->section_count - 1;
+    statement->bank = bank;
+    statement->address = address;
+    statement->length = length;
+    statement->instruction = instruction;
+    statement->mode = mode;
+    statement->preserve = encoder->preserve;
+    statement->hot = encoder->hot;
+    statement->far = encoder->far;
+    statement->bound = encoder->bound;
+    encoder->bound = 0;
+    encoder->hot = false;
+    encoder->far = false;
+    encoder->section[statement->section].aligned |= encoder->align;
+    encoder->align = false;
+    memcpy(encoder->data + encoder->length, data, length);
+    encoder->length += length;
+    ++encoder->context->statistics.statement;
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Get encoder symbol scope. Symbols named with a leading underscore are local to the current scope.
+ * @param[in] encoder Constant pointer to encoder context
+ * @param[in] token Constant pointer to label or identifier token context
+ * @return Symbol scope, or 0 if global
+ */
+static uint32_t nesla_encoder_scope(const nesla_encoder_t *encoder, const nesla_token_t *token)
+{
+    return (nesla_literal_get(nesla_token_get_literal(token))[0] == '_') ? encoder->scope : 0;
+}
+
+/*!
+ * @brief Find encoder symbol.
+ * @param[in] encoder Constant pointer to encoder context
+ * @param[in] token Constant pointer to label or identifier token context
+ * @param[in] scope Symbol scope
+ * @return Pointer to symbol context, or NULL if undefined
+ */
+static nesla_symbol_t *nesla_encoder_find(const nesla_encoder_t *encoder, const nesla_token_t *token, uint32_t scope)
+{
+    const nesla_table_entry_t *entry;
+
+    if(!(entry = nesla_table_find(&encoder->table, (const char *)nesla_literal_get(nesla_token_get_literal(token)),
+            nesla_token_get_hash(token), scope))) {
+        return NULL;
+    }
+
+    return &encoder->symbol[entry->value];
+}
+
+/*!
+ * @brief Insert encoder symbol.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to label or identifier token context
+ * @param[in] bank Bank index
+ * @param[in] address Address, or value for constants
+ * @param[in] constant Symbol is a constant
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_encoder_insert(nesla_encoder_t *encoder, const nesla_token_t *token, size_t bank, uint16_t address,
+    bool constant)
+{
+    nesla_symbol_t *symbol;
+    uint32_t scope = nesla_encoder_scope(encoder, token);
+    const char *name = (const char *)nesla_literal_get(nesla_token_get_literal(token));
+    nesla_error_e result;
+
+    if((symbol = nesla_encoder_find(encoder, token, scope))) {
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Symbol redefined: %s (%s@%zu:%zu)", name, nesla_token_get_path(symbol->token), nesla_token_get_line(symbol->token),
+            nesla_token_get_column(symbol->token));
+        goto exit;
+    }
+
+    if((result = nesla_context_reserve(encoder->context, (void **)&encoder->symbol, &encoder->symbol_capacity, encoder->symbol_count,
+            sizeof(*symbol))) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if((result = nesla_table_insert(&encoder->table, encoder->context, name, nesla_token_get_hash(token), scope,
+            encoder->symbol_count)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    symbol = &encoder->symbol[encoder->symbol_count++];
+    symbol->token = token;
+    symbol->bank = bank;
+    symbol->address = address;
+    symbol->scope = scope;
+    symbol->anchor = 0;
+    symbol->variable = 0;
+    symbol->constant = constant;
+    symbol->removed = false;
+
+    if(!constant && encoder->statement_count) {
+        const nesla_statement_t *previous = &encoder->statement[encoder->statement_count - 1];
+
+        if((previous->bank == bank) && ((previous->address + previous->length) == address)) {
+            symbol->anchor = encoder->statement_count;
+        }
+    }
+
+    ++encoder->context->statistics.symbol;
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Set encoder generated name token, reported at the position of another token.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to token context the name is reported at
+ * @param[in] name Constant pointer to name string
+ * @param[in,out] named Pointer to name token context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_encoder_name(nesla_encoder_t *encoder, const nesla_token_t *token, const char *name, nesla_token_t *named)
+{
+    nesla_literal_t literal = {};
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(; *name; ++name) {
+
+        if((result = nesla_literal_append(&literal, encoder->context, *name)) == NESLA_FAILURE) {
+            goto exit;
+        }
+    }
+
+    nesla_token_free(named, encoder->context);
+    nesla_token_set(named, TOKEN_IDENTIFIER, 0, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token));
+    result = nesla_token_set_literal(named, encoder->context, &literal);
+
+exit:
+    nesla_literal_free(&literal, encoder->context);
+
+    return result;
+}
+
+/*!
+ * @brief Add encoder derived name, a prefix followed by a suffix, such as the tables of a jump table (.JUMP) or the fields of
+ *        a structure (.SOA). The token is owned by the encoder, and reported at the position of the source token.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to source token context
+ * @param[in] prefix Constant pointer to name prefix
+ * @param[in] suffix Constant pointer to name suffix
+ * @param[in,out] derived Pointer to derived name token context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_encoder_derive(nesla_encoder_t *encoder, const nesla_token_t *token, const char *prefix,
+    const char *suffix, nesla_token_t **derived)
+{
+    size_t size = strlen(prefix) + strlen(suffix) + 1;
+    nesla_token_t *named = NULL;
+    char *buffer = NULL;
+    nesla_error_e result;
+
+    if(!(buffer = nesla_context_allocate(encoder->context, size))
+            || !(named = nesla_context_allocate(encoder->context, sizeof(*named)))) {
+        result = SET_ERROR(encoder->context, "Failed to allocate name: %s%s", prefix, suffix);
+        goto exit;
+    }
+
+    memset(named, 0, sizeof(*named));
+
+    if((result = nesla_list_insert(&encoder->derived, encoder->context, nesla_list_get_tail(&encoder->derived), named))
+            == NESLA_FAILURE) {
+        nesla_context_free(encoder->context, named);
+        goto exit;
+    }
+
+    snprintf(buffer, size, "%s%s", prefix, suffix);
+
+    if((result = nesla_encoder_name(encoder, token, buffer, named)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    *derived = named;
+
+exit:
+    nesla_context_free(encoder->context, buffer);
+
+    return result;
+}
+
+/*!
+ * @brief Add encoder decompressor names, for the first packed block of a compression mode (.PACK). The decompressor and
+ *        block address table labels are placed once blocks are linked (see nesla_pack_link), and the pointer variables are
+ *        placed in RAM.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] token Constant pointer to directive token context
+ * @param[in] mode Compression mode
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_encoder_unpack(nesla_encoder_t *encoder, const nesla_token_t *token, uint8_t mode)
+{
+    static const char *NAME[] = {
+        "UNPACK_RLE", "UNPACK_LZ", "UNPACK_RLE_TABLE", "UNPACK_LZ_TABLE", "UNPACK_DST", "UNPACK_DST_HI", "UNPACK_SRC", "UNPACK_SRC_HI",
+        "UNPACK_REF", "UNPACK_REF_HI",
+        };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(uint8_t name = UNPACK_RLE; name < UNPACK_MAX; ++name) {
+        nesla_token_t *named = &encoder->unpack_name[name];
+
+        if(nesla_literal_get_length(nesla_token_get_literal(named))
+                || ((name <= UNPACK_LZ_TABLE) && (name != mode) && (name != (UNPACK_RLE_TABLE + mode)))
+                || ((name >= UNPACK_REFERENCE) && (mode != UNPACK_LZ))) {
+            continue;
+        }
+
+        if((result = nesla_encoder_name(encoder, token, NAME[name], named)) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        switch(name) {
+            case UNPACK_RLE:
+            case UNPACK_LZ:
+                result = nesla_encoder_insert(encoder, named, ENCODER_RELOCATE_BANK, 0, false);
+                break;
+            case UNPACK_RLE_TABLE:
+            case UNPACK_LZ_TABLE:
+                continue;
+            case UNPACK_DESTINATION_HIGH:
+            case UNPACK_SOURCE_HIGH:
+            case UNPACK_REFERENCE_HIGH:
+                result = nesla_encoder_put_variable_byte(encoder, named, 1);
+                break;
+            default:
+                result = nesla_encoder_put_variable(encoder, named, 2);
+                break;
+        }
+
+        if(result == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        encoder->unpack[name] = encoder->symbol_count;
+    }
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Patch encoder statement operand.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] index Statement index
+ * @param[in] type Fixup type
+ * @param[in] operand Constant pointer to operand token context
+ * @param[in] value Operand value
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_encoder_patch(nesla_encoder_t *encoder, size_t index, nesla_fixup_e type, const nesla_token_t *operand,
+    uint16_t value)
+{
+    int offset;
+    const nesla_statement_t *statement = &encoder->statement[index];
+    uint8_t *data = encoder->data + statement->offset + ((statement->instruction != INSTRUCTION_MAX) ? 1 : 0);
+    nesla_error_e result = NESLA_SUCCESS;
+
+    switch(type) {
+        case FIXUP_BYTE:
+
+            if(value > UINT8_MAX) {
+                result = SET_ERROR_AT(encoder->context, nesla_token_get_path(operand), nesla_token_get_line(operand),
+                    nesla_token_get_column(operand), "Value too large: %u", value);
+                goto exit;
+            }
+
+            data[0] = value;
+            break;
+        case FIXUP_RELATIVE:
+            offset = (int)value - (int)(statement->address + statement->length);
+
+            if((offset < INT8_MIN) || (offset > INT8_MAX)) {
+                result = SET_ERROR_AT(encoder->context, nesla_token_get_path(operand), nesla_token_get_line(operand),
+                    nesla_token_get_column(operand), "Branch out of range: %i", offset);
+                goto exit;
+            }
+
+            data[0] = (uint8_t)offset;
+            break;
+        case FIXUP_WORD:
+            data[0] = value;
+            data[1] = value >> 8;
+            break;
+        case FIXUP_JUMP:
+            data[2] = value;
+            data[3] = value >> 8;
+            break;
+        case FIXUP_LOW:
+        case FIXUP_LOW_RETURN:
+            data[0] = value - ((type == FIXUP_LOW_RETURN) ? 1 : 0);
+            break;
+        case FIXUP_HIGH:
+        case FIXUP_HIGH_RETURN:
+            data[0] = (uint16_t)(value - ((type == FIXUP_HIGH_RETURN) ? 1 : 0)) >> 8;
+            break;
+        default:
+            break;
+    }
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Reference encoder operand, patching it if its value is known. Symbol references are recorded as fixups, to patch
+ *        again once layout is final. Branches to symbols are only patched then, since they may still be expanded.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] type Fixup type
+ * @param[in] operand Constant pointer to scalar or identifier token context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_encoder_reference(nesla_encoder_t *encoder, nesla_fixup_e type, const nesla_token_t *operand)
+{
+    nesla_fixup_t *fixup;
+    const nesla_symbol_t *symbol;
+    uint32_t scope;
+    nesla_error_e result;
+
+    if(nesla_token_get_type(operand) == TOKEN_SCALAR) {
+        result = nesla_encoder_patch(encoder, encoder->statement_count - 1, type, operand, nesla_token_get_scalar(operand));
+        goto exit;
+    }
+
+    ++encoder->context->statistics.reference;
+    scope = nesla_encoder_scope(encoder, operand);
+
+    if((symbol = nesla_encoder_find(encoder, operand, scope)) && (type != FIXUP_RELATIVE)
+            && ((result = nesla_encoder_patch(encoder, encoder->statement_count - 1, type, operand, symbol->address)) == NESLA_FAILURE)) {
+        goto exit;
+    }
+
+    if((result = nesla_context_reserve(encoder->context, (void **)&encoder->fixup, &encoder->fixup_capacity, encoder->fixup_count,
+            sizeof(*fixup))) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    fixup = &encoder->fixup[encoder->fixup_count++];
+    fixup->symbol = operand;
+    fixup->statement = encoder->statement_count - 1;
+    fixup->scope = scope;
+    fixup->index = symbol ? (symbol - encoder->symbol) : ENCODER_UNRESOLVED;
+    fixup->chained = ENCODER_UNRESOLVED;
+    fixup->saved = 0;
+    fixup->type = type;
+    fixup->forward = !symbol;
+
+    if(fixup->forward) {
+        ++encoder->context->statistics.fixup;
+    }
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Get encoder operand value, if known.
+ * @param[in] encoder Constant pointer to encoder context
+ * @param[in] operand Constant pointer to scalar or identifier token context
+ * @param[in,out] value Pointer to operand value
+ * @return true if the value is known, false otherwise
+ */
+static bool nesla_encoder_value(const nesla_encoder_t *encoder, const nesla_token_t *operand, uint16_t *value)
+{
+    const nesla_symbol_t *symbol;
+
+    if(nesla_token_get_type(operand) == TOKEN_SCALAR) {
+        *value = nesla_token_get_scalar(operand);
+    } else if((symbol = nesla_encoder_find(encoder, operand, nesla_encoder_scope(encoder, operand))) && !symbol->variable
+            && (symbol->bank < ENCODER_RELOCATE_BANK)) {
+        *value = symbol->address;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+/*!
+ * @brief Change encoder statement addressing mode, moving its encoded data past the end if it grows.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in,out] fixup Pointer to statement fixup context
+ * @param[in] mode Addressing mode
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_encoder_change(nesla_encoder_t *encoder, nesla_fixup_t *fixup, nesla_mode_e mode)
+{
+    nesla_statement_t *statement = &encoder->statement[fixup->statement];
+    const nesla_opcode_t *opcode = nesla_opcode_get(statement->instruction, mode);
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(opcode->length > statement->length) {
+
+        if((result = nesla_encoder_reserve(encoder, opcode->length)) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        memset(encoder->data + encoder->length, 0, opcode->length);
+        statement->offset = encoder->length;
+        encoder->length += opcode->length;
+    }
+
+    encoder->data[statement->offset] = opcode->opcode;
+    statement->mode = mode;
+    statement->length = opcode->length;
+    fixup->type = (opcode->length == 3) ? FIXUP_WORD : FIXUP_BYTE;
+    encoder->section[statement->section].dirty = true;
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Get encoder statement direct addressing mode, as zero-page or absolute.
+ * @param[in] statement Constant pointer to statement context
+ * @param[in] zero_page Zero-page mode if true, absolute mode otherwise
+ * @return Addressing mode, or MODE_MAX if the statement has no direct operand with both modes
+ */
+static nesla_mode_e nesla_encoder_direct(const nesla_statement_t *statement, bool zero_page)
+{
+    nesla_mode_e mode = statement->mode;
+
+    if(statement->instruction == INSTRUCTION_MAX) {
+        return MODE_MAX;
+    }
+
+    if((mode >= MODE_ZERO_PAGE) && (mode <= MODE_ZERO_PAGE_Y)) {
+        mode = mode - MODE_ZERO_PAGE + MODE_ABSOLUTE;
+    } else if((mode < MODE_ABSOLUTE) || (mode > MODE_ABSOLUTE_Y)) {
+        return MODE_MAX;
+    }
+
+    if(!nesla_opcode_get(statement->instruction, mode)->valid
+            || !nesla_opcode_get(statement->instruction, mode - MODE_ABSOLUTE + MODE_ZERO_PAGE)->valid) {
+        return MODE_MAX;
+    }
+
+    return zero_page ? (mode - MODE_ABSOLUTE + MODE_ZERO_PAGE) : mode;
+}
+
+/*!
+ * @brief Expand encoder branch statement into an inverted branch over an absolute jump, moving its encoded data past the end.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in,out] fixup Pointer to statement fixup context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_encoder_expand(nesla_encoder_t *encoder, nesla_fixup_t *fixup)
+{
+    nesla_statement_t *statement = &encoder->statement[fixup->statement];
+    const nesla_opcode_t *branch = nesla_opcode_get(statement->instruction, MODE_RELATIVE),
+        *inverse = nesla_opcode_get(nesla_opcode_invert(statement->instruction), MODE_RELATIVE),
+        *jump = nesla_opcode_get(INSTRUCTION_JMP, MODE_ABSOLUTE);
+    nesla_error_e result;
+
+    if((result = nesla_encoder_reserve(encoder, inverse->length + jump->length)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    statement->offset = encoder->length;
+    statement->length = inverse->length + jump->length;
+    encoder->data[encoder->length++] = inverse->opcode;
+    encoder->data[encoder->length++] = jump->length;
+    encoder->data[encoder->length++] = jump->opcode;
+    encoder->data[encoder->length++] = 0;
+    encoder->data[encoder->length++] = 0;
+    fixup->type = FIXUP_JUMP;
+    encoder->section[statement->section].dirty = true;
+    ++encoder->context->statistics.expanded;
+    SET_NOTE_AT(encoder->context, nesla_token_get_path(statement->token), nesla_token_get_line(statement->token),
+        nesla_token_get_column(statement->token), "Branch expanded to %s over JMP: +%u bytes, +%u cycles taken, +%u cycles not taken",
+        nesla_opcode_get_instruction(nesla_opcode_invert(statement->instruction)), statement->length - branch->length,
+        (inverse->cycles + jump->cycles) - (branch->cycles + 1), (inverse->cycles + 1) - branch->cycles);
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Place encoder label in an inlined copy, for a label placed between the copied subroutine statements. Each copy gets
+ *        its own labels, which are kept out of the symbol table.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in] symbol Symbol index, of the label placed in the subroutine
+ * @param[in] anchor Index plus one of the copied statement the label follows
+ * @param[in] first First symbol index, of the labels placed in this copy
+ * @param[in,out] index Pointer to symbol index, of the label placed in the copy
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_encoder_place(nesla_encoder_t *encoder, uint32_t symbol, uint32_t anchor, size_t first, uint32_t *index)
+{
+    nesla_symbol_t *label;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(size_t offset = first; offset < encoder->symbol_count; ++offset) {
+
+        if((encoder->symbol[offset].anchor == anchor) && (encoder->symbol[offset].token == encoder->symbol[symbol].token)) {
+            *index = offset;
+            goto exit;
+        }
+    }
+
+    if((result = nesla_context_reserve(encoder->context, (void **)&encoder->symbol, &encoder->symbol_capacity, encoder->symbol_count,
+            sizeof(*label))) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    label = &encoder->symbol[encoder->symbol_count];
+    *label = encoder->symbol[symbol];
+    label->anchor = anchor;
+    *index = encoder->symbol_count++;
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Queue encoder fixup, to evaluate in the next relaxation pass.
+ * @param[in,out] layout Pointer to layout context
+ * @param[in] index Fixup index
+ */
+static void nesla_encoder_queue(nesla_layout_t *layout, uint32_t index)
+{
+
+    if(!layout->queued[index]) {
+        layout->queued[index] = true;
+        layout->work[layout->work_count++] = index;
+    }
+}
+
+/*!
+ * @brief Lay out encoder sections whose statement lengths changed, moving the statements and labels that follow them. Branches
+ *        in those sections, and fixups referencing labels that moved, are queued for the next relaxation pass.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in,out] layout Pointer to layout context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_encoder_layout(nesla_encoder_t *encoder, nesla_layout_t *layout)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(size_t index = 0; index < encoder->section_count; ++index) {
+        const nesla_section_t *section = &encoder->section[index];
+        size_t address = encoder->statement[section->first].address, low = 0, high = encoder->fixup_count;
+
+        if(!section->dirty) {
+            continue;
+        }
+
+        for(size_t offset = section->first; offset < (section->first + section->count); ++offset) {
+            nesla_statement_t *statement = &encoder->statement[offset];
+
+            if((address + statement->length) > (UINT16_MAX + 1)) {
+                result = SET_ERROR_AT(encoder->context, nesla_token_get_path(statement->token), nesla_token_get_line(statement->token),
+                    nesla_token_get_column(statement->token), "Origin overflow: %04zX+%u", address, statement->length);
+                goto exit;
+            }
+
+            statement->address = address;
+            address += statement->length;
+        }
+
+        while(low < high) {
+            size_t middle = (low + high) / 2;
+
+            if(encoder->fixup[middle].statement < section->first) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+
+        for(; (low < encoder->fixup_count) && (encoder->fixup[low].statement < (section->first + section->count)); ++low) {
+
+            if((encoder->fixup[low].type == FIXUP_RELATIVE) && (encoder->fixup[low].index != ENCODER_UNRESOLVED)) {
+                nesla_encoder_queue(layout, low);
+            }
+        }
+    }
+
+    for(size_t index = 0; index < encoder->symbol_count; ++index) {
+        nesla_symbol_t *symbol = &encoder->symbol[index];
+        const nesla_statement_t *statement;
+
+        if(!symbol->anchor || !encoder->section[(statement = &encoder->statement[symbol->anchor - 1])->section].dirty
+                || (symbol->address == (statement->address + statement->length))) {
+            continue;
+        }
+
+        symbol->address = statement->address + statement->length;
+
+        for(size_t reference = layout->first[index]; reference < layout->first[index + 1]; ++reference) {
+            nesla_encoder_queue(layout, layout->reference[reference]);
+        }
+    }
+
+exit:
+
+    for(size_t index = 0; index < encoder->section_count; ++index) {
+        encoder->section[index].dirty = false;
+    }
+
+    return result;
+}
+
+/*!
+ * @brief Undo encoder jump chain retargeting of a branch, once layout moved its final destination out of range.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in,out] fixup Pointer to fixup context
+ */
+static void nesla_encoder_unchain(nesla_encoder_t *encoder, nesla_fixup_t *fixup)
+{
+    const nesla_statement_t *statement = &encoder->statement[fixup->statement];
+
+    SET_NOTE_AT(encoder->context, nesla_token_get_path(statement->token), nesla_token_get_line(statement->token),
+        nesla_token_get_column(statement->token), "Jump chain undone, %s out of range of %s: +%u cycles",
+        nesla_opcode_get_instruction(statement->instruction),
+        nesla_literal_get(nesla_token_get_literal(encoder->symbol[fixup->index].token)), fixup->saved);
+    --encoder->context->statistics.optimized;
+    encoder->context->statistics.saved_cycles -= fixup->saved;
+    fixup->index = fixup->chained;
+    fixup->chained = ENCODER_UNRESOLVED;
+    fixup->saved = 0;
+}
+
+/*!
+ * @brief Evaluate encoder fixup, changing its statement if the value of its symbol calls for another encoding.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in,out] layout Pointer to layout context
+ * @param[in,out] fixup Pointer to fixup context
+ * @param[in,out] changed Pointer to changed state, set if the statement changed
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_encoder_evaluate(nesla_encoder_t *encoder, nesla_layout_t *layout, nesla_fixup_t *fixup, bool *changed)
+{
+    int offset;
+    nesla_mode_e mode;
+    const nesla_statement_t *statement = &encoder->statement[fixup->statement];
+    uint16_t value = encoder->symbol[fixup->index].address;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(fixup->type == FIXUP_RELATIVE) {
+        offset = (int)value - (int)(statement->address + statement->length);
+
+        if(((offset < INT8_MIN) || (offset > INT8_MAX)) && (fixup->chained != ENCODER_UNRESOLVED)) {
+            nesla_encoder_unchain(encoder, fixup);
+            offset = (int)encoder->symbol[fixup->index].address - (int)(statement->address + statement->length);
+        }
+
+        if((encoder->context->flags & NESLA_FLAG_RELAX_BRANCH) && ((offset < INT8_MIN) || (offset > INT8_MAX))) {
+
+            if((result = nesla_encoder_expand(encoder, fixup)) == NESLA_FAILURE) {
+                goto exit;
+            }
+
+            ++layout->change[fixup->statement];
+            *changed = true;
+        }
+
+        goto exit;
+    }
+
+    if((layout->change[fixup->statement] > ENCODER_CHANGE_MAX)
+            || ((mode = nesla_encoder_direct(statement, value <= UINT8_MAX)) == MODE_MAX)
+            || (mode == statement->mode)) {
+        goto exit;
+    }
+
+    if(++layout->change[fixup->statement] > ENCODER_CHANGE_MAX) {
+        mode = nesla_encoder_direct(statement, false);
+        SET_WARNING_AT(encoder->context, nesla_token_get_path(statement->token), nesla_token_get_line(statement->token),
+            nesla_token_get_column(statement->token), "Addressing mode oscillates, kept %s", nesla_opcode_get_mode(mode));
+
+        if(mode == statement->mode) {
+            goto exit;
+        }
+    }
+
+    if((result = nesla_encoder_change(encoder, fixup, mode)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    *changed = true;
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Relax encoder direct operands to zero-page wherever their value is below $100, and back to absolute otherwise. If
+ *        NESLA_FLAG_RELAX_BRANCH is set, out-of-range branches are expanded into an inverted branch over a jump, and are never
+ *        shrunk back. Sections the optimizer changed are laid out first. Each pass re-lays out the sections that changed, and
+ *        only evaluates the fixups that layout may have affected, until a pass changes nothing. A statement that keeps changing
+ *        is kept absolute.
+ * @param[in,out] encoder Pointer to encoder context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_encoder_relax(nesla_encoder_t *encoder)
+{
+    nesla_layout_t layout = {};
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(!(layout.change = nesla_context_allocate(encoder->context, encoder->statement_count + 1))
+            || !(layout.queued = nesla_context_allocate(encoder->context, encoder->fixup_count + 1))
+            || !(layout.work = nesla_context_allocate(encoder->context, (encoder->fixup_count + 1) * sizeof(*layout.work)))
+            || !(layout.reference = nesla_context_allocate(encoder->context, ((2 * encoder->fixup_count) + 1) * sizeof(*layout.reference)))
+            || !(layout.first = nesla_context_allocate(encoder->context, (encoder->symbol_count + 1) * sizeof(*layout.first)))) {
+        result = SET_ERROR(encoder->context, "Failed to allocate layout: %zu", encoder->statement_count);
+        goto exit;
+    }
+
+    for(size_t index = 0; index < encoder->fixup_count; ++index) {
+
+        if(encoder->fixup[index].index != ENCODER_UNRESOLVED) {
+            ++layout.first[encoder->fixup[index].index + 1];
+            nesla_encoder_queue(&layout, index);
+
+            if(encoder->fixup[index].chained != ENCODER_UNRESOLVED) {
+                ++layout.first[encoder->fixup[index].chained + 1];
+            }
+        }
+    }
+
+    for(size_t index = 0; index < encoder->symbol_count; ++index) {
+        layout.first[index + 1] += layout.first[index];
+    }
+
+    for(size_t index = 0; index < encoder->fixup_count; ++index) {
+
+        if(encoder->fixup[index].index != ENCODER_UNRESOLVED) {
+            layout.reference[layout.first[encoder->fixup[index].index]++] = index;
+
+            if(encoder->fixup[index].chained != ENCODER_UNRESOLVED) {
+                layout.reference[layout.first[encoder->fixup[index].chained]++] = index;
+            }
+        }
+    }
+
+    for(size_t index = encoder->symbol_count; index > 0; --index) {
+        layout.first[index] = layout.first[index - 1];
+    }
+
+    layout.first[0] = 0;
+
+    if((result = nesla_encoder_layout(encoder, &layout)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    for(size_t pass = 0; layout.work_count; ++pass) {
+        bool changed = false;
+        size_t count = layout.work_count;
+
+        if(pass == ENCODER_PASS_MAX) {
+            result = SET_ERROR(encoder->context, "Layout did not converge: %u passes", ENCODER_PASS_MAX);
+            goto exit;
+        }
+
+        for(size_t index = 0; index < count; ++index) {
+            layout.queued[layout.work[index]] = false;
+
+            if((result = nesla_encoder_evaluate(encoder, &layout, &encoder->fixup[layout.work[index]], &changed)) == NESLA_FAILURE) {
+                goto exit;
+            }
+        }
+
+        layout.work_count = 0;
+
+        if(changed) {
+            ++encoder->context->statistics.pass;
+
+            if((result = nesla_encoder_layout(encoder, &layout)) == NESLA_FAILURE) {
+                goto exit;
+            }
+        }
+    }
+
+    for(size_t index = 0; index < encoder->statement_count; ++index) {
+
+        if(layout.change[index]) {
+            ++encoder->context->statistics.relaxed;
+        }
+    }
+
+exit:
+    nesla_context_free(encoder->context, layout.first);
+    nesla_context_free(encoder->context, layout.reference);
+    nesla_context_free(encoder->context, layout.work);
+    nesla_context_free(encoder->context, layout.queued);
+    nesla_context_free(encoder->context, layout.change);
+
+    return result;
+}
+
+nesla_error_e nesla_encoder_define(nesla_encoder_t *encoder, const nesla_token_t *token, size_t bank, uint16_t address)
+{
+
+    if(nesla_literal_get(nesla_token_get_literal(token))[0] != '_') {
+        encoder->scope = ++encoder->scope_count;
+    }
+
+    return nesla_encoder_insert(encoder, token, bank, address, false);
+}
+
+nesla_error_e nesla_encoder_define_constant(nesla_encoder_t *encoder, const nesla_token_t *token, const nesla_token_t *operand)
+{
+    uint16_t value;
+    nesla_error_e result;
+
+    if(!nesla_encoder_value(encoder, operand, &value)) {
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(operand), nesla_token_get_line(operand),
+            nesla_token_get_column(operand), "%s: %s", nesla_encoder_find(encoder, operand, nesla_encoder_scope(encoder, operand))
+                ? "Symbol not placed yet" : "Undefined symbol", nesla_literal_get(nesla_token_get_literal(operand)));
+        goto exit;
+    }
+
+    if(((result = nesla_encoder_insert(encoder, token, 0, value, true)) == NESLA_SUCCESS)
+            && (nesla_token_get_type(operand) == TOKEN_IDENTIFIER)
+            && !nesla_encoder_find(encoder, operand, nesla_encoder_scope(encoder, operand))->constant) {
+        result = nesla_encoder_put_keep(encoder, operand);
+    }
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_encoder_end_pack(nesla_encoder_t *encoder)
+{
+    static const uint8_t EMPTY[1] = {};
+    nesla_packed_t *pack = encoder->pack;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(!pack) {
+        goto exit;
+    }
+
+    encoder->pack = NULL;
+
+    if(!pack->input_length) {
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(pack->name), nesla_token_get_line(pack->name),
+            nesla_token_get_column(pack->name), "Empty packed block: %s", nesla_literal_get(nesla_token_get_literal(pack->name)));
+        goto exit;
+    }
+
+    if(((result = nesla_encoder_put_label(encoder, pack->name, pack->bank, pack->address, &pack->label)) == NESLA_FAILURE)
+            || ((result = nesla_encoder_append(encoder, pack->token, pack->bank, pack->address, INSTRUCTION_MAX, MODE_IMPLIED, EMPTY, 0))
+                == NESLA_FAILURE)) {
+        goto exit;
+    }
+
+    pack->statement = encoder->statement_count - 1;
+    result = nesla_pack_start(encoder, pack);
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_encoder_get_constant(nesla_encoder_t *encoder, const nesla_token_t *token, const char *name, uint16_t *value)
+{
+    nesla_token_t named = {};
+    const nesla_symbol_t *symbol;
+    nesla_error_e result;
+
+    if((result = nesla_encoder_name(encoder, token, name, &named)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if(!(symbol = nesla_encoder_find(encoder, &named, nesla_encoder_scope(encoder, &named))) || !symbol->constant || symbol->variable) {
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "%s: %s", symbol ? "Symbol not constant" : "Undefined symbol", name);
+        goto exit;
+    }
+
+    *value = symbol->address;
+
+exit:
+    nesla_token_free(&named, encoder->context);
+
+    return result;
+}
+
+nesla_fixup_t *nesla_encoder_get_fixup(const nesla_encoder_t *encoder, size_t index)
+{
+    size_t low = 0, high = encoder->fixup_count;
+
+    while(low < high) {
+        size_t middle = (low + high) / 2;
+
+        if(encoder->fixup[middle].statement < index) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return ((low < encoder->fixup_count) && (encoder->fixup[low].statement == index) && (encoder->fixup[low].index != ENCODER_UNRESOLVED))
+        ? &encoder->fixup[low] : NULL;
+}
+
+nesla_symbol_t *nesla_encoder_get_symbol(const nesla_encoder_t *encoder, const nesla_token_t *token, uint32_t scope)
+{
+    return nesla_encoder_find(encoder, token, scope);
+}
+
+void nesla_encoder_initialize(nesla_encoder_t *encoder, nesla_context_t *context)
+{
+    memset(encoder, 0, sizeof(*encoder));
+    encoder->context = context;
+}
+
+bool nesla_encoder_is_packing(const nesla_encoder_t *encoder)
+{
+    return encoder->pack != NULL;
+}
+
+nesla_error_e nesla_encoder_put_budget(nesla_encoder_t *encoder, const nesla_token_t *token, const nesla_token_t *symbol, uint32_t cycles)
+{
+    nesla_budget_t *budget;
+    nesla_error_e result;
+
+    if((result = nesla_context_reserve(encoder->context, (void **)&encoder->budget, &encoder->budget_capacity, encoder->budget_count,
+            sizeof(*budget))) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    budget = &encoder->budget[encoder->budget_count++];
+    budget->token = token;
+    budget->symbol = symbol;
+    budget->scope = symbol ? nesla_encoder_scope(encoder, symbol) : 0;
+    budget->cycles = cycles;
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_encoder_put_code(nesla_encoder_t *encoder, const nesla_token_t *token, size_t bank, uint16_t address,
+    nesla_instruction_e instruction, nesla_mode_e mode, uint16_t value, uint32_t symbol, size_t *length)
+{
+    size_t count = 1;
+    nesla_fixup_t *fixup;
+    uint8_t data[3] = { value, value, value >> 8 };
+    nesla_error_e result;
+
+    if(instruction != INSTRUCTION_MAX) {
+        const nesla_opcode_t *opcode = nesla_opcode_get(instruction, mode);
+
+        data[0] = opcode->opcode;
+        count = opcode->length;
+    } else if(mode == MODE_ABSOLUTE) {
+        data[1] = value >> 8;
+        count = 2;
+    }
+
+    if((result = nesla_encoder_append(encoder, token, bank, address, instruction, mode, data, count)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if(symbol != ENCODER_UNRESOLVED) {
+
+        if((result = nesla_context_reserve(encoder->context, (void **)&encoder->fixup, &encoder->fixup_capacity, encoder->fixup_count,
+                sizeof(*fixup))) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        fixup = &encoder->fixup[encoder->fixup_count++];
+        fixup->symbol = encoder->symbol[symbol].token;
+        fixup->statement = encoder->statement_count - 1;
+        fixup->scope = encoder->symbol[symbol].scope;
+        fixup->index = symbol;
+        fixup->chained = ENCODER_UNRESOLVED;
+        fixup->saved = 0;
+        fixup->type = (mode == MODE_RELATIVE) ? FIXUP_RELATIVE
+            : (((count == 3) || ((instruction == INSTRUCTION_MAX) && (count == 2))) ? FIXUP_WORD : FIXUP_BYTE);
+        fixup->forward = false;
+    }
+
+    *length = count;
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_encoder_put_data(nesla_encoder_t *encoder, const nesla_token_t *token, size_t bank, uint16_t address,
+    const nesla_token_t *operand, size_t width, size_t *length)
+{
+    uint8_t data[2] = {};
+    nesla_error_e result;
+
+    if(encoder->pack && (nesla_token_get_type(operand) != TOKEN_LITERAL)) {
+        const nesla_symbol_t *symbol = NULL;
+        uint16_t value;
+
+        if((nesla_token_get_type(operand) != TOKEN_SCALAR) && (!(symbol = nesla_encoder_find(encoder, operand,
+                nesla_encoder_scope(encoder, operand))) || !symbol->constant || symbol->variable)) {
+            result = SET_ERROR_AT(encoder->context, nesla_token_get_path(operand), nesla_token_get_line(operand),
+                nesla_token_get_column(operand), "Packed data must be constant: %s", nesla_literal_get(nesla_token_get_literal(operand)));
+            goto exit;
+        }
+
+        value = symbol ? symbol->address : nesla_token_get_scalar(operand);
+
+        if((width == 1) && (value > UINT8_MAX)) {
+            result = SET_ERROR_AT(encoder->context, nesla_token_get_path(operand), nesla_token_get_line(operand),
+                nesla_token_get_column(operand), "Value too large: %u", value);
+            goto exit;
+        }
+
+        data[0] = value;
+        data[1] = value >> 8;
+        *length = 0;
+        result = nesla_encoder_put_packed(encoder, operand, data, width);
+        goto exit;
+    }
+
+    if(nesla_token_get_type(operand) == TOKEN_LITERAL) {
+        const nesla_literal_t *literal = nesla_token_get_literal(operand);
+
+        if(width != 1) {
+            result = SET_ERROR_AT(encoder->context, nesla_token_get_path(operand), nesla_token_get_line(operand),
+                nesla_token_get_column(operand), "Unsupported literal width: %zu", width);
+            goto exit;
+        }
+
+        if(encoder->pack) {
+            *length = 0;
+            result = nesla_encoder_put_packed(encoder, operand, nesla_literal_get(literal), nesla_literal_get_length(literal));
+            goto exit;
+        }
+
+        if((result = nesla_encoder_append(encoder, token, bank, address, INSTRUCTION_MAX, MODE_IMPLIED, nesla_literal_get(literal),
+                nesla_literal_get_length(literal))) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        *length = nesla_literal_get_length(literal);
+        goto exit;
+    }
+
+    if((result = nesla_encoder_append(encoder, token, bank, address, INSTRUCTION_MAX, (width == 1) ? MODE_IMPLIED : MODE_ABSOLUTE, data,
+            width)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if((result = nesla_encoder_reference(encoder, (width == 1) ? FIXUP_BYTE : FIXUP_WORD, operand)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    *length = width;
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_encoder_put_inlined(nesla_encoder_t *encoder, const nesla_inlined_t *inlined, size_t count)
+{
+    nesla_statement_t *statement = NULL;
+    nesla_fixup_t *fixup = NULL;
+    uint32_t *position = NULL;
+    size_t statement_count = encoder->statement_count, fixup_count = encoder->fixup_count, symbol_count = encoder->symbol_count,
+        capacity, length = 0, next = 0;
+    nesla_error_e result;
+
+    for(size_t index = 0; index < count; ++index) {
+        statement_count += inlined[index].count - 1;
+        fixup_count += inlined[index].count;
+
+        for(size_t offset = inlined[index].entry; offset < (inlined[index].entry + inlined[index].count); ++offset) {
+            length += encoder->statement[offset].length;
+        }
+    }
+
+    capacity = fixup_count + 1;
+
+    if((result = nesla_encoder_reserve(encoder, length)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if(!(statement = nesla_context_allocate(encoder->context, statement_count * sizeof(*statement)))
+            || !(fixup = nesla_context_allocate(encoder->context, capacity * sizeof(*fixup)))
+            || !(position = nesla_context_allocate(encoder->context, (encoder->statement_count + 1) * sizeof(*position)))) {
+        result = SET_ERROR(encoder->context, "Failed to allocate inlined statements: %zu", statement_count);
+        goto exit;
+    }
+
+    for(size_t index = 0, call = 0; index < encoder->statement_count; ++index) {
+        position[index] = next;
+        next += ((call < count) && (inlined[call].first == index)) ? inlined[call++].count : 1;
+    }
+
+    position[encoder->statement_count] = next;
+    fixup_count = 0;
+
+    for(size_t index = 0, call = 0, source = 0; index < encoder->statement_count; ++index) {
+        bool copy = (call < count) && (inlined[call].first == index);
+        size_t first = encoder->symbol_count;
+
+        for(; (source < encoder->fixup_count) && (encoder->fixup[source].statement == index); ++source) {
+
+            if(!copy) {
+                fixup[fixup_count] = encoder->fixup[source];
+                fixup[fixup_count++].statement = position[index];
+            }
+        }
+
+        if(!copy) {
+            statement[position[index]] = encoder->statement[index];
+            continue;
+        }
+
+        for(size_t offset = 0; offset < inlined[call].count; ++offset) {
+            const nesla_statement_t *original = &encoder->statement[inlined[call].entry + offset];
+            const nesla_fixup_t *reference = nesla_encoder_get_fixup(encoder, inlined[call].entry + offset);
+            nesla_statement_t *copied = &statement[position[index] + offset];
+            uint32_t anchor;
+
+            *copied = *original;
+            copied->offset = encoder->length;
+            copied->section = encoder->statement[index].section;
+            copied->bank = encoder->statement[index].bank;
+            copied->address = encoder->statement[index].address;
+            memcpy(encoder->data + encoder->length, encoder->data + original->offset, original->length);
+            encoder->length += original->length;
+
+            if(!reference) {
+                continue;
+            }
+
+            fixup[fixup_count] = *reference;
+            fixup[fixup_count].statement = position[index] + offset;
+            fixup[fixup_count].forward = false;
+            anchor = encoder->symbol[reference->index].anchor;
+
+            if(((copied->mode == MODE_RELATIVE) || (copied->instruction == INSTRUCTION_JMP)) && (anchor > inlined[call].entry)
+                    && (anchor <= (inlined[call].entry + inlined[call].count))
+                    && ((result = nesla_encoder_place(encoder, reference->index, position[index] + (anchor - inlined[call].entry), first,
+                        &fixup[fixup_count].index)) == NESLA_FAILURE)) {
+                goto exit;
+            }
+
+            if((reference->chained != ENCODER_UNRESOLVED)
+                    && ((anchor = encoder->symbol[reference->chained].anchor) > inlined[call].entry)
+                    && (anchor <= (inlined[call].entry + inlined[call].count))
+                    && ((result = nesla_encoder_place(encoder, reference->chained, position[index] + (anchor - inlined[call].entry), first,
+                        &fixup[fixup_count].chained)) == NESLA_FAILURE)) {
+                goto exit;
+            }
+
+            ++fixup_count;
+        }
+
+        ++call;
+    }
+
+    for(size_t index = 0; index < symbol_count; ++index) {
+
+        if(encoder->symbol[index].anchor) {
+            encoder->symbol[index].anchor = position[encoder->symbol[index].anchor];
+        }
+    }
+
+    for(size_t index = 0; index < encoder->section_count; ++index) {
+        nesla_section_t *section = &encoder->section[index];
+        uint32_t last = position[section->first + section->count];
+
+        section->first = position[section->first];
+
+        if((last - section->first) != section->count) {
+            section->count = last - section->first;
+            section->dirty = true;
+        }
+    }
+
+    for(size_t index = 0; index < count; ++index) {
+        nesla_inlined_t *record;
+
+        if((result = nesla_context_reserve(encoder->context, (void **)&encoder->inlined, &encoder->inlined_capacity,
+                encoder->inlined_count, sizeof(*record))) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        record = &encoder->inlined[encoder->inlined_count++];
+        *record = inlined[index];
+        record->first = position[inlined[index].first];
+        record->entry = position[inlined[index].entry];
+    }
+
+    nesla_context_free(encoder->context, encoder->statement);
+    encoder->statement = statement;
+    encoder->statement_count = statement_count;
+    encoder->statement_capacity = statement_count;
+    statement = NULL;
+    nesla_context_free(encoder->context, encoder->fixup);
+    encoder->fixup = fixup;
+    encoder->fixup_capacity = capacity;
+    encoder->fixup_count = fixup_count;
+    fixup = NULL;
+
+exit:
+    nesla_context_free(encoder->context, position);
+    nesla_context_free(encoder->context, fixup);
+    nesla_context_free(encoder->context, statement);
+
+    return result;
+}
+
+nesla_error_e nesla_encoder_put_instruction(nesla_encoder_t *encoder, const nesla_token_t *token, size_t bank, uint16_t address,
+    nesla_mode_e mode, const nesla_token_t *operand, nesla_fixup_e type, size_t *length)
+{
+    uint16_t value = 0;
+    uint8_t data[3] = {};
+    const nesla_opcode_t *opcode;
+    nesla_instruction_e instruction = nesla_token_get_subtype(token);
+    nesla_error_e result;
+
+    switch(mode) {
+        case MODE_IMPLIED:
+
+            if(!nesla_opcode_get(instruction, MODE_IMPLIED)->valid && nesla_opcode_get(instruction, MODE_ACCUMULATOR)->valid) {
+                mode = MODE_ACCUMULATOR;
+            }
+            break;
+        case MODE_ABSOLUTE:
+        case MODE_ABSOLUTE_X:
+        case MODE_ABSOLUTE_Y:
+
+            if((mode == MODE_ABSOLUTE) && nesla_opcode_get(instruction, MODE_RELATIVE)->valid) {
+                mode = MODE_RELATIVE;
+            } else if(nesla_encoder_value(encoder, operand, &value) && (value <= UINT8_MAX)
+                    && nesla_opcode_get(instruction, mode - MODE_ABSOLUTE + MODE_ZERO_PAGE)->valid) {
+                mode = mode - MODE_ABSOLUTE + MODE_ZERO_PAGE;
+            }
+            break;
+        default:
+            break;
+    }
+
+    if(!(opcode = nesla_opcode_get(instruction, mode))->valid) {
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Unsupported addressing mode: %s", nesla_opcode_get_mode(mode));
+        goto exit;
+    }
+
+    data[0] = opcode->opcode;
+
+    if((result = nesla_encoder_append(encoder, token, bank, address, instruction, mode, data, opcode->length)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if(operand && ((result = nesla_encoder_reference(encoder, (mode == MODE_IMMEDIATE) ? type
+            : ((mode == MODE_RELATIVE) ? FIXUP_RELATIVE : ((opcode->length == 3) ? FIXUP_WORD : FIXUP_BYTE)), operand)) == NESLA_FAILURE)) {
+        goto exit;
+    }
+
+    *length = opcode->length;
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_encoder_put_jump(nesla_encoder_t *encoder, const nesla_token_t *token, size_t bank, uint16_t address, bool dispatch,
+    const nesla_token_t *name, const nesla_token_t **entry, size_t count, size_t *length)
+{
+    static const char *SUFFIX[] = { "_LO", "_HI", "_COUNT", };
+    static const nesla_instruction_e STUB[] = { INSTRUCTION_LDA, INSTRUCTION_PHA, INSTRUCTION_LDA, INSTRUCTION_PHA, INSTRUCTION_RTS, };
+    static const uint8_t EMPTY[1] = {};
+    size_t offset = 0;
+    nesla_token_t *derived[JUMP_MAX] = {};
+    nesla_error_e result;
+
+    if(!count || (count > ENCODER_JUMP_MAX)) {
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(name), nesla_token_get_line(name), nesla_token_get_column(name),
+            "Invalid jump table entry count: %zu", count);
+        goto exit;
+    }
+
+    for(size_t index = 0; index < JUMP_MAX; ++index) {
+
+        if((result = nesla_encoder_derive(encoder, name, (const char *)nesla_literal_get(nesla_token_get_literal(name)), SUFFIX[index],
+                &derived[index])) == NESLA_FAILURE) {
+            goto exit;
+        }
+    }
+
+    if((result = nesla_encoder_insert(encoder, derived[JUMP_COUNT], 0, count, true)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if(dispatch) {
+
+        if((result = nesla_encoder_insert(encoder, name, bank, address, false)) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        for(size_t index = 0; index < (sizeof(STUB) / sizeof(*STUB)); ++index) {
+            nesla_mode_e mode = (STUB[index] == INSTRUCTION_LDA) ? MODE_ABSOLUTE_X : MODE_IMPLIED;
+            const nesla_opcode_t *opcode = nesla_opcode_get(STUB[index], mode);
+            uint8_t data[3] = { opcode->opcode, };
+
+            if((result = nesla_encoder_append(encoder, token, bank, address + offset, STUB[index], mode, data, opcode->length))
+                    == NESLA_FAILURE) {
+                goto exit;
+            }
+
+            if((mode == MODE_ABSOLUTE_X) && ((result = nesla_encoder_reference(encoder, FIXUP_WORD,
+                    derived[index ? JUMP_LOW : JUMP_HIGH])) == NESLA_FAILURE)) {
+                goto exit;
+            }
+
+            offset += opcode->length;
+        }
+    }
+
+    for(size_t table = JUMP_LOW; table <= JUMP_HIGH; ++table) {
+        nesla_fixup_e type = (table == JUMP_LOW) ? (dispatch ? FIXUP_LOW_RETURN : FIXUP_LOW) : (dispatch ? FIXUP_HIGH_RETURN : FIXUP_HIGH);
+
+        if((result = nesla_encoder_insert(encoder, derived[table], bank, address + offset, false)) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        for(size_t index = 0; index < count; ++index) {
+
+            if(((result = nesla_encoder_append(encoder, token, bank, address + offset, INSTRUCTION_MAX, MODE_IMPLIED, EMPTY, 1))
+                    == NESLA_FAILURE) || ((result = nesla_encoder_reference(encoder, type, entry[index])) == NESLA_FAILURE)) {
+                goto exit;
+            }
+
+            ++offset;
+        }
+    }
+
+    *length = offset;
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_encoder_put_keep(nesla_encoder_t *encoder, const nesla_token_t *token)
+{
+    nesla_keep_t *keep;
+    nesla_error_e result;
+
+    if((result = nesla_context_reserve(encoder->context, (void **)&encoder->keep, &encoder->keep_capacity, encoder->keep_count,
+            sizeof(*keep))) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    keep = &encoder->keep[encoder->keep_count++];
+    keep->token = token;
+    keep->scope = nesla_encoder_scope(encoder, token);
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_encoder_put_label(nesla_encoder_t *encoder, const nesla_token_t *token, size_t bank, uint16_t address,
+    uint32_t *index)
+{
+    nesla_symbol_t *label;
+    nesla_error_e result;
+
+    if((result = nesla_context_reserve(encoder->context, (void **)&encoder->symbol, &encoder->symbol_capacity, encoder->symbol_count,
+            sizeof(*label))) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    label = &encoder->symbol[encoder->symbol_count];
+    label->token = token;
+    label->bank = bank;
+    label->address = address;
+    label->scope = 0;
+    label->anchor = 0;
+    label->variable = 0;
+    label->constant = false;
+    label->removed = false;
+
+    if(encoder->statement_count) {
+        const nesla_statement_t *previous = &encoder->statement[encoder->statement_count - 1];
+
+        if((previous->bank == bank) && ((previous->address + previous->length) == address)) {
+            label->anchor = encoder->statement_count;
+        }
+    }
+
+    *index = encoder->symbol_count++;
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_encoder_put_local(nesla_encoder_t *encoder, const nesla_token_t *token, const char *suffix, size_t bank,
+    uint16_t address, uint32_t *index)
+{
+    nesla_token_t *derived;
+    nesla_error_e result;
+
+    if((result = nesla_encoder_derive(encoder, token, (const char *)nesla_literal_get(nesla_token_get_literal(token)), suffix, &derived))
+            == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    result = nesla_encoder_put_label(encoder, derived, bank, address, index);
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_encoder_put_packed(nesla_encoder_t *encoder, const nesla_token_t *token, const uint8_t *data, size_t length)
+{
+    nesla_packed_t *pack = encoder->pack;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if((pack->input_length + length) > UINT16_MAX) {
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Packed block too long: %zu", pack->input_length + length);
+        goto exit;
+    }
+
+    while((pack->input_length + length) > pack->input_capacity) {
+
+        if((result = nesla_context_reserve(encoder->context, (void **)&pack->input, &pack->input_capacity, pack->input_capacity,
+                sizeof(*pack->input))) == NESLA_FAILURE) {
+            goto exit;
+        }
+    }
+
+    memcpy(pack->input + pack->input_length, data, length);
+    pack->input_length += length;
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_encoder_put_region(nesla_encoder_t *encoder, const nesla_token_t *token, uint16_t first, uint16_t last)
+{
+    nesla_region_t *region;
+    nesla_error_e result;
+
+    if(first > last) {
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Invalid RAM region: $%04X-$%04X", first, last);
+        goto exit;
+    }
+
+    if((result = nesla_context_reserve(encoder->context, (void **)&encoder->region, &encoder->region_capacity, encoder->region_count,
+            sizeof(*region))) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    region = &encoder->region[encoder->region_count++];
+    region->token = token;
+    region->first = first;
+    region->last = last;
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_encoder_put_removed(nesla_encoder_t *encoder, uint32_t symbol, uint32_t length)
+{
+    nesla_removed_t *removed;
+    nesla_error_e result;
+
+    if((result = nesla_context_reserve(encoder->context, (void **)&encoder->removed, &encoder->removed_capacity,
+            encoder->removed_count, sizeof(*removed))) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    removed = &encoder->removed[encoder->removed_count++];
+    removed->symbol = symbol;
+    removed->length = length;
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_encoder_put_relocation(nesla_encoder_t *encoder, const nesla_token_t *token, uint16_t pin,
+    const nesla_token_t *affinity, size_t *bank)
+{
+    nesla_relocation_t *relocation;
+    nesla_error_e result;
+
+    if((encoder->relocation_count + ENCODER_RELOCATE_BANK) > UINT16_MAX) {
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Too many relocatable sections: %zu", encoder->relocation_count);
+        goto exit;
+    }
+
+    if((result = nesla_context_reserve(encoder->context, (void **)&encoder->relocation, &encoder->relocation_capacity,
+            encoder->relocation_count, sizeof(*relocation))) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    *bank = ENCODER_RELOCATE_BANK + encoder->relocation_count;
+    relocation = &encoder->relocation[encoder->relocation_count++];
+    relocation->token = token;
+    relocation->affinity = affinity;
+    relocation->scope = affinity ? nesla_encoder_scope(encoder, affinity) : 0;
+    relocation->pin = pin;
+    relocation->align = 1;
+    relocation->page = false;
+    relocation->bank = 0;
+    relocation->address = 0;
+    relocation->length = 0;
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_encoder_put_structure(nesla_encoder_t *encoder, const nesla_token_t *token, const nesla_token_t *name,
+    uint16_t count, const nesla_field_t *field, size_t field_count)
+{
+    size_t size, stride = 0, zero_page = 0;
+    char *prefix = NULL;
+    const char *structure = (const char *)nesla_literal_get(nesla_token_get_literal(name));
+    nesla_token_t *derived;
+    nesla_error_e result;
+
+    if(!count || (count > ENCODER_STRUCTURE_MAX)) {
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(name), nesla_token_get_line(name), nesla_token_get_column(name),
+            "Invalid structure entry count: %u", count);
+        goto exit;
+    }
+
+    size = strlen(structure) + 2;
+
+    if(!(prefix = nesla_context_allocate(encoder->context, size))) {
+        result = SET_ERROR(encoder->context, "Failed to allocate structure: %s", structure);
+        goto exit;
+    }
+
+    snprintf(prefix, size, "%s_", structure);
+
+    if((result = nesla_encoder_derive(encoder, name, prefix, "COUNT", &derived)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if((result = nesla_encoder_insert(encoder, derived, 0, count, true)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    for(size_t index = 0; index < field_count; ++index) {
+        const nesla_field_t *entry = &field[index];
+        const char *suffix = (const char *)nesla_literal_get(nesla_token_get_literal(entry->token));
+        nesla_variable_t *variable;
+
+        size = count * entry->width;
+
+        if(entry->page && (size > RAM_PAGE_SIZE)) {
+            result = SET_ERROR_AT(encoder->context, nesla_token_get_path(entry->token), nesla_token_get_line(entry->token),
+                nesla_token_get_column(entry->token), "Field larger than a page: %s (%zu byte(s))", suffix, size);
+            goto exit;
+        }
+
+        if((result = nesla_encoder_derive(encoder, entry->token, prefix, suffix, &derived)) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        if((result = nesla_encoder_put_variable(encoder, derived, size)) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        variable = &encoder->variable[encoder->variable_count - 1];
+        variable->zero_page = entry->zero_page;
+        variable->page = entry->page;
+
+        if((entry->width > 1) && (((result = nesla_encoder_derive(encoder, entry->token,
+                (const char *)nesla_literal_get(nesla_token_get_literal(derived)), "_HI", &derived)) == NESLA_FAILURE)
+                    || ((result = nesla_encoder_put_variable_byte(encoder, derived, count)) == NESLA_FAILURE))) {
+            goto exit;
+        }
+
+        stride += entry->width;
+
+        if(entry->zero_page) {
+            zero_page += size;
+        }
+    }
+
+    SET_NOTE_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+        "Structure %s: %u entries, %zu field(s), %zu byte(s) per entry, %zu byte(s) of RAM (%zu in zero page)", structure, count,
+        field_count, stride, stride * count, zero_page);
+
+exit:
+    nesla_context_free(encoder->context, prefix);
+
+    return result;
+}
+
+nesla_error_e nesla_encoder_put_table(nesla_encoder_t *encoder, const nesla_token_t *token, size_t bank, uint16_t address,
+    const uint8_t *data, size_t length, size_t width)
+{
+    return nesla_encoder_append(encoder, token, bank, address, INSTRUCTION_MAX, (width == 1) ? MODE_IMPLIED : MODE_ABSOLUTE, data,
+        length);
+}
+
+nesla_error_e nesla_encoder_put_variable(nesla_encoder_t *encoder, const nesla_token_t *token, uint16_t size)
+{
+    nesla_variable_t *variable;
+    nesla_error_e result;
+
+    if((result = nesla_context_reserve(encoder->context, (void **)&encoder->variable, &encoder->variable_capacity,
+            encoder->variable_count, sizeof(*variable))) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if((result = nesla_encoder_insert(encoder, token, 0, 0, true)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    variable = &encoder->variable[encoder->variable_count++];
+    variable->token = token;
+    variable->symbol = encoder->symbol_count - 1;
+    variable->size = size;
+    variable->address = 0;
+    variable->references = 0;
+    variable->pointer = false;
+    variable->zero_page = false;
+    variable->page = false;
+    encoder->symbol[variable->symbol].variable = encoder->variable_count;
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_encoder_put_variable_byte(nesla_encoder_t *encoder, const nesla_token_t *token, uint16_t offset)
+{
+    nesla_error_e result;
+
+    if(!encoder->variable_count || (offset >= encoder->variable[encoder->variable_count - 1].size)) {
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Byte name past the end of variable: %s", nesla_literal_get(nesla_token_get_literal(token)));
+        goto exit;
+    }
+
+    if((result = nesla_encoder_insert(encoder, token, 0, offset, true)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    encoder->symbol[encoder->symbol_count - 1].variable = encoder->variable_count;
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_encoder_resolve(nesla_encoder_t *encoder)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(size_t index = 0; index < encoder->fixup_count; ++index) {
+        nesla_fixup_t *fixup = &encoder->fixup[index];
+        const nesla_symbol_t *symbol;
+
+        if(fixup->index != ENCODER_UNRESOLVED) {
+            continue;
+        }
+
+        if(!(symbol = nesla_encoder_find(encoder, fixup->symbol, fixup->scope))) {
+            result = SET_ERROR_AT(encoder->context, nesla_token_get_path(fixup->symbol), nesla_token_get_line(fixup->symbol),
+                nesla_token_get_column(fixup->symbol), "Undefined symbol: %s", nesla_literal_get(nesla_token_get_literal(fixup->symbol)));
+
+            if(nesla_context_is_full(encoder->context)) {
+                goto exit;
+            }
+        } else {
+            fixup->index = symbol - encoder->symbol;
+        }
+    }
+
+    if(nesla_list_get_length(&encoder->packed) && (nesla_pack_link(encoder) == NESLA_FAILURE)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(encoder->variable_count && (nesla_ram_allocate(encoder) == NESLA_FAILURE)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if((encoder->context->flags & NESLA_FLAG_PEEPHOLE) && (nesla_peephole_optimize(encoder) == NESLA_FAILURE)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if((encoder->context->flags & NESLA_FLAG_INLINE) && (nesla_inline_expand(encoder) == NESLA_FAILURE)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if((encoder->context->flags & NESLA_FLAG_DEAD) && (nesla_dead_remove(encoder) == NESLA_FAILURE)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(encoder->relocation_count && (nesla_bank_place(encoder) == NESLA_FAILURE)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if((encoder->context->flags & NESLA_FLAG_MERGE) && (nesla_merge_data(encoder) == NESLA_FAILURE)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(encoder->shadow && (nesla_far_link(encoder) == NESLA_FAILURE)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(nesla_encoder_relax(encoder) == NESLA_FAILURE) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    for(size_t index = 0; index < encoder->fixup_count; ++index) {
+        const nesla_fixup_t *fixup = &encoder->fixup[index];
+
+        if(fixup->index == ENCODER_UNRESOLVED) {
+            continue;
+        }
+
+        if(nesla_encoder_patch(encoder, fixup->statement, fixup->type, fixup->symbol, encoder->symbol[fixup->index].address)
+                == NESLA_FAILURE) {
+            result = NESLA_FAILURE;
+
+            if(nesla_context_is_full(encoder->context)) {
+                break;
+            }
+        } else if(fixup->forward) {
+            ++encoder->context->statistics.patched;
+        }
+    }
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_encoder_set_align(nesla_encoder_t *encoder, const nesla_token_t *token, size_t bank, uint16_t align, bool page,
+    uint16_t *address)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(!page && (!align || (align > ENCODER_ALIGN_MAX) || (align & (align - 1)))) {
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Invalid alignment: %u", align);
+        goto exit;
+    }
+
+    if(bank >= ENCODER_RELOCATE_BANK) {
+        nesla_relocation_t *relocation = &encoder->relocation[bank - ENCODER_RELOCATE_BANK];
+
+        if(*address != ENCODER_RELOCATE_ORIGIN) {
+            result = SET_ERROR_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+                "Alignment after the start of a relocatable section");
+            goto exit;
+        }
+
+        relocation->align = page ? 1 : align;
+        relocation->page = page;
+    } else if(page) {
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Page placement outside of a relocatable section");
+        goto exit;
+    } else if(*address & (align - 1)) {
+
+        if((*address + (align - (*address & (align - 1)))) > UINT16_MAX) {
+            result = SET_ERROR_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+                "Origin overflow: %04X, aligned to %u", *address, align);
+            goto exit;
+        }
+
+        *address += align - (*address & (align - 1));
+    }
+
+    encoder->align = true;
+
+exit:
+    return result;
+}
+
+void nesla_encoder_set_bound(nesla_encoder_t *encoder, uint16_t bound)
+{
+    encoder->bound = bound;
+}
+
+nesla_error_e nesla_encoder_set_far(nesla_encoder_t *encoder, const nesla_token_t *token)
+{
+    const nesla_symbol_t *symbol;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    encoder->far = true;
+
+    if(encoder->shadow) {
+        goto exit;
+    }
+
+    if((result = nesla_encoder_name(encoder, token, ENCODER_SHADOW, &encoder->shadow_name)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if((symbol = nesla_encoder_find(encoder, &encoder->shadow_name, 0))) {
+        encoder->shadow = (symbol - encoder->symbol) + 1;
+        goto exit;
+    }
+
+    if((result = nesla_encoder_put_variable(encoder, &encoder->shadow_name, 1)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    encoder->shadow = encoder->symbol_count;
+
+exit:
+    return result;
+}
+
+void nesla_encoder_set_hot(nesla_encoder_t *encoder)
+{
+    encoder->hot = true;
+}
+
+void nesla_encoder_set_mapper(nesla_encoder_t *encoder, uint16_t mapper)
+{
+    encoder->mapper = mapper;
+}
+
+void nesla_encoder_set_preserve(nesla_encoder_t *encoder, bool preserve)
+{
+    encoder->preserve = preserve;
+}
+
+nesla_error_e nesla_encoder_set_pack(nesla_encoder_t *encoder, const nesla_token_t *token, size_t bank, uint16_t address,
+    const nesla_token_t *mode, const nesla_token_t *name)
+{
+    static const char *MODE[] = { "RLE", "LZ", };
+    nesla_packed_t *pack = NULL;
+    uint8_t type = UNPACK_RLE;
+    nesla_error_e result;
+
+    if((result = nesla_encoder_end_pack(encoder)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    while((type <= UNPACK_LZ) && strcmp((const char *)nesla_literal_get(nesla_token_get_literal(mode)), MODE[type])) {
+        ++type;
+    }
+
+    if(type > UNPACK_LZ) {
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(mode), nesla_token_get_line(mode), nesla_token_get_column(mode),
+            "Unsupported compression mode: %s", nesla_literal_get(nesla_token_get_literal(mode)));
+        goto exit;
+    }
+
+    if(encoder->pack_count[type] >= PACK_BLOCK_MAX) {
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(name), nesla_token_get_line(name), nesla_token_get_column(name),
+            "Too many packed blocks: %zu", encoder->pack_count[type]);
+        goto exit;
+    }
+
+    if(((result = nesla_encoder_unpack(encoder, token, type)) == NESLA_FAILURE)
+            || ((result = nesla_encoder_insert(encoder, name, 0, encoder->pack_count[type], true)) == NESLA_FAILURE)) {
+        goto exit;
+    }
+
+    if(!(pack = nesla_context_allocate(encoder->context, sizeof(*pack)))) {
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(name), nesla_token_get_line(name), nesla_token_get_column(name),
+            "Failed to allocate packed block: %s", nesla_literal_get(nesla_token_get_literal(name)));
+        goto exit;
+    }
+
+    if((result = nesla_list_insert(&encoder->packed, encoder->context, nesla_list_get_tail(&encoder->packed), pack)) == NESLA_FAILURE) {
+        nesla_context_free(encoder->context, pack);
+        goto exit;
+    }
+
+    pack->token = token;
+    pack->name = name;
+    pack->mode = type;
+    pack->bank = bank;
+    pack->address = address;
+    ++encoder->pack_count[type];
+    encoder->pack = pack;
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_encoder_set_statement(nesla_encoder_t *encoder, size_t index, const uint8_t *data, size_t length)
+{
+    nesla_statement_t *statement = &encoder->statement[index];
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(length > UINT16_MAX) {
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(statement->token), nesla_token_get_line(statement->token),
+            nesla_token_get_column(statement->token), "Statement too long: %zu", length);
+        goto exit;
+    }
+
+    if(length > statement->length) {
+
+        if((result = nesla_encoder_reserve(encoder, length)) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        statement->offset = encoder->length;
+        encoder->length += length;
+    }
+
+    memcpy(encoder->data + statement->offset, data, length);
+    statement->length = length;
+    encoder->section[statement->section].dirty = true;
+
+exit:
+    return result;
+}
+
+void nesla_encoder_set_program(nesla_encoder_t *encoder, uint16_t count)
+{
+    encoder->program = count;
+}
+
+void nesla_encoder_set_stack(nesla_encoder_t *encoder, const nesla_token_t *token, uint16_t size)
+{
+    encoder->stack = token;
+    encoder->stack_size = size;
+}
+
+nesla_error_e nesla_encoder_undefine(nesla_encoder_t *encoder, const nesla_token_t *token)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(!nesla_table_remove(&encoder->table, (const char *)nesla_literal_get(nesla_token_get_literal(token)), nesla_token_get_hash(token),
+            nesla_encoder_scope(encoder, token))) {
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Undefined symbol: %s", nesla_literal_get(nesla_token_get_literal(token)));
+    }
+
+    return result;
+}
+
+void nesla_encoder_uninitialize(nesla_encoder_t *encoder)
+{
+    nesla_pack_free(encoder);
+    nesla_table_free(&encoder->table, encoder->context);
+    nesla_token_free(&encoder->shadow_name, encoder->context);
+
+    for(size_t index = 0; index < UNPACK_MAX; ++index) {
+        nesla_token_free(&encoder->unpack_name[index], encoder->context);
+    }
+
+    while(nesla_list_get_length(&encoder->derived)) {
+        nesla_list_entry_t *entry = nesla_list_get_head(&encoder->derived);
+
+        nesla_token_free(entry->context, encoder->context);
+        nesla_context_free(encoder->context, entry->context);
+        nesla_list_remove(&encoder->derived, encoder->context, entry);
+    }
+
+    nesla_context_free(encoder->context, encoder->inlined);
+    nesla_context_free(encoder->context, encoder->removed);
+    nesla_context_free(encoder->context, encoder->keep);
+    nesla_context_free(encoder->context, encoder->relocation);
+    nesla_context_free(encoder->context, encoder->region);
+    nesla_context_free(encoder->context, encoder->variable);
+    nesla_context_free(encoder->context, encoder->budget);
+    nesla_context_free(encoder->context, encoder->symbol);
+    nesla_context_free(encoder->context, encoder->fixup);
+    nesla_context_free(encoder->context, encoder->section);
+    nesla_context_free(encoder->context, encoder->statement);
+    nesla_context_free(encoder->context, encoder->data);
+    memset(encoder, 0, sizeof(*encoder));
+}
+
+nesla_error_e nesla_encoder_write(nesla_encoder_t *encoder, nesla_image_t *image)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(size_t index = 0; index < encoder->statement_count; ++index) {
+        const nesla_statement_t *statement = &encoder->statement[index];
+
+        if(!statement->length) {
+            continue;
+        }
+
+        if(nesla_image_put(image, statement->bank, statement->address, encoder->data + statement->offset, statement->length)
+                == NESLA_FAILURE) {
+            result = SET_ERROR_AT(encoder->context, nesla_token_get_path(statement->token), nesla_token_get_line(statement->token),
+                nesla_token_get_column(statement->token), "%s", nesla_context_get_error(encoder->context));
+
+            if(nesla_context_is_full(encoder->context)) {
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,488 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file expression.c
+ * @brief Constant expressions, compiled once and evaluated per table index.
+ */
+
+#include <expression.h>
+
+/*!
+ * @struct nesla_expression_parser_t
+ * @brief Expression parser context, over the bytes of a literal.
+ */
+typedef struct {
+    nesla_expression_t *expression;     /*!< Pointer to expression context */
+    nesla_encoder_t *encoder;           /*!< Pointer to encoder context */
+    const nesla_token_t *token;         /*!< Constant pointer to literal token context */
+    const char *data;                   /*!< Constant pointer to literal data */
+    size_t length;                      /*!< Literal length in bytes */
+    size_t position;                    /*!< Literal position in bytes */
+    size_t nest;                        /*!< Nesting depth */
+    size_t depth;                       /*!< Evaluation stack depth */
+} nesla_expression_parser_t;
+
+/*!
+ * @struct nesla_expression_binary_t
+ * @brief Expression binary operator.
+ */
+typedef struct {
+    const char *symbol;                 /*!< Operator symbol */
+    nesla_expression_e type;            /*!< Operation type */
+} nesla_expression_binary_t;
+
+/*!
+ * @brief Binary operators, by precedence level (lowest first). Each level ends with an empty symbol, and longer symbols
+ *        come before their prefixes.
+ */
+static const nesla_expression_binary_t EXPRESSION_BINARY[][4] = {
+    { { "|", EXPRESSION_OR }, {}, },
+    { { "^", EXPRESSION_XOR }, {}, },
+    { { "&", EXPRESSION_AND }, {}, },
+    { { "<<", EXPRESSION_SHIFT_LEFT }, { ">>", EXPRESSION_SHIFT_RIGHT }, {}, },
+    { { "+", EXPRESSION_ADD }, { "-", EXPRESSION_SUBTRACT }, {}, },
+    { { "*", EXPRESSION_MULTIPLY }, { "/", EXPRESSION_DIVIDE }, { "%", EXPRESSION_MODULO }, {}, },
+    };
+
+/*!
+ * @brief Report expression parser error, at the literal position.
+ * @param[in,out] parser Pointer to expression parser context
+ * @param[in] message Constant pointer to error message
+ * @return NESLA_ERROR
+ */
+static nesla_error_e nesla_expression_error(nesla_expression_parser_t *parser, const char *message)
+{
+    const nesla_token_t *token = parser->token;
+
+    return SET_ERROR_AT(parser->encoder->context, nesla_token_get_path(token), nesla_token_get_line(token),
+        nesla_token_get_column(token), "%s at offset %zu: %s", message, parser->position, parser->data);
+}
+
+/*!
+ * @brief Skip expression parser whitespace.
+ * @param[in,out] parser Pointer to expression parser context
+ */
+static void nesla_expression_skip(nesla_expression_parser_t *parser)
+{
+
+    while((parser->position < parser->length) && isspace((unsigned char)parser->data[parser->position])) {
+        ++parser->position;
+    }
+}
+
+/*!
+ * @brief Check if the next expression parser characters match a symbol, moving past it if found.
+ * @param[in,out] parser Pointer to expression parser context
+ * @param[in] symbol Constant pointer to symbol
+ * @return true if the symbol was found, false otherwise
+ */
+static bool nesla_expression_match(nesla_expression_parser_t *parser, const char *symbol)
+{
+    size_t length = strlen(symbol);
+    bool result = false;
+
+    nesla_expression_skip(parser);
+
+    if(((parser->length - parser->position) >= length) && !strncmp(parser->data + parser->position, symbol, length)) {
+        parser->position += length;
+        result = true;
+    }
+
+    return result;
+}
+
+/*!
+ * @brief Add expression operation, tracking the evaluation stack depth it needs.
+ * @param[in,out] parser Pointer to expression parser context
+ * @param[in] type Operation type
+ * @param[in] value Pushed value (EXPRESSION_VALUE)
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_expression_emit(nesla_expression_parser_t *parser, nesla_expression_e type, int64_t value)
+{
+    nesla_expression_t *expression = parser->expression;
+    nesla_error_e result;
+
+    switch(type) {
+        case EXPRESSION_VALUE:
+        case EXPRESSION_INDEX:
+
+            if(++parser->depth > EXPRESSION_DEPTH_MAX) {
+                result = nesla_expression_error(parser, "Expression too deep");
+                goto exit;
+            }
+            break;
+        case EXPRESSION_NEGATE:
+        case EXPRESSION_NOT:
+            break;
+        default:
+            --parser->depth;
+            break;
+    }
+
+    if((result = nesla_context_reserve(parser->encoder->context, (void **)&expression->operation, &expression->capacity,
+            expression->count, sizeof(*expression->operation))) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    expression->operation[expression->count].type = type;
+    expression->operation[expression->count++].value = value;
+
+exit:
+    return result;
+}
+
+static nesla_error_e nesla_expression_parse(nesla_expression_parser_t *parser, size_t level);
+
+/*!
+ * @brief Parse expression name: the table index (I), a function call (SIN/COS) or a constant (.DEF).
+ * @param[in,out] parser Pointer to expression parser context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_expression_parse_name(nesla_expression_parser_t *parser)
+{
+    uint16_t value;
+    char *name = NULL;
+    size_t first = parser->position, length;
+    nesla_error_e result;
+
+    while((parser->position < parser->length) && (isalnum((unsigned char)parser->data[parser->position])
+            || (parser->data[parser->position] == '_'))) {
+        ++parser->position;
+    }
+
+    length = parser->position - first;
+
+    if(!(name = nesla_context_allocate(parser->encoder->context, length + 1))) {
+        result = SET_ERROR(parser->encoder->context, "Failed to allocate expression name: %zu", length);
+        goto exit;
+    }
+
+    memcpy(name, parser->data + first, length);
+    name[length] = '\0';
+
+    if(!strcmp(name, "I")) {
+        result = nesla_expression_emit(parser, EXPRESSION_INDEX, 0);
+    } else if(!strcmp(name, "SIN") || !strcmp(name, "COS")) {
+
+        if(!nesla_expression_match(parser, "(")) {
+            result = nesla_expression_error(parser, "Expecting function arguments");
+            goto exit;
+        }
+
+        if((result = nesla_expression_parse(parser, 0)) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        if(!nesla_expression_match(parser, ",")) {
+            result = nesla_expression_error(parser, "Expecting function amplitude");
+            goto exit;
+        }
+
+        if((result = nesla_expression_parse(parser, 0)) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        if(!nesla_expression_match(parser, ")")) {
+            result = nesla_expression_error(parser, "Expecting closing parenthesis");
+            goto exit;
+        }
+
+        result = nesla_expression_emit(parser, (name[0] == 'S') ? EXPRESSION_SINE : EXPRESSION_COSINE, 0);
+    } else if((result = nesla_encoder_get_constant(parser->encoder, parser->token, name, &value)) == NESLA_SUCCESS) {
+        result = nesla_expression_emit(parser, EXPRESSION_VALUE, value);
+    }
+
+exit:
+    nesla_context_free(parser->encoder->context, name);
+
+    return result;
+}
+
+/*!
+ * @brief Parse expression scalar (decimal or $hexadecimal), limited to 16 bits like a scalar token.
+ * @param[in,out] parser Pointer to expression parser context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_expression_parse_scalar(nesla_expression_parser_t *parser)
+{
+    int base = 10, digits = 0;
+    int64_t value = 0;
+    nesla_error_e result;
+
+    if(parser->data[parser->position] == '$') {
+        base = 16;
+        ++parser->position;
+    }
+
+    while(parser->position < parser->length) {
+        int digit = toupper((unsigned char)parser->data[parser->position]);
+
+        if(isdigit(digit)) {
+            digit -= '0';
+        } else if((base == 16) && (digit >= 'A') && (digit <= 'F')) {
+            digit -= 'A' - 10;
+        } else {
+            break;
+        }
+
+        if((value = (value * base) + digit) > UINT16_MAX) {
+            result = nesla_expression_error(parser, "Scalar too large");
+            goto exit;
+        }
+
+        ++parser->position;
+        ++digits;
+    }
+
+    if(!digits) {
+        result = nesla_expression_error(parser, "Expecting scalar");
+        goto exit;
+    }
+
+    result = nesla_expression_emit(parser, EXPRESSION_VALUE, value);
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Parse expression unary operators, and the operand they apply to.
+ * @param[in,out] parser Pointer to expression parser context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_expression_parse_unary(nesla_expression_parser_t *parser)
+{
+    char next;
+    nesla_error_e result;
+
+    if(++parser->nest > EXPRESSION_DEPTH_MAX) {
+        result = nesla_expression_error(parser, "Expression too deep");
+        goto exit;
+    }
+
+    nesla_expression_skip(parser);
+    next = (parser->position < parser->length) ? parser->data[parser->position] : '\0';
+
+    switch(next) {
+        case '+':
+        case '-':
+        case '~':
+            ++parser->position;
+
+            if(((result = nesla_expression_parse_unary(parser)) == NESLA_SUCCESS) && (next != '+')) {
+                result = nesla_expression_emit(parser, (next == '-') ? EXPRESSION_NEGATE : EXPRESSION_NOT, 0);
+            }
+            break;
+        case '(':
+            ++parser->position;
+
+            if(((result = nesla_expression_parse(parser, 0)) == NESLA_SUCCESS) && !nesla_expression_match(parser, ")")) {
+                result = nesla_expression_error(parser, "Expecting closing parenthesis");
+            }
+            break;
+        default:
+
+            if((next == '$') || isdigit((unsigned char)next)) {
+                result = nesla_expression_parse_scalar(parser);
+            } else if((next == '_') || isalpha((unsigned char)next)) {
+                result = nesla_expression_parse_name(parser);
+            } else {
+                result = nesla_expression_error(parser, "Expecting operand");
+            }
+            break;
+    }
+
+    --parser->nest;
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Parse expression binary operators, from a precedence level up.
+ * @param[in,out] parser Pointer to expression parser context
+ * @param[in] level Precedence level (see EXPRESSION_BINARY)
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_expression_parse(nesla_expression_parser_t *parser, size_t level)
+{
+    bool found;
+    nesla_error_e result;
+
+    if(level == (sizeof(EXPRESSION_BINARY) / sizeof(*EXPRESSION_BINARY))) {
+        result = nesla_expression_parse_unary(parser);
+        goto exit;
+    }
+
+    if((result = nesla_expression_parse(parser, level + 1)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    do {
+        found = false;
+
+        for(const nesla_expression_binary_t *binary = EXPRESSION_BINARY[level]; binary->symbol; ++binary) {
+
+            if(nesla_expression_match(parser, binary->symbol)) {
+
+                if(((result = nesla_expression_parse(parser, level + 1)) == NESLA_FAILURE)
+                        || ((result = nesla_expression_emit(parser, binary->type, 0)) == NESLA_FAILURE)) {
+                    goto exit;
+                }
+
+                found = true;
+                break;
+            }
+        }
+    } while(found);
+
+exit:
+    return result;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+nesla_error_e nesla_expression_compile(nesla_expression_t *expression, nesla_encoder_t *encoder, const nesla_token_t *token)
+{
+    const nesla_literal_t *literal = nesla_token_get_literal(token);
+    nesla_expression_parser_t parser = { expression, encoder, token, (const char *)nesla_literal_get(literal),
+        nesla_literal_get_length(literal) };
+    nesla_error_e result;
+
+    expression->count = 0;
+
+    if((result = nesla_expression_parse(&parser, 0)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    nesla_expression_skip(&parser);
+
+    if(parser.position < parser.length) {
+        result = nesla_expression_error(&parser, "Unexpected character");
+        goto exit;
+    }
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_expression_evaluate(const nesla_expression_t *expression, nesla_context_t *context, const nesla_token_t *token,
+    uint16_t index, int64_t *value)
+{
+    size_t depth = 0;
+    int64_t stack[EXPRESSION_DEPTH_MAX];
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(size_t operation = 0; operation < expression->count; ++operation) {
+        int64_t left = 0, right = 0;
+        nesla_expression_e type = expression->operation[operation].type;
+
+        if(type >= EXPRESSION_MULTIPLY) {
+            right = stack[--depth];
+            left = stack[depth - 1];
+        }
+
+        switch(type) {
+            case EXPRESSION_VALUE:
+                stack[depth++] = expression->operation[operation].value;
+                break;
+            case EXPRESSION_INDEX:
+                stack[depth++] = index;
+                break;
+            case EXPRESSION_NEGATE:
+                stack[depth - 1] = (int64_t)(0 - (uint64_t)stack[depth - 1]);
+                break;
+            case EXPRESSION_NOT:
+                stack[depth - 1] = ~stack[depth - 1];
+                break;
+            case EXPRESSION_MULTIPLY:
+                stack[depth - 1] = (int64_t)((uint64_t)left * (uint64_t)right);
+                break;
+            case EXPRESSION_DIVIDE:
+            case EXPRESSION_MODULO:
+
+                if(!right) {
+                    result = SET_ERROR_AT(context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+                        "Division by zero at index %u: %s", index, nesla_literal_get(nesla_token_get_literal(token)));
+                    goto exit;
+                }
+
+                if((left == INT64_MIN) && (right == -1)) {
+                    stack[depth - 1] = (type == EXPRESSION_DIVIDE) ? left : 0;
+                } else {
+                    stack[depth - 1] = (type == EXPRESSION_DIVIDE) ? (left / right) : (left % right);
+                }
+                break;
+            case EXPRESSION_ADD:
+                stack[depth - 1] = (int64_t)((uint64_t)left + (uint64_t)right);
+                break;
+            case EXPRESSION_SUBTRACT:
+                stack[depth - 1] = (int64_t)((uint64_t)left - (uint64_t)right);
+                break;
+            case EXPRESSION_SHIFT_LEFT:
+                stack[depth - 1] = (int64_t)((uint64_t)left << (right & 63));
+                break;
+            case EXPRESSION_SHIFT_RIGHT:
+                stack[depth - 1] = left >> (right & 63);
+                break;
+            case EXPRESSION_AND:
+                stack[depth - 1] = left & right;
+                break;
+            case EXPRESSION_XOR:
+                stack[depth - 1] = left ^ right;
+                break;
+            case EXPRESSION_OR:
+                stack[depth - 1] = left | right;
+                break;
+            case EXPRESSION_SINE:
+            case EXPRESSION_COSINE:
+                {
+                    double angle = (2.0 * M_PI * (double)(left & UINT8_MAX)) / 256.0;
+                    double scaled = round((double)right * ((type == EXPRESSION_SINE) ? sin(angle) : cos(angle)));
+
+                    stack[depth - 1] = (int64_t)fmax(fmin(scaled, 0x1p62), -0x1p62);
+                }
+                break;
+            default:
+                result = SET_ERROR(context, "Unsupported expression operation: %i", type);
+                goto exit;
+        }
+    }
+
+    *value = stack[0];
+
+exit:
+    return result;
+}
+
+void nesla_expression_free(nesla_expression_t *expression, nesla_context_t *context)
+{
+    nesla_context_free(context, expression->operation);
+    memset(expression, 0, sizeof(*expression));
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
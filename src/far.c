@@ -0,0 +1,554 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file far.c
+ * @brief Far call trampolines.
+ */
+
+#include <far.h>
+
+#define FAR_DYNAMIC UINT16_MAX          /*!< Trampoline caller bank, for calls from the fixed bank, which switch back to the shadow */
+#define FAR_MMC3_BANK 6                 /*!< MMC3 bank register of $8000-$9FFF, followed by that of $A000-$BFFF */
+
+/*!
+ * @struct nesla_far_trampoline_t
+ * @brief Far call trampoline, shared by the calls to a label from a bank.
+ */
+typedef struct {
+    const nesla_token_t *token;         /*!< Token of the first call routed through the trampoline */
+    uint32_t symbol;                    /*!< Called label symbol index */
+    uint16_t bank;                      /*!< Calling bank, or FAR_DYNAMIC for the fixed bank */
+    uint32_t label;                     /*!< Trampoline label symbol index, once generated */
+} nesla_far_trampoline_t;
+
+/*!
+ * @struct nesla_far_span_t
+ * @brief Far call span, of offsets into the fixed bank.
+ */
+typedef struct {
+    uint32_t begin;                     /*!< First offset */
+    uint32_t end;                       /*!< Offset past the last offset */
+} nesla_far_span_t;
+
+/*!
+ * @struct nesla_far_t
+ * @brief Far call link context.
+ */
+typedef struct {
+    nesla_encoder_t *encoder;           /*!< Encoder context */
+    uint16_t fixed;                     /*!< Last (fixed) bank index */
+    nesla_far_trampoline_t *trampoline; /*!< Trampolines, in order of their first call */
+    size_t count;                       /*!< Trampoline count */
+    nesla_far_span_t *span;             /*!< Fixed bank sections, by offset */
+    const nesla_token_t *token;         /*!< Token generated statements are reported at */
+    uint16_t address;                   /*!< Address of the next generated statement */
+    uint16_t table;                     /*!< Bus conflict table address, holding each bank index (UxROM) */
+    bool measure;                       /*!< Generated statements are measured, rather than encoded */
+    bool shadow;                        /*!< Trampolines keep the bank shadow variable */
+} nesla_far_t;
+
+/*!
+ * @brief Compare far call spans, by offset.
+ * @param[in] first Constant pointer to first span context
+ * @param[in] second Constant pointer to second span context
+ * @return Negative if the first span comes first, positive if the second span does, 0 otherwise
+ */
+static int nesla_far_compare_span(const void *first, const void *second)
+{
+    const nesla_far_span_t *left = first, *right = second;
+
+    return (left->begin > right->begin) - (left->begin < right->begin);
+}
+
+/*!
+ * @brief Emit far call generated statement, or measure it.
+ * @param[in,out] far Pointer to link context
+ * @param[in] instruction Instruction type, or INSTRUCTION_MAX for a data byte
+ * @param[in] mode Addressing mode
+ * @param[in] value Operand value, or data byte
+ * @param[in] symbol Operand symbol index, or ENCODER_UNRESOLVED if the operand is the value given
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_far_emit(nesla_far_t *far, nesla_instruction_e instruction, nesla_mode_e mode, uint16_t value,
+    uint32_t symbol)
+{
+    size_t length = (instruction != INSTRUCTION_MAX) ? nesla_opcode_get(instruction, mode)->length : 1;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(!far->measure && ((result = nesla_encoder_put_code(far->encoder, far->token, far->fixed, far->address, instruction, mode, value,
+            symbol, &length)) == NESLA_FAILURE)) {
+        goto exit;
+    }
+
+    far->address += length;
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Emit far call generated statement without a symbol operand, or measure it.
+ * @param[in,out] far Pointer to link context
+ * @param[in] instruction Instruction type, or INSTRUCTION_MAX for a data byte
+ * @param[in] mode Addressing mode
+ * @param[in] value Operand value, or data byte
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_far_put(nesla_far_t *far, nesla_instruction_e instruction, nesla_mode_e mode, uint16_t value)
+{
+    return nesla_far_emit(far, instruction, mode, value, ENCODER_UNRESOLVED);
+}
+
+/*!
+ * @brief Emit far call access to the bank shadow variable, in zero page if it was placed there.
+ * @param[in,out] far Pointer to link context
+ * @param[in] instruction Instruction type (LDA, STA or EOR)
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_far_shadow(nesla_far_t *far, nesla_instruction_e instruction)
+{
+    uint32_t symbol = far->encoder->shadow - 1;
+    uint16_t address = far->encoder->symbol[symbol].address;
+
+    return nesla_far_emit(far, instruction, (address <= UINT8_MAX) ? MODE_ZERO_PAGE : MODE_ABSOLUTE, address, symbol);
+}
+
+/*!
+ * @brief Emit far call switch to a bank, keeping the bank shadow variable if needed.
+ * @param[in,out] far Pointer to link context
+ * @param[in] bank Bank index
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_far_switch(nesla_far_t *far, uint16_t bank)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(((far->encoder->mapper != FAR_MAPPER_MMC3) || far->shadow)
+            && ((result = nesla_far_put(far, INSTRUCTION_LDA, MODE_IMMEDIATE, bank)) == NESLA_FAILURE)) {
+        goto exit;
+    }
+
+    if(far->shadow && ((result = nesla_far_shadow(far, INSTRUCTION_STA)) == NESLA_FAILURE)) {
+        goto exit;
+    }
+
+    switch(far->encoder->mapper) {
+        case FAR_MAPPER_MMC1:
+
+            for(size_t bit = 0; bit < 5; ++bit) {
+
+                if(bit && ((result = nesla_far_put(far, INSTRUCTION_LSR, MODE_ACCUMULATOR, 0)) == NESLA_FAILURE)) {
+                    goto exit;
+                }
+
+                if((result = nesla_far_put(far, INSTRUCTION_STA, MODE_ABSOLUTE, FAR_MMC1_PROGRAM)) == NESLA_FAILURE) {
+                    goto exit;
+                }
+            }
+            break;
+        case FAR_MAPPER_MMC3:
+
+            for(uint16_t half = 0; half < 2; ++half) {
+
+                if(((result = nesla_far_put(far, INSTRUCTION_LDA, MODE_IMMEDIATE, FAR_MMC3_BANK + half)) == NESLA_FAILURE)
+                        || ((result = nesla_far_put(far, INSTRUCTION_STA, MODE_ABSOLUTE, FAR_MMC3_SELECT)) == NESLA_FAILURE)
+                        || ((result = nesla_far_put(far, INSTRUCTION_LDA, MODE_IMMEDIATE, (bank * 2) + half)) == NESLA_FAILURE)
+                        || ((result = nesla_far_put(far, INSTRUCTION_STA, MODE_ABSOLUTE, FAR_MMC3_DATA)) == NESLA_FAILURE)) {
+                    goto exit;
+                }
+            }
+            break;
+        default:
+            result = nesla_far_put(far, INSTRUCTION_STA, MODE_ABSOLUTE, far->table + bank);
+            break;
+    }
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Emit far call switch back to the bank pushed before the call, keeping the bank shadow variable, and the accumulator and
+ *        Y returned. The shadow variable is free once the call returns, so the accumulator is held there, and exchanged with the
+ *        bank through the stack (pushed as their exclusive or). Y is pushed while MMC3 and UxROM use it.
+ * @param[in,out] far Pointer to link context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_far_restore(nesla_far_t *far)
+{
+    bool index = (far->encoder->mapper != FAR_MAPPER_MMC1);
+    nesla_error_e result;
+
+    if(((result = nesla_far_shadow(far, INSTRUCTION_STA)) == NESLA_FAILURE)
+            || ((result = nesla_far_put(far, INSTRUCTION_PLA, MODE_IMPLIED, 0)) == NESLA_FAILURE)
+            || ((result = nesla_far_shadow(far, INSTRUCTION_EOR)) == NESLA_FAILURE)
+            || ((result = nesla_far_put(far, INSTRUCTION_PHA, MODE_IMPLIED, 0)) == NESLA_FAILURE)
+            || ((result = nesla_far_shadow(far, INSTRUCTION_EOR)) == NESLA_FAILURE)
+            || ((result = nesla_far_shadow(far, INSTRUCTION_STA)) == NESLA_FAILURE)) {
+        goto exit;
+    }
+
+    if(index && (((result = nesla_far_put(far, INSTRUCTION_TYA, MODE_IMPLIED, 0)) == NESLA_FAILURE)
+            || ((result = nesla_far_put(far, INSTRUCTION_PHA, MODE_IMPLIED, 0)) == NESLA_FAILURE)
+            || ((result = nesla_far_shadow(far, INSTRUCTION_LDA)) == NESLA_FAILURE))) {
+        goto exit;
+    }
+
+    switch(far->encoder->mapper) {
+        case FAR_MAPPER_MMC1:
+
+            for(size_t bit = 0; bit < 5; ++bit) {
+
+                if(bit && ((result = nesla_far_put(far, INSTRUCTION_LSR, MODE_ACCUMULATOR, 0)) == NESLA_FAILURE)) {
+                    goto exit;
+                }
+
+                if((result = nesla_far_put(far, INSTRUCTION_STA, MODE_ABSOLUTE, FAR_MMC1_PROGRAM)) == NESLA_FAILURE) {
+                    goto exit;
+                }
+            }
+            break;
+        case FAR_MAPPER_MMC3:
+
+            if((result = nesla_far_put(far, INSTRUCTION_ASL, MODE_ACCUMULATOR, 0)) == NESLA_FAILURE) {
+                goto exit;
+            }
+
+            for(uint16_t half = 0; half < 2; ++half) {
+
+                if(((result = nesla_far_put(far, INSTRUCTION_LDY, MODE_IMMEDIATE, FAR_MMC3_BANK + half)) == NESLA_FAILURE)
+                        || ((result = nesla_far_put(far, INSTRUCTION_STY, MODE_ABSOLUTE, FAR_MMC3_SELECT)) == NESLA_FAILURE)) {
+                    goto exit;
+                }
+
+                if(half && ((result = nesla_far_put(far, INSTRUCTION_ORA, MODE_IMMEDIATE, 1)) == NESLA_FAILURE)) {
+                    goto exit;
+                }
+
+                if((result = nesla_far_put(far, INSTRUCTION_STA, MODE_ABSOLUTE, FAR_MMC3_DATA)) == NESLA_FAILURE) {
+                    goto exit;
+                }
+            }
+            break;
+        default:
+
+            if(((result = nesla_far_put(far, INSTRUCTION_TAY, MODE_IMPLIED, 0)) == NESLA_FAILURE)
+                    || ((result = nesla_far_put(far, INSTRUCTION_STA, MODE_ABSOLUTE_Y, far->table)) == NESLA_FAILURE)) {
+                goto exit;
+            }
+            break;
+    }
+
+    if(index && (((result = nesla_far_put(far, INSTRUCTION_PLA, MODE_IMPLIED, 0)) == NESLA_FAILURE)
+            || ((result = nesla_far_put(far, INSTRUCTION_TAY, MODE_IMPLIED, 0)) == NESLA_FAILURE))) {
+        goto exit;
+    }
+
+    if((result = nesla_far_put(far, INSTRUCTION_PLA, MODE_IMPLIED, 0)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    result = nesla_far_shadow(far, INSTRUCTION_EOR);
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Emit far call trampoline, or measure it. A trampoline from a switched bank switches to the bank of the label, calls
+ *        it, and switches back to the calling bank, pushing the accumulator returned around the switch. A trampoline from the
+ *        fixed bank pushes the bank shadow variable first, and switches back to the bank it pushed (see nesla_far_restore).
+ *        Either way, the accumulator and Y returned are kept, with the flags set by the accumulator. The trampoline is listed
+ *        as <label>_FAR<bank>, or <label>_FAR from the fixed bank.
+ * @param[in,out] far Pointer to link context
+ * @param[in,out] trampoline Pointer to trampoline context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_far_generate(nesla_far_t *far, nesla_far_trampoline_t *trampoline)
+{
+    char suffix[16] = "_FAR";
+    nesla_encoder_t *encoder = far->encoder;
+    const nesla_symbol_t *symbol = &encoder->symbol[trampoline->symbol];
+    nesla_error_e result;
+
+    far->token = trampoline->token;
+
+    if(trampoline->bank != FAR_DYNAMIC) {
+        snprintf(suffix, sizeof(suffix), "_FAR%u", trampoline->bank);
+    }
+
+    if(!far->measure && ((result = nesla_encoder_put_local(encoder, symbol->token, suffix, far->fixed, far->address,
+            &trampoline->label)) == NESLA_FAILURE)) {
+        goto exit;
+    }
+
+    if((trampoline->bank == FAR_DYNAMIC) && (((result = nesla_far_shadow(far, INSTRUCTION_LDA)) == NESLA_FAILURE)
+            || ((result = nesla_far_put(far, INSTRUCTION_PHA, MODE_IMPLIED, 0)) == NESLA_FAILURE))) {
+        goto exit;
+    }
+
+    if(((result = nesla_far_switch(far, symbol->bank)) == NESLA_FAILURE)
+            || ((result = nesla_far_emit(far, INSTRUCTION_JSR, MODE_ABSOLUTE, symbol->address, trampoline->symbol)) == NESLA_FAILURE)) {
+        goto exit;
+    }
+
+    if(trampoline->bank == FAR_DYNAMIC) {
+
+        if((result = nesla_far_restore(far)) == NESLA_FAILURE) {
+            goto exit;
+        }
+    } else if(((result = nesla_far_put(far, INSTRUCTION_PHA, MODE_IMPLIED, 0)) == NESLA_FAILURE)
+            || ((result = nesla_far_switch(far, trampoline->bank)) == NESLA_FAILURE)
+            || ((result = nesla_far_put(far, INSTRUCTION_PLA, MODE_IMPLIED, 0)) == NESLA_FAILURE)) {
+        goto exit;
+    }
+
+    result = nesla_far_put(far, INSTRUCTION_RTS, MODE_IMPLIED, 0);
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Find far call trampoline for a far call, adding it if needed.
+ * @param[in,out] far Pointer to link context
+ * @param[in] index Far call statement index
+ * @param[in,out] trampoline Pointer to trampoline index, or far->count if the call is left direct
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_far_route(nesla_far_t *far, size_t index, size_t *trampoline)
+{
+    const nesla_encoder_t *encoder = far->encoder;
+    const nesla_statement_t *statement = &encoder->statement[index];
+    const nesla_fixup_t *fixup = nesla_encoder_get_fixup(encoder, index);
+    const nesla_symbol_t *symbol;
+    uint16_t bank;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    *trampoline = far->count;
+
+    if(!fixup || (symbol = &encoder->symbol[fixup->index])->constant || (symbol->bank == statement->bank)
+            || (symbol->bank == far->fixed) || (symbol->bank >= encoder->program) || (statement->bank >= encoder->program)) {
+        goto exit;
+    }
+
+    if((encoder->mapper != FAR_MAPPER_MMC1) && (encoder->mapper != FAR_MAPPER_UXROM) && (encoder->mapper != FAR_MAPPER_MMC3)) {
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(statement->token), nesla_token_get_line(statement->token),
+            nesla_token_get_column(statement->token), "Unsupported mapper for far call: %u", encoder->mapper);
+        goto exit;
+    }
+
+    bank = (statement->bank == far->fixed) ? FAR_DYNAMIC : statement->bank;
+
+    for(*trampoline = 0; *trampoline < far->count; ++*trampoline) {
+
+        if((far->trampoline[*trampoline].symbol == fixup->index) && (far->trampoline[*trampoline].bank == bank)) {
+            goto exit;
+        }
+    }
+
+    far->trampoline[far->count].token = statement->token;
+    far->trampoline[far->count].symbol = fixup->index;
+    far->trampoline[far->count].bank = bank;
+    far->trampoline[far->count++].label = ENCODER_UNRESOLVED;
+    far->shadow |= (bank == FAR_DYNAMIC);
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Find far call room for the trampolines in the fixed bank, around the sections placed there.
+ * @param[in,out] far Pointer to link context
+ * @param[in] length Trampoline length in bytes
+ * @param[in,out] address Pointer to address
+ * @return true if the trampolines fit, false otherwise
+ */
+static bool nesla_far_find(nesla_far_t *far, uint32_t length, uint16_t *address)
+{
+    const nesla_encoder_t *encoder = far->encoder;
+    uint32_t cursor = 0;
+    size_t used = 0;
+    bool result = false;
+
+    for(size_t index = 0; index < encoder->section_count; ++index) {
+        const nesla_section_t *section = &encoder->section[index];
+        const nesla_statement_t *statement = &encoder->statement[section->first];
+        uint32_t end = statement->address % BANK_LENGTH;
+
+        if(statement->bank != far->fixed) {
+            continue;
+        }
+
+        far->span[used].begin = end;
+
+        for(size_t offset = section->first; offset < (section->first + section->count); ++offset) {
+            end += encoder->statement[offset].length;
+        }
+
+        far->span[used++].end = end;
+    }
+
+    qsort(far->span, used, sizeof(*far->span), nesla_far_compare_span);
+
+    for(size_t index = 0; index <= used; ++index) {
+        uint32_t begin = (index < used) ? far->span[index].begin : BANK_LENGTH;
+
+        if((begin >= cursor) && ((begin - cursor) >= length)) {
+            *address = BANK_FIXED + cursor;
+            result = true;
+            break;
+        }
+
+        if((index < used) && (far->span[index].end > cursor)) {
+            cursor = far->span[index].end;
+        }
+    }
+
+    return result;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+nesla_error_e nesla_far_link(nesla_encoder_t *encoder)
+{
+    nesla_far_t far = {};
+    const nesla_token_t *token = NULL;
+    size_t calls = 0, routed = 0, trampoline;
+    uint16_t address = 0;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(size_t index = 0; index < encoder->statement_count; ++index) {
+
+        if(encoder->statement[index].far && encoder->statement[index].length) {
+
+            if(!calls++) {
+                token = encoder->statement[index].token;
+            }
+        }
+    }
+
+    far.encoder = encoder;
+    far.fixed = encoder->program - 1;
+
+    if(!calls || (encoder->program < 2) || (encoder->mapper == FAR_MAPPER_NROM)) {
+        goto report;
+    }
+
+    if(!(far.trampoline = nesla_context_allocate(encoder->context, calls * sizeof(*far.trampoline)))
+            || !(far.span = nesla_context_allocate(encoder->context, encoder->section_count * sizeof(*far.span)))) {
+        result = SET_ERROR(encoder->context, "Failed to allocate far call link: %zu", calls);
+        goto exit;
+    }
+
+    for(size_t index = 0; index < encoder->statement_count; ++index) {
+
+        if(encoder->statement[index].far && encoder->statement[index].length
+                && (nesla_far_route(&far, index, &trampoline) == NESLA_FAILURE)) {
+            result = NESLA_FAILURE;
+
+            if(nesla_context_is_full(encoder->context)) {
+                goto exit;
+            }
+        }
+    }
+
+    if((result == NESLA_FAILURE) || !far.count) {
+        goto report;
+    }
+
+    far.measure = true;
+    far.address = (encoder->mapper == FAR_MAPPER_UXROM) ? encoder->program : 0;
+
+    for(size_t index = 0; index < far.count; ++index) {
+
+        if((result = nesla_far_generate(&far, &far.trampoline[index])) == NESLA_FAILURE) {
+            goto exit;
+        }
+    }
+
+    far.token = far.trampoline[0].token;
+
+    if(!nesla_far_find(&far, far.address, &address)) {
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(far.token), nesla_token_get_line(far.token),
+            nesla_token_get_column(far.token), "Out of fixed bank space for far call trampolines: %u bytes", far.address);
+        goto exit;
+    }
+
+    far.measure = false;
+    far.address = address;
+
+    if(encoder->mapper == FAR_MAPPER_UXROM) {
+        far.table = address;
+
+        for(uint16_t bank = 0; bank < encoder->program; ++bank) {
+
+            if((result = nesla_far_put(&far, INSTRUCTION_MAX, MODE_IMPLIED, bank)) == NESLA_FAILURE) {
+                goto exit;
+            }
+        }
+    }
+
+    for(size_t index = 0; index < far.count; ++index) {
+
+        if((result = nesla_far_generate(&far, &far.trampoline[index])) == NESLA_FAILURE) {
+            goto exit;
+        }
+    }
+
+    for(size_t index = 0; index < encoder->statement_count; ++index) {
+
+        if(!encoder->statement[index].far || !encoder->statement[index].length) {
+            continue;
+        }
+
+        nesla_far_route(&far, index, &trampoline);
+
+        if(trampoline < far.count) {
+            nesla_encoder_get_fixup(encoder, index)->index = far.trampoline[trampoline].label;
+            ++routed;
+        }
+    }
+
+report:
+
+    if((result == NESLA_SUCCESS) && far.count) {
+        SET_NOTE_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Far calls: %zu direct, %zu through %zu trampoline(s), %u byte(s) at $%04X, %s at $%04X", calls - routed, routed,
+            far.count, far.address - address, address, ENCODER_SHADOW, encoder->symbol[encoder->shadow - 1].address);
+    } else if(result == NESLA_SUCCESS) {
+        SET_NOTE_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Far calls: %zu direct, %s at $%04X", calls, ENCODER_SHADOW, encoder->symbol[encoder->shadow - 1].address);
+    }
+
+exit:
+    nesla_context_free(encoder->context, far.span);
+    nesla_context_free(encoder->context, far.trampoline);
+
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
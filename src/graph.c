@@ -0,0 +1,413 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file graph.c
+ * @brief Control-flow graph, over encoded instructions.
+ */
+
+#include <graph.h>
+
+/*!
+ * @brief Compare graph entries, by address and bank.
+ * @param[in] first Constant pointer to first entry
+ * @param[in] second Constant pointer to second entry
+ * @return Less than, equal to, or greater than zero, if the first entry is placed before, at, or after the second
+ */
+static int nesla_graph_compare(const void *first, const void *second)
+{
+    const nesla_graph_entry_t *left = first, *right = second;
+
+    if(left->address != right->address) {
+        return (left->address < right->address) ? -1 : 1;
+    }
+
+    if(left->bank != right->bank) {
+        return (left->bank < right->bank) ? -1 : 1;
+    }
+
+    return (left->statement < right->statement) ? -1 : (left->statement > right->statement);
+}
+
+/*!
+ * @brief Compare graph loops, innermost first.
+ * @param[in] first Constant pointer to first loop
+ * @param[in] second Constant pointer to second loop
+ * @return Less than, equal to, or greater than zero, if the first loop spans fewer, as many, or more statements than the second
+ */
+static int nesla_graph_compare_loop(const void *first, const void *second)
+{
+    const nesla_graph_loop_t *left = first, *right = second;
+
+    return (left->span < right->span) ? -1 : (left->span > right->span);
+}
+
+/*!
+ * @brief Set graph edge, finding its target instruction.
+ * @param[in] graph Constant pointer to graph context
+ * @param[in,out] edge Pointer to edge context
+ * @param[in] type Edge type
+ * @param[in] bank Bank index
+ * @param[in] address Target address
+ */
+static void nesla_graph_edge(const nesla_graph_t *graph, nesla_edge_t *edge, nesla_edge_e type, size_t bank, uint16_t address)
+{
+    edge->statement = (type != EDGE_INDIRECT) ? nesla_graph_find(graph, bank, address) : ENCODER_UNRESOLVED;
+    edge->address = address;
+    edge->type = type;
+}
+
+/*!
+ * @brief Report graph edge, whose target is not a placed instruction.
+ * @param[in] graph Constant pointer to graph context
+ * @param[in] index Statement index
+ * @param[in] edge Constant pointer to edge context
+ * @return NESLA_ERROR
+ */
+static nesla_error_e nesla_graph_unresolved(const nesla_graph_t *graph, uint32_t index, const nesla_edge_t *edge)
+{
+    const nesla_token_t *token = graph->encoder->statement[index].token;
+    const char *path = nesla_token_get_path(token);
+    size_t line = nesla_token_get_line(token), column = nesla_token_get_column(token);
+    nesla_error_e result;
+
+    switch(edge->type) {
+        case EDGE_BRANCH:
+            result = SET_ERROR_AT(graph->encoder->context, path, line, column, "Branch target is not an instruction: $%04X", edge->address);
+            break;
+        case EDGE_CALL:
+            result = SET_ERROR_AT(graph->encoder->context, path, line, column, "Subroutine is not an instruction: $%04X", edge->address);
+            break;
+        case EDGE_INDIRECT:
+            result = SET_ERROR_AT(graph->encoder->context, path, line, column, "Indirect jump target is unknown: ($%04X)", edge->address);
+            break;
+        default:
+            result = SET_ERROR_AT(graph->encoder->context, path, line, column, "Execution runs past the last instruction: $%04X",
+                edge->address);
+            break;
+    }
+
+    return result;
+}
+
+/*!
+ * @brief Walk graph statements, reachable from a subroutine entry without calls, placing them in reverse postorder and
+ *        recording the edges that loop back. Subroutines called that are not yet measured are added to the pending list.
+ * @param[in,out] graph Pointer to graph context
+ * @param[in] entry Entry statement index
+ * @param[in,out] pending Pointer to pending flag, set if a subroutine called is not yet measured
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_graph_walk(nesla_graph_t *graph, uint32_t entry, bool *pending)
+{
+    size_t depth = 0;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    ++graph->generation;
+    graph->order_count = 0;
+    graph->loop_count = 0;
+    *pending = false;
+    graph->stamp[entry] = graph->generation;
+    graph->state[entry] = VISIT_ACTIVE;
+    graph->frame[depth].statement = entry;
+    graph->frame[depth++].edge = 0;
+
+    while(depth) {
+        nesla_edge_t edge[GRAPH_EDGE_MAX];
+        nesla_graph_frame_t *frame = &graph->frame[depth - 1];
+        const nesla_edge_t *current;
+        const nesla_token_t *token;
+        uint32_t target;
+
+        if(frame->edge == nesla_graph_get_edges(graph, frame->statement, edge)) {
+            graph->state[frame->statement] = VISIT_DONE;
+            graph->order[graph->order_count++] = frame->statement;
+            --depth;
+            continue;
+        }
+
+        current = &edge[frame->edge++];
+
+        if((target = current->statement) == ENCODER_UNRESOLVED) {
+            result = nesla_graph_unresolved(graph, frame->statement, current);
+            goto exit;
+        }
+
+        if(current->type == EDGE_CALL) {
+
+            switch(graph->call[target]) {
+                case CALL_ACTIVE:
+                    token = graph->encoder->statement[frame->statement].token;
+                    result = SET_ERROR_AT(graph->encoder->context, nesla_token_get_path(token), nesla_token_get_line(token),
+                        nesla_token_get_column(token), "Recursive call: $%04X", current->address);
+                    goto exit;
+                case CALL_FAILED:
+                    result = NESLA_FAILURE;
+                    goto exit;
+                case CALL_NONE:
+
+                    if((result = nesla_context_reserve(graph->encoder->context, (void **)&graph->pending, &graph->pending_capacity,
+                            graph->pending_count, sizeof(*graph->pending))) == NESLA_FAILURE) {
+                        goto exit;
+                    }
+
+                    graph->pending[graph->pending_count++] = target;
+                    *pending = true;
+                    break;
+                default:
+                    break;
+            }
+            continue;
+        }
+
+        if(graph->stamp[target] != graph->generation) {
+            graph->stamp[target] = graph->generation;
+            graph->state[target] = VISIT_ACTIVE;
+            graph->frame[depth].statement = target;
+            graph->frame[depth++].edge = 0;
+        } else if(graph->state[target] == VISIT_ACTIVE) {
+
+            if((result = nesla_context_reserve(graph->encoder->context, (void **)&graph->loop, &graph->loop_capacity,
+                    graph->loop_count, sizeof(*graph->loop))) == NESLA_FAILURE) {
+                goto exit;
+            }
+
+            graph->loop[graph->loop_count].source = frame->statement;
+            graph->loop[graph->loop_count++].target = target;
+        }
+    }
+
+    for(size_t index = 0; index < (graph->order_count / 2); ++index) {
+        uint32_t swap = graph->order[index];
+
+        graph->order[index] = graph->order[graph->order_count - index - 1];
+        graph->order[graph->order_count - index - 1] = swap;
+    }
+
+    for(size_t index = 0; index < graph->order_count; ++index) {
+        graph->position[graph->order[index]] = index;
+    }
+
+    for(size_t index = 0; index < graph->loop_count; ++index) {
+        nesla_graph_loop_t *loop = &graph->loop[index];
+
+        loop->span = graph->position[loop->source] - graph->position[loop->target];
+    }
+
+    if(graph->loop_count) {
+        qsort(graph->loop, graph->loop_count, sizeof(*graph->loop), nesla_graph_compare_loop);
+    }
+
+exit:
+    return result;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+uint32_t nesla_graph_find(const nesla_graph_t *graph, size_t bank, uint16_t address)
+{
+    size_t low = 0, high = graph->entry_count;
+
+    while(low < high) {
+        size_t middle = (low + high) / 2;
+
+        if(graph->entry[middle].address < address) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    for(size_t index = low; (index < graph->entry_count) && (graph->entry[index].address == address); ++index) {
+
+        if(graph->entry[index].bank == bank) {
+            return graph->entry[index].statement;
+        }
+    }
+
+    return ((low < graph->entry_count) && (graph->entry[low].address == address)) ? graph->entry[low].statement : ENCODER_UNRESOLVED;
+}
+
+size_t nesla_graph_get_edges(const nesla_graph_t *graph, size_t index, nesla_edge_t *edge)
+{
+    const nesla_encoder_t *encoder = graph->encoder;
+    const nesla_statement_t *statement = &encoder->statement[index];
+    const nesla_fixup_t *fixup = nesla_encoder_get_fixup(encoder, index);
+    const uint8_t *data = encoder->data + statement->offset;
+    size_t bank = fixup ? encoder->symbol[fixup->index].bank : statement->bank, count = 0;
+    uint16_t next = statement->address + statement->length;
+
+    if((statement->instruction == INSTRUCTION_MAX) || !statement->length) {
+        return 0;
+    }
+
+    switch(statement->instruction) {
+        case INSTRUCTION_BRK:
+        case INSTRUCTION_RTI:
+        case INSTRUCTION_RTS:
+            break;
+        case INSTRUCTION_JMP:
+            nesla_graph_edge(graph, &edge[count++], (statement->mode == MODE_INDIRECT) ? EDGE_INDIRECT : EDGE_BRANCH, bank,
+                data[1] | (data[2] << 8));
+            break;
+        case INSTRUCTION_JSR:
+            nesla_graph_edge(graph, &edge[count++], EDGE_CALL, bank, data[1] | (data[2] << 8));
+            nesla_graph_edge(graph, &edge[count++], EDGE_NEXT, statement->bank, next);
+            break;
+        default:
+            nesla_graph_edge(graph, &edge[count++], EDGE_NEXT, statement->bank, next);
+
+            if(statement->mode == MODE_RELATIVE) {
+                nesla_graph_edge(graph, &edge[count++], EDGE_BRANCH, bank, (statement->length != nesla_opcode_get(statement->instruction,
+                    MODE_RELATIVE)->length) ? (data[3] | (data[4] << 8)) : (uint16_t)(statement->address + 2 + (int8_t)data[1]));
+            }
+            break;
+    }
+
+    return count;
+}
+
+bool nesla_graph_get_vector(const nesla_graph_t *graph, uint16_t vector, size_t *bank, uint16_t *address)
+{
+    const nesla_encoder_t *encoder = graph->encoder;
+    const nesla_statement_t *found = NULL;
+
+    for(size_t index = 0; index < encoder->statement_count; ++index) {
+        const nesla_statement_t *statement = &encoder->statement[index];
+
+        if((statement->instruction == INSTRUCTION_MAX) && (statement->address == vector) && (statement->length == 2)
+                && (!found || (statement->bank >= found->bank))) {
+            const nesla_fixup_t *fixup = nesla_encoder_get_fixup(encoder, index);
+
+            *bank = fixup ? encoder->symbol[fixup->index].bank : statement->bank;
+            *address = encoder->data[statement->offset] | (encoder->data[statement->offset + 1] << 8);
+            found = statement;
+        }
+    }
+
+    return found != NULL;
+}
+
+nesla_error_e nesla_graph_initialize(nesla_graph_t *graph, const nesla_encoder_t *encoder)
+{
+    size_t count = encoder->statement_count + 1;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    memset(graph, 0, sizeof(*graph));
+    graph->encoder = encoder;
+
+    if(!(graph->entry = nesla_context_allocate(encoder->context, count * sizeof(*graph->entry)))
+            || !(graph->stamp = nesla_context_allocate(encoder->context, count * sizeof(*graph->stamp)))
+            || !(graph->state = nesla_context_allocate(encoder->context, count * sizeof(*graph->state)))
+            || !(graph->position = nesla_context_allocate(encoder->context, count * sizeof(*graph->position)))
+            || !(graph->order = nesla_context_allocate(encoder->context, count * sizeof(*graph->order)))
+            || !(graph->frame = nesla_context_allocate(encoder->context, count * sizeof(*graph->frame)))
+            || !(graph->call = nesla_context_allocate(encoder->context, count * sizeof(*graph->call)))) {
+        result = SET_ERROR(encoder->context, "Failed to allocate graph: %zu", encoder->statement_count);
+        goto exit;
+    }
+
+    for(size_t index = 0; index < encoder->statement_count; ++index) {
+        const nesla_statement_t *statement = &encoder->statement[index];
+
+        if((statement->instruction != INSTRUCTION_MAX) && statement->length) {
+            nesla_graph_entry_t *entry = &graph->entry[graph->entry_count++];
+
+            entry->address = statement->address;
+            entry->bank = statement->bank;
+            entry->statement = index;
+        }
+    }
+
+    qsort(graph->entry, graph->entry_count, sizeof(*graph->entry), nesla_graph_compare);
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_graph_measure(nesla_graph_t *graph, uint32_t entry, nesla_measure measure, void *context)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    graph->pending_count = 0;
+
+    if((result = nesla_context_reserve(graph->encoder->context, (void **)&graph->pending, &graph->pending_capacity,
+            graph->pending_count, sizeof(*graph->pending))) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    graph->pending[graph->pending_count++] = entry;
+
+    while(graph->pending_count) {
+        size_t base = graph->pending_count - 1;
+        uint32_t index = graph->pending[base];
+        bool pending;
+
+        if((graph->call[index] == CALL_DONE) || (graph->call[index] == CALL_FAILED)) {
+            --graph->pending_count;
+            continue;
+        }
+
+        graph->call[index] = CALL_ACTIVE;
+
+        if(nesla_graph_walk(graph, index, &pending) == NESLA_FAILURE) {
+            graph->call[index] = CALL_FAILED;
+            graph->pending_count = base;
+            continue;
+        }
+
+        if(!pending) {
+            graph->call[index] = (measure(context, index) == NESLA_SUCCESS) ? CALL_DONE : CALL_FAILED;
+            graph->pending_count = base;
+        }
+    }
+
+    if(graph->call[entry] != CALL_DONE) {
+        result = NESLA_FAILURE;
+    }
+
+exit:
+    return result;
+}
+
+void nesla_graph_uninitialize(nesla_graph_t *graph)
+{
+
+    if(graph->encoder) {
+        nesla_context_free(graph->encoder->context, graph->pending);
+        nesla_context_free(graph->encoder->context, graph->loop);
+        nesla_context_free(graph->encoder->context, graph->call);
+        nesla_context_free(graph->encoder->context, graph->frame);
+        nesla_context_free(graph->encoder->context, graph->order);
+        nesla_context_free(graph->encoder->context, graph->position);
+        nesla_context_free(graph->encoder->context, graph->state);
+        nesla_context_free(graph->encoder->context, graph->stamp);
+        nesla_context_free(graph->encoder->context, graph->entry);
+    }
+
+    memset(graph, 0, sizeof(*graph));
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,429 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file image.c
+ * @brief Output image.
+ */
+
+#include <image.h>
+
+#define IMAGE_CHARACTER_LENGTH 0x2000   /*!< Character bank length in bytes */
+#define IMAGE_FILL 0xFF                 /*!< Unused bank fill value */
+#define IMAGE_HEADER_LENGTH 16          /*!< Header length in bytes */
+#define IMAGE_PATTERN_LENGTH 0x1000     /*!< Character pattern table length in bytes */
+#define IMAGE_PROGRAM_LENGTH 0x4000     /*!< Program bank length in bytes */
+#define IMAGE_TILE_COUNT 256            /*!< Tiles per character pattern table */
+#define IMAGE_TILE_LENGTH 16            /*!< Tile length in bytes */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Allocate image context banks, using the program and character counts in the header.
+ * @param[in,out] image Pointer to image context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_image_allocate(nesla_image_t *image)
+{
+    static const size_t LENGTH[] = {
+        IMAGE_PROGRAM_LENGTH, IMAGE_CHARACTER_LENGTH,
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(!image->header[HEADER_PROGRAM]) {
+        result = SET_ERROR(image->context, "Undefined program bank count: %u", image->header[HEADER_PROGRAM]);
+        goto exit;
+    }
+
+    image->count = image->header[HEADER_PROGRAM] + image->header[HEADER_CHARACTER];
+
+    if(!(image->bank = nesla_context_allocate(image->context, image->count * sizeof(*image->bank)))) {
+        result = SET_ERROR(image->context, "Failed to allocate image banks: %zu", image->count);
+        goto exit;
+    }
+
+    for(size_t index = 0; index < image->count; ++index) {
+        nesla_image_bank_t *bank = &image->bank[index];
+
+        bank->type = (index < image->header[HEADER_PROGRAM]) ? BANK_PROGRAM : BANK_CHARACTER;
+        bank->length = LENGTH[bank->type];
+
+        if(!(bank->data = nesla_context_allocate(image->context, bank->length))
+                || !(bank->used = nesla_context_allocate(image->context, (bank->length / 8) * sizeof(*bank->used)))) {
+            result = SET_ERROR(image->context, "Failed to allocate image bank: %zu", index);
+            goto exit;
+        }
+
+        memset(bank->data, IMAGE_FILL, bank->length);
+    }
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Get image context bank, allocating banks if needed.
+ * @param[in,out] image Pointer to image context
+ * @param[in] index Bank index
+ * @param[in,out] bank Pointer to bank context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_image_get_bank(nesla_image_t *image, size_t index, nesla_image_bank_t **bank)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(!image->bank && ((result = nesla_image_allocate(image)) == NESLA_FAILURE)) {
+        goto exit;
+    }
+
+    if(index >= image->count) {
+        result = SET_ERROR(image->context, "Invalid bank: %zu", index);
+        goto exit;
+    }
+
+    *bank = &image->bank[index];
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Reserve image context bank range, failing if the range overlaps a previously reserved range.
+ * @param[in,out] image Pointer to image context
+ * @param[in,out] bank Pointer to bank context
+ * @param[in] index Bank index
+ * @param[in] offset Bank offset in bytes
+ * @param[in] length Range length in bytes
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_image_reserve(nesla_image_t *image, nesla_image_bank_t *bank, size_t index, size_t offset, size_t length)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if((offset > bank->length) || (length > (bank->length - offset))) {
+        result = SET_ERROR(image->context, "Bank overflow: %zu@%04zX+%zu", index, offset, length);
+        goto exit;
+    }
+
+    for(size_t position = offset; position < offset + length; ++position) {
+
+        if(bank->used[position / 8] & (1 << (position % 8))) {
+            result = SET_ERROR(image->context, "Bank overlap: %zu@%04zX", index, position);
+            goto exit;
+        }
+    }
+
+    for(size_t position = offset; position < offset + length; ++position) {
+        bank->used[position / 8] |= (1 << (position % 8));
+    }
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Copy image context binaries into bank data, so the bank can be changed in place.
+ * @param[in,out] image Pointer to image context
+ * @param[in,out] bank Pointer to bank context
+ */
+static void nesla_image_copy(nesla_image_t *image, nesla_image_bank_t *bank)
+{
+
+    while(nesla_list_get_length(&bank->binary)) {
+        nesla_list_entry_t *entry = nesla_list_get_head(&bank->binary);
+        nesla_image_binary_t *binary = entry->context;
+
+        memcpy(bank->data + binary->offset, nesla_binary_get(&binary->binary), nesla_binary_get_length(&binary->binary));
+        nesla_binary_close(&binary->binary);
+        nesla_context_free(image->context, binary);
+        nesla_list_remove(&bank->binary, image->context, entry);
+    }
+}
+
+/*!
+ * @brief Merge image context tiles in a pattern table, mapping each tile to the first identical tile, in place.
+ * @param[in] bank Constant pointer to bank context
+ * @param[in] offset Pattern table offset in bytes
+ * @param[out] map Pointer to tile map of the pattern table
+ * @return Merged tile count, of the tiles placed that map to an earlier tile
+ */
+static size_t nesla_image_merge_pattern(const nesla_image_bank_t *bank, size_t offset, uint8_t *map)
+{
+    uint32_t hash[IMAGE_TILE_COUNT];
+    uint8_t kept[IMAGE_TILE_COUNT];
+    size_t count = 0, result = 0;
+    const uint8_t *data = bank->data + offset;
+
+    for(size_t tile = 0; tile < IMAGE_TILE_COUNT; ++tile) {
+        const uint8_t *bytes = data + (tile * IMAGE_TILE_LENGTH);
+        uint32_t value = nesla_table_hash((const char *)bytes, IMAGE_TILE_LENGTH);
+        bool used = false;
+        size_t index = 0;
+
+        for(; index < count; ++index) {
+
+            if((hash[index] == value) && !memcmp(data + (kept[index] * IMAGE_TILE_LENGTH), bytes, IMAGE_TILE_LENGTH)) {
+                break;
+            }
+        }
+
+        for(size_t position = offset + (tile * IMAGE_TILE_LENGTH); position < offset + ((tile + 1) * IMAGE_TILE_LENGTH); ++position) {
+            used |= (bank->used[position / 8] >> (position % 8)) & 1;
+        }
+
+        if(index == count) {
+            kept[count] = tile;
+            hash[count++] = value;
+        } else if(used) {
+            ++result;
+        }
+
+        map[tile] = kept[index];
+    }
+
+    return result;
+}
+
+size_t nesla_image_get_count(const nesla_image_t *image)
+{
+    return image->count;
+}
+
+uint8_t nesla_image_get_header(const nesla_image_t *image, nesla_header_e type)
+{
+    return image->header[type];
+}
+
+size_t nesla_image_get_size(const nesla_image_t *image)
+{
+    return IMAGE_HEADER_LENGTH + (image->header[HEADER_PROGRAM] * IMAGE_PROGRAM_LENGTH)
+        + (image->header[HEADER_CHARACTER] * IMAGE_CHARACTER_LENGTH);
+}
+
+size_t nesla_image_get_length(const nesla_image_t *image, size_t bank)
+{
+    return (bank < image->count) ? image->bank[bank].length : 0;
+}
+
+void nesla_image_initialize(nesla_image_t *image, nesla_context_t *context)
+{
+    memset(image, 0, sizeof(*image));
+    image->context = context;
+}
+
+nesla_error_e nesla_image_merge_tiles(nesla_image_t *image, uint8_t **map, size_t *length, size_t *merged)
+{
+    size_t patterns = image->header[HEADER_CHARACTER] * (IMAGE_CHARACTER_LENGTH / IMAGE_PATTERN_LENGTH);
+    nesla_error_e result = NESLA_SUCCESS;
+
+    *merged = 0;
+
+    if(!image->bank && ((result = nesla_image_allocate(image)) == NESLA_FAILURE)) {
+        goto exit;
+    }
+
+    if(!(*map = nesla_context_allocate(image->context, (patterns + 1) * IMAGE_TILE_COUNT))) {
+        result = SET_ERROR(image->context, "Failed to allocate tile map: %zu", patterns);
+        goto exit;
+    }
+
+    *length = patterns * IMAGE_TILE_COUNT;
+
+    for(size_t index = image->header[HEADER_PROGRAM]; index < image->count; ++index) {
+        nesla_image_bank_t *bank = &image->bank[index];
+        size_t pattern = (index - image->header[HEADER_PROGRAM]) * (IMAGE_CHARACTER_LENGTH / IMAGE_PATTERN_LENGTH);
+
+        nesla_image_copy(image, bank);
+
+        for(size_t offset = 0; offset < bank->length; offset += IMAGE_PATTERN_LENGTH, ++pattern) {
+            *merged += nesla_image_merge_pattern(bank, offset, *map + (pattern * IMAGE_TILE_COUNT));
+        }
+    }
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_image_put(nesla_image_t *image, size_t bank, uint16_t address, const uint8_t *data, size_t length)
+{
+    size_t offset;
+    nesla_image_bank_t *context;
+    nesla_error_e result;
+
+    if((result = nesla_image_get_bank(image, bank, &context)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    offset = address % context->length;
+
+    if((result = nesla_image_reserve(image, context, bank, offset, length)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    memcpy(context->data + offset, data, length);
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_image_put_binary(nesla_image_t *image, size_t bank, uint16_t address, nesla_binary_t *binary)
+{
+    size_t offset;
+    nesla_image_bank_t *context;
+    nesla_list_entry_t *entry, *previous = NULL;
+    nesla_image_binary_t *placed = NULL;
+    nesla_error_e result;
+
+    if((result = nesla_image_get_bank(image, bank, &context)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    offset = address % context->length;
+
+    if((result = nesla_image_reserve(image, context, bank, offset, nesla_binary_get_length(binary))) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if(!(placed = nesla_context_allocate(image->context, sizeof(*placed)))) {
+        result = SET_ERROR(image->context, "Failed to allocate image binary: %p", placed);
+        goto exit;
+    }
+
+    placed->offset = offset;
+    placed->binary = *binary;
+
+    for(entry = nesla_list_get_head(&context->binary); entry; entry = entry->next) {
+
+        if(((nesla_image_binary_t *)entry->context)->offset > offset) {
+            break;
+        }
+
+        previous = entry;
+    }
+
+    if((result = nesla_list_insert(&context->binary, image->context, previous, placed)) == NESLA_FAILURE) {
+        nesla_context_free(image->context, placed);
+        goto exit;
+    }
+
+    nesla_binary_close(binary);
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_image_set_header(nesla_image_t *image, nesla_header_e type, uint16_t value)
+{
+    static const uint16_t MAXIMUM[] = {
+        UINT8_MAX, UINT8_MAX, UINT8_MAX, 1,
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(image->bank && ((type == HEADER_PROGRAM) || (type == HEADER_CHARACTER))) {
+        result = SET_ERROR(image->context, "Bank count redefined after use: %u", value);
+        goto exit;
+    }
+
+    if(value > MAXIMUM[type]) {
+        result = SET_ERROR(image->context, "Invalid header value: %u", value);
+        goto exit;
+    }
+
+    image->header[type] = value;
+
+exit:
+    return result;
+}
+
+void nesla_image_uninitialize(nesla_image_t *image)
+{
+
+    for(size_t index = 0; index < image->count; ++index) {
+        nesla_image_bank_t *bank = &image->bank[index];
+
+        while(nesla_list_get_length(&bank->binary)) {
+            nesla_list_entry_t *entry = nesla_list_get_head(&bank->binary);
+
+            nesla_binary_close(&((nesla_image_binary_t *)entry->context)->binary);
+            nesla_context_free(image->context, entry->context);
+            nesla_list_remove(&bank->binary, image->context, entry);
+        }
+
+        nesla_context_free(image->context, bank->data);
+        nesla_context_free(image->context, bank->used);
+    }
+
+    nesla_context_free(image->context, image->bank);
+    memset(image, 0, sizeof(*image));
+}
+
+nesla_error_e nesla_image_write(nesla_image_t *image, nesla_writer_t *writer)
+{
+    nesla_error_e result;
+    uint8_t header[IMAGE_HEADER_LENGTH] = { 'N', 'E', 'S', 0x1A, };
+
+    if(!image->bank && ((result = nesla_image_allocate(image)) == NESLA_FAILURE)) {
+        goto exit;
+    }
+
+    header[4] = image->header[HEADER_PROGRAM];
+    header[5] = image->header[HEADER_CHARACTER];
+    header[6] = ((image->header[HEADER_MAPPER] & 0x0F) << 4) | (image->header[HEADER_MIRROR] & 1);
+    header[7] = image->header[HEADER_MAPPER] & 0xF0;
+
+    if((result = nesla_writer_put(writer, header, sizeof(header))) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    for(size_t index = 0; index < image->count; ++index) {
+        size_t offset = 0;
+        const nesla_image_bank_t *bank = &image->bank[index];
+
+        for(nesla_list_entry_t *entry = nesla_list_get_head(&bank->binary); entry; entry = entry->next) {
+            const nesla_image_binary_t *binary = entry->context;
+
+            if((result = nesla_writer_put(writer, bank->data + offset, binary->offset - offset)) == NESLA_FAILURE) {
+                goto exit;
+            }
+
+            if((result = nesla_writer_put_binary(writer, &binary->binary)) == NESLA_FAILURE) {
+                goto exit;
+            }
+
+            offset = binary->offset + nesla_binary_get_length(&binary->binary);
+        }
+
+        if((result = nesla_writer_put(writer, bank->data + offset, bank->length - offset)) == NESLA_FAILURE) {
+            goto exit;
+        }
+    }
+
+exit:
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,362 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file inline.c
+ * @brief Leaf subroutine inliner.
+ */
+
+#include <inline.h>
+
+/*!
+ * @struct nesla_inline_t
+ * @brief Inliner context.
+ */
+typedef struct {
+    nesla_encoder_t *encoder;           /*!< Encoder context */
+    nesla_inlined_t *call;              /*!< Inlinable call array */
+    size_t call_count;                  /*!< Inlinable call count */
+    int32_t *room;                      /*!< Bytes free after the section, before the next section in its bank, per section */
+} nesla_inline_t;
+
+/*!
+ * @brief Get the inliner statement a label is placed before.
+ * @param[in] inliner Constant pointer to inliner context
+ * @param[in] symbol Symbol index
+ * @return Statement index, or the statement count if the symbol is not a label placed before a statement
+ */
+static size_t nesla_inline_target(const nesla_inline_t *inliner, uint32_t symbol)
+{
+    const nesla_encoder_t *encoder = inliner->encoder;
+    const nesla_symbol_t *label = &encoder->symbol[symbol];
+
+    if(label->constant) {
+        return encoder->statement_count;
+    }
+
+    if(label->anchor) {
+        return ((label->anchor < encoder->statement_count)
+            && (encoder->statement[label->anchor].section == encoder->statement[label->anchor - 1].section))
+                ? label->anchor : encoder->statement_count;
+    }
+
+    for(size_t index = 0; index < encoder->section_count; ++index) {
+        const nesla_statement_t *first = &encoder->statement[encoder->section[index].first];
+
+        if((first->bank == label->bank) && (first->address == label->address)) {
+            return encoder->section[index].first;
+        }
+    }
+
+    return encoder->statement_count;
+}
+
+/*!
+ * @brief Measure inliner subroutine, from its first statement up to its RTS.
+ * @param[in] inliner Constant pointer to inliner context
+ * @param[in,out] call Pointer to inlined call context, with the first subroutine statement index set
+ * @return true if the subroutine can be inlined, false otherwise
+ */
+static bool nesla_inline_measure(const nesla_inline_t *inliner, nesla_inlined_t *call)
+{
+    const nesla_encoder_t *encoder = inliner->encoder;
+    const nesla_section_t *section = &encoder->section[encoder->statement[call->entry].section];
+    size_t bytes = 0, depth = 0, last = call->entry;
+
+    for(size_t index = call->entry; index < (section->first + section->count); ++index) {
+        const nesla_statement_t *statement = &encoder->statement[index];
+        const nesla_fixup_t *fixup;
+        size_t target;
+
+        if(!statement->length) {
+            continue;
+        }
+
+        if(statement->preserve || (statement->instruction == INSTRUCTION_MAX)) {
+            return false;
+        }
+
+        switch(statement->instruction) {
+            case INSTRUCTION_BRK:
+            case INSTRUCTION_JSR:
+            case INSTRUCTION_RTI:
+            case INSTRUCTION_TSX:
+            case INSTRUCTION_TXS:
+                return false;
+            case INSTRUCTION_PHA:
+            case INSTRUCTION_PHP:
+                ++depth;
+                break;
+            case INSTRUCTION_PLA:
+            case INSTRUCTION_PLP:
+
+                if(!depth--) {
+                    return false;
+                }
+                break;
+            case INSTRUCTION_RTS:
+                call->count = index - call->entry;
+                call->bytes = (int32_t)bytes - nesla_opcode_get(INSTRUCTION_JSR, MODE_ABSOLUTE)->length;
+
+                return bytes && (last <= index) && !depth;
+            default:
+                break;
+        }
+
+        if((statement->mode == MODE_RELATIVE) || (statement->instruction == INSTRUCTION_JMP)) {
+
+            if((statement->mode == MODE_INDIRECT) || !(fixup = nesla_encoder_get_fixup(encoder, index))
+                    || ((target = nesla_inline_target(inliner, fixup->index)) <= call->entry)
+                    || (target >= (section->first + section->count))) {
+                return false;
+            }
+
+            if(target > last) {
+                last = target;
+            }
+        }
+
+        if((bytes += statement->length) > INLINE_SIZE_MAX) {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+/*!
+ * @brief Estimate inliner call count, each time the code around the call runs. A call in a loop (a branch or jump back over
+ *        it, in its section) runs once more than the bound of the innermost such loop (.LOOP), or INLINE_WEIGHT_LOOP times if
+ *        unbounded. A call marked hot (.HOT) runs at least INLINE_WEIGHT_HOT times.
+ * @param[in] inliner Constant pointer to inliner context
+ * @param[in] index Call statement index
+ * @return Estimated call count, or 0 if the call is not hot
+ */
+static uint32_t nesla_inline_weight(const nesla_inline_t *inliner, size_t index)
+{
+    const nesla_encoder_t *encoder = inliner->encoder;
+    const nesla_statement_t *call = &encoder->statement[index];
+    const nesla_section_t *section = &encoder->section[call->section];
+    size_t low = 0, high = encoder->fixup_count, span = SIZE_MAX;
+    uint32_t weight = 0;
+
+    while(low < high) {
+        size_t middle = (low + high) / 2;
+
+        if(encoder->fixup[middle].statement <= index) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    for(; (low < encoder->fixup_count) && (encoder->fixup[low].statement < (section->first + section->count)); ++low) {
+        const nesla_fixup_t *fixup = &encoder->fixup[low];
+        const nesla_statement_t *statement = &encoder->statement[fixup->statement];
+        size_t target;
+
+        if(!statement->length || (fixup->index == ENCODER_UNRESOLVED)
+                || ((statement->mode != MODE_RELATIVE)
+                    && ((statement->instruction != INSTRUCTION_JMP) || (statement->mode != MODE_ABSOLUTE)))
+                || ((target = nesla_inline_target(inliner, fixup->index)) > index) || (target < section->first)
+                || ((fixup->statement - target) >= span)) {
+            continue;
+        }
+
+        span = fixup->statement - target;
+        weight = statement->bound ? (statement->bound + 1) : INLINE_WEIGHT_LOOP;
+    }
+
+    if(call->hot && (weight < INLINE_WEIGHT_HOT)) {
+        weight = INLINE_WEIGHT_HOT;
+    }
+
+    return weight;
+}
+
+/*!
+ * @brief Find inliner room after each section, up to the next section in its bank, or the end of the address space.
+ * @param[in,out] inliner Pointer to inliner context
+ */
+static void nesla_inline_room(nesla_inline_t *inliner)
+{
+    const nesla_encoder_t *encoder = inliner->encoder;
+
+    for(size_t index = 0; index < encoder->section_count; ++index) {
+        const nesla_section_t *section = &encoder->section[index];
+        const nesla_statement_t *first = &encoder->statement[section->first];
+        int32_t end = first->address, boundary = UINT16_MAX + 1;
+
+        for(size_t offset = section->first; offset < (section->first + section->count); ++offset) {
+            end += encoder->statement[offset].length;
+        }
+
+        for(size_t other = 0; other < encoder->section_count; ++other) {
+            const nesla_statement_t *next = &encoder->statement[encoder->section[other].first];
+
+            if((next->bank == first->bank) && (next->address > first->address) && (next->address < boundary)) {
+                boundary = next->address;
+            }
+        }
+
+        inliner->room[index] = boundary - end;
+    }
+}
+
+/*!
+ * @brief Compare inliner calls, by cycles saved per byte added (calls that add no bytes first), then by call statement.
+ * @param[in] first Constant pointer to first inlined call context
+ * @param[in] second Constant pointer to second inlined call context
+ * @return Negative if the first call is inlined first, positive if the second call is, 0 otherwise
+ */
+static int nesla_inline_compare(const void *first, const void *second)
+{
+    const nesla_inlined_t *left = first, *right = second;
+
+    if((left->bytes <= 0) != (right->bytes <= 0)) {
+        return (left->bytes <= 0) ? -1 : 1;
+    }
+
+    if(left->bytes > 0) {
+        uint64_t left_gain = (uint64_t)left->cycles * left->weight * right->bytes,
+            right_gain = (uint64_t)right->cycles * right->weight * left->bytes;
+
+        if(left_gain != right_gain) {
+            return (left_gain > right_gain) ? -1 : 1;
+        }
+    }
+
+    return (left->first > right->first) - (left->first < right->first);
+}
+
+/*!
+ * @brief Compare inliner calls, by call statement.
+ * @param[in] first Constant pointer to first inlined call context
+ * @param[in] second Constant pointer to second inlined call context
+ * @return Negative if the first call comes first, positive if the second call does, 0 otherwise
+ */
+static int nesla_inline_order(const void *first, const void *second)
+{
+    const nesla_inlined_t *left = first, *right = second;
+
+    return (left->first > right->first) - (left->first < right->first);
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+nesla_error_e nesla_inline_expand(nesla_encoder_t *encoder)
+{
+    nesla_inline_t inliner = { encoder, };
+    const nesla_opcode_t *call = nesla_opcode_get(INSTRUCTION_JSR, MODE_ABSOLUTE), *exit = nesla_opcode_get(INSTRUCTION_RTS, MODE_IMPLIED);
+    size_t count = 0, kept = 0;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(size_t index = 0; index < encoder->statement_count; ++index) {
+
+        if(encoder->statement[index].instruction == INSTRUCTION_JSR) {
+            ++count;
+        }
+    }
+
+    if(!count) {
+        goto exit;
+    }
+
+    if(!(inliner.call = nesla_context_allocate(encoder->context, count * sizeof(*inliner.call)))
+            || !(inliner.room = nesla_context_allocate(encoder->context, encoder->section_count * sizeof(*inliner.room)))) {
+        result = SET_ERROR(encoder->context, "Failed to allocate inliner: %zu", count);
+        goto exit;
+    }
+
+    nesla_inline_room(&inliner);
+
+    for(size_t index = 0; index < encoder->statement_count; ++index) {
+        const nesla_statement_t *statement = &encoder->statement[index];
+        nesla_inlined_t *candidate = &inliner.call[inliner.call_count];
+        const nesla_fixup_t *fixup;
+
+        if(!statement->length || statement->preserve || (statement->instruction != INSTRUCTION_JSR)
+                || !(fixup = nesla_encoder_get_fixup(encoder, index))
+                || ((candidate->entry = nesla_inline_target(&inliner, fixup->index)) == encoder->statement_count)
+                || (encoder->statement[candidate->entry].bank != statement->bank)
+                || !(candidate->weight = nesla_inline_weight(&inliner, index)) || !nesla_inline_measure(&inliner, candidate)) {
+            continue;
+        }
+
+        candidate->token = statement->token;
+        candidate->symbol = fixup->index;
+        candidate->first = index;
+        candidate->cycles = call->cycles + exit->cycles;
+
+        if((candidate->bytes <= 0) || ((candidate->cycles * candidate->weight) >= (uint32_t)(INLINE_BYTE_CYCLES * candidate->bytes))) {
+            ++inliner.call_count;
+        }
+    }
+
+    qsort(inliner.call, inliner.call_count, sizeof(*inliner.call), nesla_inline_compare);
+
+    for(size_t index = 0; index < inliner.call_count; ++index) {
+        const nesla_inlined_t *candidate = &inliner.call[index];
+        int32_t *room = &inliner.room[encoder->statement[candidate->first].section];
+
+        if(candidate->bytes > *room) {
+            SET_NOTE_AT(encoder->context, nesla_token_get_path(candidate->token), nesla_token_get_line(candidate->token),
+                nesla_token_get_column(candidate->token), "Call to %s not inlined: +%i bytes do not fit before the next section",
+                nesla_literal_get(nesla_token_get_literal(encoder->symbol[candidate->symbol].token)), candidate->bytes);
+            continue;
+        }
+
+        *room -= candidate->bytes;
+        inliner.call[kept++] = *candidate;
+    }
+
+    if(!(inliner.call_count = kept)) {
+        goto exit;
+    }
+
+    qsort(inliner.call, inliner.call_count, sizeof(*inliner.call), nesla_inline_order);
+
+    for(size_t index = 0; index < inliner.call_count; ++index) {
+        const nesla_inlined_t *candidate = &inliner.call[index];
+
+        ++encoder->context->statistics.inlined;
+        encoder->context->statistics.inlined_bytes += candidate->bytes;
+        encoder->context->statistics.inlined_cycles += candidate->cycles;
+        SET_NOTE_AT(encoder->context, nesla_token_get_path(candidate->token), nesla_token_get_line(candidate->token),
+            nesla_token_get_column(candidate->token), "Call to %s inlined: %+i bytes, -%u cycles per call, ~%u calls",
+            nesla_literal_get(nesla_token_get_literal(encoder->symbol[candidate->symbol].token)), candidate->bytes, candidate->cycles,
+            candidate->weight);
+    }
+
+    result = nesla_encoder_put_inlined(encoder, inliner.call, inliner.call_count);
+
+exit:
+    nesla_context_free(encoder->context, inliner.room);
+    nesla_context_free(encoder->context, inliner.call);
+
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -30,30 +30,44 @@
 extern "C" {
 #endif /* __cplusplus */
 
+/*!
+ * @brief Move lexer stream to next character.
+ * @param[in,out] lexer Pointer to lexer context
+ * @return true if a character is available, false at end of stream
+ */
+static bool nesla_lexer_advance(nesla_lexer_t *lexer)
+{
+
+    if(!lexer->end && (nesla_stream_next(&lexer->stream) == NESLA_FAILURE)) {
+        lexer->end = true;
+    }
+
+    return !lexer->end;
+}
+
 /*!
  * @brief Allocate lexer token.
  * @param[in,out] lexer Pointer to lexer context
  * @param[in] type Token type
  * @param[in] subtype Token subtype
  * @param[in] path Token file path
- * @param[in] line Token flle line
+ * @param[in] line Token file line
+ * @param[in] column Token file column
  * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
  */
-static nesla_error_e nesla_lexer_append(nesla_lexer_t *lexer, nesla_token_e type, int subtype, const char *path, size_t line)
+static nesla_error_e nesla_lexer_append(nesla_lexer_t *lexer, nesla_token_e type, int subtype, const char *path, size_t line, size_t column)
 {
-    nesla_token_t *token = NULL;
-    nesla_error_e result = NESLA_SUCCESS;
+    nesla_token_t *token;
+    nesla_error_e result;
 
-    if(!(token = calloc(1, sizeof(*token)))) {
-        result = SET_ERROR("Failed to allocate token: %p", token);
+    if((result = nesla_context_reserve(lexer->context, (void **)&lexer->token, &lexer->capacity, lexer->count, sizeof(*token)))
+            == NESLA_FAILURE) {
         goto exit;
     }
 
-    nesla_token_set(token, type, subtype, path, line);
-
-    if((result = nesla_list_insert(&lexer->token, nesla_list_get_tail(&lexer->token), token)) == NESLA_FAILURE) {
-        goto exit;
-    }
+    token = &lexer->token[lexer->count++];
+    memset(token, 0, sizeof(*token));
+    nesla_token_set(token, type, subtype, path, line, column);
 
 exit:
     return result;
@@ -65,18 +79,20 @@ exit:
  * @param[in] literal Constant pointer to literal context
  * @param[in] type Token type
  * @param[in] path Token file path
- * @param[in] line Token flle line
+ * @param[in] line Token file line
+ * @param[in] column Token file column
  * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
  */
-static nesla_error_e nesla_lexer_append_literal(nesla_lexer_t *lexer, const nesla_literal_t *literal, nesla_token_e type, const char *path, size_t line)
+static nesla_error_e nesla_lexer_append_literal(nesla_lexer_t *lexer, const nesla_literal_t *literal, nesla_token_e type, const char *path, size_t line,
+    size_t column)
 {
     nesla_error_e result;
 
-    if((result = nesla_lexer_append(lexer, type, 0, path, line)) == NESLA_FAILURE) {
+    if((result = nesla_lexer_append(lexer, type, 0, path, line, column)) == NESLA_FAILURE) {
         goto exit;
     }
 
-    if((result = nesla_token_set_literal(nesla_list_get_tail(&lexer->token)->context, literal)) == NESLA_FAILURE) {
+    if((result = nesla_token_set_literal(&lexer->token[lexer->count - 1], lexer->context, literal)) == NESLA_FAILURE) {
         goto exit;
     }
 
@@ -84,42 +100,36 @@ exit:
     return result;
 }
 
-#if 0 /* TODO: IMPLEMENT LEXER PARSE ROUTINES */
-
 /*!
  * @brief Allocate lexer scalar token.
  * @param[in,out] lexer Pointer to lexer context
  * @param[in] scalar Scalar value
  * @param[in] path Token file path
- * @param[in] line Token flle line
+ * @param[in] line Token file line
+ * @param[in] column Token file column
  * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
  */
-static nesla_error_e nesla_lexer_append_scalar(nesla_lexer_t *lexer, uint16_t scalar, const char *path, size_t line)
+static nesla_error_e nesla_lexer_append_scalar(nesla_lexer_t *lexer, uint16_t scalar, const char *path, size_t line, size_t column)
 {
     nesla_error_e result;
 
-    if((result = nesla_lexer_append(lexer, TOKEN_SCALAR, 0, path, line)) == NESLA_FAILURE) {
+    if((result = nesla_lexer_append(lexer, TOKEN_SCALAR, 0, path, line, column)) == NESLA_FAILURE) {
         goto exit;
     }
 
-    nesla_token_set_scalar(nesla_list_get_tail(&lexer->token)->context, scalar);
+    nesla_token_set_scalar(&lexer->token[lexer->count - 1], scalar);
 
 exit:
     return result;
 }
 
-#endif /* 0 */
-
 /*!
- * @brief Free lexer token.
+ * @brief Free lexer token at the end of the token array.
  * @param[in,out] lexer Pointer to lexer context
- * @param[in] entry Pointer to list entry context
  */
-static void nesla_lexer_free(nesla_lexer_t *lexer, nesla_list_entry_t *entry)
+static void nesla_lexer_free(nesla_lexer_t *lexer)
 {
-    nesla_token_free(entry->context);
-    free(entry->context);
-    nesla_list_remove(&lexer->token, entry);
+    nesla_token_free(&lexer->token[--lexer->count], lexer->context);
 }
 
 /*!
@@ -129,9 +139,11 @@ static void nesla_lexer_free(nesla_lexer_t *lexer, nesla_list_entry_t *entry)
 static void nesla_lexer_free_all(nesla_lexer_t *lexer)
 {
 
-    while(nesla_list_get_length(&lexer->token)) {
-        nesla_lexer_free(lexer, nesla_list_get_head(&lexer->token));
+    while(lexer->count) {
+        nesla_lexer_free(lexer);
     }
+
+    nesla_context_free(lexer->context, lexer->token);
 }
 
 /*!
@@ -144,7 +156,8 @@ static void nesla_lexer_free_all(nesla_lexer_t *lexer)
 static bool nesla_lexer_match_type(nesla_token_e type, int *subtype, const nesla_literal_t *literal)
 {
     static const char *DIRECTIVE[] = {
-        ".BANK", ".BYTE", ".CHR", ".DEF", ".INC", ".INCB", ".MAP", ".MIR", ".ORG", ".PRG", ".RESV", ".UNDEF", ".WORD",
+        ".ALIGN", ".BANK", ".BUDGET", ".BYTE", ".CHR", ".DEF", ".FAR", ".HOT", ".INC", ".INCB", ".JUMP", ".KEEP", ".LOOP", ".MAP",
+        ".MIR", ".NOOPT", ".OPT", ".ORG", ".PACK", ".PRG", ".RELOC", ".RESV", ".SOA", ".STACK", ".TABLE", ".UNDEF", ".WORD",
         };
 
     static const char *INSTRUCTION[] = {
@@ -159,7 +172,7 @@ static bool nesla_lexer_match_type(nesla_token_e type, int *subtype, const nesla
         };
 
     static const char *SYMBOL[] = {
-        ",", "#", ")", "(",
+        ",", "#", ")", "(", ">", "<",
         };
 
     size_t length = 0;
@@ -211,21 +224,22 @@ static bool nesla_lexer_match_type(nesla_token_e type, int *subtype, const nesla
  * @param[in,out] lexer Pointer to lexer context
  * @param[in] value Current character value
  * @param[in] path Token file path
- * @param[in] line Token flle line
+ * @param[in] line Token file line
+ * @param[in] column Token file column
  * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
  */
-static nesla_error_e nesla_lexer_parse_alpha(nesla_lexer_t *lexer, uint8_t value, const char *path, size_t line)
+static nesla_error_e nesla_lexer_parse_alpha(nesla_lexer_t *lexer, uint8_t value, const char *path, size_t line, size_t column)
 {
     int subtype = 0;
     nesla_token_e type;
     nesla_error_e result;
     nesla_literal_t literal = {};
 
-    if((result = nesla_literal_append(&literal, value)) == NESLA_FAILURE) {
+    if((result = nesla_literal_append(&literal, lexer->context, value)) == NESLA_FAILURE) {
         goto exit;
     }
 
-    while(nesla_stream_next(&lexer->stream) == NESLA_SUCCESS) {
+    while(nesla_lexer_advance(lexer)) {
         nesla_character_e char_type = nesla_stream_get_type(&lexer->stream);
 
         value = nesla_stream_get(&lexer->stream);
@@ -236,13 +250,14 @@ static nesla_error_e nesla_lexer_parse_alpha(nesla_lexer_t *lexer, uint8_t value
             break;
         }
 
-        if((result = nesla_literal_append(&literal, value)) == NESLA_FAILURE) {
+        if((result = nesla_literal_append(&literal, lexer->context, value)) == NESLA_FAILURE) {
             goto exit;
         }
     }
 
-    if(nesla_stream_get(&lexer->stream) == ':') {
+    if(!lexer->end && (nesla_stream_get(&lexer->stream) == ':')) {
         type = TOKEN_LABEL;
+        nesla_lexer_advance(lexer);
     } else if(nesla_lexer_match_type(TOKEN_INSTRUCTION, &subtype, &literal)) {
         type = TOKEN_INSTRUCTION;
     } else if(nesla_lexer_match_type(TOKEN_OPERAND, &subtype, &literal)) {
@@ -255,14 +270,14 @@ static nesla_error_e nesla_lexer_parse_alpha(nesla_lexer_t *lexer, uint8_t value
         case TOKEN_INSTRUCTION:
         case TOKEN_OPERAND:
 
-            if((result = nesla_lexer_append(lexer, type, subtype, path, line)) == NESLA_FAILURE) {
+            if((result = nesla_lexer_append(lexer, type, subtype, path, line, column)) == NESLA_FAILURE) {
                 goto exit;
             }
             break;
         case TOKEN_IDENTIFIER:
         case TOKEN_LABEL:
 
-            if((result = nesla_lexer_append_literal(lexer, &literal, type, path, line)) == NESLA_FAILURE) {
+            if((result = nesla_lexer_append_literal(lexer, &literal, type, path, line, column)) == NESLA_FAILURE) {
                 goto exit;
             }
             break;
@@ -271,27 +286,200 @@ static nesla_error_e nesla_lexer_parse_alpha(nesla_lexer_t *lexer, uint8_t value
     }
 
 exit:
-    nesla_literal_free(&literal);
+    nesla_literal_free(&literal, lexer->context);
 
     return result;
 }
 
 /*!
- * @brief Parse lexer digit token.
+ * @brief Parse lexer scalar digits in a given base.
  * @param[in,out] lexer Pointer to lexer context
- * @param[in] value Current character value
+ * @param[in] base Scalar base (2, 10 or 16)
+ * @param[in] count Exact number of digits to parse, or 0 to parse all digits
+ * @param[in,out] scalar Pointer to scalar value
+ * @param[in] path Token file path
+ * @param[in] line Token file line
+ * @param[in] column Token file column
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_lexer_parse_digits(nesla_lexer_t *lexer, int base, size_t count, uint16_t *scalar, const char *path, size_t line,
+    size_t column)
+{
+    size_t digits = 0;
+    uint32_t value = 0;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    while(!lexer->end && (!count || (digits < count))) {
+        int digit = toupper(nesla_stream_get(&lexer->stream));
+
+        if((digit >= '0') && (digit <= '9')) {
+            digit -= '0';
+        } else if((digit >= 'A') && (digit <= 'F')) {
+            digit = (digit - 'A') + 10;
+        } else {
+            break;
+        }
+
+        if(digit >= base) {
+            break;
+        }
+
+        if((value = (value * base) + digit) > UINT16_MAX) {
+            result = SET_ERROR_AT(lexer->context, path, line, column, "Scalar too large: %u", value);
+            goto exit;
+        }
+
+        ++digits;
+        nesla_lexer_advance(lexer);
+    }
+
+    if(!digits || (count && (digits != count))) {
+        result = SET_ERROR_AT(lexer->context, path, line, column, "Malformed scalar");
+        goto exit;
+    }
+
+    *scalar = value;
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Parse lexer literal escape character.
+ * @param[in,out] lexer Pointer to lexer context
+ * @param[in,out] value Pointer to escaped character value
+ * @param[in] path Token file path
+ * @param[in] line Token file line
+ * @param[in] column Token file column
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_lexer_parse_escape(nesla_lexer_t *lexer, uint8_t *value, const char *path, size_t line, size_t column)
+{
+    uint16_t scalar = 0;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(!nesla_lexer_advance(lexer)) {
+        result = SET_ERROR_AT(lexer->context, path, line, column, "Malformed escape");
+        goto exit;
+    }
+
+    switch(nesla_stream_get(&lexer->stream)) {
+        case '&':
+            nesla_lexer_advance(lexer);
+            result = nesla_lexer_parse_digits(lexer, 2, 8, &scalar, path, line, column);
+            break;
+        case '$':
+            nesla_lexer_advance(lexer);
+            result = nesla_lexer_parse_digits(lexer, 16, 2, &scalar, path, line, column);
+            break;
+        default:
+
+            if(nesla_stream_get_type(&lexer->stream) == CHARACTER_DIGIT) {
+
+                if(((result = nesla_lexer_parse_digits(lexer, 10, 3, &scalar, path, line, column)) == NESLA_SUCCESS)
+                        && (scalar > UINT8_MAX)) {
+                    result = SET_ERROR_AT(lexer->context, path, line, column, "Malformed escape: %u", scalar);
+                }
+            } else {
+                scalar = nesla_stream_get(&lexer->stream);
+                nesla_lexer_advance(lexer);
+            }
+            break;
+    }
+
+    *value = scalar;
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Parse lexer literal token.
+ * @param[in,out] lexer Pointer to lexer context
+ * @param[in] value Current character value (literal delimiter)
  * @param[in] path Token file path
- * @param[in] line Token flle line
+ * @param[in] line Token file line
+ * @param[in] column Token file column
  * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
  */
-static nesla_error_e nesla_lexer_parse_digit(nesla_lexer_t *lexer, uint8_t value, const char *path, size_t line)
+static nesla_error_e nesla_lexer_parse_literal(nesla_lexer_t *lexer, uint8_t value, const char *path, size_t line, size_t column)
 {
+    uint8_t delimiter = value;
+    nesla_literal_t literal = {};
+    nesla_error_e result = NESLA_SUCCESS;
+
+    nesla_lexer_advance(lexer);
+
+    while(!lexer->end && ((value = nesla_stream_get(&lexer->stream)) != delimiter) && (value != '\n')) {
+
+        if(value == '\\') {
+
+            if((result = nesla_lexer_parse_escape(lexer, &value, path, line, column)) == NESLA_FAILURE) {
+                goto exit;
+            }
+        } else {
+            nesla_lexer_advance(lexer);
+        }
+
+        if((result = nesla_literal_append(&literal, lexer->context, value)) == NESLA_FAILURE) {
+            goto exit;
+        }
+    }
+
+    if(lexer->end || (value != delimiter)) {
+        result = SET_ERROR_AT(lexer->context, path, line, column, "Unterminated literal");
+        goto exit;
+    }
+
+    nesla_lexer_advance(lexer);
+
+    if(delimiter == '\'') {
+
+        if(nesla_literal_get_length(&literal) != 1) {
+            result = SET_ERROR_AT(lexer->context, path, line, column, "Malformed character literal");
+            goto exit;
+        }
+
+        result = nesla_lexer_append_scalar(lexer, nesla_literal_get(&literal)[0], path, line, column);
+    } else {
+
+        if(!nesla_literal_get_length(&literal)) {
+            result = SET_ERROR_AT(lexer->context, path, line, column, "Empty literal");
+            goto exit;
+        }
+
+        result = nesla_lexer_append_literal(lexer, &literal, TOKEN_LITERAL, path, line, column);
+    }
+
+exit:
+    nesla_literal_free(&literal, lexer->context);
+
+    return result;
+}
+
+/*!
+ * @brief Parse lexer scalar token.
+ * @param[in,out] lexer Pointer to lexer context
+ * @param[in] base Scalar base (2, 10 or 16)
+ * @param[in] path Token file path
+ * @param[in] line Token file line
+ * @param[in] column Token file column
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_lexer_parse_scalar(nesla_lexer_t *lexer, int base, const char *path, size_t line, size_t column)
+{
+    uint16_t scalar = 0;
     nesla_error_e result;
 
-    /* TODO: PARSE DIGIT */
-    result = NESLA_SUCCESS;
-    /* --- */
+    if((result = nesla_lexer_parse_digits(lexer, base, 0, &scalar, path, line, column)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if((result = nesla_lexer_append_scalar(lexer, scalar, path, line, column)) == NESLA_FAILURE) {
+        goto exit;
+    }
 
+exit:
     return result;
 }
 
@@ -300,10 +488,11 @@ static nesla_error_e nesla_lexer_parse_digit(nesla_lexer_t *lexer, uint8_t value
  * @param[in,out] lexer Pointer to lexer context
  * @param[in] value Current character value
  * @param[in] path Token file path
- * @param[in] line Token flle line
+ * @param[in] line Token file line
+ * @param[in] column Token file column
  * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
  */
-static nesla_error_e nesla_lexer_parse_symbol(nesla_lexer_t *lexer, uint8_t value, const char *path, size_t line)
+static nesla_error_e nesla_lexer_parse_symbol(nesla_lexer_t *lexer, uint8_t value, const char *path, size_t line, size_t column)
 {
     int subtype = 0;
     nesla_literal_t literal = {};
@@ -311,7 +500,7 @@ static nesla_error_e nesla_lexer_parse_symbol(nesla_lexer_t *lexer, uint8_t valu
 
     if(value == ';') {
 
-        while(nesla_stream_next(&lexer->stream) == NESLA_SUCCESS) {
+        while(nesla_lexer_advance(lexer)) {
 
             if(nesla_stream_get(&lexer->stream) == '\n') {
                 break;
@@ -319,56 +508,103 @@ static nesla_error_e nesla_lexer_parse_symbol(nesla_lexer_t *lexer, uint8_t valu
         }
     } else if(value == '.') {
 
-        if((result = nesla_literal_append(&literal, value)) == NESLA_FAILURE) {
+        if((result = nesla_literal_append(&literal, lexer->context, value)) == NESLA_FAILURE) {
             goto exit;
         }
 
-        while(nesla_stream_next(&lexer->stream) == NESLA_SUCCESS) {
+        while(nesla_lexer_advance(lexer)) {
 
             if(nesla_stream_get_type(&lexer->stream) != CHARACTER_ALPHA) {
                 break;
             }
 
-            if((result = nesla_literal_append(&literal, nesla_stream_get(&lexer->stream))) == NESLA_FAILURE) {
+            if((result = nesla_literal_append(&literal, lexer->context, nesla_stream_get(&lexer->stream))) == NESLA_FAILURE) {
                 goto exit;
             }
         }
 
         if(!nesla_lexer_match_type(TOKEN_DIRECTIVE, &subtype, &literal)) {
-            result = SET_ERROR("Unsupported directive: \"%s\" (%s@%zu)", nesla_literal_get(&literal), path, line);
+            result = SET_ERROR_AT(lexer->context, path, line, column, "Unsupported directive: \"%s\"", nesla_literal_get(&literal));
             goto exit;
         }
 
-        if((result = nesla_lexer_append(lexer, TOKEN_DIRECTIVE, subtype, path, line)) == NESLA_FAILURE) {
+        if((result = nesla_lexer_append(lexer, TOKEN_DIRECTIVE, subtype, path, line, column)) == NESLA_FAILURE) {
             goto exit;
         }
     } else if(value == '_') {
 
-        if((result = nesla_lexer_parse_alpha(lexer, value, path, line)) == NESLA_FAILURE) {
+        if((result = nesla_lexer_parse_alpha(lexer, value, path, line, column)) == NESLA_FAILURE) {
+            goto exit;
+        }
+    } else if((value == '"') || (value == '\'')) {
+
+        if((result = nesla_lexer_parse_literal(lexer, value, path, line, column)) == NESLA_FAILURE) {
+            goto exit;
+        }
+    } else if((value == '$') || (value == '&')) {
+        nesla_lexer_advance(lexer);
+
+        if((result = nesla_lexer_parse_scalar(lexer, (value == '$') ? 16 : 2, path, line, column)) == NESLA_FAILURE) {
             goto exit;
         }
     } else {
 
-        if((result = nesla_literal_append(&literal, value)) == NESLA_FAILURE) {
+        if((result = nesla_literal_append(&literal, lexer->context, value)) == NESLA_FAILURE) {
             goto exit;
         }
 
         if(!nesla_lexer_match_type(TOKEN_SYMBOL, &subtype, &literal)) {
-            result = SET_ERROR("Unsupported symbol: \"%s\" (%s@%zu)", nesla_literal_get(&literal), path, line);
+            result = SET_ERROR_AT(lexer->context, path, line, column, "Unsupported symbol: \"%s\"", nesla_literal_get(&literal));
             goto exit;
         }
 
-        if((result = nesla_lexer_append(lexer, TOKEN_SYMBOL, subtype, path, line)) == NESLA_FAILURE) {
+        if((result = nesla_lexer_append(lexer, TOKEN_SYMBOL, subtype, path, line, column)) == NESLA_FAILURE) {
             goto exit;
         }
+
+        nesla_lexer_advance(lexer);
     }
 
 exit:
-    nesla_literal_free(&literal);
+    nesla_literal_free(&literal, lexer->context);
 
     return result;
 }
 
+/*!
+ * @brief Recover lexer from a malformed token, by dropping the tokens on its line and resuming at the next line.
+ * @param[in,out] lexer Pointer to lexer context
+ * @param[in] errors Number of errors reported before the malformed token
+ * @param[in] path Token file path
+ * @param[in] line Token file line
+ * @param[in] column Token file column
+ * @return NESLA_ERROR if no more diagnostics can be kept, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_lexer_recover(nesla_lexer_t *lexer, size_t errors, const char *path, size_t line, size_t column)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(nesla_context_get_diagnostic_count(lexer->context, NESLA_DIAGNOSTIC_ERROR) == errors) {
+        SET_ERROR_AT(lexer->context, path, line, column, "%s", nesla_context_get_error(lexer->context));
+    }
+
+    if(nesla_context_is_full(lexer->context)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    while(lexer->count && (nesla_token_get_line(&lexer->token[lexer->count - 1]) == line)) {
+        nesla_lexer_free(lexer);
+    }
+
+    while(!lexer->end && (nesla_stream_get(&lexer->stream) != '\n')) {
+        nesla_lexer_advance(lexer);
+    }
+
+exit:
+    return result;
+}
+
 /*!
  * @brief Parse lexer token.
  * @param[in,out] lexer Pointer to lexer context
@@ -376,39 +612,42 @@ exit:
  */
 static nesla_error_e nesla_lexer_parse(nesla_lexer_t *lexer)
 {
-    nesla_error_e result;
+    nesla_error_e result = NESLA_SUCCESS;
 
-    do {
-        nesla_character_e type;
+    while(!lexer->end) {
         uint8_t value = nesla_stream_get(&lexer->stream);
         size_t line = nesla_stream_get_line(&lexer->stream);
+        size_t column = nesla_stream_get_column(&lexer->stream);
         const char *path = nesla_stream_get_path(&lexer->stream);
+        size_t errors = nesla_context_get_diagnostic_count(lexer->context, NESLA_DIAGNOSTIC_ERROR);
 
-        switch(type = nesla_stream_get_type(&lexer->stream)) {
+        switch(nesla_stream_get_type(&lexer->stream)) {
             case CHARACTER_ALPHA:
-
-                if((result = nesla_lexer_parse_alpha(lexer, value, path, line)) == NESLA_FAILURE) {
-                    goto exit;
-                }
+                result = nesla_lexer_parse_alpha(lexer, value, path, line, column);
                 break;
             case CHARACTER_DIGIT:
-
-                if((result = nesla_lexer_parse_digit(lexer, value, path, line)) == NESLA_FAILURE) {
-                    goto exit;
-                }
+                result = nesla_lexer_parse_scalar(lexer, 10, path, line, column);
                 break;
             case CHARACTER_SYMBOL:
-
-                if((result = nesla_lexer_parse_symbol(lexer, value, path, line)) == NESLA_FAILURE) {
-                    goto exit;
-                }
+                result = nesla_lexer_parse_symbol(lexer, value, path, line, column);
                 break;
             default:
+                nesla_lexer_advance(lexer);
                 break;
         }
-    } while(nesla_stream_next(&lexer->stream) == NESLA_SUCCESS);
 
-    if((result = nesla_lexer_append(lexer, TOKEN_END, 0, NULL, 0)) == NESLA_FAILURE) {
+        if((result == NESLA_FAILURE)
+                && ((result = nesla_lexer_recover(lexer, errors, path, line, column)) == NESLA_FAILURE)) {
+            goto exit;
+        }
+    }
+
+    if(nesla_stream_is_failed(&lexer->stream)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if((result = nesla_lexer_append(lexer, TOKEN_END, 0, NULL, 0, 0)) == NESLA_FAILURE) {
         goto exit;
     }
 
@@ -419,25 +658,46 @@ exit:
 }
 
 nesla_error_e nesla_lexer_get(const nesla_lexer_t *lexer, nesla_token_t **token)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(lexer->index >= lexer->count) {
+        result = SET_ERROR(lexer->context, "Invalid token index: %zu", lexer->index);
+        goto exit;
+    }
+
+    *token = &lexer->token[lexer->index];
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_lexer_initialize(nesla_lexer_t *lexer, nesla_context_t *context, const char *path)
 {
     nesla_error_e result;
-    nesla_list_entry_t *entry;
 
-    if((result = nesla_list_get(&lexer->token, lexer->index, &entry)) == NESLA_FAILURE) {
+    lexer->context = context;
+
+    if((result = nesla_stream_initialize(&lexer->stream, context, path)) == NESLA_FAILURE) {
         goto exit;
     }
 
-    *token = entry->context;
+    if((result = nesla_lexer_parse(lexer)) == NESLA_FAILURE) {
+        goto exit;
+    }
 
 exit:
     return result;
 }
 
-nesla_error_e nesla_lexer_initialize(nesla_lexer_t *lexer, const char *path)
+nesla_error_e nesla_lexer_initialize_buffer(nesla_lexer_t *lexer, nesla_context_t *context, const char *path, const uint8_t *data,
+    size_t length)
 {
     nesla_error_e result;
 
-    if((result = nesla_stream_initialize(&lexer->stream, path)) == NESLA_FAILURE) {
+    lexer->context = context;
+
+    if((result = nesla_stream_initialize_buffer(&lexer->stream, context, path, data, length)) == NESLA_FAILURE) {
         goto exit;
     }
 
@@ -453,8 +713,8 @@ nesla_error_e nesla_lexer_next(nesla_lexer_t *lexer)
 {
     nesla_error_e result = NESLA_SUCCESS;
 
-    if(lexer->index + 1 >= nesla_list_get_length(&lexer->token)) {
-        result = SET_ERROR("No next token: %zu", lexer->index);
+    if(lexer->index + 1 >= lexer->count) {
+        result = SET_ERROR(lexer->context, "No next token: %zu", lexer->index);
         goto exit;
     }
 
@@ -464,6 +724,21 @@ exit:
     return result;
 }
 
+nesla_error_e nesla_lexer_peek(const nesla_lexer_t *lexer, nesla_token_t **token)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(lexer->index + 1 >= lexer->count) {
+        result = SET_ERROR(lexer->context, "Invalid token index: %zu", lexer->index + 1);
+        goto exit;
+    }
+
+    *token = &lexer->token[lexer->index + 1];
+
+exit:
+    return result;
+}
+
 nesla_error_e nesla_lexer_reset(nesla_lexer_t *lexer)
 {
     nesla_error_e result;
@@ -0,0 +1,540 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file listing.c
+ * @brief Assembly listing.
+ */
+
+#include <listing.h>
+
+/*!
+ * @struct nesla_listing_t
+ * @brief Listing context.
+ */
+typedef struct {
+    const nesla_encoder_t *encoder;     /*!< Encoder context */
+    nesla_writer_t *writer;             /*!< Writer context */
+    uint32_t *label;                    /*!< First label index, per statement (and one past the last), or ENCODER_UNRESOLVED */
+    uint32_t *next;                     /*!< Next label index placed before the same statement, per symbol */
+} nesla_listing_t;
+
+/*!
+ * @struct nesla_total_t
+ * @brief Cycle totals, of a run of statements.
+ */
+typedef struct {
+    size_t count;                       /*!< Instruction count */
+    size_t minimum;                     /*!< Cycles, without penalties */
+    size_t maximum;                     /*!< Cycles, with every penalty that can apply */
+} nesla_total_t;
+
+/*!
+ * @brief Print listing line.
+ * @param[in,out] listing Pointer to listing context
+ * @param[in] format Line format, followed by some number of arguments
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_listing_print(nesla_listing_t *listing, const char *format, ...)
+{
+    int length;
+    va_list arguments;
+    char line[LISTING_LINE_MAX];
+
+    va_start(arguments, format);
+    length = vsnprintf(line, sizeof(line), format, arguments);
+    va_end(arguments);
+
+    if(length < 0) {
+        return SET_ERROR(listing->encoder->context, "Invalid listing line: %s", format);
+    }
+
+    if((size_t)length >= sizeof(line)) {
+        length = sizeof(line) - 1;
+        line[length - 1] = '\n';
+    }
+
+    return nesla_writer_put(listing->writer, (const uint8_t *)line, length);
+}
+
+/*!
+ * @brief Add listing statement cycles to a total.
+ * @param[in] listing Constant pointer to listing context
+ * @param[in] index Statement index
+ * @param[in,out] total Pointer to total context
+ */
+static void nesla_listing_add(const nesla_listing_t *listing, size_t index, nesla_total_t *total)
+{
+    nesla_cycle_t cycle;
+
+    if((listing->encoder->statement[index].instruction == INSTRUCTION_MAX) || !listing->encoder->statement[index].length) {
+        return;
+    }
+
+    nesla_cycle_get(listing->encoder, index, &cycle);
+    ++total->count;
+    total->minimum += cycle.minimum;
+    total->maximum += cycle.maximum;
+}
+
+/*!
+ * @brief Format listing cycle range.
+ * @param[in,out] buffer Pointer to buffer
+ * @param[in] length Buffer length in bytes
+ * @param[in] minimum Minimum cycles
+ * @param[in] maximum Maximum cycles
+ */
+static void nesla_listing_range(char *buffer, size_t length, size_t minimum, size_t maximum)
+{
+
+    if(minimum == maximum) {
+        snprintf(buffer, length, "%zu", minimum);
+    } else {
+        snprintf(buffer, length, "%zu-%zu", minimum, maximum);
+    }
+}
+
+/*!
+ * @brief Format listing statement operand, naming the symbol it references if any, and the byte of it taken.
+ * @param[in] listing Constant pointer to listing context
+ * @param[in] index Statement index
+ * @param[in,out] buffer Pointer to buffer
+ * @param[in] length Buffer length in bytes
+ */
+static void nesla_listing_operand(const nesla_listing_t *listing, size_t index, char *buffer, size_t length)
+{
+    static const char *FORMAT[] = {
+        "", "A", "#%s", "%s", "%s,X", "%s,Y", "%s", "%s,X", "%s,Y", "(%s)", "(%s,X)", "(%s),Y", "%s",
+        };
+
+    char value[LISTING_LINE_MAX / 2];
+    const nesla_encoder_t *encoder = listing->encoder;
+    const nesla_statement_t *statement = &encoder->statement[index];
+    const uint8_t *data = encoder->data + statement->offset;
+    const nesla_fixup_t *fixup = nesla_encoder_get_fixup(encoder, index);
+
+    if(fixup) {
+        snprintf(value, sizeof(value), "%s%s", (fixup->type == FIXUP_LOW) ? "<" : ((fixup->type == FIXUP_HIGH) ? ">" : ""),
+            nesla_literal_get(nesla_token_get_literal(fixup->symbol)));
+    } else if(statement->mode == MODE_RELATIVE) {
+        snprintf(value, sizeof(value), "$%04X", (uint16_t)(statement->address + 2 + (int8_t)data[1]));
+    } else if(statement->length == 3) {
+        snprintf(value, sizeof(value), "$%04X", data[1] | (data[2] << 8));
+    } else {
+        snprintf(value, sizeof(value), "$%02X", data[1]);
+    }
+
+    snprintf(buffer, length, FORMAT[statement->mode], value);
+}
+
+/*!
+ * @brief Format listing statement bytes, the first three followed by an ellipsis if there are more.
+ * @param[in] data Constant pointer to statement data
+ * @param[in] length Statement data length in bytes
+ * @param[in,out] buffer Pointer to buffer
+ * @param[in] size Buffer length in bytes
+ */
+static void nesla_listing_bytes(const uint8_t *data, size_t length, char *buffer, size_t size)
+{
+
+    for(size_t offset = 0; (offset < length) && (offset < 3); ++offset) {
+        snprintf(buffer + (offset * 3), size - (offset * 3), "%02X ", data[offset]);
+    }
+
+    if(length > 3) {
+        snprintf(buffer + 9, size - 9, "...");
+    }
+}
+
+/*!
+ * @brief Write listing data statement lines, as the .BYTE or .WORD items it emits, up to LISTING_DATA_MAX bytes per line.
+ * @param[in,out] listing Pointer to listing context
+ * @param[in] index Statement index
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_listing_data(nesla_listing_t *listing, size_t index)
+{
+    static const char *PREFIX[FIXUP_MAX] = { "", "", "", "", "<", ">", "<", ">", };
+    static const char *SUFFIX[FIXUP_MAX] = { "", "", "", "", "", "", "-1", "-1", };
+    const nesla_encoder_t *encoder = listing->encoder;
+    const nesla_statement_t *statement = &encoder->statement[index];
+    const nesla_fixup_t *fixup = nesla_encoder_get_fixup(encoder, index);
+    const uint8_t *data = encoder->data + statement->offset;
+    size_t width = ((statement->mode == MODE_ABSOLUTE) && !(statement->length % 2)) ? 2 : 1;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(size_t offset = 0; offset < statement->length; offset += LISTING_DATA_MAX) {
+        char bytes[16] = {}, operand[LISTING_LINE_MAX / 2] = {};
+        size_t count = statement->length - offset, used = 0;
+
+        if(count > LISTING_DATA_MAX) {
+            count = LISTING_DATA_MAX;
+        }
+
+        nesla_listing_bytes(data + offset, count, bytes, sizeof(bytes));
+
+        if(fixup) {
+            snprintf(operand, sizeof(operand), "%s%s%s", PREFIX[fixup->type], nesla_literal_get(nesla_token_get_literal(fixup->symbol)),
+                SUFFIX[fixup->type]);
+        } else {
+
+            for(size_t item = offset; item < (offset + count); item += width) {
+                used += snprintf(operand + used, sizeof(operand) - used, (width == 2) ? "%s$%04X" : "%s$%02X", (item != offset) ? ", " : "",
+                    (width == 2) ? (data[item] | (data[item + 1] << 8)) : data[item]);
+            }
+        }
+
+        if((result = nesla_listing_print(listing, "%02X:%04X  %-12s %-6s %-6s %-5s %-24s; %s:%zu\n", statement->bank,
+                (uint16_t)(statement->address + offset), bytes, "", "", (width == 2) ? ".WORD" : ".BYTE", operand,
+                nesla_token_get_path(statement->token), nesla_token_get_line(statement->token))) == NESLA_FAILURE) {
+            break;
+        }
+    }
+
+    return result;
+}
+
+/*!
+ * @brief Write listing statement line.
+ * @param[in,out] listing Pointer to listing context
+ * @param[in] index Statement index
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_listing_statement(nesla_listing_t *listing, size_t index)
+{
+    nesla_cycle_t cycle;
+    char bytes[16] = {}, cycles[16] = {}, operand[LISTING_LINE_MAX / 2] = {};
+    const nesla_encoder_t *encoder = listing->encoder;
+    const nesla_statement_t *statement = &encoder->statement[index];
+    const char *cross[] = { "", "page?", "page", };
+
+    if(statement->instruction == INSTRUCTION_MAX) {
+        return nesla_listing_data(listing, index);
+    }
+
+    nesla_listing_bytes(encoder->data + statement->offset, statement->length, bytes, sizeof(bytes));
+    nesla_cycle_get(encoder, index, &cycle);
+    nesla_listing_range(cycles, sizeof(cycles), cycle.minimum, cycle.maximum);
+    nesla_listing_operand(listing, index, operand, sizeof(operand));
+
+    if((statement->mode == MODE_RELATIVE) && (statement->length != nesla_opcode_get(statement->instruction, MODE_RELATIVE)->length)) {
+        size_t used = strlen(operand);
+
+        snprintf(operand + used, sizeof(operand) - used, " (%s *+5, JMP)", nesla_opcode_get_instruction(nesla_opcode_invert(
+            statement->instruction)));
+    }
+
+    return nesla_listing_print(listing, "%02X:%04X  %-12s %-6s %-6s %-5s %-24s; %s:%zu\n", statement->bank, statement->address, bytes,
+        cycles, cross[cycle.cross], nesla_opcode_get_instruction(statement->instruction), operand, nesla_token_get_path(statement->token),
+        nesla_token_get_line(statement->token));
+}
+
+/*!
+ * @brief Write listing labels placed before a statement, with the cycles up to the next label.
+ * @param[in,out] listing Pointer to listing context
+ * @param[in] index Statement index, or the statement count for labels placed after the last statement
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_listing_label(nesla_listing_t *listing, size_t index)
+{
+    char cycles[32];
+    nesla_total_t total = {};
+    const nesla_encoder_t *encoder = listing->encoder;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(listing->label[index] == ENCODER_UNRESOLVED) {
+        goto exit;
+    }
+
+    if(index < encoder->statement_count) {
+        const nesla_section_t *section = &encoder->section[encoder->statement[index].section];
+
+        for(size_t offset = index; offset < (section->first + section->count); ++offset) {
+
+            if((offset != index) && (listing->label[offset] != ENCODER_UNRESOLVED)) {
+                break;
+            }
+
+            nesla_listing_add(listing, offset, &total);
+        }
+    }
+
+    nesla_listing_range(cycles, sizeof(cycles), total.minimum, total.maximum);
+
+    for(uint32_t label = listing->label[index]; label != ENCODER_UNRESOLVED; label = listing->next[label]) {
+        char name[LISTING_LINE_MAX / 2];
+
+        snprintf(name, sizeof(name), "%s:", nesla_literal_get(nesla_token_get_literal(encoder->symbol[label].token)));
+
+        if((result = nesla_listing_print(listing, "\n%-66s; %s cycles, %zu instruction(s), to the next label\n", name, cycles,
+                total.count)) == NESLA_FAILURE) {
+            goto exit;
+        }
+    }
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Place listing labels before the statements they are defined at.
+ * @param[in,out] listing Pointer to listing context
+ */
+static void nesla_listing_place(nesla_listing_t *listing)
+{
+    const nesla_encoder_t *encoder = listing->encoder;
+
+    for(size_t index = 0; index <= encoder->statement_count; ++index) {
+        listing->label[index] = ENCODER_UNRESOLVED;
+    }
+
+    for(size_t index = encoder->symbol_count; index-- > 0;) {
+        const nesla_symbol_t *symbol = &encoder->symbol[index];
+        size_t statement = encoder->statement_count;
+
+        if(symbol->constant || symbol->removed) {
+            continue;
+        }
+
+        if(symbol->anchor) {
+            statement = symbol->anchor;
+        } else {
+
+            for(size_t section = 0; section < encoder->section_count; ++section) {
+                const nesla_statement_t *first = &encoder->statement[encoder->section[section].first];
+
+                if((first->bank == symbol->bank) && (first->address == symbol->address)) {
+                    statement = encoder->section[section].first;
+                    break;
+                }
+            }
+        }
+
+        listing->next[index] = listing->label[statement];
+        listing->label[statement] = index;
+    }
+}
+
+/*!
+ * @brief Write listing bank usage, with the bytes used in each program bank, and those placed there by bank placement (.RELOC).
+ * @param[in,out] listing Pointer to listing context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_listing_bank(nesla_listing_t *listing)
+{
+    const nesla_encoder_t *encoder = listing->encoder;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(encoder->relocation_count && ((result = nesla_listing_print(listing, "\n; Bank usage\n")) == NESLA_FAILURE)) {
+        goto exit;
+    }
+
+    for(uint16_t bank = 0; encoder->relocation_count && (bank < encoder->program); ++bank) {
+        size_t used = 0, relocated = 0, sections = 0;
+
+        for(size_t index = 0; index < encoder->statement_count; ++index) {
+
+            if(encoder->statement[index].bank == bank) {
+                used += encoder->statement[index].length;
+            }
+        }
+
+        for(size_t index = 0; index < encoder->relocation_count; ++index) {
+
+            if(encoder->relocation[index].bank == bank) {
+                relocated += encoder->relocation[index].length;
+                ++sections;
+            }
+        }
+
+        if((result = nesla_listing_print(listing, "; bank %u: %zu of %u bytes used, %zu bytes in %zu relocatable section(s)\n", bank,
+                used, BANK_LENGTH, relocated, sections)) == NESLA_FAILURE) {
+            goto exit;
+        }
+    }
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Write listing RAM map, with the address, size and references of each variable (.RESV).
+ * @param[in,out] listing Pointer to listing context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_listing_variable(nesla_listing_t *listing)
+{
+    const nesla_encoder_t *encoder = listing->encoder;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(encoder->variable_count && ((result = nesla_listing_print(listing, "\n; RAM map\n")) == NESLA_FAILURE)) {
+        goto exit;
+    }
+
+    for(size_t index = 0; index < encoder->variable_count; ++index) {
+        const nesla_variable_t *variable = &encoder->variable[index];
+
+        if((result = nesla_listing_print(listing, "; $%04X-$%04X  %-32s %u byte(s), %u reference(s)%s%s\n", variable->address,
+                variable->address + variable->size - 1, nesla_literal_get(nesla_token_get_literal(variable->token)), variable->size,
+                variable->references, variable->pointer ? ", pointer" : "", variable->page ? ", page" : "")) == NESLA_FAILURE) {
+            goto exit;
+        }
+    }
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Write listing removed labels, with the bytes removed as unreachable from each (-d).
+ * @param[in,out] listing Pointer to listing context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_listing_removed(nesla_listing_t *listing)
+{
+    const nesla_encoder_t *encoder = listing->encoder;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(encoder->removed_count && ((result = nesla_listing_print(listing, "\n; Removed\n")) == NESLA_FAILURE)) {
+        goto exit;
+    }
+
+    for(size_t index = 0; index < encoder->removed_count; ++index) {
+        const nesla_removed_t *removed = &encoder->removed[index];
+
+        if((result = nesla_listing_print(listing, "; %-32s %u byte(s)\n",
+                nesla_literal_get(nesla_token_get_literal(encoder->symbol[removed->symbol].token)), removed->length)) == NESLA_FAILURE) {
+            goto exit;
+        }
+    }
+
+exit:
+    return result;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+nesla_error_e nesla_listing_write(const nesla_encoder_t *encoder, nesla_writer_t *writer)
+{
+    static const char *HEADER[] = {
+        "; BB:ADDR  BYTES        CYCLES PAGE   INSTRUCTION                    SOURCE",
+        "; Cycles are a range where a penalty can apply: indexed reads marked page? pay a cycle if the index crosses a page,",
+        "; taken branches pay a cycle, and branches marked page pay another to reach a target on another page.",
+        };
+
+    nesla_listing_t listing = { encoder, writer, };
+    nesla_total_t block = {};
+    size_t inlined = 0;
+    nesla_error_e result;
+
+    if(!(listing.label = nesla_context_allocate(encoder->context, (encoder->statement_count + 1) * sizeof(*listing.label)))
+            || !(listing.next = nesla_context_allocate(encoder->context, (encoder->symbol_count + 1) * sizeof(*listing.next)))) {
+        result = SET_ERROR(encoder->context, "Failed to allocate listing: %zu", encoder->statement_count);
+        goto exit;
+    }
+
+    nesla_listing_place(&listing);
+
+    for(size_t index = 0; index < (sizeof(HEADER) / sizeof(*HEADER)); ++index) {
+
+        if((result = nesla_listing_print(&listing, "%s\n", HEADER[index])) == NESLA_FAILURE) {
+            goto exit;
+        }
+    }
+
+    for(size_t index = 0; index < encoder->statement_count; ++index) {
+        const nesla_statement_t *statement = &encoder->statement[index];
+        const nesla_section_t *section = &encoder->section[statement->section];
+        size_t next = index + 1;
+
+        if(index == section->first) {
+
+            if((result = nesla_listing_print(&listing, "\n; .BANK %u .ORG $%04X\n", statement->bank,
+                    statement->address)) == NESLA_FAILURE) {
+                goto exit;
+            }
+        }
+
+        if((result = nesla_listing_label(&listing, index)) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        for(; (inlined < encoder->inlined_count) && (encoder->inlined[inlined].first == index); ++inlined) {
+            const nesla_inlined_t *call = &encoder->inlined[inlined];
+
+            if((result = nesla_listing_print(&listing, "%-66s; inlined %s, called at %s:%zu: %+i bytes, ~%u cycles saved\n", "",
+                    nesla_literal_get(nesla_token_get_literal(encoder->symbol[call->symbol].token)), nesla_token_get_path(call->token),
+                    nesla_token_get_line(call->token), call->bytes, call->cycles * call->weight)) == NESLA_FAILURE) {
+                goto exit;
+            }
+        }
+
+        if(!statement->length) {
+            continue;
+        }
+
+        if((result = nesla_listing_statement(&listing, index)) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        nesla_listing_add(&listing, index, &block);
+
+        if(block.count && (nesla_cycle_is_terminal(encoder, index) || (next == (section->first + section->count))
+                || (listing.label[next] != ENCODER_UNRESOLVED))) {
+            char cycles[32];
+
+            nesla_listing_range(cycles, sizeof(cycles), block.minimum, block.maximum);
+
+            if((result = nesla_listing_print(&listing, "%-66s; block: %s cycles, %zu instruction(s)\n", "", cycles, block.count))
+                    == NESLA_FAILURE) {
+                goto exit;
+            }
+
+            memset(&block, 0, sizeof(block));
+        }
+    }
+
+    if((result = nesla_listing_label(&listing, encoder->statement_count)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if((result = nesla_listing_bank(&listing)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if((result = nesla_listing_variable(&listing)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    result = nesla_listing_removed(&listing);
+
+exit:
+    nesla_context_free(encoder->context, listing.next);
+    nesla_context_free(encoder->context, listing.label);
+
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -37,10 +37,19 @@
  * @brief Interface option.
  */
 typedef enum {
-    OPTION_HELP,    /*!< Show help information */
-    OPTION_OUTPUT,  /*!< Set output directory */
-    OPTION_VERSION, /*!< Show version information */
-    OPTION_MAX,     /*!< Maximum option */
+    OPTION_BRANCH,      /*!< Relax out-of-range branches */
+    OPTION_CACHE,       /*!< Set compression cache directory */
+    OPTION_DEAD,        /*!< Remove unreachable code */
+    OPTION_HELP,        /*!< Show help information */
+    OPTION_INLINE,      /*!< Inline hot leaf subroutines */
+    OPTION_LISTING,     /*!< Write assembly listing */
+    OPTION_MERGE,       /*!< Merge identical data blocks */
+    OPTION_OUTPUT,      /*!< Set output directory */
+    OPTION_PEEPHOLE,    /*!< Optimize instruction sequences */
+    OPTION_STATISTICS,  /*!< Show assembly statistics */
+    OPTION_TILE,        /*!< Merge identical CHR tiles */
+    OPTION_VERSION,     /*!< Show version information */
+    OPTION_MAX,         /*!< Maximum option */
 } nesla_option_e;
 
 /*!
@@ -92,8 +101,11 @@ static void show_help(FILE *stream, bool verbose)
     TRACE(NESLA_SUCCESS, "%s", "nesla [options] file\n");
 
     if(verbose) {
-        static const char *OPTION[] = { "-h", "-o", "-v", },
-            *DESCRIPTION[] = { "Show help information", "Set output directory", "Show version information", };
+        static const char *OPTION[] = { "-b", "-c", "-d", "-h", "-i", "-l", "-m", "-o", "-p", "-s", "-t", "-v", },
+            *DESCRIPTION[] = { "Relax out-of-range branches", "Set compression cache directory", "Remove unreachable code",
+                "Show help information", "Inline hot leaf subroutines", "Write assembly listing", "Merge identical data blocks",
+                "Set output directory", "Optimize instruction sequences", "Show assembly statistics", "Merge identical CHR tiles",
+                "Show version information", };
 
         TRACE(NESLA_SUCCESS, "%s", "\n");
 
@@ -104,22 +116,102 @@ static void show_help(FILE *stream, bool verbose)
     }
 }
 
+/*!
+ * @brief Show assembler context handle statistics.
+ * @param[in] context Constant pointer to assembler context handle
+ */
+static void show_statistics(const nesla_context_t *context)
+{
+    const nesla_statistics_t *statistics = nesla_context_get_statistics(context);
+
+    TRACE(NESLA_SUCCESS, "Passes: %zu\n", statistics->pass);
+    TRACE(NESLA_SUCCESS, "Statements: %zu\n", statistics->statement);
+    TRACE(NESLA_SUCCESS, "Symbols: %zu (%zu references)\n", statistics->symbol, statistics->reference);
+    TRACE(NESLA_SUCCESS, "Fixups: %zu (%zu patched)\n", statistics->fixup, statistics->patched);
+    TRACE(NESLA_SUCCESS, "Relaxed: %zu (%zu branches expanded)\n", statistics->relaxed, statistics->expanded);
+    TRACE(NESLA_SUCCESS, "Optimized: %zu (%zu bytes, %zu cycles saved)\n", statistics->optimized, statistics->saved_bytes,
+        statistics->saved_cycles);
+    TRACE(NESLA_SUCCESS, "Inlined: %zu (%+td bytes, %zu cycles saved)\n", statistics->inlined, statistics->inlined_bytes,
+        statistics->inlined_cycles);
+    TRACE(NESLA_SUCCESS, "Removed: %zu (%zu bytes)\n", statistics->removed, statistics->removed_bytes);
+    TRACE(NESLA_SUCCESS, "Merged: %zu (%zu bytes, %zu tiles)\n", statistics->merged, statistics->merged_bytes, statistics->merged_tiles);
+    TRACE(NESLA_SUCCESS, "Packed: %zu (%+td bytes, %zu cached)\n", statistics->packed, statistics->packed_bytes, statistics->cached);
+}
+
+/*!
+ * @brief Show assembler context handle diagnostics.
+ * @param[in] context Constant pointer to assembler context handle
+ * @param[in] name Constant pointer to binary name
+ */
+static void show_diagnostics(const nesla_context_t *context, const char *name)
+{
+    size_t index = 0, dropped = 0;
+    const nesla_diagnostic_t *diagnostic;
+
+    while((diagnostic = nesla_context_get_diagnostic(context, index++))) {
+        static const char *LEVEL[] = { "error", "warning", "note", };
+        nesla_error_e level = (diagnostic->level == NESLA_DIAGNOSTIC_ERROR) ? NESLA_FAILURE : NESLA_SUCCESS;
+
+        TRACE(level, "%s:%zu:%zu: %s: %s\n", diagnostic->path, diagnostic->line, diagnostic->column, LEVEL[diagnostic->level],
+            diagnostic->message);
+    }
+
+    for(int level = 0; level < NESLA_DIAGNOSTIC_MAX; ++level) {
+        dropped += nesla_context_get_diagnostic_count(context, level);
+    }
+
+    if((dropped -= nesla_context_get_diagnostic_count(context, NESLA_DIAGNOSTIC_MAX))) {
+        TRACE(NESLA_FAILURE, "%s: %zu more diagnostic(s) not shown\n", name, dropped);
+    }
+}
+
 int main(int argc, char *argv[])
 {
     int option;
-    nesla_t context = {};
+    const char *cache = NULL;
+    uint32_t flags = NESLA_FLAG_NONE;
+    bool statistics = false;
+    nesla_t input = {};
+    nesla_context_t *context = NULL;
     nesla_error_e result = NESLA_SUCCESS;
 
     opterr = 1;
 
-    while((option = getopt(argc, argv, "ho:v")) != -1) {
+    while((option = getopt(argc, argv, "bc:dhilmo:pstv")) != -1) {
 
         switch(option) {
+            case 'b':
+                flags |= NESLA_FLAG_RELAX_BRANCH;
+                break;
+            case 'c':
+                cache = optarg;
+                break;
+            case 'd':
+                flags |= NESLA_FLAG_DEAD;
+                break;
             case 'h':
                 show_help(stdout, true);
                 goto exit;
+            case 'i':
+                flags |= NESLA_FLAG_INLINE;
+                break;
+            case 'l':
+                flags |= NESLA_FLAG_LISTING;
+                break;
+            case 'm':
+                flags |= NESLA_FLAG_MERGE;
+                break;
             case 'o':
-                context.output = optarg;
+                input.output = optarg;
+                break;
+            case 'p':
+                flags |= NESLA_FLAG_PEEPHOLE;
+                break;
+            case 's':
+                statistics = true;
+                break;
+            case 't':
+                flags |= NESLA_FLAG_TILE;
                 break;
             case 'v':
                 show_version(stdout, false);
@@ -132,21 +224,37 @@ int main(int argc, char *argv[])
     }
 
     for(option = optind; option < argc; ++option) {
-        context.input = argv[option];
+        input.input = argv[option];
         break;
     }
 
-    if(!context.input) {
+    if(!input.input) {
         TRACE(NESLA_FAILURE, "%s: Undefined input path\n", argv[0]);
         goto exit;
     }
 
-    if((result = nesla(&context)) == NESLA_FAILURE) {
-        TRACE(NESLA_FAILURE, "%s: %s\n", argv[0], nesla_get_error());
+    if((result = nesla_context_create(&context, NULL)) == NESLA_FAILURE) {
+        TRACE(NESLA_FAILURE, "%s: Failed to allocate context\n", argv[0]);
+        goto exit;
+    }
+
+    nesla_context_set_cache(context, cache);
+    nesla_context_set_flags(context, flags);
+    result = nesla_context_assemble(context, &input);
+
+    show_diagnostics(context, argv[0]);
+
+    if(statistics) {
+        show_statistics(context);
+    }
+
+    if(result == NESLA_FAILURE) {
+        TRACE(NESLA_FAILURE, "%s: %s\n", argv[0], nesla_context_get_error(context));
         goto exit;
     }
 
 exit:
+    nesla_context_destroy(context);
 
     return (int)result;
 }
@@ -0,0 +1,401 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file merge.c
+ * @brief Identical data block merging.
+ */
+
+#include <graph.h>
+#include <merge.h>
+
+/*!
+ * @struct nesla_merge_block_t
+ * @brief Data block context, a run of data statements from a global label.
+ */
+typedef struct {
+    uint32_t first;                     /*!< First statement index */
+    uint32_t last;                      /*!< Statement index past the last */
+    uint32_t length;                    /*!< Block length in bytes */
+    uint32_t hash;                      /*!< Hash of the bytes and symbol references */
+    uint32_t name;                      /*!< First global label symbol index */
+    bool kept;                          /*!< Block is kept, and may be merged into */
+} nesla_merge_block_t;
+
+/*!
+ * @struct nesla_merge_t
+ * @brief Data block merge context.
+ */
+typedef struct {
+    nesla_encoder_t *encoder;           /*!< Encoder context */
+    uint32_t *label;                    /*!< First label index placed before the statement, per statement */
+    uint32_t *next;                     /*!< Next label index placed before the same statement, per symbol */
+    uint8_t *start;                     /*!< A global label is placed before the statement, per statement */
+    nesla_merge_block_t *block;         /*!< Block array */
+    size_t count;                       /*!< Block count */
+} nesla_merge_t;
+
+/*!
+ * @brief Locate data block merge labels, finding the statement each label is placed before.
+ * @param[in,out] merge Pointer to merge context
+ */
+static void nesla_merge_locate(nesla_merge_t *merge)
+{
+    const nesla_encoder_t *encoder = merge->encoder;
+
+    for(size_t index = 0; index < encoder->statement_count; ++index) {
+        merge->label[index] = ENCODER_UNRESOLVED;
+        merge->start[index] = false;
+    }
+
+    for(size_t index = encoder->symbol_count; index-- > 0;) {
+        const nesla_symbol_t *label = &encoder->symbol[index];
+        size_t statement = encoder->statement_count;
+
+        if(label->constant || label->removed) {
+            continue;
+        }
+
+        if(label->anchor) {
+
+            if((label->anchor < encoder->statement_count)
+                    && (encoder->statement[label->anchor].section == encoder->statement[label->anchor - 1].section)) {
+                statement = label->anchor;
+            }
+        } else {
+
+            for(size_t section = 0; section < encoder->section_count; ++section) {
+                const nesla_statement_t *first = &encoder->statement[encoder->section[section].first];
+
+                if((first->bank == label->bank) && (first->address == label->address)) {
+                    statement = encoder->section[section].first;
+                    break;
+                }
+            }
+        }
+
+        if(statement < encoder->statement_count) {
+            merge->next[index] = merge->label[statement];
+            merge->label[statement] = index;
+            merge->start[statement] |= !label->scope;
+        }
+    }
+}
+
+/*!
+ * @brief Hash data block merge statement, from its bytes, or from its symbol reference.
+ * @param[in] merge Constant pointer to merge context
+ * @param[in] index Statement index
+ * @param[in] hash Hash of the statements before it
+ * @return Hash, including the statement
+ */
+static uint32_t nesla_merge_hash(const nesla_merge_t *merge, size_t index, uint32_t hash)
+{
+    const nesla_encoder_t *encoder = merge->encoder;
+    const nesla_statement_t *statement = &encoder->statement[index];
+    const nesla_fixup_t *fixup = nesla_encoder_get_fixup(encoder, index);
+
+    if(fixup) {
+        return (hash * 31) + fixup->index + fixup->type + statement->length;
+    }
+
+    return (hash * 31) + nesla_table_hash((const char *)encoder->data + statement->offset, statement->length);
+}
+
+/*!
+ * @brief Split data block merge blocks, at each global label placed before data, up to the next label, instruction or origin.
+ *        Blocks in character banks, holding the vectors or under .NOOPT are left out.
+ * @param[in,out] merge Pointer to merge context
+ */
+static void nesla_merge_split(nesla_merge_t *merge)
+{
+    const nesla_encoder_t *encoder = merge->encoder;
+
+    for(size_t index = 0; index < encoder->statement_count;) {
+        const nesla_section_t *section = &encoder->section[encoder->statement[index].section];
+        nesla_merge_block_t *block = &merge->block[merge->count];
+        bool valid = true;
+
+        if(!merge->start[index] || (encoder->statement[index].instruction != INSTRUCTION_MAX)) {
+            ++index;
+            continue;
+        }
+
+        memset(block, 0, sizeof(*block));
+        block->first = index;
+
+        do {
+            const nesla_statement_t *statement = &encoder->statement[index];
+
+            if(statement->length) {
+                valid &= (statement->instruction == INSTRUCTION_MAX) && !statement->preserve && (statement->bank < encoder->program)
+                    && ((statement->address + statement->length) <= GRAPH_VECTOR_NMI);
+                block->hash = nesla_merge_hash(merge, index, block->hash);
+                block->length += statement->length;
+            }
+
+            ++index;
+        } while((index < (section->first + section->count)) && !merge->start[index]
+            && (!encoder->statement[index].length || (encoder->statement[index].instruction == INSTRUCTION_MAX)));
+
+        block->last = index;
+
+        for(uint32_t label = merge->label[block->first]; label != ENCODER_UNRESOLVED; label = merge->next[label]) {
+
+            if(!encoder->symbol[label].scope) {
+                block->name = label;
+                break;
+            }
+        }
+
+        if(valid && block->length) {
+            ++merge->count;
+        }
+    }
+}
+
+/*!
+ * @brief Compare data block merge blocks, by hash, then length, then first statement.
+ * @param[in] first Constant pointer to first block
+ * @param[in] second Constant pointer to second block
+ * @return Less than, equal to, or greater than zero, as the first block orders before, with, or after the second
+ */
+static int nesla_merge_compare(const void *first, const void *second)
+{
+    const nesla_merge_block_t *left = first, *right = second;
+
+    if(left->hash != right->hash) {
+        return (left->hash > right->hash) - (left->hash < right->hash);
+    }
+
+    if(left->length != right->length) {
+        return (left->length > right->length) - (left->length < right->length);
+    }
+
+    return (left->first > right->first) - (left->first < right->first);
+}
+
+/*!
+ * @brief Check if data block merge blocks are equal, with the same bytes and the same symbol references.
+ * @param[in] merge Constant pointer to merge context
+ * @param[in] first Constant pointer to first block
+ * @param[in] second Constant pointer to second block
+ * @return true if the blocks are equal, false otherwise
+ */
+static bool nesla_merge_is_equal(const nesla_merge_t *merge, const nesla_merge_block_t *first, const nesla_merge_block_t *second)
+{
+    const nesla_encoder_t *encoder = merge->encoder;
+    size_t left = first->first, right = second->first;
+
+    for(;;) {
+        const nesla_statement_t *left_statement, *right_statement;
+        const nesla_fixup_t *left_fixup, *right_fixup;
+
+        for(; (left < first->last) && !encoder->statement[left].length; ++left);
+        for(; (right < second->last) && !encoder->statement[right].length; ++right);
+
+        if((left == first->last) || (right == second->last)) {
+            break;
+        }
+
+        left_statement = &encoder->statement[left];
+        right_statement = &encoder->statement[right];
+
+        if(left_statement->length != right_statement->length) {
+            return false;
+        }
+
+        left_fixup = nesla_encoder_get_fixup(encoder, left);
+        right_fixup = nesla_encoder_get_fixup(encoder, right);
+
+        if(left_fixup || right_fixup) {
+
+            if(!left_fixup || !right_fixup || (left_fixup->index != right_fixup->index) || (left_fixup->type != right_fixup->type)) {
+                return false;
+            }
+        } else if(memcmp(encoder->data + left_statement->offset, encoder->data + right_statement->offset, left_statement->length)) {
+            return false;
+        }
+
+        ++left;
+        ++right;
+    }
+
+    return (left == first->last) && (right == second->last);
+}
+
+/*!
+ * @brief Check if data block merge block is readable wherever another block is, from the same bank or the last (fixed) bank.
+ * @param[in] merge Constant pointer to merge context
+ * @param[in] kept Constant pointer to kept block
+ * @param[in] block Constant pointer to block
+ * @return true if the kept block is readable wherever the block is, false otherwise
+ */
+static bool nesla_merge_is_visible(const nesla_merge_t *merge, const nesla_merge_block_t *kept, const nesla_merge_block_t *block)
+{
+    const nesla_encoder_t *encoder = merge->encoder;
+    uint16_t bank = encoder->statement[kept->first].bank;
+
+    return (bank == encoder->statement[block->first].bank) || ((bank + 1) == encoder->program);
+}
+
+/*!
+ * @brief Alias data block merge label to the statement of a kept block at the same offset.
+ * @param[in] merge Constant pointer to merge context
+ * @param[in] kept Constant pointer to kept block
+ * @param[in] symbol Label symbol index
+ * @param[in] offset Label offset into its block in bytes
+ */
+static void nesla_merge_alias(const nesla_merge_t *merge, const nesla_merge_block_t *kept, uint32_t symbol, uint32_t offset)
+{
+    const nesla_encoder_t *encoder = merge->encoder;
+    nesla_symbol_t *label = &encoder->symbol[symbol];
+    size_t index = kept->first;
+    const nesla_statement_t *statement;
+
+    for(; !encoder->statement[index].length || offset; ++index) {
+        offset -= encoder->statement[index].length;
+    }
+
+    statement = &encoder->statement[index];
+    label->bank = statement->bank;
+    label->address = statement->address;
+    label->anchor = (encoder->section[statement->section].first == index) ? 0 : index;
+}
+
+/*!
+ * @brief Merge data block merge block into a kept block, aliasing its labels and removing its statements.
+ * @param[in,out] merge Pointer to merge context
+ * @param[in] kept Constant pointer to kept block
+ * @param[in] block Constant pointer to block
+ */
+static void nesla_merge_block(nesla_merge_t *merge, const nesla_merge_block_t *kept, const nesla_merge_block_t *block)
+{
+    nesla_encoder_t *encoder = merge->encoder;
+
+    uint32_t offset = 0;
+
+    for(size_t index = block->first; index < block->last; ++index) {
+        nesla_statement_t *statement = &encoder->statement[index];
+        nesla_fixup_t *fixup;
+
+        for(uint32_t label = merge->label[index]; label != ENCODER_UNRESOLVED; label = merge->next[label]) {
+            nesla_merge_alias(merge, kept, label, offset);
+        }
+
+        if(!statement->length) {
+            continue;
+        }
+
+        offset += statement->length;
+
+        if((fixup = nesla_encoder_get_fixup(encoder, index))) {
+            fixup->index = ENCODER_UNRESOLVED;
+        }
+
+        encoder->section[statement->section].dirty = true;
+        statement->length = 0;
+    }
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+nesla_error_e nesla_merge_data(nesla_encoder_t *encoder)
+{
+    nesla_merge_t merge = {};
+    const nesla_token_t *token = NULL;
+    size_t merged = 0, bytes = 0;
+    uint32_t first = 0;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(!encoder->statement_count) {
+        goto exit;
+    }
+
+    merge.encoder = encoder;
+
+    if(!(merge.label = nesla_context_allocate(encoder->context, encoder->statement_count * sizeof(*merge.label)))
+            || !(merge.next = nesla_context_allocate(encoder->context, (encoder->symbol_count + 1) * sizeof(*merge.next)))
+            || !(merge.start = nesla_context_allocate(encoder->context, encoder->statement_count * sizeof(*merge.start)))
+            || !(merge.block = nesla_context_allocate(encoder->context, encoder->statement_count * sizeof(*merge.block)))) {
+        result = SET_ERROR(encoder->context, "Failed to allocate data merge: %zu", encoder->statement_count);
+        goto exit;
+    }
+
+    nesla_merge_locate(&merge);
+    nesla_merge_split(&merge);
+    qsort(merge.block, merge.count, sizeof(*merge.block), nesla_merge_compare);
+
+    for(size_t group = 0, next; group < merge.count; group = next) {
+
+        for(next = group + 1; (next < merge.count) && (merge.block[next].hash == merge.block[group].hash)
+                && (merge.block[next].length == merge.block[group].length); ++next);
+
+        for(size_t index = group; index < next; ++index) {
+            nesla_merge_block_t *block = &merge.block[index];
+            size_t kept = group;
+
+            for(; kept < index; ++kept) {
+
+                if(merge.block[kept].kept && nesla_merge_is_visible(&merge, &merge.block[kept], block)
+                        && nesla_merge_is_equal(&merge, &merge.block[kept], block)) {
+                    break;
+                }
+            }
+
+            if(kept == index) {
+                block->kept = true;
+                continue;
+            }
+
+            nesla_merge_block(&merge, &merge.block[kept], block);
+
+            if(!merged++ || (block->first < first)) {
+                first = block->first;
+                token = encoder->symbol[block->name].token;
+            }
+
+            bytes += block->length;
+        }
+    }
+
+    encoder->context->statistics.merged += merged;
+    encoder->context->statistics.merged_bytes += bytes;
+
+    if(merged) {
+        SET_NOTE_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Identical data merged: %zu block(s), %zu bytes", merged, bytes);
+    }
+
+exit:
+    nesla_context_free(encoder->context, merge.block);
+    nesla_context_free(encoder->context, merge.start);
+    nesla_context_free(encoder->context, merge.next);
+    nesla_context_free(encoder->context, merge.label);
+
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -24,62 +24,204 @@
  * @brief Public interface.
  */
 
-#include <common.h>
+#include <assembler.h>
 
-/* TODO: DEBUGGING */
-#include <lexer.h>
-/* --- */
+static _Thread_local char g_error[256] = {};   /*!< Error string of the last legacy call, per thread */
 
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
 
-nesla_error_e nesla(const nesla_t *context)
+/*!
+ * @brief Build output file path from input file path and output directory.
+ * @param[in,out] context Pointer to assembler context handle
+ * @param[in] input Constant pointer to caller defined context
+ * @param[in] extension Constant pointer to output file extension
+ * @param[in,out] path Pointer to output file path, must be freed with the assembler context handle allocator
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_output_path(nesla_context_t *context, const nesla_t *input, const char *extension, char **path)
 {
+    size_t length;
+    char *base, *suffix, *name = NULL;
+    const char *directory = input->output ? input->output : ".";
     nesla_error_e result = NESLA_SUCCESS;
 
-    /* TODO: DEBUGGING */
-    nesla_lexer_t lexer = {};
+    if(!(name = nesla_context_duplicate(context, strcmp(input->input, "-") ? input->input : "stdin"))) {
+        result = SET_ERROR(context, "Failed to allocate path: %s", input->input);
+        goto exit;
+    }
+
+    base = basename(name);
+
+    if((suffix = strrchr(base, '.')) && (suffix != base)) {
+        *suffix = '\0';
+    }
+
+    length = strlen(directory) + strlen(base) + strlen(extension) + strlen("/") + 1;
+
+    if(!(*path = nesla_context_allocate(context, length * sizeof(**path)))) {
+        result = SET_ERROR(context, "Failed to allocate path: %s", input->input);
+        goto exit;
+    }
+
+    snprintf(*path, length, "%s/%s%s", directory, base, extension);
+
+exit:
+    nesla_context_free(context, name);
+
+    return result;
+}
+
+/*!
+ * @brief Finish legacy call, copying the assembler context handle error into the per-thread error string, or clearing it on success.
+ * @param[in,out] context Pointer to assembler context handle, or NULL
+ * @param[in] result Call result
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_legacy_finish(nesla_context_t *context, nesla_error_e result)
+{
+
+    if(!context) {
+        snprintf(g_error, sizeof(g_error), "Failed to allocate context");
+    } else if(result == NESLA_FAILURE) {
+        snprintf(g_error, sizeof(g_error), "%s", nesla_context_get_error(context));
+    } else {
+        g_error[0] = '\0';
+    }
+
+    nesla_context_destroy(context);
+
+    return result;
+}
+
+nesla_error_e nesla(const nesla_t *input)
+{
+    nesla_context_t *context = NULL;
+    nesla_error_e result;
+
+    if((result = nesla_context_create(&context, NULL)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    result = nesla_context_assemble(context, input);
+
+exit:
+    return nesla_legacy_finish(context, result);
+}
+
+nesla_error_e nesla_buffer(const nesla_source_t *source, uint8_t **output, size_t *length)
+{
+    nesla_context_t *context = NULL;
+    nesla_error_e result;
+
+    if((result = nesla_context_create(&context, NULL)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    result = nesla_context_assemble_buffer(context, source, output, length);
+
+exit:
+    return nesla_legacy_finish(context, result);
+}
+
+nesla_error_e nesla_context_assemble(nesla_context_t *context, const nesla_t *input)
+{
+    char *path = NULL, *listing = NULL, *map = NULL;
+    nesla_assembler_t assembler = {};
+    nesla_error_e result;
+
+    if((result = nesla_assembler_initialize(&assembler, context, input->input)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if((result = nesla_output_path(context, input, ".nes", &path)) == NESLA_FAILURE) {
+        goto exit;
+    }
 
-    if((result = nesla_lexer_initialize(&lexer, context->input)) == NESLA_FAILURE) {
+    if((result = nesla_assembler_write(&assembler, path)) == NESLA_FAILURE) {
         goto exit;
     }
 
-    do {
-        nesla_token_t *token;
+    if(nesla_context_get_flags(context) & NESLA_FLAG_LISTING) {
 
-        if((result = nesla_lexer_get(&lexer, &token)) == NESLA_FAILURE) {
+        if((result = nesla_output_path(context, input, ".lst", &listing)) == NESLA_FAILURE) {
             goto exit;
         }
 
-        switch(token->type) {
-            case TOKEN_END:
-                fprintf(stdout, "[%i:%i] END\n", nesla_token_get_type(token), nesla_token_get_subtype(token));
-                break;
-            case TOKEN_IDENTIFIER:
-            case TOKEN_LABEL:
-            case TOKEN_LITERAL:
-                fprintf(stdout, "[%i:%i] \"%s\" (%s@%zu)\n", nesla_token_get_type(token), nesla_token_get_subtype(token),
-                    nesla_literal_get(nesla_token_get_literal(token)), nesla_token_get_path(token), nesla_token_get_line(token));
-                break;
-            case TOKEN_SCALAR:
-                fprintf(stdout, "[%i:%i] %04X (%u) (%s@%zu)\n", nesla_token_get_type(token), nesla_token_get_subtype(token),
-                    nesla_token_get_scalar(token), nesla_token_get_scalar(token), nesla_token_get_path(token), nesla_token_get_line(token));
-                break;
-            default:
-                fprintf(stdout, "[%i:%i] (%s@%zu)\n", nesla_token_get_type(token), nesla_token_get_subtype(token),
-                    nesla_token_get_path(token), nesla_token_get_line(token));
-                break;
+        if((result = nesla_assembler_write_listing(&assembler, listing)) == NESLA_FAILURE) {
+            goto exit;
         }
-    } while(nesla_lexer_next(&lexer) == NESLA_SUCCESS);
+    }
+
+    if(nesla_context_get_flags(context) & NESLA_FLAG_TILE) {
+
+        if((result = nesla_output_path(context, input, ".map", &map)) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        if((result = nesla_assembler_write_map(&assembler, map)) == NESLA_FAILURE) {
+            goto exit;
+        }
+    }
 
 exit:
-    nesla_lexer_uninitialize(&lexer);
-    /* --- */
+    nesla_context_free(context, map);
+    nesla_context_free(context, listing);
+    nesla_context_free(context, path);
+    nesla_assembler_uninitialize(&assembler);
 
     return result;
 }
 
+nesla_error_e nesla_context_assemble_buffer(nesla_context_t *context, const nesla_source_t *source, uint8_t **output,
+    size_t *length)
+{
+    size_t size;
+    uint8_t *buffer = *output;
+    nesla_assembler_t assembler = {};
+    nesla_error_e result;
+
+    if((result = nesla_assembler_initialize_buffer(&assembler, context, source)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    size = nesla_assembler_get_size(&assembler);
+
+    if(!buffer) {
+
+        if(!(buffer = nesla_context_allocate(context, size))) {
+            result = SET_ERROR(context, "Failed to allocate image: %zu", size);
+            goto exit;
+        }
+    } else if(*length < size) {
+        result = SET_ERROR(context, "Image buffer too small: %zu (expecting %zu)", *length, size);
+        goto exit;
+    }
+
+    if((result = nesla_assembler_write_buffer(&assembler, buffer, size)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    *output = buffer;
+    *length = size;
+
+exit:
+
+    if((result == NESLA_FAILURE) && (buffer != *output)) {
+        nesla_context_free(context, buffer);
+    }
+
+    nesla_assembler_uninitialize(&assembler);
+
+    return result;
+}
+
+const char *nesla_get_error(void)
+{
+    return g_error;
+}
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,328 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file opcode.c
+ * @brief Opcode matrix.
+ */
+
+#include <opcode.h>
+
+/*!
+ * @brief Official opcode list, the single source for every opcode table below. Each entry is an instruction, addressing
+ *        mode, opcode byte, base cycle count and cycle penalty type.
+ * @param[in] _ENTRY_ Entry macro
+ */
+#define OPCODES(_ENTRY_) \
+    _ENTRY_(ADC, IMMEDIATE,   0x69, 2, NONE) \
+    _ENTRY_(ADC, ZERO_PAGE,   0x65, 3, NONE) \
+    _ENTRY_(ADC, ZERO_PAGE_X, 0x75, 4, NONE) \
+    _ENTRY_(ADC, ABSOLUTE,    0x6D, 4, NONE) \
+    _ENTRY_(ADC, ABSOLUTE_X,  0x7D, 4, PAGE) \
+    _ENTRY_(ADC, ABSOLUTE_Y,  0x79, 4, PAGE) \
+    _ENTRY_(ADC, INDIRECT_X,  0x61, 6, NONE) \
+    _ENTRY_(ADC, INDIRECT_Y,  0x71, 5, PAGE) \
+    _ENTRY_(AND, IMMEDIATE,   0x29, 2, NONE) \
+    _ENTRY_(AND, ZERO_PAGE,   0x25, 3, NONE) \
+    _ENTRY_(AND, ZERO_PAGE_X, 0x35, 4, NONE) \
+    _ENTRY_(AND, ABSOLUTE,    0x2D, 4, NONE) \
+    _ENTRY_(AND, ABSOLUTE_X,  0x3D, 4, PAGE) \
+    _ENTRY_(AND, ABSOLUTE_Y,  0x39, 4, PAGE) \
+    _ENTRY_(AND, INDIRECT_X,  0x21, 6, NONE) \
+    _ENTRY_(AND, INDIRECT_Y,  0x31, 5, PAGE) \
+    _ENTRY_(ASL, ACCUMULATOR, 0x0A, 2, NONE) \
+    _ENTRY_(ASL, ZERO_PAGE,   0x06, 5, NONE) \
+    _ENTRY_(ASL, ZERO_PAGE_X, 0x16, 6, NONE) \
+    _ENTRY_(ASL, ABSOLUTE,    0x0E, 6, NONE) \
+    _ENTRY_(ASL, ABSOLUTE_X,  0x1E, 7, NONE) \
+    _ENTRY_(BCC, RELATIVE,    0x90, 2, BRANCH) \
+    _ENTRY_(BCS, RELATIVE,    0xB0, 2, BRANCH) \
+    _ENTRY_(BEQ, RELATIVE,    0xF0, 2, BRANCH) \
+    _ENTRY_(BIT, ZERO_PAGE,   0x24, 3, NONE) \
+    _ENTRY_(BIT, ABSOLUTE,    0x2C, 4, NONE) \
+    _ENTRY_(BMI, RELATIVE,    0x30, 2, BRANCH) \
+    _ENTRY_(BNE, RELATIVE,    0xD0, 2, BRANCH) \
+    _ENTRY_(BPL, RELATIVE,    0x10, 2, BRANCH) \
+    _ENTRY_(BRK, IMPLIED,     0x00, 7, NONE) \
+    _ENTRY_(BVC, RELATIVE,    0x50, 2, BRANCH) \
+    _ENTRY_(BVS, RELATIVE,    0x70, 2, BRANCH) \
+    _ENTRY_(CLC, IMPLIED,     0x18, 2, NONE) \
+    _ENTRY_(CLD, IMPLIED,     0xD8, 2, NONE) \
+    _ENTRY_(CLI, IMPLIED,     0x58, 2, NONE) \
+    _ENTRY_(CLV, IMPLIED,     0xB8, 2, NONE) \
+    _ENTRY_(CMP, IMMEDIATE,   0xC9, 2, NONE) \
+    _ENTRY_(CMP, ZERO_PAGE,   0xC5, 3, NONE) \
+    _ENTRY_(CMP, ZERO_PAGE_X, 0xD5, 4, NONE) \
+    _ENTRY_(CMP, ABSOLUTE,    0xCD, 4, NONE) \
+    _ENTRY_(CMP, ABSOLUTE_X,  0xDD, 4, PAGE) \
+    _ENTRY_(CMP, ABSOLUTE_Y,  0xD9, 4, PAGE) \
+    _ENTRY_(CMP, INDIRECT_X,  0xC1, 6, NONE) \
+    _ENTRY_(CMP, INDIRECT_Y,  0xD1, 5, PAGE) \
+    _ENTRY_(CPX, IMMEDIATE,   0xE0, 2, NONE) \
+    _ENTRY_(CPX, ZERO_PAGE,   0xE4, 3, NONE) \
+    _ENTRY_(CPX, ABSOLUTE,    0xEC, 4, NONE) \
+    _ENTRY_(CPY, IMMEDIATE,   0xC0, 2, NONE) \
+    _ENTRY_(CPY, ZERO_PAGE,   0xC4, 3, NONE) \
+    _ENTRY_(CPY, ABSOLUTE,    0xCC, 4, NONE) \
+    _ENTRY_(DEC, ZERO_PAGE,   0xC6, 5, NONE) \
+    _ENTRY_(DEC, ZERO_PAGE_X, 0xD6, 6, NONE) \
+    _ENTRY_(DEC, ABSOLUTE,    0xCE, 6, NONE) \
+    _ENTRY_(DEC, ABSOLUTE_X,  0xDE, 7, NONE) \
+    _ENTRY_(DEX, IMPLIED,     0xCA, 2, NONE) \
+    _ENTRY_(DEY, IMPLIED,     0x88, 2, NONE) \
+    _ENTRY_(EOR, IMMEDIATE,   0x49, 2, NONE) \
+    _ENTRY_(EOR, ZERO_PAGE,   0x45, 3, NONE) \
+    _ENTRY_(EOR, ZERO_PAGE_X, 0x55, 4, NONE) \
+    _ENTRY_(EOR, ABSOLUTE,    0x4D, 4, NONE) \
+    _ENTRY_(EOR, ABSOLUTE_X,  0x5D, 4, PAGE) \
+    _ENTRY_(EOR, ABSOLUTE_Y,  0x59, 4, PAGE) \
+    _ENTRY_(EOR, INDIRECT_X,  0x41, 6, NONE) \
+    _ENTRY_(EOR, INDIRECT_Y,  0x51, 5, PAGE) \
+    _ENTRY_(INC, ZERO_PAGE,   0xE6, 5, NONE) \
+    _ENTRY_(INC, ZERO_PAGE_X, 0xF6, 6, NONE) \
+    _ENTRY_(INC, ABSOLUTE,    0xEE, 6, NONE) \
+    _ENTRY_(INC, ABSOLUTE_X,  0xFE, 7, NONE) \
+    _ENTRY_(INX, IMPLIED,     0xE8, 2, NONE) \
+    _ENTRY_(INY, IMPLIED,     0xC8, 2, NONE) \
+    _ENTRY_(JMP, ABSOLUTE,    0x4C, 3, NONE) \
+    _ENTRY_(JMP, INDIRECT,    0x6C, 5, NONE) \
+    _ENTRY_(JSR, ABSOLUTE,    0x20, 6, NONE) \
+    _ENTRY_(LDA, IMMEDIATE,   0xA9, 2, NONE) \
+    _ENTRY_(LDA, ZERO_PAGE,   0xA5, 3, NONE) \
+    _ENTRY_(LDA, ZERO_PAGE_X, 0xB5, 4, NONE) \
+    _ENTRY_(LDA, ABSOLUTE,    0xAD, 4, NONE) \
+    _ENTRY_(LDA, ABSOLUTE_X,  0xBD, 4, PAGE) \
+    _ENTRY_(LDA, ABSOLUTE_Y,  0xB9, 4, PAGE) \
+    _ENTRY_(LDA, INDIRECT_X,  0xA1, 6, NONE) \
+    _ENTRY_(LDA, INDIRECT_Y,  0xB1, 5, PAGE) \
+    _ENTRY_(LDX, IMMEDIATE,   0xA2, 2, NONE) \
+    _ENTRY_(LDX, ZERO_PAGE,   0xA6, 3, NONE) \
+    _ENTRY_(LDX, ZERO_PAGE_Y, 0xB6, 4, NONE) \
+    _ENTRY_(LDX, ABSOLUTE,    0xAE, 4, NONE) \
+    _ENTRY_(LDX, ABSOLUTE_Y,  0xBE, 4, PAGE) \
+    _ENTRY_(LDY, IMMEDIATE,   0xA0, 2, NONE) \
+    _ENTRY_(LDY, ZERO_PAGE,   0xA4, 3, NONE) \
+    _ENTRY_(LDY, ZERO_PAGE_X, 0xB4, 4, NONE) \
+    _ENTRY_(LDY, ABSOLUTE,    0xAC, 4, NONE) \
+    _ENTRY_(LDY, ABSOLUTE_X,  0xBC, 4, PAGE) \
+    _ENTRY_(LSR, ACCUMULATOR, 0x4A, 2, NONE) \
+    _ENTRY_(LSR, ZERO_PAGE,   0x46, 5, NONE) \
+    _ENTRY_(LSR, ZERO_PAGE_X, 0x56, 6, NONE) \
+    _ENTRY_(LSR, ABSOLUTE,    0x4E, 6, NONE) \
+    _ENTRY_(LSR, ABSOLUTE_X,  0x5E, 7, NONE) \
+    _ENTRY_(NOP, IMPLIED,     0xEA, 2, NONE) \
+    _ENTRY_(ORA, IMMEDIATE,   0x09, 2, NONE) \
+    _ENTRY_(ORA, ZERO_PAGE,   0x05, 3, NONE) \
+    _ENTRY_(ORA, ZERO_PAGE_X, 0x15, 4, NONE) \
+    _ENTRY_(ORA, ABSOLUTE,    0x0D, 4, NONE) \
+    _ENTRY_(ORA, ABSOLUTE_X,  0x1D, 4, PAGE) \
+    _ENTRY_(ORA, ABSOLUTE_Y,  0x19, 4, PAGE) \
+    _ENTRY_(ORA, INDIRECT_X,  0x01, 6, NONE) \
+    _ENTRY_(ORA, INDIRECT_Y,  0x11, 5, PAGE) \
+    _ENTRY_(PHA, IMPLIED,     0x48, 3, NONE) \
+    _ENTRY_(PHP, IMPLIED,     0x08, 3, NONE) \
+    _ENTRY_(PLA, IMPLIED,     0x68, 4, NONE) \
+    _ENTRY_(PLP, IMPLIED,     0x28, 4, NONE) \
+    _ENTRY_(ROL, ACCUMULATOR, 0x2A, 2, NONE) \
+    _ENTRY_(ROL, ZERO_PAGE,   0x26, 5, NONE) \
+    _ENTRY_(ROL, ZERO_PAGE_X, 0x36, 6, NONE) \
+    _ENTRY_(ROL, ABSOLUTE,    0x2E, 6, NONE) \
+    _ENTRY_(ROL, ABSOLUTE_X,  0x3E, 7, NONE) \
+    _ENTRY_(ROR, ACCUMULATOR, 0x6A, 2, NONE) \
+    _ENTRY_(ROR, ZERO_PAGE,   0x66, 5, NONE) \
+    _ENTRY_(ROR, ZERO_PAGE_X, 0x76, 6, NONE) \
+    _ENTRY_(ROR, ABSOLUTE,    0x6E, 6, NONE) \
+    _ENTRY_(ROR, ABSOLUTE_X,  0x7E, 7, NONE) \
+    _ENTRY_(RTI, IMPLIED,     0x40, 6, NONE) \
+    _ENTRY_(RTS, IMPLIED,     0x60, 6, NONE) \
+    _ENTRY_(SBC, IMMEDIATE,   0xE9, 2, NONE) \
+    _ENTRY_(SBC, ZERO_PAGE,   0xE5, 3, NONE) \
+    _ENTRY_(SBC, ZERO_PAGE_X, 0xF5, 4, NONE) \
+    _ENTRY_(SBC, ABSOLUTE,    0xED, 4, NONE) \
+    _ENTRY_(SBC, ABSOLUTE_X,  0xFD, 4, PAGE) \
+    _ENTRY_(SBC, ABSOLUTE_Y,  0xF9, 4, PAGE) \
+    _ENTRY_(SBC, INDIRECT_X,  0xE1, 6, NONE) \
+    _ENTRY_(SBC, INDIRECT_Y,  0xF1, 5, PAGE) \
+    _ENTRY_(SEC, IMPLIED,     0x38, 2, NONE) \
+    _ENTRY_(SED, IMPLIED,     0xF8, 2, NONE) \
+    _ENTRY_(SEI, IMPLIED,     0x78, 2, NONE) \
+    _ENTRY_(STA, ZERO_PAGE,   0x85, 3, NONE) \
+    _ENTRY_(STA, ZERO_PAGE_X, 0x95, 4, NONE) \
+    _ENTRY_(STA, ABSOLUTE,    0x8D, 4, NONE) \
+    _ENTRY_(STA, ABSOLUTE_X,  0x9D, 5, NONE) \
+    _ENTRY_(STA, ABSOLUTE_Y,  0x99, 5, NONE) \
+    _ENTRY_(STA, INDIRECT_X,  0x81, 6, NONE) \
+    _ENTRY_(STA, INDIRECT_Y,  0x91, 6, NONE) \
+    _ENTRY_(STX, ZERO_PAGE,   0x86, 3, NONE) \
+    _ENTRY_(STX, ZERO_PAGE_Y, 0x96, 4, NONE) \
+    _ENTRY_(STX, ABSOLUTE,    0x8E, 4, NONE) \
+    _ENTRY_(STY, ZERO_PAGE,   0x84, 3, NONE) \
+    _ENTRY_(STY, ZERO_PAGE_X, 0x94, 4, NONE) \
+    _ENTRY_(STY, ABSOLUTE,    0x8C, 4, NONE) \
+    _ENTRY_(TAX, IMPLIED,     0xAA, 2, NONE) \
+    _ENTRY_(TAY, IMPLIED,     0xA8, 2, NONE) \
+    _ENTRY_(TSX, IMPLIED,     0xBA, 2, NONE) \
+    _ENTRY_(TXA, IMPLIED,     0x8A, 2, NONE) \
+    _ENTRY_(TXS, IMPLIED,     0x9A, 2, NONE) \
+    _ENTRY_(TYA, IMPLIED,     0x98, 2, NONE)
+
+/*!
+ * @brief Instruction length macro, derived from the addressing mode.
+ * @param[in] _MODE_ Addressing mode
+ */
+#define LENGTH(_MODE_) \
+    (((_MODE_) <= MODE_ACCUMULATOR) ? 1 : ((((_MODE_) >= MODE_ABSOLUTE) && ((_MODE_) <= MODE_INDIRECT)) ? 3 : 2))
+
+/*!
+ * @brief Entry check macro. Each entry is checked at build time, so a bad entry fails the build rather than the output.
+ */
+#define ENTRY_CHECK(_INSTRUCTION_, _MODE_, _OPCODE_, _CYCLES_, _PENALTY_) \
+    _Static_assert(((_OPCODE_) <= UINT8_MAX) && ((_CYCLES_) >= 2) && ((_CYCLES_) <= 7) \
+        && ((_CYCLES_) >= LENGTH(MODE_##_MODE_)), #_INSTRUCTION_ " " #_MODE_ ": Invalid opcode or cycle count"); \
+    _Static_assert((PENALTY_##_PENALTY_ != PENALTY_PAGE) || (MODE_##_MODE_ == MODE_ABSOLUTE_X) \
+        || (MODE_##_MODE_ == MODE_ABSOLUTE_Y) || (MODE_##_MODE_ == MODE_INDIRECT_Y), \
+        #_INSTRUCTION_ " " #_MODE_ ": Page penalty on unindexed mode"); \
+    _Static_assert((PENALTY_##_PENALTY_ == PENALTY_BRANCH) == (MODE_##_MODE_ == MODE_RELATIVE), \
+        #_INSTRUCTION_ " " #_MODE_ ": Branch penalty mismatch");
+
+/*!
+ * @brief Entry count macro.
+ */
+#define ENTRY_COUNT(...) + 1
+
+/*!
+ * @brief Entry decode macro.
+ */
+#define ENTRY_DECODE(_INSTRUCTION_, _MODE_, _OPCODE_, ...) \
+    [_OPCODE_] = { true, INSTRUCTION_##_INSTRUCTION_, MODE_##_MODE_ },
+
+/*!
+ * @brief Entry matrix macro.
+ */
+#define ENTRY_MATRIX(_INSTRUCTION_, _MODE_, _OPCODE_, _CYCLES_, _PENALTY_) \
+    [INSTRUCTION_##_INSTRUCTION_][MODE_##_MODE_] = { true, _OPCODE_, LENGTH(MODE_##_MODE_), _CYCLES_, PENALTY_##_PENALTY_ },
+
+/*!
+ * @brief Entry unique mode macro. A repeated instruction and addressing mode redeclares an enumerator, failing the build.
+ */
+#define ENTRY_UNIQUE_MODE(_INSTRUCTION_, _MODE_, ...) \
+    UNIQUE_##_INSTRUCTION_##_##_MODE_,
+
+/*!
+ * @brief Entry unique opcode macro. A repeated opcode byte redeclares an enumerator, failing the build.
+ */
+#define ENTRY_UNIQUE_OPCODE(_INSTRUCTION_, _MODE_, _OPCODE_, ...) \
+    UNIQUE_##_OPCODE_,
+
+OPCODES(ENTRY_CHECK)
+
+enum { OPCODES(ENTRY_UNIQUE_MODE) };
+enum { OPCODES(ENTRY_UNIQUE_OPCODE) };
+enum { OPCODE_COUNT = 0 OPCODES(ENTRY_COUNT) };
+
+_Static_assert(OPCODE_COUNT == 151, "Official opcode count mismatch");
+
+/*!
+ * @brief Opcode decode table, indexed by opcode byte.
+ */
+static const struct {
+    uint8_t valid;                      /*!< Opcode is valid */
+    uint8_t instruction;                /*!< Instruction type */
+    uint8_t mode;                       /*!< Addressing mode */
+} DECODE[UINT8_MAX + 1] = {
+    OPCODES(ENTRY_DECODE)
+    };
+
+/*!
+ * @brief Instruction names, indexed by instruction type.
+ */
+static const char *INSTRUCTION[] = {
+    "ADC", "AND", "ASL", "BCC", "BCS", "BEQ", "BIT", "BMI", "BNE", "BPL", "BRK", "BVC", "BVS", "CLC", "CLD", "CLI",
+    "CLV", "CMP", "CPX", "CPY", "DEC", "DEX", "DEY", "EOR", "INC", "INX", "INY", "JMP", "JSR", "LDA", "LDX", "LDY",
+    "LSR", "NOP", "ORA", "PHA", "PHP", "PLA", "PLP", "ROL", "ROR", "RTI", "RTS", "SBC", "SEC", "SED", "SEI", "STA",
+    "STX", "STY", "TAX", "TAY", "TSX", "TXA", "TXS", "TYA",
+    };
+
+_Static_assert((sizeof(INSTRUCTION) / sizeof(*INSTRUCTION)) == INSTRUCTION_MAX, "Instruction name count mismatch");
+
+/*!
+ * @brief Addressing mode names, indexed by addressing mode.
+ */
+static const char *MODE[] = {
+    "implied", "accumulator", "immediate", "zero-page", "zero-page,X", "zero-page,Y", "absolute", "absolute,X", "absolute,Y",
+    "indirect", "indirect,X", "indirect,Y", "relative",
+    };
+
+_Static_assert((sizeof(MODE) / sizeof(*MODE)) == MODE_MAX, "Addressing mode name count mismatch");
+
+/*!
+ * @brief Opcode matrix, indexed by instruction and addressing mode. Invalid combinations are zero.
+ */
+static const nesla_opcode_t OPCODE[INSTRUCTION_MAX][MODE_MAX] = {
+    OPCODES(ENTRY_MATRIX)
+    };
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+bool nesla_opcode_decode(uint8_t opcode, nesla_instruction_e *instruction, nesla_mode_e *mode)
+{
+
+    if(!DECODE[opcode].valid) {
+        return false;
+    }
+
+    *instruction = DECODE[opcode].instruction;
+    *mode = DECODE[opcode].mode;
+
+    return true;
+}
+
+const nesla_opcode_t *nesla_opcode_get(nesla_instruction_e instruction, nesla_mode_e mode)
+{
+    return &OPCODE[instruction][mode];
+}
+
+const char *nesla_opcode_get_instruction(nesla_instruction_e instruction)
+{
+    return INSTRUCTION[instruction];
+}
+
+const char *nesla_opcode_get_mode(nesla_mode_e mode)
+{
+    return MODE[mode];
+}
+
+nesla_instruction_e nesla_opcode_invert(nesla_instruction_e instruction)
+{
+    static const nesla_instruction_e INVERSE[INSTRUCTION_MAX] = {
+        [INSTRUCTION_BCC] = INSTRUCTION_BCS, [INSTRUCTION_BCS] = INSTRUCTION_BCC, [INSTRUCTION_BEQ] = INSTRUCTION_BNE,
+        [INSTRUCTION_BMI] = INSTRUCTION_BPL, [INSTRUCTION_BNE] = INSTRUCTION_BEQ, [INSTRUCTION_BPL] = INSTRUCTION_BMI,
+        [INSTRUCTION_BVC] = INSTRUCTION_BVS, [INSTRUCTION_BVS] = INSTRUCTION_BVC,
+        };
+
+    return nesla_opcode_get(instruction, MODE_RELATIVE)->valid ? INVERSE[instruction] : INSTRUCTION_MAX;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,807 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <pack.h>
+
+#define PACK_HASH_BASIS 0xCBF29CE484222325 /*!< 64-bit FNV-1a offset basis, of compression cache file names */
+#define PACK_HASH_PRIME 0x100000001B3   /*!< 64-bit FNV-1a prime */
+
+/*!
+ * @enum nesla_pack_label_e
+ * @brief Decompressor local label.
+ */
+typedef enum {
+    PACK_LABEL_NEXT = 0,                /*!< Next packet */
+    PACK_LABEL_SKIP,                    /*!< Control byte skipped */
+    PACK_LABEL_LITERAL,                 /*!< Literal copy loop */
+    PACK_LABEL_ADVANCE,                 /*!< Destination advance, by the accumulator */
+    PACK_LABEL_SOURCE,                  /*!< Source advance, by Y */
+    PACK_LABEL_REPEAT,                  /*!< Run or match packet */
+    PACK_LABEL_COPY,                    /*!< Run fill, or match copy loop */
+    PACK_LABEL_DONE,                    /*!< End of block */
+    PACK_LABEL_MAX,                     /*!< Max local label */
+} nesla_pack_label_e;
+
+/*!
+ * @enum nesla_pack_operand_e
+ * @brief Decompressor operand type.
+ */
+typedef enum {
+    PACK_OPERAND_NONE = 0,              /*!< Value given, or no operand */
+    PACK_OPERAND_LABEL,                 /*!< Local label (nesla_pack_label_e) */
+    PACK_OPERAND_NAME,                  /*!< Decompressor name symbol (nesla_unpack_e) */
+    PACK_OPERAND_TABLE,                 /*!< Block address table of the decompressor */
+} nesla_pack_operand_e;
+
+/*!
+ * @struct nesla_pack_code_t
+ * @brief Decompressor statement, or local label.
+ */
+typedef struct {
+    uint8_t instruction;                /*!< Instruction type, or INSTRUCTION_MAX for a local label */
+    uint8_t mode;                       /*!< Addressing mode */
+    uint8_t operand;                    /*!< Operand type */
+    uint8_t value;                      /*!< Operand value, local label or decompressor name */
+} nesla_pack_code_t;
+
+/*!
+ * @struct nesla_pack_t
+ * @brief Packed block link context.
+ */
+typedef struct {
+    nesla_encoder_t *encoder;           /*!< Encoder context */
+    const nesla_token_t *token;         /*!< Token generated statements are reported at */
+    size_t bank;                        /*!< Provisional bank of the decompressor section */
+    uint16_t address;                   /*!< Address of the next generated statement */
+    uint32_t label[PACK_LABEL_MAX];     /*!< Local label symbol indices, of the decompressor being generated */
+} nesla_pack_t;
+
+/*!
+ * @brief Decompressor statements shared by both compression modes. X holds the block index, and the block address is read
+ *        from the table into the source pointer. Each packet advances both pointers, so Y never passes a packet.
+ */
+static const nesla_pack_code_t PACK_ENTRY[] = {
+    { INSTRUCTION_TXA, MODE_IMPLIED, PACK_OPERAND_NONE, 0 },
+    { INSTRUCTION_ASL, MODE_ACCUMULATOR, PACK_OPERAND_NONE, 0 },
+    { INSTRUCTION_TAX, MODE_IMPLIED, PACK_OPERAND_NONE, 0 },
+    { INSTRUCTION_LDA, MODE_ABSOLUTE_X, PACK_OPERAND_TABLE, 0 },
+    { INSTRUCTION_STA, MODE_ABSOLUTE, PACK_OPERAND_NAME, UNPACK_SOURCE },
+    { INSTRUCTION_INX, MODE_IMPLIED, PACK_OPERAND_NONE, 0 },
+    { INSTRUCTION_LDA, MODE_ABSOLUTE_X, PACK_OPERAND_TABLE, 0 },
+    { INSTRUCTION_STA, MODE_ABSOLUTE, PACK_OPERAND_NAME, UNPACK_SOURCE_HIGH },
+    { INSTRUCTION_MAX, MODE_IMPLIED, PACK_OPERAND_LABEL, PACK_LABEL_NEXT },
+    { INSTRUCTION_LDY, MODE_IMMEDIATE, PACK_OPERAND_NONE, 0 },
+    { INSTRUCTION_LDA, MODE_INDIRECT_Y, PACK_OPERAND_NAME, UNPACK_SOURCE },
+    { INSTRUCTION_BEQ, MODE_RELATIVE, PACK_OPERAND_LABEL, PACK_LABEL_DONE },
+    { INSTRUCTION_INC, MODE_ABSOLUTE, PACK_OPERAND_NAME, UNPACK_SOURCE },
+    { INSTRUCTION_BNE, MODE_RELATIVE, PACK_OPERAND_LABEL, PACK_LABEL_SKIP },
+    { INSTRUCTION_INC, MODE_ABSOLUTE, PACK_OPERAND_NAME, UNPACK_SOURCE_HIGH },
+    { INSTRUCTION_MAX, MODE_IMPLIED, PACK_OPERAND_LABEL, PACK_LABEL_SKIP },
+    { INSTRUCTION_TAX, MODE_IMPLIED, PACK_OPERAND_NONE, 0 },
+    { INSTRUCTION_BMI, MODE_RELATIVE, PACK_OPERAND_LABEL, PACK_LABEL_REPEAT },
+    { INSTRUCTION_MAX, MODE_IMPLIED, PACK_OPERAND_LABEL, PACK_LABEL_LITERAL },
+    { INSTRUCTION_LDA, MODE_INDIRECT_Y, PACK_OPERAND_NAME, UNPACK_SOURCE },
+    { INSTRUCTION_STA, MODE_INDIRECT_Y, PACK_OPERAND_NAME, UNPACK_DESTINATION },
+    { INSTRUCTION_INY, MODE_IMPLIED, PACK_OPERAND_NONE, 0 },
+    { INSTRUCTION_DEX, MODE_IMPLIED, PACK_OPERAND_NONE, 0 },
+    { INSTRUCTION_BNE, MODE_RELATIVE, PACK_OPERAND_LABEL, PACK_LABEL_LITERAL },
+    { INSTRUCTION_TYA, MODE_IMPLIED, PACK_OPERAND_NONE, 0 },
+    { INSTRUCTION_MAX, MODE_IMPLIED, PACK_OPERAND_LABEL, PACK_LABEL_ADVANCE },
+    { INSTRUCTION_CLC, MODE_IMPLIED, PACK_OPERAND_NONE, 0 },
+    { INSTRUCTION_ADC, MODE_ABSOLUTE, PACK_OPERAND_NAME, UNPACK_DESTINATION },
+    { INSTRUCTION_STA, MODE_ABSOLUTE, PACK_OPERAND_NAME, UNPACK_DESTINATION },
+    { INSTRUCTION_BCC, MODE_RELATIVE, PACK_OPERAND_LABEL, PACK_LABEL_SOURCE },
+    { INSTRUCTION_INC, MODE_ABSOLUTE, PACK_OPERAND_NAME, UNPACK_DESTINATION_HIGH },
+    { INSTRUCTION_MAX, MODE_IMPLIED, PACK_OPERAND_LABEL, PACK_LABEL_SOURCE },
+    { INSTRUCTION_TYA, MODE_IMPLIED, PACK_OPERAND_NONE, 0 },
+    { INSTRUCTION_CLC, MODE_IMPLIED, PACK_OPERAND_NONE, 0 },
+    { INSTRUCTION_ADC, MODE_ABSOLUTE, PACK_OPERAND_NAME, UNPACK_SOURCE },
+    { INSTRUCTION_STA, MODE_ABSOLUTE, PACK_OPERAND_NAME, UNPACK_SOURCE },
+    { INSTRUCTION_BCC, MODE_RELATIVE, PACK_OPERAND_LABEL, PACK_LABEL_NEXT },
+    { INSTRUCTION_INC, MODE_ABSOLUTE, PACK_OPERAND_NAME, UNPACK_SOURCE_HIGH },
+    { INSTRUCTION_BCS, MODE_RELATIVE, PACK_OPERAND_LABEL, PACK_LABEL_NEXT },
+    { INSTRUCTION_MAX, MODE_IMPLIED, PACK_OPERAND_LABEL, PACK_LABEL_REPEAT },
+    };
+
+/*!
+ * @brief Run-length decompressor statements, filling the run with the byte that follows its control byte.
+ */
+static const nesla_pack_code_t PACK_RLE[] = {
+    { INSTRUCTION_AND, MODE_IMMEDIATE, PACK_OPERAND_NONE, 0x7F },
+    { INSTRUCTION_TAX, MODE_IMPLIED, PACK_OPERAND_NONE, 0 },
+    { INSTRUCTION_INX, MODE_IMPLIED, PACK_OPERAND_NONE, 0 },
+    { INSTRUCTION_LDA, MODE_INDIRECT_Y, PACK_OPERAND_NAME, UNPACK_SOURCE },
+    { INSTRUCTION_MAX, MODE_IMPLIED, PACK_OPERAND_LABEL, PACK_LABEL_COPY },
+    { INSTRUCTION_STA, MODE_INDIRECT_Y, PACK_OPERAND_NAME, UNPACK_DESTINATION },
+    { INSTRUCTION_INY, MODE_IMPLIED, PACK_OPERAND_NONE, 0 },
+    { INSTRUCTION_DEX, MODE_IMPLIED, PACK_OPERAND_NONE, 0 },
+    { INSTRUCTION_BNE, MODE_RELATIVE, PACK_OPERAND_LABEL, PACK_LABEL_COPY },
+    { INSTRUCTION_TYA, MODE_IMPLIED, PACK_OPERAND_NONE, 0 },
+    { INSTRUCTION_LDY, MODE_IMMEDIATE, PACK_OPERAND_NONE, 1 },
+    { INSTRUCTION_BNE, MODE_RELATIVE, PACK_OPERAND_LABEL, PACK_LABEL_ADVANCE },
+    { INSTRUCTION_MAX, MODE_IMPLIED, PACK_OPERAND_LABEL, PACK_LABEL_DONE },
+    { INSTRUCTION_RTS, MODE_IMPLIED, PACK_OPERAND_NONE, 0 },
+    };
+
+/*!
+ * @brief LZ decompressor statements, pointing the match pointer at the destination, less the distance plus one that follows
+ *        the control byte, and copying forward, so a match may overlap the bytes it writes.
+ */
+static const nesla_pack_code_t PACK_LZ[] = {
+    { INSTRUCTION_AND, MODE_IMMEDIATE, PACK_OPERAND_NONE, 0x7F },
+    { INSTRUCTION_CLC, MODE_IMPLIED, PACK_OPERAND_NONE, 0 },
+    { INSTRUCTION_ADC, MODE_IMMEDIATE, PACK_OPERAND_NONE, PACK_MATCH_MIN },
+    { INSTRUCTION_TAX, MODE_IMPLIED, PACK_OPERAND_NONE, 0 },
+    { INSTRUCTION_LDA, MODE_ABSOLUTE, PACK_OPERAND_NAME, UNPACK_DESTINATION },
+    { INSTRUCTION_CLC, MODE_IMPLIED, PACK_OPERAND_NONE, 0 },
+    { INSTRUCTION_SBC, MODE_INDIRECT_Y, PACK_OPERAND_NAME, UNPACK_SOURCE },
+    { INSTRUCTION_STA, MODE_ABSOLUTE, PACK_OPERAND_NAME, UNPACK_REFERENCE },
+    { INSTRUCTION_LDA, MODE_ABSOLUTE, PACK_OPERAND_NAME, UNPACK_DESTINATION_HIGH },
+    { INSTRUCTION_SBC, MODE_IMMEDIATE, PACK_OPERAND_NONE, 0 },
+    { INSTRUCTION_STA, MODE_ABSOLUTE, PACK_OPERAND_NAME, UNPACK_REFERENCE_HIGH },
+    { INSTRUCTION_MAX, MODE_IMPLIED, PACK_OPERAND_LABEL, PACK_LABEL_COPY },
+    { INSTRUCTION_LDA, MODE_INDIRECT_Y, PACK_OPERAND_NAME, UNPACK_REFERENCE },
+    { INSTRUCTION_STA, MODE_INDIRECT_Y, PACK_OPERAND_NAME, UNPACK_DESTINATION },
+    { INSTRUCTION_INY, MODE_IMPLIED, PACK_OPERAND_NONE, 0 },
+    { INSTRUCTION_DEX, MODE_IMPLIED, PACK_OPERAND_NONE, 0 },
+    { INSTRUCTION_BNE, MODE_RELATIVE, PACK_OPERAND_LABEL, PACK_LABEL_COPY },
+    { INSTRUCTION_TYA, MODE_IMPLIED, PACK_OPERAND_NONE, 0 },
+    { INSTRUCTION_LDY, MODE_IMMEDIATE, PACK_OPERAND_NONE, 1 },
+    { INSTRUCTION_BNE, MODE_RELATIVE, PACK_OPERAND_LABEL, PACK_LABEL_ADVANCE },
+    { INSTRUCTION_MAX, MODE_IMPLIED, PACK_OPERAND_LABEL, PACK_LABEL_DONE },
+    { INSTRUCTION_RTS, MODE_IMPLIED, PACK_OPERAND_NONE, 0 },
+    };
+
+/*!
+ * @brief Get packed block compressed length bound, for data that does not compress at all.
+ * @param[in] length Uncompressed length in bytes
+ * @return Compressed length bound in bytes
+ */
+static size_t nesla_pack_bound(size_t length)
+{
+    return length + (length / PACK_LITERAL_MAX) + 3;
+}
+
+/*!
+ * @brief Check packed block compressed data, by decompressing it against the uncompressed data.
+ * @param[in] mode Compression mode
+ * @param[in] data Constant pointer to compressed data
+ * @param[in] length Compressed data length in bytes
+ * @param[in] expected Constant pointer to uncompressed data
+ * @param[in] expected_length Uncompressed data length in bytes
+ * @return true if the compressed data decompresses to the uncompressed data, false otherwise
+ */
+static bool nesla_pack_check(uint8_t mode, const uint8_t *data, size_t length, const uint8_t *expected, size_t expected_length)
+{
+    size_t in = 0, out = 0;
+
+    while(in < length) {
+        size_t count, distance = 0;
+        uint8_t control = data[in++];
+
+        if(!control) {
+            return (in == length) && (out == expected_length);
+        }
+
+        if(!(control & 0x80)) {
+
+            if(((in + control) > length) || ((out + control) > expected_length) || memcmp(data + in, expected + out, control)) {
+                return false;
+            }
+
+            in += control;
+            out += control;
+            continue;
+        }
+
+        if(in == length) {
+            return false;
+        }
+
+        count = (control & 0x7F) + ((mode == UNPACK_LZ) ? PACK_MATCH_MIN : 1);
+
+        if((mode == UNPACK_LZ) && ((distance = data[in] + 1) > out)) {
+            return false;
+        }
+
+        for(; count; --count, ++out) {
+
+            if((out == expected_length) || (expected[out] != (distance ? expected[out - distance] : data[in]))) {
+                return false;
+            }
+        }
+
+        ++in;
+    }
+
+    return false;
+}
+
+/*!
+ * @brief Write packed block literal packets.
+ * @param[in,out] output Pointer to compressed data
+ * @param[in] length Compressed data length in bytes
+ * @param[in] input Constant pointer to uncompressed data
+ * @param[in] first First literal byte offset
+ * @param[in] last Offset past the last literal byte
+ * @return Compressed data length in bytes
+ */
+static size_t nesla_pack_literal(uint8_t *output, size_t length, const uint8_t *input, size_t first, size_t last)
+{
+
+    while(first < last) {
+        size_t count = ((last - first) > PACK_LITERAL_MAX) ? PACK_LITERAL_MAX : (last - first);
+
+        output[length++] = count;
+        memcpy(output + length, input + first, count);
+        length += count;
+        first += count;
+    }
+
+    return length;
+}
+
+/*!
+ * @brief Compress packed block with run-length encoding. Runs shorter than PACK_RUN_MIN are left in literal packets.
+ * @param[in] input Constant pointer to uncompressed data
+ * @param[in] length Uncompressed data length in bytes
+ * @param[in,out] output Pointer to compressed data, sized for the worst case (see nesla_pack_bound)
+ * @return Compressed data length in bytes
+ */
+static size_t nesla_pack_rle(const uint8_t *input, size_t length, uint8_t *output)
+{
+    size_t first = 0, index = 0, result = 0;
+
+    while(index < length) {
+        size_t count = 1;
+
+        while(((index + count) < length) && (count < PACK_RUN_MAX) && (input[index + count] == input[index])) {
+            ++count;
+        }
+
+        if(count < PACK_RUN_MIN) {
+            index += count;
+            continue;
+        }
+
+        result = nesla_pack_literal(output, result, input, first, index);
+        output[result++] = 0x80 | (count - 1);
+        output[result++] = input[index];
+        first = (index += count);
+    }
+
+    result = nesla_pack_literal(output, result, input, first, length);
+    output[result++] = 0;
+
+    return result;
+}
+
+/*!
+ * @brief Compress packed block with LZ encoding, taking the longest match in the window at each byte, and the nearest of
+ *        those. Matches shorter than PACK_MATCH_MIN are left in literal packets.
+ * @param[in] input Constant pointer to uncompressed data
+ * @param[in] length Uncompressed data length in bytes
+ * @param[in,out] output Pointer to compressed data, sized for the worst case (see nesla_pack_bound)
+ * @return Compressed data length in bytes
+ */
+static size_t nesla_pack_lz(const uint8_t *input, size_t length, uint8_t *output)
+{
+    size_t first = 0, index = 0, result = 0;
+
+    while(index < length) {
+        size_t best = 0, distance = 0, limit = ((length - index) > PACK_MATCH_MAX) ? PACK_MATCH_MAX : (length - index);
+
+        for(size_t back = 1; (back <= PACK_WINDOW) && (back <= index) && (best < limit); ++back) {
+            size_t count = 0;
+
+            while((count < limit) && (input[index + count] == input[index + count - back])) {
+                ++count;
+            }
+
+            if(count > best) {
+                best = count;
+                distance = back;
+            }
+        }
+
+        if(best < PACK_MATCH_MIN) {
+            ++index;
+            continue;
+        }
+
+        result = nesla_pack_literal(output, result, input, first, index);
+        output[result++] = 0x80 | (best - PACK_MATCH_MIN);
+        output[result++] = distance - 1;
+        first = (index += best);
+    }
+
+    result = nesla_pack_literal(output, result, input, first, length);
+    output[result++] = 0;
+
+    return result;
+}
+
+/*!
+ * @brief Write packed block compressed data to the compression cache, through a temporary file renamed into place, so a
+ *        concurrent assembly never reads a partial file. Failures are ignored, and leave the block uncached.
+ * @param[in,out] pack Pointer to packed block context
+ */
+static void nesla_pack_write(nesla_packed_t *pack)
+{
+    int descriptor;
+    size_t offset = 0;
+
+    if((descriptor = mkstemp(pack->temporary)) < 0) {
+        return;
+    }
+
+    while(offset < pack->output_length) {
+        ssize_t written = write(descriptor, pack->output + offset, pack->output_length - offset);
+
+        if(written <= 0) {
+            break;
+        }
+
+        offset += written;
+    }
+
+    if(close(descriptor) || (offset < pack->output_length) || rename(pack->temporary, pack->path)) {
+        unlink(pack->temporary);
+    }
+}
+
+/*!
+ * @brief Compress packed block, on a worker thread or the calling thread. Only the block itself is touched, so no lock is
+ *        needed.
+ * @param[in,out] pack Pointer to packed block context
+ */
+static void nesla_pack_compress(nesla_packed_t *pack)
+{
+
+    if(pack->mode == UNPACK_LZ) {
+        pack->output_length = nesla_pack_lz(pack->input, pack->input_length, pack->output);
+    } else {
+        pack->output_length = nesla_pack_rle(pack->input, pack->input_length, pack->output);
+    }
+
+    if(pack->path) {
+        nesla_pack_write(pack);
+    }
+}
+
+/*!
+ * @brief Compress packed blocks queued in the worker thread pool, until the pool is closed and its queue is empty.
+ * @param[in,out] context Pointer to worker thread pool context
+ * @return 0
+ */
+static int nesla_pack_worker(void *context)
+{
+    nesla_pack_pool_t *pool = context;
+
+    for(;;) {
+        nesla_packed_t *pack;
+
+        mtx_lock(&pool->lock);
+
+        while(!pool->head && !pool->closed) {
+            cnd_wait(&pool->signal, &pool->lock);
+        }
+
+        if((pack = pool->head) && !(pool->head = pack->queued)) {
+            pool->tail = NULL;
+        }
+
+        mtx_unlock(&pool->lock);
+
+        if(!pack) {
+            break;
+        }
+
+        nesla_pack_compress(pack);
+    }
+
+    return 0;
+}
+
+/*!
+ * @brief Read packed block compressed data from the compression cache, keeping it only if it decompresses to the block.
+ * @param[in,out] pack Pointer to packed block context
+ * @return true if the block was cached, false otherwise
+ */
+static bool nesla_pack_read(nesla_packed_t *pack)
+{
+    FILE *file;
+    size_t length;
+
+    if(!(file = fopen(pack->path, "rb"))) {
+        return false;
+    }
+
+    length = fread(pack->output, sizeof(*pack->output), nesla_pack_bound(pack->input_length), file);
+    pack->cached = !ferror(file) && (fgetc(file) == EOF)
+        && nesla_pack_check(pack->mode, pack->output, length, pack->input, pack->input_length);
+    pack->output_length = pack->cached ? length : 0;
+    fclose(file);
+
+    return pack->cached;
+}
+
+/*!
+ * @brief Set packed block compression cache paths, named after the hash and length of its data.
+ * @param[in,out] encoder Pointer to encoder context
+ * @param[in,out] pack Pointer to packed block context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_pack_path(nesla_encoder_t *encoder, nesla_packed_t *pack)
+{
+    static const char *EXTENSION[] = { "rle", "lz", };
+    const char *directory = encoder->context->cache;
+    uint64_t hash = PACK_HASH_BASIS;
+    size_t length;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(size_t index = 0; index < pack->input_length; ++index) {
+        hash = (hash ^ pack->input[index]) * PACK_HASH_PRIME;
+    }
+
+    length = snprintf(NULL, 0, "%s/%016" PRIx64 "-%zu.%s", directory, hash, pack->input_length, EXTENSION[pack->mode]) + 1;
+
+    if(!(pack->path = nesla_context_allocate(encoder->context, length))
+            || !(pack->temporary = nesla_context_allocate(encoder->context, length + 7))) {
+        result = SET_ERROR(encoder->context, "Failed to allocate packed block path: %s", directory);
+        goto exit;
+    }
+
+    snprintf(pack->path, length, "%s/%016" PRIx64 "-%zu.%s", directory, hash, pack->input_length, EXTENSION[pack->mode]);
+    snprintf(pack->temporary, length + 7, "%s.XXXXXX", pack->path);
+    mkdir(directory, 0755);
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Emit packed block decompressor statements, with their local labels placed where each one follows.
+ * @param[in,out] pack Pointer to link context
+ * @param[in] mode Compression mode
+ * @param[in] code Constant pointer to decompressor statements
+ * @param[in] count Decompressor statement count, including local labels
+ * @param[in] first Index of the first decompressor statement
+ * @param[in,out] position Pointer to the number of decompressor statements emitted so far
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_pack_emit(nesla_pack_t *pack, uint8_t mode, const nesla_pack_code_t *code, size_t count, size_t first,
+    size_t *position)
+{
+    nesla_encoder_t *encoder = pack->encoder;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(size_t index = 0; index < count; ++index) {
+        const nesla_pack_code_t *statement = &code[index];
+        uint32_t symbol = ENCODER_UNRESOLVED;
+        size_t length;
+
+        if(statement->instruction == INSTRUCTION_MAX) {
+            nesla_symbol_t *label = &encoder->symbol[pack->label[statement->value]];
+
+            label->bank = pack->bank;
+            label->address = pack->address;
+            label->anchor = first + *position;
+            continue;
+        }
+
+        switch(statement->operand) {
+            case PACK_OPERAND_LABEL:
+                symbol = pack->label[statement->value];
+                break;
+            case PACK_OPERAND_NAME:
+                symbol = encoder->unpack[statement->value] - 1;
+                break;
+            case PACK_OPERAND_TABLE:
+                symbol = encoder->unpack[UNPACK_RLE_TABLE + mode] - 1;
+                break;
+            default:
+                break;
+        }
+
+        if((result = nesla_encoder_put_code(encoder, pack->token, pack->bank, pack->address, statement->instruction, statement->mode,
+                (symbol == ENCODER_UNRESOLVED) ? statement->value : encoder->symbol[symbol].address, symbol, &length))
+                    == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        pack->address += length;
+        ++*position;
+    }
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Generate packed block decompressor, for a compression mode, following the block address tables.
+ * @param[in,out] pack Pointer to link context
+ * @param[in] mode Compression mode
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_pack_generate(nesla_pack_t *pack, uint8_t mode)
+{
+    static const char *SUFFIX[PACK_LABEL_MAX] = { "_NEXT", "_SKIP", "_LITERAL", "_ADVANCE", "_SOURCE", "_REPEAT", "_COPY", "_DONE", };
+    nesla_encoder_t *encoder = pack->encoder;
+    nesla_symbol_t *symbol = &encoder->symbol[encoder->unpack[mode] - 1];
+    size_t first = encoder->statement_count, position = 0;
+    nesla_error_e result;
+
+    symbol->bank = pack->bank;
+    symbol->address = pack->address;
+    symbol->anchor = first;
+
+    for(size_t label = 0; label < PACK_LABEL_MAX; ++label) {
+
+        if((result = nesla_encoder_put_local(encoder, &encoder->unpack_name[mode], SUFFIX[label], pack->bank, pack->address,
+                &pack->label[label])) == NESLA_FAILURE) {
+            goto exit;
+        }
+    }
+
+    if((result = nesla_pack_emit(pack, mode, PACK_ENTRY, sizeof(PACK_ENTRY) / sizeof(*PACK_ENTRY), first, &position))
+            == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if(mode == UNPACK_LZ) {
+        result = nesla_pack_emit(pack, mode, PACK_LZ, sizeof(PACK_LZ) / sizeof(*PACK_LZ), first, &position);
+    } else {
+        result = nesla_pack_emit(pack, mode, PACK_RLE, sizeof(PACK_RLE) / sizeof(*PACK_RLE), first, &position);
+    }
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Start packed block worker thread pool, with a worker per online processor. If no worker can be started, blocks are
+ *        compressed on the calling thread instead.
+ * @param[in,out] pool Pointer to worker thread pool context
+ */
+static void nesla_pack_pool(nesla_pack_pool_t *pool)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    pool->started = true;
+
+    if(count < 1) {
+        count = 1;
+    } else if(count > ENCODER_PACK_THREAD_MAX) {
+        count = ENCODER_PACK_THREAD_MAX;
+    }
+
+    if(mtx_init(&pool->lock, mtx_plain) != thrd_success) {
+        return;
+    }
+
+    if(cnd_init(&pool->signal) != thrd_success) {
+        mtx_destroy(&pool->lock);
+        return;
+    }
+
+    while((pool->thread_count < (size_t)count)
+            && (thrd_create(&pool->thread[pool->thread_count], nesla_pack_worker, pool) == thrd_success)) {
+        ++pool->thread_count;
+    }
+
+    if(!pool->thread_count) {
+        cnd_destroy(&pool->signal);
+        mtx_destroy(&pool->lock);
+    }
+}
+
+/*!
+ * @brief Wait for encoder context packed block worker threads to finish, closing the worker thread pool.
+ * @param[in,out] encoder Pointer to encoder context
+ */
+static void nesla_pack_wait(nesla_encoder_t *encoder)
+{
+    nesla_pack_pool_t *pool = &encoder->pool;
+
+    if(pool->thread_count) {
+        mtx_lock(&pool->lock);
+        pool->closed = true;
+        cnd_broadcast(&pool->signal);
+        mtx_unlock(&pool->lock);
+
+        for(size_t index = 0; index < pool->thread_count; ++index) {
+            thrd_join(pool->thread[index], NULL);
+        }
+
+        cnd_destroy(&pool->signal);
+        mtx_destroy(&pool->lock);
+    }
+
+    memset(pool, 0, sizeof(*pool));
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+void nesla_pack_free(nesla_encoder_t *encoder)
+{
+    nesla_pack_wait(encoder);
+
+    while(nesla_list_get_length(&encoder->packed)) {
+        nesla_list_entry_t *entry = nesla_list_get_head(&encoder->packed);
+        nesla_packed_t *pack = entry->context;
+
+        nesla_context_free(encoder->context, pack->temporary);
+        nesla_context_free(encoder->context, pack->path);
+        nesla_context_free(encoder->context, pack->output);
+        nesla_context_free(encoder->context, pack->input);
+        nesla_context_free(encoder->context, pack);
+        nesla_list_remove(&encoder->packed, encoder->context, entry);
+    }
+}
+
+nesla_error_e nesla_pack_link(nesla_encoder_t *encoder)
+{
+    nesla_pack_t pack = {};
+    const nesla_packed_t *first = nesla_list_get_head(&encoder->packed)->context;
+    size_t blocks = 0, input = 0, output = 0, cached = 0;
+    bool preserve = encoder->preserve;
+    nesla_error_e result;
+
+    nesla_pack_wait(encoder);
+
+    for(nesla_list_entry_t *entry = nesla_list_get_head(&encoder->packed); entry; entry = entry->next) {
+        const nesla_packed_t *block = entry->context;
+
+        if(!block->output) {
+            result = NESLA_FAILURE;
+            goto exit;
+        }
+
+        if((result = nesla_encoder_set_statement(encoder, block->statement, block->output, block->output_length)) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        if(block->output_length > block->input_length) {
+            SET_WARNING_AT(encoder->context, nesla_token_get_path(block->name), nesla_token_get_line(block->name),
+                nesla_token_get_column(block->name), "Packed block grew: %s, %zu to %zu bytes",
+                nesla_literal_get(nesla_token_get_literal(block->name)), block->input_length, block->output_length);
+        }
+
+        ++blocks;
+        input += block->input_length;
+        output += block->output_length;
+        cached += block->cached;
+    }
+
+    pack.encoder = encoder;
+    pack.token = first->token;
+    pack.address = ENCODER_RELOCATE_ORIGIN;
+
+    if((result = nesla_encoder_put_relocation(encoder, first->token, encoder->program ? (encoder->program - 1) : 0, NULL, &pack.bank))
+            == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    encoder->preserve = true;
+
+    for(uint8_t mode = UNPACK_RLE; mode <= UNPACK_LZ; ++mode) {
+        uint32_t table = UNPACK_RLE_TABLE + mode;
+
+        if(!encoder->pack_count[mode]) {
+            continue;
+        }
+
+        if((result = nesla_encoder_put_label(encoder, &encoder->unpack_name[table], pack.bank, pack.address, &encoder->unpack[table]))
+                == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        ++encoder->unpack[table];
+
+        for(nesla_list_entry_t *entry = nesla_list_get_head(&encoder->packed); entry; entry = entry->next) {
+            const nesla_packed_t *block = entry->context;
+            size_t length;
+
+            if(block->mode != mode) {
+                continue;
+            }
+
+            if((result = nesla_encoder_put_code(encoder, block->token, pack.bank, pack.address, INSTRUCTION_MAX, MODE_ABSOLUTE,
+                    encoder->symbol[block->label].address, block->label, &length)) == NESLA_FAILURE) {
+                goto exit;
+            }
+
+            pack.address += length;
+        }
+    }
+
+    for(uint8_t mode = UNPACK_RLE; mode <= UNPACK_LZ; ++mode) {
+
+        if(encoder->pack_count[mode] && ((result = nesla_pack_generate(&pack, mode)) == NESLA_FAILURE)) {
+            goto exit;
+        }
+    }
+
+    encoder->context->statistics.packed += blocks;
+    encoder->context->statistics.packed_bytes += (ptrdiff_t)output - (ptrdiff_t)input;
+    encoder->context->statistics.cached += cached;
+    SET_NOTE_AT(encoder->context, nesla_token_get_path(first->token), nesla_token_get_line(first->token),
+        nesla_token_get_column(first->token), "Packed: %zu block(s), %zu bytes into %zu bytes (%zu cached), %u bytes of decompressors",
+        blocks, input, output, cached, pack.address - ENCODER_RELOCATE_ORIGIN);
+
+exit:
+    encoder->preserve = preserve;
+
+    return result;
+}
+
+nesla_error_e nesla_pack_start(nesla_encoder_t *encoder, nesla_packed_t *pack)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(!(pack->output = nesla_context_allocate(encoder->context, nesla_pack_bound(pack->input_length)))) {
+        result = SET_ERROR(encoder->context, "Failed to allocate packed block: %zu bytes", pack->input_length);
+        goto exit;
+    }
+
+    if(encoder->context->cache) {
+
+        if((result = nesla_pack_path(encoder, pack)) == NESLA_FAILURE) {
+            goto exit;
+        }
+
+        if(nesla_pack_read(pack)) {
+            goto exit;
+        }
+    }
+
+    if(!encoder->pool.started) {
+        nesla_pack_pool(&encoder->pool);
+    }
+
+    if(!encoder->pool.thread_count) {
+        nesla_pack_compress(pack);
+        goto exit;
+    }
+
+    pack->queued = NULL;
+    mtx_lock(&encoder->pool.lock);
+
+    if(encoder->pool.tail) {
+        encoder->pool.tail->queued = pack;
+    } else {
+        encoder->pool.head = pack;
+    }
+
+    encoder->pool.tail = pack;
+    cnd_signal(&encoder->pool.signal);
+    mtx_unlock(&encoder->pool.lock);
+
+exit:
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
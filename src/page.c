@@ -0,0 +1,207 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file page.c
+ * @brief Page crossing report.
+ */
+
+#include <page.h>
+
+/*!
+ * @struct nesla_page_t
+ * @brief Page crossing report context.
+ */
+typedef struct {
+    nesla_encoder_t *encoder;           /*!< Encoder context */
+    uint32_t *label;                    /*!< Statement each label is placed before, or the statement count, per symbol */
+    bool *start;                        /*!< A label is placed before the statement, per statement */
+} nesla_page_t;
+
+/*!
+ * @brief Locate page crossing report labels, finding the statement each label is placed before.
+ * @param[in,out] page Pointer to page crossing report context
+ */
+static void nesla_page_locate(nesla_page_t *page)
+{
+    const nesla_encoder_t *encoder = page->encoder;
+
+    memset(page->start, 0, encoder->statement_count * sizeof(*page->start));
+
+    for(size_t index = 0; index < encoder->symbol_count; ++index) {
+        const nesla_symbol_t *label = &encoder->symbol[index];
+
+        page->label[index] = encoder->statement_count;
+
+        if(label->constant || label->removed) {
+            continue;
+        }
+
+        if(label->anchor) {
+
+            if((label->anchor < encoder->statement_count)
+                    && (encoder->statement[label->anchor].section == encoder->statement[label->anchor - 1].section)) {
+                page->label[index] = label->anchor;
+            }
+        } else {
+
+            for(size_t section = 0; section < encoder->section_count; ++section) {
+                const nesla_statement_t *first = &encoder->statement[encoder->section[section].first];
+
+                if((first->bank == label->bank) && (first->address == label->address)) {
+                    page->label[index] = encoder->section[section].first;
+                    break;
+                }
+            }
+        }
+
+        if(page->label[index] < encoder->statement_count) {
+            page->start[page->label[index]] = true;
+        }
+    }
+}
+
+/*!
+ * @brief Find page crossing report table read by an indexed statement: the variable its operand names a byte of, or the run
+ *        of data from its operand label to the next label, instruction or origin.
+ * @param[in] page Constant pointer to page crossing report context
+ * @param[in] index Statement index
+ * @param[in,out] first Pointer to first table address
+ * @param[in,out] end Pointer to address past the end of the table
+ * @param[in,out] section Pointer to table section index, or ENCODER_UNRESOLVED for a variable
+ * @return true if the table was found, false otherwise
+ */
+static bool nesla_page_table(const nesla_page_t *page, size_t index, uint32_t *first, uint32_t *end, uint32_t *section)
+{
+    const nesla_encoder_t *encoder = page->encoder;
+    const nesla_fixup_t *fixup = nesla_encoder_get_fixup(encoder, index);
+    const nesla_symbol_t *symbol;
+    const nesla_section_t *table;
+    uint32_t statement;
+
+    if(!fixup || (fixup->index == ENCODER_UNRESOLVED)) {
+        return false;
+    }
+
+    symbol = &encoder->symbol[fixup->index];
+
+    if(symbol->variable) {
+        const nesla_variable_t *variable = &encoder->variable[symbol->variable - 1];
+
+        *first = symbol->address;
+        *end = variable->address + variable->size;
+        *section = ENCODER_UNRESOLVED;
+
+        return true;
+    }
+
+    if(symbol->constant || ((statement = page->label[fixup->index]) >= encoder->statement_count)
+            || (encoder->statement[statement].instruction != INSTRUCTION_MAX)) {
+        return false;
+    }
+
+    *section = encoder->statement[statement].section;
+    *first = encoder->statement[statement].address;
+    *end = *first;
+    table = &encoder->section[*section];
+
+    for(size_t offset = statement; (offset < (table->first + table->count)) && ((offset == statement) || !page->start[offset])
+            && (encoder->statement[offset].instruction == INSTRUCTION_MAX); ++offset) {
+        *end += encoder->statement[offset].length;
+    }
+
+    return true;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+nesla_error_e nesla_page_check(nesla_encoder_t *encoder)
+{
+    nesla_page_t page = { encoder, };
+    size_t branches = 0, reads = 0, aligned = 0;
+    const nesla_token_t *token = NULL;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(size_t index = 0; !token && (index < encoder->section_count); ++index) {
+
+        if(encoder->section[index].aligned) {
+            token = encoder->statement[encoder->section[index].first].token;
+        }
+    }
+
+    if(!token) {
+        goto exit;
+    }
+
+    if(!(page.label = nesla_context_allocate(encoder->context, encoder->symbol_count * sizeof(*page.label)))
+            || !(page.start = nesla_context_allocate(encoder->context, encoder->statement_count * sizeof(*page.start)))) {
+        result = SET_ERROR(encoder->context, "Failed to allocate page crossing report: %zu", encoder->statement_count);
+        goto exit;
+    }
+
+    nesla_page_locate(&page);
+
+    for(size_t index = 0; index < encoder->statement_count; ++index) {
+        const nesla_statement_t *statement = &encoder->statement[index];
+        bool hot = encoder->section[statement->section].aligned;
+        uint32_t first, end, section;
+        nesla_cycle_t cycle;
+
+        nesla_cycle_get(encoder, index, &cycle);
+
+        if(cycle.cross == CROSS_WILL) {
+            ++branches;
+
+            if(hot) {
+                ++aligned;
+                SET_WARNING_AT(encoder->context, nesla_token_get_path(statement->token), nesla_token_get_line(statement->token),
+                    nesla_token_get_column(statement->token), "Branch crosses a page when taken: +1 cycle");
+            }
+        } else if((cycle.cross == CROSS_MAY) && ((statement->mode == MODE_ABSOLUTE_X) || (statement->mode == MODE_ABSOLUTE_Y))
+                && nesla_page_table(&page, index, &first, &end, &section) && (end > first)
+                && ((first / PAGE_LENGTH) != ((end - 1) / PAGE_LENGTH))) {
+            ++reads;
+
+            if(hot || ((section != ENCODER_UNRESOLVED) && encoder->section[section].aligned)) {
+                ++aligned;
+                SET_WARNING_AT(encoder->context, nesla_token_get_path(statement->token), nesla_token_get_line(statement->token),
+                    nesla_token_get_column(statement->token), "Indexed read of a table crossing a page: $%04X-$%04X, +1 cycle",
+                    first, end - 1);
+            }
+        }
+    }
+
+    SET_NOTE_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+        "Page crossings: %zu branch(es), %zu indexed read(s) of a table crossing a page, %zu in or into aligned sections", branches,
+        reads, aligned);
+
+exit:
+    nesla_context_free(encoder->context, page.start);
+    nesla_context_free(encoder->context, page.label);
+
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,469 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file peephole.c
+ * @brief Peephole optimizer.
+ */
+
+#include <peephole.h>
+
+/*!
+ * @enum nesla_carry_e
+ * @brief Carry state, after an instruction falls through.
+ */
+typedef enum {
+    CARRY_KEEP = 0,                     /*!< Carry is unchanged */
+    CARRY_CLEAR,                        /*!< Carry is clear */
+    CARRY_SET,                          /*!< Carry is set */
+    CARRY_UNKNOWN,                      /*!< Carry is unknown */
+} nesla_carry_e;
+
+/*!
+ * @enum nesla_register_e
+ * @brief Register type.
+ */
+typedef enum {
+    REGISTER_NONE = 0,                  /*!< No register */
+    REGISTER_A,                         /*!< Accumulator */
+    REGISTER_X,                         /*!< X index register */
+    REGISTER_Y,                         /*!< Y index register */
+} nesla_register_e;
+
+/*!
+ * @struct nesla_peephole_t
+ * @brief Peephole optimizer context.
+ */
+typedef struct {
+    nesla_encoder_t *encoder;           /*!< Encoder context */
+    uint8_t *entry;                     /*!< Statement may be entered other than by falling through, per statement */
+} nesla_peephole_t;
+
+/*!
+ * @brief Peephole rule, rewriting a statement and the statement that follows it.
+ * @param[in,out] peephole Pointer to peephole context
+ * @param[in] first First statement index
+ * @param[in] second Second statement index
+ */
+typedef void (*nesla_peephole_rule)(nesla_peephole_t *peephole, size_t first, size_t second);
+
+/*!
+ * @brief Instruction effects, indexed by instruction type. Instructions that do not fall through leave the carry unknown.
+ */
+static const struct {
+    uint8_t carry;                      /*!< Carry state afterwards (nesla_carry_e) */
+    uint8_t flags;                      /*!< Register the N and Z flags reflect afterwards (nesla_register_e) */
+    bool store;                         /*!< Instruction stores a register, leaving registers and flags unchanged */
+} EFFECT[INSTRUCTION_MAX] = {
+    [INSTRUCTION_ADC] = { CARRY_UNKNOWN, REGISTER_A, false, }, [INSTRUCTION_AND] = { CARRY_KEEP, REGISTER_A, false, },
+    [INSTRUCTION_ASL] = { CARRY_UNKNOWN, REGISTER_NONE, false, }, [INSTRUCTION_BCC] = { CARRY_SET, REGISTER_NONE, false, },
+    [INSTRUCTION_BCS] = { CARRY_CLEAR, REGISTER_NONE, false, }, [INSTRUCTION_BRK] = { CARRY_UNKNOWN, REGISTER_NONE, false, },
+    [INSTRUCTION_CLC] = { CARRY_CLEAR, REGISTER_NONE, false, }, [INSTRUCTION_CMP] = { CARRY_UNKNOWN, REGISTER_NONE, false, },
+    [INSTRUCTION_CPX] = { CARRY_UNKNOWN, REGISTER_NONE, false, }, [INSTRUCTION_CPY] = { CARRY_UNKNOWN, REGISTER_NONE, false, },
+    [INSTRUCTION_DEX] = { CARRY_KEEP, REGISTER_X, false, }, [INSTRUCTION_DEY] = { CARRY_KEEP, REGISTER_Y, false, },
+    [INSTRUCTION_EOR] = { CARRY_KEEP, REGISTER_A, false, }, [INSTRUCTION_INX] = { CARRY_KEEP, REGISTER_X, false, },
+    [INSTRUCTION_INY] = { CARRY_KEEP, REGISTER_Y, false, }, [INSTRUCTION_JMP] = { CARRY_UNKNOWN, REGISTER_NONE, false, },
+    [INSTRUCTION_JSR] = { CARRY_UNKNOWN, REGISTER_NONE, false, }, [INSTRUCTION_LDA] = { CARRY_KEEP, REGISTER_A, false, },
+    [INSTRUCTION_LDX] = { CARRY_KEEP, REGISTER_X, false, }, [INSTRUCTION_LDY] = { CARRY_KEEP, REGISTER_Y, false, },
+    [INSTRUCTION_LSR] = { CARRY_UNKNOWN, REGISTER_NONE, false, }, [INSTRUCTION_ORA] = { CARRY_KEEP, REGISTER_A, false, },
+    [INSTRUCTION_PLA] = { CARRY_KEEP, REGISTER_A, false, }, [INSTRUCTION_PLP] = { CARRY_UNKNOWN, REGISTER_NONE, false, },
+    [INSTRUCTION_ROL] = { CARRY_UNKNOWN, REGISTER_NONE, false, }, [INSTRUCTION_ROR] = { CARRY_UNKNOWN, REGISTER_NONE, false, },
+    [INSTRUCTION_RTI] = { CARRY_UNKNOWN, REGISTER_NONE, false, }, [INSTRUCTION_RTS] = { CARRY_UNKNOWN, REGISTER_NONE, false, },
+    [INSTRUCTION_SBC] = { CARRY_UNKNOWN, REGISTER_A, false, }, [INSTRUCTION_SEC] = { CARRY_SET, REGISTER_NONE, false, },
+    [INSTRUCTION_STA] = { CARRY_KEEP, REGISTER_NONE, true, }, [INSTRUCTION_STX] = { CARRY_KEEP, REGISTER_NONE, true, },
+    [INSTRUCTION_STY] = { CARRY_KEEP, REGISTER_NONE, true, }, [INSTRUCTION_TAX] = { CARRY_KEEP, REGISTER_X, false, },
+    [INSTRUCTION_TAY] = { CARRY_KEEP, REGISTER_Y, false, }, [INSTRUCTION_TSX] = { CARRY_KEEP, REGISTER_X, false, },
+    [INSTRUCTION_TXA] = { CARRY_KEEP, REGISTER_A, false, }, [INSTRUCTION_TYA] = { CARRY_KEEP, REGISTER_A, false, },
+    };
+
+/*!
+ * @brief Get the peephole statement that follows a statement in its section, skipping removed statements.
+ * @param[in] peephole Constant pointer to peephole context
+ * @param[in] index Statement index
+ * @return Following statement index, or the statement count if there is none
+ */
+static size_t nesla_peephole_next(const nesla_peephole_t *peephole, size_t index)
+{
+    const nesla_encoder_t *encoder = peephole->encoder;
+    const nesla_section_t *section = &encoder->section[encoder->statement[index].section];
+
+    while(++index < (section->first + section->count)) {
+
+        if(encoder->statement[index].length) {
+            return index;
+        }
+    }
+
+    return encoder->statement_count;
+}
+
+/*!
+ * @brief Get the peephole statement that precedes a statement in its section, skipping removed statements.
+ * @param[in] peephole Constant pointer to peephole context
+ * @param[in] index Statement index
+ * @return Preceding statement index, or the statement count if there is none
+ */
+static size_t nesla_peephole_previous(const nesla_peephole_t *peephole, size_t index)
+{
+    const nesla_encoder_t *encoder = peephole->encoder;
+    const nesla_section_t *section = &encoder->section[encoder->statement[index].section];
+
+    while(index-- > section->first) {
+
+        if(encoder->statement[index].length) {
+            return index;
+        }
+    }
+
+    return encoder->statement_count;
+}
+
+/*!
+ * @brief Get peephole statement operand value.
+ * @param[in] peephole Constant pointer to peephole context
+ * @param[in] index Statement index
+ * @param[in,out] value Pointer to operand value
+ * @param[in,out] symbol Pointer to label index the operand references, or ENCODER_UNRESOLVED for values that never move
+ */
+static void nesla_peephole_operand(const nesla_peephole_t *peephole, size_t index, uint16_t *value, uint32_t *symbol)
+{
+    const nesla_encoder_t *encoder = peephole->encoder;
+    const nesla_statement_t *statement = &encoder->statement[index];
+    const nesla_fixup_t *fixup;
+
+    if((fixup = nesla_encoder_get_fixup(peephole->encoder, index))) {
+        *value = encoder->symbol[fixup->index].address;
+        *symbol = encoder->symbol[fixup->index].constant ? ENCODER_UNRESOLVED : fixup->index;
+    } else {
+        *value = encoder->data[statement->offset + 1] | ((statement->length == 3) ? (encoder->data[statement->offset + 2] << 8) : 0);
+        *symbol = ENCODER_UNRESOLVED;
+    }
+}
+
+/*!
+ * @brief Get the peephole statement a label is placed before.
+ * @param[in] peephole Constant pointer to peephole context
+ * @param[in] symbol Symbol index
+ * @return Statement index, or the statement count if the symbol is not a label placed before a statement
+ */
+static size_t nesla_peephole_target(const nesla_peephole_t *peephole, uint32_t symbol)
+{
+    const nesla_encoder_t *encoder = peephole->encoder;
+    const nesla_symbol_t *label = &encoder->symbol[symbol];
+    size_t index = label->anchor;
+
+    if(label->constant || !index || (index >= encoder->statement_count)
+            || (encoder->statement[index].section != encoder->statement[index - 1].section)) {
+        return encoder->statement_count;
+    }
+
+    return encoder->statement[index].length ? index : nesla_peephole_next(peephole, index);
+}
+
+/*!
+ * @brief Remove peephole statement, by giving it a length of zero.
+ * @param[in,out] peephole Pointer to peephole context
+ * @param[in] index Statement index
+ */
+static void nesla_peephole_remove(nesla_peephole_t *peephole, size_t index)
+{
+    nesla_encoder_t *encoder = peephole->encoder;
+    nesla_statement_t *statement = &encoder->statement[index];
+    nesla_fixup_t *fixup;
+
+    if((fixup = nesla_encoder_get_fixup(peephole->encoder, index))) {
+        fixup->index = ENCODER_UNRESOLVED;
+    }
+
+    encoder->section[statement->section].dirty = true;
+    encoder->context->statistics.saved_bytes += statement->length;
+    statement->length = 0;
+}
+
+/*!
+ * @brief Count peephole rewrite.
+ * @param[in,out] peephole Pointer to peephole context
+ * @param[in] cycles Cycles saved
+ */
+static void nesla_peephole_count(nesla_peephole_t *peephole, size_t cycles)
+{
+    ++peephole->encoder->context->statistics.optimized;
+    peephole->encoder->context->statistics.saved_cycles += cycles;
+}
+
+/*!
+ * @brief Rewrite peephole tail call (JSR followed by RTS) as a jump, dropping the RTS unless it is a label target.
+ * @param[in,out] peephole Pointer to peephole context
+ * @param[in] first JSR statement index
+ * @param[in] second RTS statement index
+ */
+static void nesla_peephole_tail(nesla_peephole_t *peephole, size_t first, size_t second)
+{
+    nesla_encoder_t *encoder = peephole->encoder;
+    nesla_statement_t *statement = &encoder->statement[first];
+    const nesla_opcode_t *call = nesla_opcode_get(INSTRUCTION_JSR, MODE_ABSOLUTE), *jump = nesla_opcode_get(INSTRUCTION_JMP, MODE_ABSOLUTE),
+        *exit = nesla_opcode_get(INSTRUCTION_RTS, MODE_IMPLIED);
+    size_t bytes = 0;
+
+    statement->instruction = INSTRUCTION_JMP;
+    encoder->data[statement->offset] = jump->opcode;
+
+    if(!peephole->entry[second]) {
+        bytes = encoder->statement[second].length;
+        nesla_peephole_remove(peephole, second);
+    }
+
+    nesla_peephole_count(peephole, (call->cycles + exit->cycles) - jump->cycles);
+    SET_NOTE_AT(encoder->context, nesla_token_get_path(statement->token), nesla_token_get_line(statement->token),
+        nesla_token_get_column(statement->token), "Tail call rewritten as JMP: -%zu bytes, -%u cycles", bytes,
+        (call->cycles + exit->cycles) - jump->cycles);
+}
+
+/*!
+ * @brief Drop peephole load of the RAM location just stored from the same register, if the N and Z flags already reflect
+ *        that register (the stores back to the instruction that set them are not label targets).
+ * @param[in,out] peephole Pointer to peephole context
+ * @param[in] first Store statement index
+ * @param[in] second Load statement index
+ */
+static void nesla_peephole_reload(nesla_peephole_t *peephole, size_t first, size_t second)
+{
+    uint16_t value, other;
+    uint32_t symbol, other_symbol;
+    nesla_encoder_t *encoder = peephole->encoder;
+    const nesla_statement_t *store = &encoder->statement[first], *load = &encoder->statement[second];
+    const nesla_opcode_t *opcode = nesla_opcode_get(load->instruction, load->mode);
+    nesla_register_e target = EFFECT[load->instruction].flags;
+    size_t index = first, bytes = load->length;
+    uint32_t last;
+
+    if(peephole->entry[second] || (store->mode != load->mode) || (store->mode < MODE_ZERO_PAGE) || (store->mode > MODE_ABSOLUTE_Y)) {
+        return;
+    }
+
+    nesla_peephole_operand(peephole, first, &value, &symbol);
+    nesla_peephole_operand(peephole, second, &other, &other_symbol);
+    last = value + (((store->mode == MODE_ABSOLUTE_X) || (store->mode == MODE_ABSOLUTE_Y)) ? UINT8_MAX : 0);
+
+    if((value != other) || (symbol != other_symbol)
+            || ((last >= PEEPHOLE_RAM_END) && ((value < PEEPHOLE_WRAM_BEGIN) || (last >= PEEPHOLE_WRAM_END)))) {
+        return;
+    }
+
+    for(;;) {
+
+        if(peephole->entry[index] || ((index = nesla_peephole_previous(peephole, index)) == encoder->statement_count)
+                || (encoder->statement[index].instruction == INSTRUCTION_MAX)) {
+            return;
+        }
+
+        if(EFFECT[encoder->statement[index].instruction].flags == target) {
+            break;
+        }
+
+        if(!EFFECT[encoder->statement[index].instruction].store) {
+            return;
+        }
+    }
+
+    nesla_peephole_remove(peephole, second);
+    nesla_peephole_count(peephole, opcode->cycles);
+    SET_NOTE_AT(encoder->context, nesla_token_get_path(load->token), nesla_token_get_line(load->token), nesla_token_get_column(load->token),
+        "Redundant %s removed, value already in register: -%zu bytes, -%u cycles", nesla_opcode_get_instruction(load->instruction),
+        bytes, opcode->cycles);
+}
+
+/*!
+ * @brief Rules, indexed by the instruction type of the first statement.
+ */
+static const struct {
+    uint8_t second;                     /*!< Instruction type of the second statement */
+    nesla_peephole_rule rule;           /*!< Rule, or NULL if none */
+} RULE[INSTRUCTION_MAX] = {
+    [INSTRUCTION_JSR] = { INSTRUCTION_RTS, nesla_peephole_tail, },
+    [INSTRUCTION_STA] = { INSTRUCTION_LDA, nesla_peephole_reload, },
+    [INSTRUCTION_STX] = { INSTRUCTION_LDX, nesla_peephole_reload, },
+    [INSTRUCTION_STY] = { INSTRUCTION_LDY, nesla_peephole_reload, },
+    };
+
+/*!
+ * @brief Retarget peephole jump, call or branch to a JMP (or to the same branch) at the final destination. Branches are only
+ *        retargeted within range, and keep their destination, so relaxation can undo the retargeting if layout moves the
+ *        final destination out of range.
+ * @param[in,out] peephole Pointer to peephole context
+ * @param[in] index Statement index
+ */
+static void nesla_peephole_chain(nesla_peephole_t *peephole, size_t index)
+{
+    nesla_encoder_t *encoder = peephole->encoder;
+    const nesla_statement_t *statement = &encoder->statement[index];
+    bool branch = (statement->mode == MODE_RELATIVE);
+    uint32_t symbol, target = ENCODER_UNRESOLVED;
+    size_t cycles = 0, saved = 0;
+    nesla_fixup_t *fixup;
+
+    if((!branch && (statement->instruction != INSTRUCTION_JMP) && (statement->instruction != INSTRUCTION_JSR))
+            || (statement->mode == MODE_INDIRECT)
+            || (statement->length != nesla_opcode_get(statement->instruction, statement->mode)->length)
+            || !(fixup = nesla_encoder_get_fixup(peephole->encoder, index))) {
+        return;
+    }
+
+    symbol = fixup->index;
+
+    for(size_t hop = 0; hop < PEEPHOLE_CHAIN_MAX; ++hop) {
+        const nesla_statement_t *next;
+        const nesla_fixup_t *next_fixup;
+        size_t position = nesla_peephole_target(peephole, symbol);
+        int offset;
+
+        if((position == encoder->statement_count) || (position == index)
+                || (next = &encoder->statement[position])->preserve || (next->bank != statement->bank)
+                || (next->instruction != (branch ? statement->instruction : INSTRUCTION_JMP))
+                || (next->mode == MODE_INDIRECT) || (next->length != nesla_opcode_get(next->instruction, next->mode)->length)
+                || !(next_fixup = nesla_encoder_get_fixup(peephole->encoder, position)) || (next_fixup->index == fixup->index)) {
+            break;
+        }
+
+        symbol = next_fixup->index;
+        cycles += nesla_opcode_get(next->instruction, next->mode)->cycles + (branch ? 1 : 0);
+        offset = (int)encoder->symbol[symbol].address - (int)(statement->address + statement->length);
+
+        if(!branch || ((offset >= INT8_MIN) && (offset <= INT8_MAX))) {
+            target = symbol;
+            saved = cycles;
+        }
+    }
+
+    if(target == ENCODER_UNRESOLVED) {
+        return;
+    }
+
+    fixup->chained = branch ? fixup->index : ENCODER_UNRESOLVED;
+    fixup->saved = saved;
+    fixup->index = target;
+    nesla_peephole_count(peephole, saved);
+    SET_NOTE_AT(encoder->context, nesla_token_get_path(statement->token), nesla_token_get_line(statement->token),
+        nesla_token_get_column(statement->token), "Jump chain, %s retargeted to %s: -%zu cycles",
+        nesla_opcode_get_instruction(statement->instruction), nesla_literal_get(nesla_token_get_literal(encoder->symbol[target].token)),
+        saved);
+}
+
+/*!
+ * @brief Drop peephole CLC/SEC where the carry is already known to be clear/set, tracking the carry through each section.
+ * @param[in,out] peephole Pointer to peephole context
+ */
+static void nesla_peephole_carry(nesla_peephole_t *peephole)
+{
+    nesla_encoder_t *encoder = peephole->encoder;
+    nesla_carry_e carry = CARRY_UNKNOWN;
+
+    for(size_t index = 0; index < encoder->statement_count; ++index) {
+        const nesla_statement_t *statement = &encoder->statement[index];
+        const nesla_opcode_t *opcode;
+
+        if(peephole->entry[index]) {
+            carry = CARRY_UNKNOWN;
+        }
+
+        if(!statement->length) {
+            continue;
+        }
+
+        if(statement->instruction == INSTRUCTION_MAX) {
+            carry = CARRY_UNKNOWN;
+            continue;
+        }
+
+        if(!statement->preserve && (((statement->instruction == INSTRUCTION_CLC) && (carry == CARRY_CLEAR))
+                || ((statement->instruction == INSTRUCTION_SEC) && (carry == CARRY_SET)))) {
+            opcode = nesla_opcode_get(statement->instruction, MODE_IMPLIED);
+            nesla_peephole_remove(peephole, index);
+            nesla_peephole_count(peephole, opcode->cycles);
+            SET_NOTE_AT(encoder->context, nesla_token_get_path(statement->token), nesla_token_get_line(statement->token),
+                nesla_token_get_column(statement->token), "Redundant %s removed, carry already %s: -%u bytes, -%u cycles",
+                nesla_opcode_get_instruction(statement->instruction), (carry == CARRY_CLEAR) ? "clear" : "set", opcode->length,
+                opcode->cycles);
+            continue;
+        }
+
+        if(EFFECT[statement->instruction].carry != CARRY_KEEP) {
+            carry = EFFECT[statement->instruction].carry;
+        }
+    }
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+nesla_error_e nesla_peephole_optimize(nesla_encoder_t *encoder)
+{
+    nesla_peephole_t peephole = { encoder, };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(!encoder->statement_count) {
+        goto exit;
+    }
+
+    if(!(peephole.entry = nesla_context_allocate(encoder->context, encoder->statement_count))) {
+        result = SET_ERROR(encoder->context, "Failed to allocate peephole: %zu", encoder->statement_count);
+        goto exit;
+    }
+
+    for(size_t index = 0; index < encoder->section_count; ++index) {
+        peephole.entry[encoder->section[index].first] = true;
+    }
+
+    for(size_t index = 0; index < encoder->symbol_count; ++index) {
+
+        if(!encoder->symbol[index].constant && (encoder->symbol[index].anchor < encoder->statement_count)) {
+            peephole.entry[encoder->symbol[index].anchor] = true;
+        }
+    }
+
+    for(size_t index = 0; index < encoder->statement_count; ++index) {
+        const nesla_statement_t *statement = &encoder->statement[index];
+        size_t next;
+
+        if(!statement->length || statement->preserve || (statement->instruction == INSTRUCTION_MAX)) {
+            continue;
+        }
+
+        nesla_peephole_chain(&peephole, index);
+
+        if(RULE[statement->instruction].rule && ((next = nesla_peephole_next(&peephole, index)) != encoder->statement_count)
+                && !encoder->statement[next].preserve && (encoder->statement[next].instruction == RULE[statement->instruction].second)) {
+            RULE[statement->instruction].rule(&peephole, index, next);
+        }
+    }
+
+    nesla_peephole_carry(&peephole);
+
+exit:
+    nesla_context_free(encoder->context, peephole.entry);
+
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,336 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file ram.c
+ * @brief RAM variable allocator.
+ */
+
+#include <ram.h>
+
+/*!
+ * @struct nesla_ram_span_t
+ * @brief Free RAM span.
+ */
+typedef struct {
+    uint32_t begin;                     /*!< First free address */
+    uint32_t end;                       /*!< Address past the last free address */
+} nesla_ram_span_t;
+
+/*!
+ * @struct nesla_ram_entry_t
+ * @brief Variable placement entry.
+ */
+typedef struct {
+    uint32_t variable;                  /*!< Variable index */
+    uint32_t references;                /*!< References to the variable, and to the names of its bytes */
+    uint16_t size;                      /*!< Size in bytes */
+    bool pointer;                       /*!< Variable is referenced as a pointer */
+    bool zero_page;                     /*!< Variable must be placed in zero page */
+    bool page;                          /*!< Variable must not cross a page */
+} nesla_ram_entry_t;
+
+/*!
+ * @struct nesla_ram_t
+ * @brief RAM allocator context.
+ */
+typedef struct {
+    nesla_encoder_t *encoder;           /*!< Encoder context */
+    nesla_ram_entry_t *entry;           /*!< Variable placement entries, per variable until sorted */
+    nesla_ram_span_t *span;             /*!< Free spans, by address, none spanning the end of zero page, split to place a
+                                             variable at the start of a page */
+    size_t span_count;                  /*!< Free span count */
+} nesla_ram_t;
+
+/*!
+ * @brief Add RAM free span, split at the end of zero page.
+ * @param[in,out] ram Pointer to RAM allocator context
+ * @param[in] begin First free address
+ * @param[in] end Address past the last free address
+ */
+static void nesla_ram_add(nesla_ram_t *ram, uint32_t begin, uint32_t end)
+{
+
+    if((begin < RAM_ZERO_PAGE_END) && (end > RAM_ZERO_PAGE_END)) {
+        nesla_ram_add(ram, begin, RAM_ZERO_PAGE_END);
+        begin = RAM_ZERO_PAGE_END;
+    }
+
+    ram->span[ram->span_count].begin = begin;
+    ram->span[ram->span_count++].end = end;
+}
+
+/*!
+ * @brief Compare RAM free spans, by address.
+ * @param[in] first Constant pointer to first span context
+ * @param[in] second Constant pointer to second span context
+ * @return Negative if the first span comes first, positive if the second span does, 0 otherwise
+ */
+static int nesla_ram_compare_span(const void *first, const void *second)
+{
+    const nesla_ram_span_t *left = first, *right = second;
+
+    return (left->begin > right->begin) - (left->begin < right->begin);
+}
+
+/*!
+ * @brief Compare RAM variable placement entries: pointers and zero page variables first, then by references per byte, then
+ *        by size.
+ * @param[in] first Constant pointer to first entry context
+ * @param[in] second Constant pointer to second entry context
+ * @return Negative if the first variable is placed first, positive if the second variable is, 0 otherwise
+ */
+static int nesla_ram_compare_entry(const void *first, const void *second)
+{
+    const nesla_ram_entry_t *left = first, *right = second;
+    uint64_t left_density = (uint64_t)left->references * right->size, right_density = (uint64_t)right->references * left->size;
+
+    if((left->pointer || left->zero_page) != (right->pointer || right->zero_page)) {
+        return (left->pointer || left->zero_page) ? -1 : 1;
+    }
+
+    if(left_density != right_density) {
+        return (left_density > right_density) ? -1 : 1;
+    }
+
+    if(left->size != right->size) {
+        return (left->size > right->size) ? -1 : 1;
+    }
+
+    return (left->variable > right->variable) - (left->variable < right->variable);
+}
+
+/*!
+ * @brief Count RAM variable references, marking the variables referenced as a pointer. Each far call (.FAR) counts as a
+ *        reference to the bank shadow variable, which its trampoline may keep, unless the source defined it as a constant.
+ * @param[in,out] ram Pointer to RAM allocator context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_ram_count(nesla_ram_t *ram)
+{
+    const nesla_encoder_t *encoder = ram->encoder;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(size_t index = 0; index < encoder->fixup_count; ++index) {
+        const nesla_fixup_t *fixup = &encoder->fixup[index];
+        const nesla_statement_t *statement = &encoder->statement[fixup->statement];
+        const nesla_symbol_t *symbol;
+        nesla_ram_entry_t *entry;
+
+        if((fixup->index == ENCODER_UNRESOLVED) || !(symbol = &encoder->symbol[fixup->index])->variable) {
+            continue;
+        }
+
+        entry = &ram->entry[symbol->variable - 1];
+        ++entry->references;
+
+        if((statement->instruction == INSTRUCTION_MAX) || ((statement->mode != MODE_INDIRECT_X) && (statement->mode != MODE_INDIRECT_Y))) {
+            continue;
+        }
+
+        if((symbol->address + 2) > entry->size) {
+            result = SET_ERROR_AT(encoder->context, nesla_token_get_path(fixup->symbol), nesla_token_get_line(fixup->symbol),
+                nesla_token_get_column(fixup->symbol), "Pointer variable too small: %s",
+                nesla_literal_get(nesla_token_get_literal(fixup->symbol)));
+
+            if(nesla_context_is_full(encoder->context)) {
+                break;
+            }
+        }
+
+        entry->pointer = true;
+    }
+
+    if(encoder->shadow && encoder->symbol[encoder->shadow - 1].variable) {
+        nesla_ram_entry_t *entry = &ram->entry[encoder->symbol[encoder->shadow - 1].variable - 1];
+
+        for(size_t index = 0; index < encoder->statement_count; ++index) {
+
+            if(encoder->statement[index].far) {
+                ++entry->references;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*!
+ * @brief Find RAM free spans, in the regions given, or in internal RAM outside of the stack if none are.
+ * @param[in,out] ram Pointer to RAM allocator context
+ */
+static void nesla_ram_find(nesla_ram_t *ram)
+{
+    const nesla_encoder_t *encoder = ram->encoder;
+    size_t count = 0;
+
+    if(!encoder->region_count) {
+        nesla_ram_add(ram, 0, RAM_STACK_BEGIN);
+        nesla_ram_add(ram, RAM_STACK_END, RAM_END);
+    }
+
+    for(size_t index = 0; index < encoder->region_count; ++index) {
+        nesla_ram_add(ram, encoder->region[index].first, encoder->region[index].last + 1);
+    }
+
+    qsort(ram->span, ram->span_count, sizeof(*ram->span), nesla_ram_compare_span);
+
+    for(size_t index = 0; index < ram->span_count; ++index) {
+        nesla_ram_span_t *span = &ram->span[index];
+
+        if(count && (span->begin < ram->span[count - 1].end)) {
+
+            if(span->end > ram->span[count - 1].end) {
+                ram->span[count - 1].end = span->end;
+            }
+        } else {
+            ram->span[count++] = *span;
+        }
+    }
+
+    ram->span_count = count;
+}
+
+/*!
+ * @brief Place RAM variable, in the first free span it fits in. A variable that must not cross a page, and does not fit in the
+ *        page a span starts in, is placed at the start of the next page, leaving the bytes before it free.
+ * @param[in,out] ram Pointer to RAM allocator context
+ * @param[in] entry Constant pointer to variable placement entry context
+ * @param[in,out] address Pointer to variable address
+ * @return true if the variable was placed, false if no free span fits it
+ */
+static bool nesla_ram_place(nesla_ram_t *ram, const nesla_ram_entry_t *entry, uint16_t *address)
+{
+
+    for(size_t index = 0; index < ram->span_count; ++index) {
+        nesla_ram_span_t *span = &ram->span[index];
+        uint32_t begin = span->begin;
+
+        if((entry->pointer || entry->zero_page) && (span->end > RAM_ZERO_PAGE_END)) {
+            break;
+        }
+
+        if(entry->page && (((begin % RAM_PAGE_SIZE) + entry->size) > RAM_PAGE_SIZE)) {
+            begin += RAM_PAGE_SIZE - (begin % RAM_PAGE_SIZE);
+        }
+
+        if((span->end < begin) || ((span->end - begin) < entry->size)) {
+            continue;
+        }
+
+        if(begin > span->begin) {
+            memmove(span + 1, span, (ram->span_count++ - index) * sizeof(*span));
+            span->end = begin;
+            ++span;
+        }
+
+        *address = begin;
+        span->begin = begin + entry->size;
+
+        return true;
+    }
+
+    return false;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+nesla_error_e nesla_ram_allocate(nesla_encoder_t *encoder)
+{
+    nesla_ram_t ram = { encoder, };
+    size_t zero_page = 0, above = 0;
+    nesla_error_e result;
+
+    if(!(ram.entry = nesla_context_allocate(encoder->context, encoder->variable_count * sizeof(*ram.entry)))
+            || !(ram.span = nesla_context_allocate(encoder->context,
+                ((encoder->region_count + 2) * 2 + encoder->variable_count) * sizeof(*ram.span)))) {
+        result = SET_ERROR(encoder->context, "Failed to allocate RAM allocator: %zu", encoder->variable_count);
+        goto exit;
+    }
+
+    for(size_t index = 0; index < encoder->variable_count; ++index) {
+        ram.entry[index].variable = index;
+        ram.entry[index].size = encoder->variable[index].size;
+        ram.entry[index].zero_page = encoder->variable[index].zero_page;
+        ram.entry[index].page = encoder->variable[index].page;
+    }
+
+    if(((result = nesla_ram_count(&ram)) == NESLA_FAILURE) && nesla_context_is_full(encoder->context)) {
+        goto exit;
+    }
+
+    nesla_ram_find(&ram);
+    qsort(ram.entry, encoder->variable_count, sizeof(*ram.entry), nesla_ram_compare_entry);
+
+    for(size_t index = 0; index < encoder->variable_count; ++index) {
+        const nesla_ram_entry_t *entry = &ram.entry[index];
+        nesla_variable_t *variable = &encoder->variable[entry->variable];
+
+        variable->references = entry->references;
+        variable->pointer = entry->pointer;
+
+        if(!nesla_ram_place(&ram, entry, &variable->address)) {
+            result = SET_ERROR_AT(encoder->context, nesla_token_get_path(variable->token), nesla_token_get_line(variable->token),
+                nesla_token_get_column(variable->token), "Out of %s for variable: %s (%u byte(s))",
+                (entry->pointer || entry->zero_page) ? "zero page" : "RAM",
+                nesla_literal_get(nesla_token_get_literal(variable->token)), variable->size);
+
+            if(nesla_context_is_full(encoder->context)) {
+                goto exit;
+            }
+
+            continue;
+        }
+
+        if(variable->address < RAM_ZERO_PAGE_END) {
+            zero_page += variable->size;
+        } else {
+            above += variable->size;
+        }
+    }
+
+    for(size_t index = 0; index < encoder->symbol_count; ++index) {
+        nesla_symbol_t *symbol = &encoder->symbol[index];
+
+        if(symbol->variable) {
+            symbol->address += encoder->variable[symbol->variable - 1].address;
+        }
+    }
+
+    if(result == NESLA_SUCCESS) {
+        const nesla_token_t *token = encoder->variable[0].token;
+
+        SET_NOTE_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Variables placed: %zu, %zu byte(s) in zero page, %zu byte(s) above", encoder->variable_count, zero_page, above);
+    }
+
+exit:
+    nesla_context_free(encoder->context, ram.span);
+    nesla_context_free(encoder->context, ram.entry);
+
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,230 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file stack.c
+ * @brief Hardware stack depth analysis.
+ */
+
+#include <stack.h>
+
+#define STACK_UNSET INT32_MIN           /*!< Statement not reached */
+
+/*!
+ * @struct nesla_stack_t
+ * @brief Stack analysis context.
+ */
+typedef struct {
+    nesla_encoder_t *encoder;           /*!< Encoder context */
+    nesla_graph_t graph;                /*!< Control-flow graph */
+    int32_t *depth;                     /*!< Most bytes pushed before the statement executes, per statement */
+    size_t *usage;                      /*!< Most bytes a subroutine pushes, with its callees, per entry statement */
+} nesla_stack_t;
+
+/*!
+ * @brief Measure stack subroutine of the last walk, over the deepest point of any path from its entry.
+ * @param[in,out] context Pointer to stack context
+ * @param[in] entry Entry statement index
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_stack_deepest(void *context, uint32_t entry)
+{
+    nesla_stack_t *stack = context;
+    const nesla_graph_t *graph = &stack->graph;
+    const nesla_encoder_t *encoder = stack->encoder;
+    int32_t usage = 0;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(size_t position = 0; position < graph->order_count; ++position) {
+        stack->depth[graph->order[position]] = STACK_UNSET;
+    }
+
+    stack->depth[entry] = 0;
+
+    for(size_t position = 0; position < graph->order_count; ++position) {
+        nesla_edge_t edge[GRAPH_EDGE_MAX];
+        uint32_t statement = graph->order[position];
+        int32_t depth = stack->depth[statement], peak = depth, next = depth;
+        size_t count;
+
+        if(depth == STACK_UNSET) {
+            continue;
+        }
+
+        count = nesla_graph_get_edges(graph, statement, edge);
+
+        switch(encoder->statement[statement].instruction) {
+            case INSTRUCTION_BRK:
+                peak = depth + STACK_FRAME_INTERRUPT;
+                break;
+            case INSTRUCTION_JSR:
+                peak = depth + STACK_FRAME_CALL + stack->usage[edge[0].statement];
+                break;
+            case INSTRUCTION_PHA:
+            case INSTRUCTION_PHP:
+                peak = next = depth + 1;
+                break;
+            case INSTRUCTION_PLA:
+            case INSTRUCTION_PLP:
+                next = depth - 1;
+                break;
+            case INSTRUCTION_TXS:
+                next = 0;
+                break;
+            default:
+                break;
+        }
+
+        if(peak > usage) {
+            usage = peak;
+        }
+
+        for(size_t current = 0; current < count; ++current) {
+            uint32_t target = edge[current].statement;
+
+            if(edge[current].type == EDGE_CALL) {
+                continue;
+            }
+
+            if(graph->position[target] > position) {
+
+                if(next > stack->depth[target]) {
+                    stack->depth[target] = next;
+                }
+            } else if(next > stack->depth[target]) {
+                const nesla_token_t *token = encoder->statement[statement].token;
+
+                result = SET_ERROR_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token),
+                    nesla_token_get_column(token), "Stack grows on each pass of the loop: %i byte(s)", next - stack->depth[target]);
+                goto exit;
+            }
+        }
+    }
+
+    stack->usage[entry] = usage;
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Measure stack usage from an interrupt vector, with the frame the interrupt pushes.
+ * @param[in,out] stack Pointer to stack context
+ * @param[in] vector Vector address
+ * @param[in] frame Bytes pushed on entry
+ * @param[in,out] usage Pointer to usage in bytes, or 0 if the vector is not placed
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_stack_vector(nesla_stack_t *stack, uint16_t vector, size_t frame, size_t *usage)
+{
+    size_t bank;
+    uint32_t entry;
+    uint16_t address;
+    const nesla_token_t *token = stack->encoder->stack;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    *usage = 0;
+
+    if(!nesla_graph_get_vector(&stack->graph, vector, &bank, &address)) {
+
+        if(vector == GRAPH_VECTOR_RESET) {
+            result = SET_ERROR_AT(stack->encoder->context, nesla_token_get_path(token), nesla_token_get_line(token),
+                nesla_token_get_column(token), "Reset vector not found: $%04X", vector);
+        }
+        goto exit;
+    }
+
+    if((entry = nesla_graph_find(&stack->graph, bank, address)) == ENCODER_UNRESOLVED) {
+        result = SET_ERROR_AT(stack->encoder->context, nesla_token_get_path(token), nesla_token_get_line(token),
+            nesla_token_get_column(token), "Handler is not an instruction: $%04X", address);
+        goto exit;
+    }
+
+    if((result = nesla_graph_measure(&stack->graph, entry, nesla_stack_deepest, stack)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    *usage = frame + stack->usage[entry];
+
+exit:
+    return result;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+nesla_error_e nesla_stack_check(nesla_encoder_t *encoder)
+{
+    size_t count = encoder->statement_count + 1, irq = 0, nmi = 0, reset = 0, total;
+    nesla_stack_t stack = { encoder, };
+    const nesla_token_t *token = encoder->stack;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(!token) {
+        goto exit;
+    }
+
+    if(!(stack.depth = nesla_context_allocate(encoder->context, count * sizeof(*stack.depth)))
+            || !(stack.usage = nesla_context_allocate(encoder->context, count * sizeof(*stack.usage)))) {
+        result = SET_ERROR(encoder->context, "Failed to allocate stack: %zu", encoder->statement_count);
+        goto exit;
+    }
+
+    if((result = nesla_graph_initialize(&stack.graph, encoder)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if(nesla_stack_vector(&stack, GRAPH_VECTOR_RESET, 0, &reset) == NESLA_FAILURE) {
+        result = NESLA_FAILURE;
+    }
+
+    if(nesla_stack_vector(&stack, GRAPH_VECTOR_IRQ, STACK_FRAME_INTERRUPT, &irq) == NESLA_FAILURE) {
+        result = NESLA_FAILURE;
+    }
+
+    if(nesla_stack_vector(&stack, GRAPH_VECTOR_NMI, STACK_FRAME_INTERRUPT, &nmi) == NESLA_FAILURE) {
+        result = NESLA_FAILURE;
+    }
+
+    if(result == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if((total = reset + irq + nmi) > encoder->stack_size) {
+        SET_WARNING_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Stack budget exceeded: up to %zu of %u bytes (reset %zu, IRQ %zu, NMI %zu)", total, encoder->stack_size, reset, irq, nmi);
+    } else {
+        SET_NOTE_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Stack budget: up to %zu of %u bytes (reset %zu, IRQ %zu, NMI %zu)", total, encoder->stack_size, reset, irq, nmi);
+    }
+
+exit:
+    nesla_graph_uninitialize(&stack.graph);
+    nesla_context_free(encoder->context, stack.usage);
+    nesla_context_free(encoder->context, stack.depth);
+
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
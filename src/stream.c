@@ -35,6 +35,11 @@ uint8_t nesla_stream_get(const nesla_stream_t *stream)
     return stream->character;
 }
 
+size_t nesla_stream_get_column(const nesla_stream_t *stream)
+{
+    return stream->column;
+}
+
 size_t nesla_stream_get_line(const nesla_stream_t *stream)
 {
     return stream->line;
@@ -60,30 +65,64 @@ nesla_character_e nesla_stream_get_type(const nesla_stream_t *stream)
     return result;
 }
 
-nesla_error_e nesla_stream_initialize(nesla_stream_t *stream, const char *path)
+/*!
+ * @brief Move stream context to its first character, failing if the stream is empty. The length is never probed,
+ *        so pipes are supported.
+ * @param[in,out] stream Pointer to stream context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_stream_start(nesla_stream_t *stream)
 {
-    size_t length = 0;
-    nesla_error_e result;
+    nesla_error_e result = NESLA_SUCCESS;
 
-    if((result = nesla_reader_open(&stream->reader, path)) == NESLA_FAILURE) {
+    if(nesla_stream_reset(stream) == NESLA_FAILURE) {
+        result = nesla_stream_is_failed(stream) ? NESLA_FAILURE
+            : SET_ERROR(stream->context, "Empty file: %s", nesla_reader_get_path(&stream->reader));
         goto exit;
     }
 
-    if((result = nesla_reader_get_length(&stream->reader, &length)) == NESLA_FAILURE) {
+exit:
+    return result;
+}
+
+nesla_error_e nesla_stream_initialize(nesla_stream_t *stream, nesla_context_t *context, const char *path)
+{
+    nesla_error_e result;
+
+    stream->context = context;
+
+    if((result = nesla_reader_open(&stream->reader, context, path)) == NESLA_FAILURE) {
         goto exit;
     }
 
-    if(!length) {
-        result = SET_ERROR("Empty file: %s", path);
+    result = nesla_stream_start(stream);
+
+exit:
+    return result;
+}
+
+nesla_error_e nesla_stream_initialize_buffer(nesla_stream_t *stream, nesla_context_t *context, const char *path, const uint8_t *data,
+    size_t length)
+{
+    nesla_error_e result;
+
+    stream->context = context;
+
+    if((result = nesla_reader_open_buffer(&stream->reader, context, path, data, length)) == NESLA_FAILURE) {
         goto exit;
     }
 
-    result = nesla_stream_reset(stream);
+    result = nesla_stream_start(stream);
 
 exit:
     return result;
 }
 
+bool nesla_stream_is_failed(const nesla_stream_t *stream)
+{
+    return nesla_reader_is_failed(&stream->reader);
+}
+
 nesla_error_e nesla_stream_next(nesla_stream_t *stream)
 {
 
@@ -91,9 +130,13 @@ nesla_error_e nesla_stream_next(nesla_stream_t *stream)
 
         if(stream->character == '\n') {
             ++stream->line;
+            stream->column = 1;
+        } else {
+            ++stream->column;
         }
     } else {
         stream->line = 1;
+        stream->column = 1;
     }
 
     return nesla_reader_get(&stream->reader, &stream->character, 1);
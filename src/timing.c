@@ -0,0 +1,361 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file timing.c
+ * @brief Worst-case timing analysis.
+ */
+
+#include <timing.h>
+
+#define TIMING_UNSET SIZE_MAX           /*!< Statement not reached */
+
+/*!
+ * @struct nesla_timing_t
+ * @brief Timing analysis context.
+ */
+typedef struct {
+    nesla_encoder_t *encoder;           /*!< Encoder context */
+    nesla_graph_t graph;                /*!< Control-flow graph */
+    size_t *cost;                       /*!< Most cycles before the statement executes, per statement */
+    size_t *extra;                      /*!< Cycles spent looping, paid as the loop head executes, per statement */
+    size_t *cycles;                     /*!< Most cycles a subroutine takes, through its return, per entry statement */
+    uint32_t *end;                      /*!< Statement its longest path ends on, per entry statement */
+} nesla_timing_t;
+
+/*!
+ * @brief Get timing edges leaving a statement, with the cycles the statement takes along each. A JSR takes the cycles of the
+ *        subroutine it calls along its return edge.
+ * @param[in] timing Constant pointer to timing context
+ * @param[in] index Statement index
+ * @param[in,out] edge Pointer to edge array, of GRAPH_EDGE_MAX entries
+ * @param[in,out] weight Pointer to cycle array, of GRAPH_EDGE_MAX entries, holding the cycles taken to return if there are no edges
+ * @return Edge count
+ */
+static size_t nesla_timing_edges(const nesla_timing_t *timing, uint32_t index, nesla_edge_t *edge, size_t *weight)
+{
+    nesla_cycle_t cycle;
+    const nesla_statement_t *statement = &timing->encoder->statement[index];
+    size_t count = nesla_graph_get_edges(&timing->graph, index, edge);
+
+    nesla_cycle_get(timing->encoder, index, &cycle);
+    weight[0] = cycle.maximum;
+
+    for(size_t current = 0; current < count; ++current) {
+
+        switch(edge[current].type) {
+            case EDGE_NEXT:
+                weight[current] = (statement->mode == MODE_RELATIVE) ? cycle.minimum : cycle.maximum;
+
+                if(statement->instruction == INSTRUCTION_JSR) {
+                    weight[current] += timing->cycles[edge[0].statement];
+                }
+                break;
+            default:
+                weight[current] = cycle.maximum;
+                break;
+        }
+    }
+
+    return count;
+}
+
+/*!
+ * @brief Get timing loop bound. The bound is placed on the branch that loops back, or, for a loop entered at its test (the
+ *        edge back to its head falls through), on the branch from the test into its body.
+ * @param[in] timing Constant pointer to timing context
+ * @param[in] loop Constant pointer to loop context
+ * @return Times the loop may go back to its head, or 0 if unbounded
+ */
+static uint16_t nesla_timing_bound(const nesla_timing_t *timing, const nesla_graph_loop_t *loop)
+{
+    const nesla_statement_t *statement = timing->encoder->statement;
+
+    if(statement[loop->source].bound) {
+        return statement[loop->source].bound;
+    }
+
+    for(size_t position = timing->graph.position[loop->source]; position-- > timing->graph.position[loop->target];) {
+        nesla_edge_t edge[GRAPH_EDGE_MAX];
+        uint32_t index = timing->graph.order[position];
+        size_t count;
+
+        if(!statement[index].bound) {
+            continue;
+        }
+
+        count = nesla_graph_get_edges(&timing->graph, index, edge);
+
+        for(size_t current = 0; current < count; ++current) {
+
+            if((edge[current].type == EDGE_BRANCH) && (timing->graph.position[edge[current].statement] > position)
+                    && (timing->graph.position[edge[current].statement] <= timing->graph.position[loop->source])) {
+                return statement[index].bound;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*!
+ * @brief Measure timing loops of the last walk, innermost first. Each loop head pays the cycles of every time its loop may
+ *        go back to it, each taking the longest pass from the head back to it.
+ * @param[in,out] timing Pointer to timing context
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_timing_loops(nesla_timing_t *timing)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(size_t position = 0; position < timing->graph.order_count; ++position) {
+        timing->extra[timing->graph.order[position]] = 0;
+    }
+
+    for(size_t index = 0; index < timing->graph.loop_count; ++index) {
+        const nesla_graph_loop_t *loop = &timing->graph.loop[index];
+        size_t first = timing->graph.position[loop->target], last = timing->graph.position[loop->source], pass = 0;
+        uint16_t bound;
+
+        if(!(bound = nesla_timing_bound(timing, loop))) {
+            const nesla_token_t *token = timing->encoder->statement[loop->source].token;
+
+            result = SET_ERROR_AT(timing->encoder->context, nesla_token_get_path(token), nesla_token_get_line(token),
+                nesla_token_get_column(token), "Loop without a bound (.LOOP)");
+            goto exit;
+        }
+
+        for(size_t position = first; position <= last; ++position) {
+            timing->cost[timing->graph.order[position]] = TIMING_UNSET;
+        }
+
+        timing->cost[loop->target] = 0;
+
+        for(size_t position = first; position <= last; ++position) {
+            size_t count, cost, weight[GRAPH_EDGE_MAX];
+            nesla_edge_t edge[GRAPH_EDGE_MAX];
+            uint32_t statement = timing->graph.order[position];
+
+            if((cost = timing->cost[statement]) == TIMING_UNSET) {
+                continue;
+            }
+
+            count = nesla_timing_edges(timing, statement, edge, weight);
+            cost += (statement != loop->target) ? timing->extra[statement] : 0;
+
+            for(size_t current = 0; current < count; ++current) {
+                uint32_t target = edge[current].statement;
+
+                if(edge[current].type == EDGE_CALL) {
+                    continue;
+                }
+
+                if(timing->graph.position[target] <= position) {
+
+                    if((statement == loop->source) && (target == loop->target) && ((cost + weight[current]) > pass)) {
+                        pass = cost + weight[current];
+                    }
+                } else if((timing->graph.position[target] <= last)
+                        && ((timing->cost[target] == TIMING_UNSET) || ((cost + weight[current]) > timing->cost[target]))) {
+                    timing->cost[target] = cost + weight[current];
+                }
+            }
+        }
+
+        timing->extra[loop->target] += bound * pass;
+    }
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Measure timing subroutine of the last walk, over the longest path from its entry to a return. Loops are measured first.
+ * @param[in,out] context Pointer to timing context
+ * @param[in] entry Entry statement index
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_timing_longest(void *context, uint32_t entry)
+{
+    nesla_timing_t *timing = context;
+    bool found = false;
+    nesla_error_e result;
+
+    if((result = nesla_timing_loops(timing)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    for(size_t position = 0; position < timing->graph.order_count; ++position) {
+        timing->cost[timing->graph.order[position]] = TIMING_UNSET;
+    }
+
+    timing->cost[entry] = 0;
+    timing->cycles[entry] = 0;
+    timing->end[entry] = entry;
+
+    for(size_t position = 0; position < timing->graph.order_count; ++position) {
+        size_t count, cost, weight[GRAPH_EDGE_MAX];
+        nesla_edge_t edge[GRAPH_EDGE_MAX];
+        uint32_t statement = timing->graph.order[position];
+
+        if((cost = timing->cost[statement]) == TIMING_UNSET) {
+            continue;
+        }
+
+        cost += timing->extra[statement];
+
+        if(!(count = nesla_timing_edges(timing, statement, edge, weight))) {
+
+            if(!found || ((cost + weight[0]) > timing->cycles[entry])) {
+                timing->cycles[entry] = cost + weight[0];
+                timing->end[entry] = statement;
+                found = true;
+            }
+            continue;
+        }
+
+        for(size_t current = 0; current < count; ++current) {
+            uint32_t target = edge[current].statement;
+
+            if((edge[current].type != EDGE_CALL) && (timing->graph.position[target] > position)
+                    && ((timing->cost[target] == TIMING_UNSET) || ((cost + weight[current]) > timing->cost[target]))) {
+                timing->cost[target] = cost + weight[current];
+            }
+        }
+    }
+
+    if(!found) {
+        const nesla_token_t *token = timing->encoder->statement[entry].token;
+
+        result = SET_ERROR_AT(timing->encoder->context, nesla_token_get_path(token), nesla_token_get_line(token),
+            nesla_token_get_column(token), "No path returns: $%04X", timing->encoder->statement[entry].address);
+    }
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Find timing budget handler entry, at its label or where the NMI vector points.
+ * @param[in,out] timing Pointer to timing context
+ * @param[in] budget Constant pointer to budget context
+ * @param[in,out] entry Pointer to entry statement index
+ * @return NESLA_ERROR on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_timing_entry(nesla_timing_t *timing, const nesla_budget_t *budget, uint32_t *entry)
+{
+    size_t bank = 0;
+    uint16_t address = 0;
+    const nesla_token_t *token = budget->symbol ? budget->symbol : budget->token;
+    const nesla_encoder_t *encoder = timing->encoder;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(budget->symbol) {
+        const nesla_symbol_t *symbol;
+
+        if(!(symbol = nesla_encoder_get_symbol(encoder, budget->symbol, budget->scope)) || symbol->constant) {
+            result = SET_ERROR_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+                "Undefined label: %s", nesla_literal_get(nesla_token_get_literal(token)));
+            goto exit;
+        }
+
+        bank = symbol->bank;
+        address = symbol->address;
+    } else if(!nesla_graph_get_vector(&timing->graph, GRAPH_VECTOR_NMI, &bank, &address)) {
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "NMI vector not found: $%04X", GRAPH_VECTOR_NMI);
+        goto exit;
+    }
+
+    if((*entry = nesla_graph_find(&timing->graph, bank, address)) == ENCODER_UNRESOLVED) {
+        result = SET_ERROR_AT(encoder->context, nesla_token_get_path(token), nesla_token_get_line(token), nesla_token_get_column(token),
+            "Handler is not an instruction: $%04X", address);
+    }
+
+exit:
+    return result;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+nesla_error_e nesla_timing_check(nesla_encoder_t *encoder)
+{
+    size_t count = encoder->statement_count + 1;
+    nesla_timing_t timing = { encoder, };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(!encoder->budget_count) {
+        goto exit;
+    }
+
+    if(!(timing.cost = nesla_context_allocate(encoder->context, count * sizeof(*timing.cost)))
+            || !(timing.extra = nesla_context_allocate(encoder->context, count * sizeof(*timing.extra)))
+            || !(timing.cycles = nesla_context_allocate(encoder->context, count * sizeof(*timing.cycles)))
+            || !(timing.end = nesla_context_allocate(encoder->context, count * sizeof(*timing.end)))) {
+        result = SET_ERROR(encoder->context, "Failed to allocate timing: %zu", encoder->statement_count);
+        goto exit;
+    }
+
+    if((result = nesla_graph_initialize(&timing.graph, encoder)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    for(size_t index = 0; index < encoder->budget_count; ++index) {
+        const nesla_budget_t *budget = &encoder->budget[index];
+        const char *name = budget->symbol ? (const char *)nesla_literal_get(nesla_token_get_literal(budget->symbol)) : "NMI handler";
+        const nesla_token_t *end;
+        uint32_t entry;
+
+        if((nesla_timing_entry(&timing, budget, &entry) == NESLA_FAILURE)
+                || (nesla_graph_measure(&timing.graph, entry, nesla_timing_longest, &timing) == NESLA_FAILURE)) {
+            result = NESLA_FAILURE;
+            continue;
+        }
+
+        if(timing.cycles[entry] > budget->cycles) {
+            end = encoder->statement[timing.end[entry]].token;
+            result = SET_ERROR_AT(encoder->context, nesla_token_get_path(budget->token), nesla_token_get_line(budget->token),
+                nesla_token_get_column(budget->token), "Cycle budget exceeded: %s takes up to %zu of %u cycles", name,
+                timing.cycles[entry], budget->cycles);
+            SET_NOTE_AT(encoder->context, nesla_token_get_path(end), nesla_token_get_line(end), nesla_token_get_column(end),
+                "Longest path through %s ends here", name);
+        } else {
+            SET_NOTE_AT(encoder->context, nesla_token_get_path(budget->token), nesla_token_get_line(budget->token),
+                nesla_token_get_column(budget->token), "Cycle budget: %s takes up to %zu of %u cycles", name, timing.cycles[entry],
+                budget->cycles);
+        }
+    }
+
+exit:
+    nesla_graph_uninitialize(&timing.graph);
+    nesla_context_free(encoder->context, timing.end);
+    nesla_context_free(encoder->context, timing.cycles);
+    nesla_context_free(encoder->context, timing.extra);
+    nesla_context_free(encoder->context, timing.cost);
+
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
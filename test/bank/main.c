@@ -0,0 +1,180 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file main.c
+ * @brief Relocatable section bank placement tests.
+ */
+
+#include <bank.h>
+#include <test.h>
+#include <assemble.h>
+
+static nesla_test_assembly_t g_test = {};   /*!< Test assembly context */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Test relocatable section placement into the bank of the calls they make, over the first bank with room.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_bank_call(void)
+{
+    static const uint8_t EXPECTED[] = { 0x60, 0xA9, 0x01, 0x20, 0x00, 0x80, 0x60, };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, ".PRG 4\n.BANK 3\n.ORG $C000\nreset:\nRTS\n.RELOC\ncaller:\nLDA #1\nJSR other\nRTS\n"
+                ".BANK 2\n.ORG $8000\nother:\nRTS\n.BANK 3\n" TEST_VECTORS, 0) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE,
+                "Sections placed: 1 in 1 bank(s), 0 call(s) into another switched bank, 1 avoided over first fit") == 1)
+            && nesla_test_match(&g_test, 2, 0x8000, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test relocatable section placement, of a section given a bank, a section placed in the bank of a label, and a
+ *        cluster of sections that call each other.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_bank_cluster(void)
+{
+    static const uint8_t EXPECTED[] = {
+        0xA9, 0x02, 0x60, 0xA9, 0x04, 0x60, 0xA9, 0x01, 0x20, 0x0C, 0x80, 0x60, 0xA9, 0x03, 0x20, 0x04, 0xC0, 0x60,
+        };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, ".PRG 4\n.BANK 3\n.ORG $C000\nreset:\nJSR fixed\nRTS\nfixed:\nRTS\n.RELOC\nfirst:\nLDA #1\n"
+                "JSR second\nRTS\n.RELOC 1\npinned:\nLDA #2\nRTS\n.RELOC\nsecond:\nLDA #3\nJSR fixed\nRTS\n.RELOC pinned\nnear:\nLDA #4\n"
+                "RTS\n.BANK 2\n.ORG $8000\nother:\nLDA #5\nRTS\n.BANK 3\n" TEST_VECTORS, 0) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE,
+                "Sections placed: 4 in 1 bank(s), 0 call(s) into another switched bank, 0 avoided over first fit") == 1)
+            && nesla_test_match(&g_test, 1, 0x8000, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test relocatable sections given a bank that does not exist, or the bank of an undefined label.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_bank_invalid(void)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, ".PRG 4\n.BANK 3\n.ORG $C000\nreset:\nRTS\n.RELOC 7\nsection:\nRTS\n.BANK 3\n" TEST_VECTORS, 0)
+                == NESLA_FAILURE)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, "Invalid bank: 7") == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble(&g_test, ".PRG 4\n.BANK 3\n.ORG $C000\nreset:\nRTS\n.RELOC label\nsection:\nRTS\n.BANK 3\n"
+                TEST_VECTORS, 0) == NESLA_FAILURE)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, "Undefined label: label") == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test relocatable section placement into the free space left around code placed with .ORG.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_bank_space(void)
+{
+    static const char *PREFIX = ".PRG 1\n.BANK 0\n.ORG $C000\nreset:\nRTS\n";
+    static const char *SUFFIX = ".RELOC\nsection:\nLDA #1\nRTS\n.BANK 0\n" TEST_VECTORS;
+    static const uint8_t EXPECTED[] = { 0xA9, 0x01, 0x60, 0x00, 0xC0, };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble_fill(&g_test, 0, PREFIX, 0xFFF7 - 0xC001, SUFFIX) == NESLA_SUCCESS)
+            && nesla_test_match(&g_test, 0, 0xFFF7, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble_fill(&g_test, 0, PREFIX, 0xFFF8 - 0xC001, SUFFIX) == NESLA_FAILURE)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, "Out of program bank space: 3 bytes") == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble_fill(&g_test, 0, ".PRG 2\n.BANK 1\n.ORG $C000\nreset:\nRTS\n.RELOC\nsection:\n", 16385,
+                ".BANK 1\n" TEST_VECTORS) == NESLA_FAILURE)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, "Relocatable section longer than a bank: 16385 bytes") == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+int main(void)
+{
+    static const test TEST[] = {
+        nesla_test_bank_call,
+        nesla_test_bank_cluster,
+        nesla_test_bank_invalid,
+        nesla_test_bank_space,
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(int index = 0; index < TEST_COUNT(TEST); ++index) {
+
+        if(TEST[index]() == NESLA_FAILURE) {
+            result = NESLA_FAILURE;
+        }
+    }
+
+    return (int)result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,255 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file main.c
+ * @brief Binary file tests.
+ */
+
+#include <common.h>
+#include <test.h>
+
+#define TEST_DESCRIPTOR 3       /*!< Mapped file descriptor */
+#define TEST_LENGTH 16          /*!< Mapped file length in bytes */
+#define TEST_PATH "test.bin"    /*!< Mapped file path */
+
+/*!
+ * @struct nesla_test_t
+ * @brief Test contexts.
+ */
+typedef struct {
+    nesla_binary_t binary;          /*!< Binary context */
+    uint8_t data[TEST_LENGTH];      /*!< Mapped file data */
+    bool fail;                      /*!< Fail mapping */
+} nesla_test_t;
+
+static nesla_test_t g_test = {};    /*!< Test context */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+nesla_error_e nesla_context_map(nesla_context_t *context, const char *path, const uint8_t **data, size_t *length, int *descriptor)
+{
+
+    if(g_test.fail || strcmp(path, TEST_PATH)) {
+        return NESLA_FAILURE;
+    }
+
+    *data = g_test.data;
+    *length = sizeof(g_test.data);
+    *descriptor = TEST_DESCRIPTOR;
+
+    return NESLA_SUCCESS;
+}
+
+nesla_error_e nesla_set_error(nesla_context_t *context, const char *file, const char *function, int line, const char *format, ...)
+{
+    return NESLA_FAILURE;
+}
+
+/*!
+ * @brief Initialize test.
+ */
+static void nesla_test_initialize(void)
+{
+    memset(&g_test, 0, sizeof(g_test));
+
+    for(size_t index = 0; index < TEST_LENGTH; ++index) {
+        g_test.data[index] = index;
+    }
+}
+
+/*!
+ * @brief Test binary slice, against the test data.
+ * @param[in] offset Expected slice offset in bytes
+ * @param[in] length Expected slice length in bytes
+ * @return true if the binary context views the slice, false otherwise
+ */
+static bool nesla_test_slice(size_t offset, size_t length)
+{
+    return (nesla_binary_get(&g_test.binary) == g_test.data + offset)
+        && (nesla_binary_get_offset(&g_test.binary) == offset)
+        && (nesla_binary_get_length(&g_test.binary) == length)
+        && !strcmp(nesla_binary_get_path(&g_test.binary), TEST_PATH);
+}
+
+/*!
+ * @brief Test binary close.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_binary_close(void)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    nesla_test_initialize();
+
+    if(ASSERT(nesla_binary_open(&g_test.binary, NULL, TEST_PATH, 4, 8) == NESLA_SUCCESS)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    nesla_binary_close(&g_test.binary);
+
+    if(ASSERT(!nesla_binary_get(&g_test.binary)
+            && (nesla_binary_get_descriptor(&g_test.binary) == -1)
+            && !nesla_binary_get_length(&g_test.binary)
+            && !nesla_binary_get_offset(&g_test.binary)
+            && !nesla_binary_get_path(&g_test.binary))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test binary open, slicing a mapped file.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_binary_open(void)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    nesla_test_initialize();
+
+    if(ASSERT((nesla_binary_open(&g_test.binary, NULL, TEST_PATH, 0, 0) == NESLA_SUCCESS)
+            && nesla_test_slice(0, TEST_LENGTH)
+            && (nesla_binary_get_descriptor(&g_test.binary) == TEST_DESCRIPTOR))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_binary_open(&g_test.binary, NULL, TEST_PATH, 4, 0) == NESLA_SUCCESS)
+            && nesla_test_slice(4, TEST_LENGTH - 4))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_binary_open(&g_test.binary, NULL, TEST_PATH, 4, TEST_LENGTH - 4) == NESLA_SUCCESS)
+            && nesla_test_slice(4, TEST_LENGTH - 4))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_binary_open(&g_test.binary, NULL, TEST_PATH, TEST_LENGTH - 1, 1) == NESLA_SUCCESS)
+            && nesla_test_slice(TEST_LENGTH - 1, 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_binary_open(&g_test.binary, NULL, TEST_PATH, 4, TEST_LENGTH - 3) == NESLA_FAILURE)
+            && (nesla_binary_open(&g_test.binary, NULL, TEST_PATH, TEST_LENGTH - 1, 2) == NESLA_FAILURE)
+            && (nesla_binary_open(&g_test.binary, NULL, TEST_PATH, TEST_LENGTH, 0) == NESLA_FAILURE)
+            && (nesla_binary_open(&g_test.binary, NULL, TEST_PATH, TEST_LENGTH, 1) == NESLA_FAILURE)
+            && (nesla_binary_open(&g_test.binary, NULL, TEST_PATH, 1, SIZE_MAX) == NESLA_FAILURE)
+            && (nesla_binary_open(&g_test.binary, NULL, TEST_PATH, SIZE_MAX, 1) == NESLA_FAILURE))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    g_test.fail = true;
+
+    if(ASSERT((nesla_binary_open(&g_test.binary, NULL, TEST_PATH, 0, 0) == NESLA_FAILURE)
+            && (nesla_binary_get_descriptor(&g_test.binary) == -1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test binary open, slicing a caller owned buffer.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_binary_open_buffer(void)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    nesla_test_initialize();
+
+    if(ASSERT((nesla_binary_open_buffer(&g_test.binary, NULL, TEST_PATH, g_test.data, TEST_LENGTH, 0, 0) == NESLA_SUCCESS)
+            && nesla_test_slice(0, TEST_LENGTH)
+            && (nesla_binary_get_descriptor(&g_test.binary) == -1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_binary_open_buffer(&g_test.binary, NULL, TEST_PATH, g_test.data, TEST_LENGTH, 8, TEST_LENGTH - 8)
+                == NESLA_SUCCESS)
+            && nesla_test_slice(8, TEST_LENGTH - 8))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_binary_open_buffer(&g_test.binary, NULL, TEST_PATH, g_test.data, TEST_LENGTH, TEST_LENGTH - 1, 0)
+                == NESLA_SUCCESS)
+            && nesla_test_slice(TEST_LENGTH - 1, 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_binary_open_buffer(&g_test.binary, NULL, TEST_PATH, NULL, TEST_LENGTH, 0, 0) == NESLA_FAILURE)
+            && (nesla_binary_open_buffer(&g_test.binary, NULL, TEST_PATH, g_test.data, 0, 0, 0) == NESLA_FAILURE)
+            && (nesla_binary_open_buffer(&g_test.binary, NULL, TEST_PATH, g_test.data, TEST_LENGTH, TEST_LENGTH, 0) == NESLA_FAILURE)
+            && (nesla_binary_open_buffer(&g_test.binary, NULL, TEST_PATH, g_test.data, TEST_LENGTH, 8, TEST_LENGTH - 7)
+                == NESLA_FAILURE)
+            && (nesla_binary_open_buffer(&g_test.binary, NULL, TEST_PATH, g_test.data, TEST_LENGTH, 1, SIZE_MAX) == NESLA_FAILURE))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    TEST_RESULT(result);
+
+    return result;
+}
+
+int main(void)
+{
+    static const test TEST[] = {
+        nesla_test_binary_close,
+        nesla_test_binary_open,
+        nesla_test_binary_open_buffer,
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(int index = 0; index < TEST_COUNT(TEST); ++index) {
+
+        if(TEST[index]() == NESLA_FAILURE) {
+            result = NESLA_FAILURE;
+        }
+    }
+
+    return (int)result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,127 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file main.c
+ * @brief Unreachable code and data removal tests.
+ */
+
+#include <dead.h>
+#include <test.h>
+#include <assemble.h>
+
+static nesla_test_assembly_t g_test = {};   /*!< Test assembly context */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Test units kept, by .KEEP, .DEF or .NOOPT, while units only they would reach are removed.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_dead_keep(void)
+{
+    static const char *SOURCE = ".PRG 1\n.KEEP kept\n.BANK 0\n.ORG $C000\nreset:\nJSR used\nJMP reset\nused:\nLDA table\nRTS\nunused:\n"
+        "LDA other\nRTS\ntable:\n.BYTE 1, 2\nother:\n.BYTE 3\nkept:\nRTS\nfalls:\nNOP\n.NOOPT\nheld:\nRTS\n.OPT\ndefined:\nRTS\n"
+        ".DEF ENTRY defined\n" TEST_VECTORS;
+    static const uint8_t EXPECTED[] = {
+        0x20, 0x06, 0xC0, 0x4C, 0x00, 0xC0, 0xAD, 0x0A, 0xC0, 0x60, 0x01, 0x02, 0x60, 0x60, 0x60, 0xFF,
+        };
+    static const uint8_t EXPECTED_KEPT[] = {
+        0x20, 0x06, 0xC0, 0x4C, 0x00, 0xC0, 0xAD, 0x0E, 0xC0, 0x60, 0xAD, 0x10, 0xC0, 0x60, 0x01, 0x02, 0x03, 0x60, 0xEA, 0x60, 0x60,
+        };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, SOURCE, NESLA_FLAG_DEAD) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Unreachable code and data removed: 3 label(s), 6 bytes") == 1)
+            && nesla_test_match(&g_test, 0, 0xC000, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble(&g_test, SOURCE, 0) == NESLA_SUCCESS)
+            && !nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Unreachable code and data removed")
+            && nesla_test_match(&g_test, 0, 0xC000, EXPECTED_KEPT, sizeof(EXPECTED_KEPT)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble(&g_test, ".PRG 1\n.KEEP label\n.BANK 0\n.ORG $C000\nreset:\nRTS\n" TEST_VECTORS, NESLA_FLAG_DEAD)
+                == NESLA_FAILURE)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, "Undefined symbol: label") == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test units reached by running into them, unless the unit before holds only data.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_dead_run(void)
+{
+    static const uint8_t EXPECTED[] = { 0x20, 0x06, 0xC0, 0x4C, 0x00, 0xC0, 0xA9, 0x01, 0x60, 0xFF, };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, ".PRG 1\n.BANK 0\n.ORG $C000\nreset:\nJSR used\nJMP reset\nused:\nLDA #1\ntail:\nRTS\n"
+                "data:\n.BYTE 1\nafter:\nRTS\n" TEST_VECTORS, NESLA_FLAG_DEAD) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Unreachable code and data removed: 2 label(s), 2 bytes") == 1)
+            && nesla_test_match(&g_test, 0, 0xC000, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+int main(void)
+{
+    static const test TEST[] = {
+        nesla_test_dead_keep,
+        nesla_test_dead_run,
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(int index = 0; index < TEST_COUNT(TEST); ++index) {
+
+        if(TEST[index]() == NESLA_FAILURE) {
+            result = NESLA_FAILURE;
+        }
+    }
+
+    return (int)result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,479 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file main.c
+ * @brief Encoder fixup, relaxation and jump table tests.
+ */
+
+#include <encoder.h>
+#include <test.h>
+#include <assemble.h>
+
+static const char *SOURCE = ".PRG 1\n.BANK 0\n.ORG $C000\nreset:\nLDX #1\nCPX #state_COUNT\nJSR state\nLDA plain_LO,X\n"
+    "LDY #plain_COUNT\nRTS\nidle:\nRTS\nwalk:\nRTS\nattack:\nRTS\n.JUMP RTS state idle, walk, attack\n.JUMP plain idle, walk\n"
+    TEST_VECTORS;                           /*!< Jump tables, with and without a dispatch stub */
+
+static nesla_test_assembly_t g_test = {};   /*!< Test assembly context */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Assemble a chain of forward references, each relaxed to zero-page only once the one before it is, so each layout pass
+ *        relaxes one more. The labels referenced follow the references, one byte apart, the first at $FF once all are relaxed.
+ * @param[in] count Reference count
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_assemble_chain(int count)
+{
+    size_t length;
+    static char source[TEST_SOURCE_MAX];
+
+    length = snprintf(source, sizeof(source), ".PRG 1\n.BANK 0\n.ORG $%04X\n", 0xFF - (3 * count));
+
+    for(int index = 0; index < count; ++index) {
+        length += snprintf(source + length, sizeof(source) - length, "LDA label%i\n", index);
+    }
+
+    for(int index = 0; index < count; ++index) {
+        length += snprintf(source + length, sizeof(source) - length, "label%i:\nNOP\n", index);
+    }
+
+    snprintf(source + length, sizeof(source) - length, ".ORG $C000\nreset:\nRTS\n" TEST_VECTORS);
+
+    return nesla_test_assemble(&g_test, source, 0);
+}
+
+/*!
+ * @brief Test fixups of forward references, patched once their symbols are defined, as a byte, a relative branch, a word, and the
+ *        low and high bytes of an address.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_encoder_fixup_forward(void)
+{
+    static const char SOURCE[] = ".PRG 1\n.BANK 0\n.ORG $C000\nreset:\nLDA #value\nBEQ done\nLDA table\nLDA #<table\n"
+        "LDX #>table\nJMP done\n.WORD table\n.BYTE value\ndone:\nRTS\ntable:\n.BYTE 1\n.DEF value $10\n" TEST_VECTORS;
+    static const uint8_t EXPECTED[] = {
+        0xA9, 0x10, 0xF0, 0x0D, 0xAD, 0x12, 0xC0, 0xA9, 0x12, 0xA2, 0xC0, 0x4C, 0x11, 0xC0, 0x12, 0xC0, 0x10, 0x60, 0x01,
+        };
+    const nesla_statistics_t *statistics;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, SOURCE, 0) == NESLA_SUCCESS)
+            && nesla_test_match(&g_test, 0, 0xC000, EXPECTED, sizeof(EXPECTED))
+            && (statistics = nesla_context_get_statistics(g_test.context))
+            && (statistics->pass == 1)
+            && (statistics->fixup == 8)
+            && (statistics->patched == 8)
+            && (statistics->relaxed == 0))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test fixup of an expanded branch, patching the jump that follows the inverted branch.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_encoder_fixup_jump(void)
+{
+    static const uint8_t EXPECTED[] = { 0xD0, 0x03, 0x4C, 0x00, 0xC1, 0x60, };
+    const nesla_statistics_t *statistics;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, ".PRG 1\n.BANK 0\n.ORG $C000\nreset:\nBEQ far\nRTS\n.ORG $C100\nfar:\nRTS\n" TEST_VECTORS,
+                NESLA_FLAG_RELAX_BRANCH) == NESLA_SUCCESS)
+            && nesla_test_match(&g_test, 0, 0xC000, EXPECTED, sizeof(EXPECTED))
+            && (statistics = nesla_context_get_statistics(g_test.context))
+            && (statistics->pass == 2)
+            && (statistics->fixup == 1)
+            && (statistics->patched == 1)
+            && (statistics->expanded == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test fixups patched with values that do not fit, as a byte too large and a branch out of range.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_encoder_fixup_range(void)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, ".PRG 1\n.BANK 0\n.ORG $C000\nreset:\nLDA #big\nBNE far\n.ORG $C100\nfar:\nRTS\n"
+                ".DEF big $1FF\n" TEST_VECTORS, 0) == NESLA_FAILURE)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, "Value too large: 511") == 1)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, "Branch out of range: 252") == 1)
+            && strstr(nesla_context_get_error(g_test.context), "Value too large: 511 (test.asm@5:6), and 1 more error(s)"))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test immediate scalars, taken whole or as their low and high bytes.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_encoder_fixup_scalar(void)
+{
+    static const uint8_t EXPECTED[] = { 0xA9, 0x34, 0xA2, 0x12, 0xA0, 0xC0, 0x60, };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, ".PRG 1\n.BANK 0\n.ORG $C000\nreset:\nLDA #<$1234\nLDX #>$1234\nLDY #>reset\nRTS\n"
+                TEST_VECTORS, 0) == NESLA_SUCCESS)
+            && nesla_test_match(&g_test, 0, 0xC000, EXPECTED, sizeof(EXPECTED))
+            && (nesla_context_get_statistics(g_test.context)->fixup == 0))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test fixups of undefined symbols, each reported at its operand.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_encoder_fixup_undefined(void)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, ".PRG 1\n.BANK 0\n.ORG $C000\nreset:\nLDA missing\nBEQ nowhere\nLDX #<missing\nRTS\n"
+                TEST_VECTORS, 0) == NESLA_FAILURE)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, "Undefined symbol: missing") == 2)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, "Undefined symbol: nowhere") == 1)
+            && strstr(nesla_context_get_error(g_test.context), "Undefined symbol: missing (test.asm@5:5), and 2 more error(s)"))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test jump table entry counts, of at least one entry and at most ENCODER_JUMP_MAX.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_encoder_jump_count(void)
+{
+    size_t length;
+    static char source[TEST_SOURCE_MAX];
+    nesla_error_e result = NESLA_SUCCESS;
+
+    length = snprintf(source, sizeof(source), ".PRG 1\n.BANK 0\n.ORG $C000\nreset:\nRTS\n.JUMP table reset");
+
+    for(int index = 1; index <= ENCODER_JUMP_MAX; ++index) {
+        length += snprintf(source + length, sizeof(source) - length, ", reset");
+    }
+
+    snprintf(source + length, sizeof(source) - length, "\n" TEST_VECTORS);
+
+    if(ASSERT((nesla_test_assemble(&g_test, source, 0) == NESLA_FAILURE)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, "Invalid jump table entry count: 257") == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test jump table entries kept reachable through the tables, once unreachable code is removed.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_encoder_jump_dead(void)
+{
+    static const uint8_t EXPECTED[] = { 0x60, 0x60, 0x60, };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, SOURCE, NESLA_FLAG_DEAD) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Unreachable code and data removed: 1 label(s), 2 bytes") == 1)
+            && nesla_test_match(&g_test, 0, 0xC00D, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test out-of-range branches, forward and backward, expanded into the inverted branch over a jump with
+ *        NESLA_FLAG_RELAX_BRANCH, and reported as errors without it. Branches in range are left alone.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_encoder_relax_branch(void)
+{
+    static const char SOURCE[] = ".PRG 1\n.BANK 0\n.ORG $C000\nreset:\nBEQ far\nBNE reset\nRTS\n.ORG $C100\nfar:\nBCC reset\nRTS\n"
+        TEST_VECTORS;
+    static const uint8_t FORWARD[] = { 0xD0, 0x03, 0x4C, 0x00, 0xC1, 0xD0, 0xF9, 0x60, },
+        BACKWARD[] = { 0xB0, 0x03, 0x4C, 0x00, 0xC0, 0x60, };
+    const nesla_statistics_t *statistics;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, SOURCE, NESLA_FLAG_RELAX_BRANCH) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE,
+                "Branch expanded to BNE over JMP: +3 bytes, +2 cycles taken, +1 cycles not taken") == 1)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Branch expanded to BCS over JMP") == 1)
+            && nesla_test_match(&g_test, 0, 0xC000, FORWARD, sizeof(FORWARD))
+            && nesla_test_match(&g_test, 0, 0xC100, BACKWARD, sizeof(BACKWARD))
+            && (statistics = nesla_context_get_statistics(g_test.context))
+            && (statistics->pass == 2)
+            && (statistics->expanded == 2))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble(&g_test, SOURCE, 0) == NESLA_FAILURE)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, "Branch out of range: 254") == 1)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, "Branch out of range: -258") == 1)
+            && !nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Branch expanded"))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test a branch in range until an expanded branch moves its target out of range, expanded in the next layout pass.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_encoder_relax_cascade(void)
+{
+    static const uint8_t EXPECTED[] = { 0xF0, 0x03, 0x4C, 0x85, 0xC0, 0xD0, 0x03, 0x4C, 0x00, 0xC1, };
+    const nesla_statistics_t *statistics;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble_fill(&g_test, NESLA_FLAG_RELAX_BRANCH, ".PRG 1\n.BANK 0\n.ORG $C000\nreset:\nBNE edge\nBEQ far\n",
+                INT8_MAX - 4, "edge:\nRTS\n.ORG $C100\nfar:\nRTS\n" TEST_VECTORS) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Branch expanded") == 2)
+            && nesla_test_match(&g_test, 0, 0xC000, EXPECTED, sizeof(EXPECTED))
+            && (statistics = nesla_context_get_statistics(g_test.context))
+            && (statistics->pass == 3)
+            && (statistics->expanded == 2))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test statements whose addressing mode keeps changing, kept absolute past ENCODER_CHANGE_MAX changes. The first two
+ *        statements are relaxed once a label in another bank moves into zero-page, while the expanded branch moves the label
+ *        referenced by the third out of it and back.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_encoder_relax_oscillate(void)
+{
+    static const char SOURCE[] = ".PRG 2\n.BANK 0\n.ORG $00F3\nLDA crossed\nLDA crossed\nLDA near\nBNE reset\nnear:\n.BANK 1\n"
+        ".ORG $00FD\nLDA value\ncrossed:\n.ORG $C000\nreset:\nRTS\n.DEF value $10\n" TEST_VECTORS;
+    static const uint8_t EXPECTED[] = { 0xA5, 0xFF, 0xA5, 0xFF, 0xAD, 0xFF, 0x00, 0xF0, 0x03, 0x4C, 0x00, 0xC0, };
+    const nesla_statistics_t *statistics;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, SOURCE, NESLA_FLAG_RELAX_BRANCH) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_WARNING, "Addressing mode oscillates, kept absolute") == 1)
+            && nesla_test_match(&g_test, 0, 0x00F3, EXPECTED, sizeof(EXPECTED))
+            && (statistics = nesla_context_get_statistics(g_test.context))
+            && (statistics->pass == 3)
+            && (statistics->relaxed == 5)
+            && (statistics->expanded == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test layout passes, converging within ENCODER_PASS_MAX passes, and failing past them.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_encoder_relax_pass(void)
+{
+    static const uint8_t FIRST[] = { 0xA5, 0xFF - (ENCODER_PASS_MAX - 1), }, LAST[] = { 0xA5, 0xFE, 0xEA, };
+    const nesla_statistics_t *statistics;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble_chain(ENCODER_PASS_MAX - 1) == NESLA_SUCCESS)
+            && nesla_test_match(&g_test, 0, 0xFF - (3 * (ENCODER_PASS_MAX - 1)), FIRST, sizeof(FIRST))
+            && nesla_test_match(&g_test, 0, 0xFF - (ENCODER_PASS_MAX - 1) - 2, LAST, sizeof(LAST))
+            && (statistics = nesla_context_get_statistics(g_test.context))
+            && (statistics->pass == ENCODER_PASS_MAX)
+            && (statistics->relaxed == (ENCODER_PASS_MAX - 1)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble_chain(ENCODER_PASS_MAX) == NESLA_FAILURE)
+            && g_test.context
+            && strstr(nesla_context_get_error(g_test.context), "Layout did not converge: 64 passes"))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test forward references relaxed to zero-page once their values are known, for a constant, a variable and a label
+ *        that lands in zero-page, and kept absolute for a label that lands at $100.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_encoder_relax_zero_page(void)
+{
+    static const char SOURCE[] = ".PRG 1\n.BANK 0\n.ORG $00F0\nLDA here\nhere:\nRTS\n.ORG $00FD\nLDA edge\nedge:\nRTS\n.ORG $C000\n"
+        "reset:\nLDA value\nLDX variable\nRTS\n.DEF value $10\n.RESV variable 1\n" TEST_VECTORS;
+    static const uint8_t EXPECTED[] = { 0xA5, 0x10, 0xA6, 0x00, 0x60, }, HERE[] = { 0xA5, 0xF2, 0x60, }, EDGE[] = { 0xAD, 0x00, 0x01, };
+    const nesla_statistics_t *statistics;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, SOURCE, 0) == NESLA_SUCCESS)
+            && nesla_test_match(&g_test, 0, 0xC000, EXPECTED, sizeof(EXPECTED))
+            && nesla_test_match(&g_test, 0, 0x00F0, HERE, sizeof(HERE))
+            && nesla_test_match(&g_test, 0, 0x00FD, EDGE, sizeof(EDGE))
+            && (statistics = nesla_context_get_statistics(g_test.context))
+            && (statistics->pass == 2)
+            && (statistics->relaxed == 3))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test jump tables, split into low and high byte tables, with an RTS dispatch stub holding each entry less one.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_encoder_jump_table(void)
+{
+    static const uint8_t EXPECTED[] = {
+        0xA2, 0x01, 0xE0, 0x03, 0x20, 0x10, 0xC0, 0xBD, 0x1F, 0xC0, 0xA0, 0x02, 0x60, 0x60, 0x60, 0x60, 0xBD, 0x1C, 0xC0, 0x48, 0xBD,
+        0x19, 0xC0, 0x48, 0x60, 0x0C, 0x0D, 0x0E, 0xC0, 0xC0, 0xC0, 0x0D, 0x0E, 0xC0, 0xC0, 0xFF,
+        };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, SOURCE, 0) == NESLA_SUCCESS)
+            && nesla_test_match(&g_test, 0, 0xC000, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+int main(void)
+{
+    static const test TEST[] = {
+        nesla_test_encoder_fixup_forward,
+        nesla_test_encoder_fixup_jump,
+        nesla_test_encoder_fixup_range,
+        nesla_test_encoder_fixup_scalar,
+        nesla_test_encoder_fixup_undefined,
+        nesla_test_encoder_jump_count,
+        nesla_test_encoder_jump_dead,
+        nesla_test_encoder_jump_table,
+        nesla_test_encoder_relax_branch,
+        nesla_test_encoder_relax_cascade,
+        nesla_test_encoder_relax_oscillate,
+        nesla_test_encoder_relax_pass,
+        nesla_test_encoder_relax_zero_page,
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(int index = 0; index < TEST_COUNT(TEST); ++index) {
+
+        if(TEST[index]() == NESLA_FAILURE) {
+            result = NESLA_FAILURE;
+        }
+    }
+
+    return (int)result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
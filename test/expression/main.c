@@ -0,0 +1,255 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file main.c
+ * @brief Table expression tests.
+ */
+
+#include <expression.h>
+#include <test.h>
+#include <assemble.h>
+
+static nesla_test_assembly_t g_test = {};   /*!< Test assembly context */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Assemble test source, with tables placed at the start of the last bank.
+ * @param[in] table Constant pointer to table directives
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_assemble_table(const char *table)
+{
+    return nesla_test_assemble_format(&g_test, 0, ".PRG 1\n.DEF K 10\n.BANK 0\n.ORG $C000\n%sreset:\nRTS\n" TEST_VECTORS, table);
+}
+
+/*!
+ * @brief Test table expression, failing with an error containing a string.
+ * @param[in] table Constant pointer to table mode and names
+ * @param[in] expression Constant pointer to expression
+ * @param[in] message Constant pointer to error message substring
+ * @return true if assembly failed with the error, false otherwise
+ */
+static bool nesla_test_error(const char *table, const char *expression, const char *message)
+{
+    char source[TEST_SOURCE_MAX];
+
+    snprintf(source, sizeof(source), ".TABLE %s 0, 3, \"%s\"\n", table, expression);
+
+    return (nesla_test_assemble_table(source) == NESLA_FAILURE) && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, message) == 1);
+}
+
+/*!
+ * @brief Test table expression division and modulo by zero, at the index where the divisor reaches zero.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_expression_divide(void)
+{
+    static const uint8_t EXPECTED[] = { 0xCE, 0x9C, 0x02, 0x03, };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble_table(".TABLE BYTE t 0, 1, \"100 / (I - 2)\"\n.TABLE BYTE m 0, 1, \"(I + 7) % 5\"\n") == NESLA_SUCCESS)
+            && nesla_test_match(&g_test, 0, 0xC000, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT(nesla_test_error("BYTE t", "100 / (I - 1)", "Division by zero at index 1: 100 / (I - 1)")
+            && nesla_test_error("BYTE t", "7 % (I - 2)", "Division by zero at index 2: 7 % (I - 2)"))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test table expression parse errors, reported with the offset into the expression.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_expression_error(void)
+{
+    char deep[TEST_SOURCE_MAX] = {};
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(int index = 0; index <= EXPRESSION_DEPTH_MAX; ++index) {
+        deep[index] = '(';
+    }
+
+    deep[EXPRESSION_DEPTH_MAX + 1] = '1';
+
+    if(ASSERT(nesla_test_error("BYTE t", "1 +", "Expecting operand at offset 3")
+            && nesla_test_error("BYTE t", "(1", "Expecting closing parenthesis at offset 2")
+            && nesla_test_error("BYTE t", "1 )", "Unexpected character at offset 2")
+            && nesla_test_error("BYTE t", "1 @ 2", "Unexpected character at offset 2")
+            && nesla_test_error("BYTE t", "$", "Expecting scalar at offset 1")
+            && nesla_test_error("BYTE t", "65536", "Scalar too large at offset 4")
+            && nesla_test_error("BYTE t", "SIN 1", "Expecting function arguments at offset 4")
+            && nesla_test_error("BYTE t", "SIN(1)", "Expecting function amplitude at offset 5")
+            && nesla_test_error("BYTE t", "SIN(1, 2", "Expecting closing parenthesis at offset 8")
+            && nesla_test_error("BYTE t", "UNDEFINED + 1", "Undefined symbol: UNDEFINED")
+            && nesla_test_error("BYTE t", deep, "Expression too deep"))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test table expression SIN and COS, in 256ths of a turn, scaled by amplitude.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_expression_function(void)
+{
+    static const uint8_t EXPECTED[] = { 0x00, 0x7F, 0x00, 0x81, 0x7F, 0x00, 0x81, 0x00, 0x00, 0x47, 0x64, 0x47, };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble_table(".TABLE BYTE s 0, 3, \"SIN(I * 64, 127)\"\n.TABLE BYTE c 0, 3, \"COS(I * 64, 127)\"\n"
+                ".TABLE BYTE h 0, 3, \"SIN(I * 32, 100)\"\n") == NESLA_SUCCESS)
+            && nesla_test_match(&g_test, 0, 0xC000, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test table expression values out of range of the table mode.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_expression_overflow(void)
+{
+    static const uint8_t EXPECTED[] = { 0x80, 0xFF, 0x00, 0x80, 0xFF, 0xFF, 0x00, 0xFF, 0x80, 0xFF, };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble_table(".TABLE BYTE b 0, 1, \"I * 383 - 128\"\n.TABLE WORD w 0, 1, \"I * $FFFF + I * $8000 - $8000\"\n"
+                ".TABLE SPLIT l, h 0, 1, \"I * $FFFF + I * $8000 - $8000\"\n") == NESLA_SUCCESS)
+            && nesla_test_match(&g_test, 0, 0xC000, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT(nesla_test_error("BYTE t", "I * 100", "Table value out of range at index 3: 300")
+            && nesla_test_error("BYTE t", "0 - 129", "Table value out of range at index 0: -129")
+            && nesla_test_error("WORD t", "I * 65535 + I", "Table value out of range at index 1: 65536")
+            && nesla_test_error("WORD t", "0 - 32769", "Table value out of range at index 0: -32769")
+            && nesla_test_error("SPLIT l, h", "I * $8000", "Table value out of range at index 2: 65536"))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test table expression operator precedence, parentheses, constants and the index.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_expression_precedence(void)
+{
+    static const uint8_t EXPECTED[] = { 0x0F, 0x12, 0x0E, 0x07, 0x06, 0x20, 0x03, 0x05, 0x07, };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble_table(".TABLE BYTE a 0, 0, \"1 + 2 * 3 << 1 | 1\"\n.TABLE BYTE b 0, 0, \"(1 + 2) * 3 << 1\"\n"
+                ".TABLE BYTE c 0, 0, \"12 & 10 ^ 6 | 2\"\n.TABLE BYTE d 0, 0, \"15 - 4 - 4\"\n.TABLE BYTE e 0, 0, \"96 / 4 / 4 % 7\"\n"
+                ".TABLE BYTE k 0, 0, \"K * 3 + 2\"\n.TABLE BYTE i 1, 3, \"I * 2 + 1\"\n") == NESLA_SUCCESS)
+            && nesla_test_match(&g_test, 0, 0xC000, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test table expression unary operators, including negative values stored as two's complement.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_expression_unary(void)
+{
+    static const uint8_t EXPECTED[] = { 0xFF, 0xFE, 0xFD, 0x05, 0x04, 0xF0, 0x20, 0xFE, 0xFF, };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble_table(".TABLE BYTE n 0, 2, \"-(I + 1)\"\n.TABLE BYTE p 0, 1, \"-I + +5\"\n"
+                ".TABLE BYTE c 0, 0, \"~$0F & $FF\"\n.TABLE BYTE d 0, 0, \"K * 3 - -2\"\n.TABLE WORD w 0, 0, \"-2\"\n") == NESLA_SUCCESS)
+            && nesla_test_match(&g_test, 0, 0xC000, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+int main(void)
+{
+    static const test TEST[] = {
+        nesla_test_expression_divide,
+        nesla_test_expression_error,
+        nesla_test_expression_function,
+        nesla_test_expression_overflow,
+        nesla_test_expression_precedence,
+        nesla_test_expression_unary,
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(int index = 0; index < TEST_COUNT(TEST); ++index) {
+
+        if(TEST[index]() == NESLA_FAILURE) {
+            result = NESLA_FAILURE;
+        }
+    }
+
+    return (int)result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
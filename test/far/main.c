@@ -0,0 +1,207 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file main.c
+ * @brief Far call trampoline tests.
+ */
+
+#include <far.h>
+#include <test.h>
+#include <assemble.h>
+
+static const char *SOURCE = "%s.PRG 4\n.MAP %u\n.BANK 3\n.ORG $C000\nreset:\n.FAR\nJSR far1\n.FAR\nJSR fixed\nRTS\nfixed:\nRTS\n.BANK 0\n"
+    ".ORG $8000\ncode0:\n.FAR\nJSR far1\n.FAR\nJSR far1\n.FAR\nJSR same\nRTS\nsame:\nRTS\n.BANK 1\n.ORG $8000\nfar1:\nRTS\n.BANK 3\n"
+    TEST_VECTORS;                           /*!< Far calls from the fixed bank and a switched bank, under a mapper */
+
+static nesla_test_assembly_t g_test = {};   /*!< Test assembly context */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Assemble far call test source, under a mapper.
+ * @param[in] prefix Constant pointer to source string before the far calls
+ * @param[in] mapper Mapper
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_assemble_far(const char *prefix, unsigned mapper)
+{
+    return nesla_test_assemble_format(&g_test, 0, SOURCE, prefix, mapper);
+}
+
+/*!
+ * @brief Test far calls under mappers that switch banks differently, or do not switch them at all.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_far_mapper(void)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble_far("", 0) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Far calls: 5 direct") == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble_far("", 1) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE,
+                "Far calls: 2 direct, 3 through 2 trampoline(s), 114 byte(s) at $C008, FAR_BANK at $0000") == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble_far("", 4) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE,
+                "Far calls: 2 direct, 3 through 2 trampoline(s), 123 byte(s) at $C008, FAR_BANK at $0000") == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble_far("", 3) == NESLA_FAILURE)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, "Unsupported mapper for far call: 3") == 3))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test far call trampolines that do not fit in the fixed bank.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_far_space(void)
+{
+    static const char *PREFIX = ".PRG 3\n.MAP 2\n.BANK 2\n.ORG $C000\nreset:\nRTS\n";
+    static const char *SUFFIX = ".BANK 0\n.ORG $8000\ncode:\n.FAR\nJSR far1\nRTS\n.BANK 1\n.ORG $8000\nfar1:\nRTS\n.BANK 2\n" TEST_VECTORS;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble_fill(&g_test, 0, PREFIX, 0xFFE8 - 0xC002, SUFFIX) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE,
+                "Far calls: 0 direct, 1 through 1 trampoline(s), 19 byte(s) at $FFE7") == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble_fill(&g_test, 0, PREFIX, 0xFFE9 - 0xC002, SUFFIX) == NESLA_FAILURE)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, "Out of fixed bank space for far call trampolines") == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test far calls placing the bank shadow variable where the source defined it, before the first far call.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_far_shadow(void)
+{
+    static const uint8_t EXPECTED[] = {
+        0xA9, 0x01, 0x8D, 0x00, 0x03, 0x8D, 0x09, 0xC0, 0x20, 0x00, 0x80, 0x48, 0xA9, 0x00, 0x8D, 0x00, 0x03, 0x8D, 0x08, 0xC0, 0x68,
+        0x60,
+        };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble_far(".DEF FAR_BANK $0300\n", 2) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "FAR_BANK at $0300") == 1)
+            && !nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Variables placed")
+            && nesla_test_match(&g_test, 3, 0xC039, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test far calls under UxROM, left plain within a bank or into the fixed bank, and otherwise routed through shared
+ *        trampolines that switch over a table of bank indices. Each trampoline keeps the accumulator and Y returned.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_far_uxrom(void)
+{
+    static const uint8_t EXPECTED[] = {
+        0x20, 0x31, 0xC0, 0x20, 0x31, 0xC0, 0x20, 0x0A, 0x80, 0x60, 0x60,
+        };
+    static const uint8_t EXPECTED_FIXED[] = {
+        0x20, 0x0C, 0xC0, 0x20, 0x07, 0xC0, 0x60, 0x60, 0x00, 0x01, 0x02, 0x03, 0xA5, 0x00, 0x48, 0xA9, 0x01, 0x85, 0x00, 0x8D, 0x09,
+        0xC0, 0x20, 0x00, 0x80, 0x85, 0x00, 0x68, 0x45, 0x00, 0x48, 0x45, 0x00, 0x85, 0x00, 0x98, 0x48, 0xA5, 0x00, 0xA8, 0x99, 0x08,
+        0xC0, 0x68, 0xA8, 0x68, 0x45, 0x00, 0x60, 0xA9, 0x01, 0x85, 0x00, 0x8D, 0x09, 0xC0, 0x20, 0x00, 0x80, 0x48, 0xA9, 0x00, 0x85,
+        0x00, 0x8D, 0x08, 0xC0, 0x68, 0x60,
+        };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble_far("", 2) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE,
+                "Far calls: 2 direct, 3 through 2 trampoline(s), 61 byte(s) at $C008, FAR_BANK at $0000") == 1)
+            && nesla_test_match(&g_test, 0, 0x8000, EXPECTED, sizeof(EXPECTED))
+            && nesla_test_match(&g_test, 3, 0xC000, EXPECTED_FIXED, sizeof(EXPECTED_FIXED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+int main(void)
+{
+    static const test TEST[] = {
+        nesla_test_far_mapper,
+        nesla_test_far_shadow,
+        nesla_test_far_space,
+        nesla_test_far_uxrom,
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(int index = 0; index < TEST_COUNT(TEST); ++index) {
+
+        if(TEST[index]() == NESLA_FAILURE) {
+            result = NESLA_FAILURE;
+        }
+    }
+
+    return (int)result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,389 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file main.c
+ * @brief Image tests.
+ */
+
+#include <image.h>
+#include <test.h>
+
+#define TEST_CHARACTER_LENGTH 0x2000    /*!< Character bank length in bytes */
+#define TEST_HEADER_LENGTH 16           /*!< Header length in bytes */
+#define TEST_PROGRAM_LENGTH 0x4000      /*!< Program bank length in bytes */
+#define TEST_OUTPUT_LENGTH (TEST_HEADER_LENGTH + (2 * TEST_PROGRAM_LENGTH) + TEST_CHARACTER_LENGTH) /*!< Output length in bytes */
+
+/*!
+ * @struct nesla_test_t
+ * @brief Test contexts.
+ */
+typedef struct {
+    nesla_image_t image;                        /*!< Image context */
+    nesla_writer_t writer;                      /*!< Writer context */
+    uint8_t data[TEST_PROGRAM_LENGTH];          /*!< Binary data */
+    uint8_t expected[TEST_OUTPUT_LENGTH];       /*!< Expected output */
+    uint8_t output[TEST_OUTPUT_LENGTH];         /*!< Writer output */
+    size_t length;                              /*!< Writer output length in bytes */
+    size_t puts;                                /*!< Writer put count */
+} nesla_test_t;
+
+static nesla_test_t g_test = {};                /*!< Test context */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+void nesla_binary_close(nesla_binary_t *binary)
+{
+    memset(binary, 0, sizeof(*binary));
+    binary->descriptor = -1;
+}
+
+const uint8_t *nesla_binary_get(const nesla_binary_t *binary)
+{
+    return binary->data;
+}
+
+size_t nesla_binary_get_length(const nesla_binary_t *binary)
+{
+    return binary->length;
+}
+
+void *nesla_context_allocate(nesla_context_t *context, size_t length)
+{
+    return calloc(1, length);
+}
+
+void nesla_context_free(nesla_context_t *context, void *data)
+{
+    free(data);
+}
+
+nesla_list_entry_t *nesla_list_get_head(const nesla_list_t *list)
+{
+    return list->head;
+}
+
+size_t nesla_list_get_length(const nesla_list_t *list)
+{
+    return list->length;
+}
+
+nesla_error_e nesla_list_insert(nesla_list_t *list, nesla_context_t *context, nesla_list_entry_t *entry, void *data)
+{
+    nesla_list_entry_t *new_entry;
+
+    if(!(new_entry = calloc(1, sizeof(*new_entry)))) {
+        return NESLA_FAILURE;
+    }
+
+    new_entry->context = data;
+    new_entry->previous = entry;
+    new_entry->next = entry ? entry->next : list->head;
+    *(new_entry->next ? &new_entry->next->previous : &list->tail) = new_entry;
+    *(entry ? &entry->next : &list->head) = new_entry;
+    ++list->length;
+
+    return NESLA_SUCCESS;
+}
+
+void nesla_list_remove(nesla_list_t *list, nesla_context_t *context, nesla_list_entry_t *entry)
+{
+    *(entry->previous ? &entry->previous->next : &list->head) = entry->next;
+    *(entry->next ? &entry->next->previous : &list->tail) = entry->previous;
+    free(entry);
+    --list->length;
+}
+
+nesla_error_e nesla_set_error(nesla_context_t *context, const char *file, const char *function, int line, const char *format, ...)
+{
+    return NESLA_FAILURE;
+}
+
+uint32_t nesla_table_hash(const char *name, size_t length)
+{
+    uint32_t result = 0x811C9DC5;
+
+    for(size_t index = 0; index < length; ++index) {
+        result = (result ^ (uint8_t)name[index]) * 0x01000193;
+    }
+
+    return result;
+}
+
+nesla_error_e nesla_writer_put(nesla_writer_t *writer, const uint8_t *data, size_t length)
+{
+
+    if((writer != &g_test.writer) || (length > (sizeof(g_test.output) - g_test.length))) {
+        return NESLA_FAILURE;
+    }
+
+    memcpy(g_test.output + g_test.length, data, length);
+    g_test.length += length;
+    ++g_test.puts;
+
+    return NESLA_SUCCESS;
+}
+
+nesla_error_e nesla_writer_put_binary(nesla_writer_t *writer, const nesla_binary_t *binary)
+{
+    return nesla_writer_put(writer, binary->data, binary->length);
+}
+
+/*!
+ * @brief Initialize test, with two program banks and one character bank.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_initialize(void)
+{
+    nesla_error_e result;
+
+    nesla_image_uninitialize(&g_test.image);
+    memset(&g_test, 0, sizeof(g_test));
+
+    for(size_t index = 0; index < TEST_PROGRAM_LENGTH; ++index) {
+        g_test.data[index] = index * 7;
+    }
+
+    nesla_image_initialize(&g_test.image, NULL);
+
+    if((result = nesla_image_set_header(&g_test.image, HEADER_PROGRAM, 2)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if((result = nesla_image_set_header(&g_test.image, HEADER_CHARACTER, 1)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Put binary slice of the test data into image bank.
+ * @param[in] bank Bank index
+ * @param[in] address Address
+ * @param[in] offset Slice offset into test data in bytes
+ * @param[in] length Slice length in bytes
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_put_binary(size_t bank, uint16_t address, size_t offset, size_t length)
+{
+    nesla_binary_t binary = { .data = g_test.data + offset, .offset = offset, .length = length, };
+
+    return nesla_image_put_binary(&g_test.image, bank, address, &binary);
+}
+
+/*!
+ * @brief Test image put, reserving ranges and rejecting overlaps.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_image_put(void)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT(nesla_test_initialize() == NESLA_SUCCESS)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_image_put(&g_test.image, 0, 0x8010, g_test.data, 8) == NESLA_SUCCESS)
+            && (nesla_image_put(&g_test.image, 0, 0x8017, g_test.data, 1) == NESLA_FAILURE)
+            && (nesla_image_put(&g_test.image, 0, 0x8010, g_test.data, 1) == NESLA_FAILURE)
+            && (nesla_image_put(&g_test.image, 0, 0x800C, g_test.data, 8) == NESLA_FAILURE)
+            && (nesla_image_put(&g_test.image, 0, 0x8014, g_test.data, 8) == NESLA_FAILURE)
+            && (nesla_image_put(&g_test.image, 0, 0x8000, g_test.data, 0x40) == NESLA_FAILURE))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_image_put(&g_test.image, 0, 0x800C, g_test.data, 4) == NESLA_SUCCESS)
+            && (nesla_image_put(&g_test.image, 0, 0x8018, g_test.data, 4) == NESLA_SUCCESS)
+            && (nesla_image_put(&g_test.image, 0, 0x8000, g_test.data, 0) == NESLA_SUCCESS))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_image_put(&g_test.image, 1, 0xBFFF, g_test.data, 2) == NESLA_FAILURE)
+            && (nesla_image_put(&g_test.image, 1, 0xBFFF, g_test.data, 1) == NESLA_SUCCESS)
+            && (nesla_image_put(&g_test.image, 1, 0xC000, g_test.data, TEST_PROGRAM_LENGTH - 1) == NESLA_SUCCESS)
+            && (nesla_image_put(&g_test.image, 1, 0xC000, g_test.data, 1) == NESLA_FAILURE))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_image_put(&g_test.image, 2, 0x0000, g_test.data, TEST_CHARACTER_LENGTH + 1) == NESLA_FAILURE)
+            && (nesla_image_put(&g_test.image, 2, 0x0000, g_test.data, TEST_CHARACTER_LENGTH) == NESLA_SUCCESS)
+            && (nesla_image_put(&g_test.image, 3, 0x0000, g_test.data, 1) == NESLA_FAILURE))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT(nesla_image_set_header(&g_test.image, HEADER_PROGRAM, 1) == NESLA_FAILURE)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_image_uninitialize(&g_test.image);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test image put binary, reserving ranges against data and other binaries.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_image_put_binary(void)
+{
+    nesla_binary_t binary = {};
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT(nesla_test_initialize() == NESLA_SUCCESS)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_put_binary(0, 0x8100, 0, 0x100) == NESLA_SUCCESS)
+            && (nesla_test_put_binary(0, 0x81FF, 0, 1) == NESLA_FAILURE)
+            && (nesla_test_put_binary(0, 0x80FF, 0, 2) == NESLA_FAILURE)
+            && (nesla_image_put(&g_test.image, 0, 0x8180, g_test.data, 1) == NESLA_FAILURE)
+            && (nesla_test_put_binary(0, 0x8200, 0, 1) == NESLA_SUCCESS)
+            && (nesla_test_put_binary(0, 0x80FF, 0, 1) == NESLA_SUCCESS))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_put_binary(1, 0xBFF0, 0, 0x11) == NESLA_FAILURE)
+            && (nesla_test_put_binary(1, 0xBFF0, 0, 0x10) == NESLA_SUCCESS)
+            && (nesla_test_put_binary(1, 0x8000, 0, TEST_PROGRAM_LENGTH - 0x10) == NESLA_SUCCESS)
+            && (nesla_image_get_length(&g_test.image, 1) == TEST_PROGRAM_LENGTH))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    binary.data = g_test.data;
+    binary.length = 1;
+
+    if(ASSERT((nesla_image_put_binary(&g_test.image, 0, 0x8100, &binary) == NESLA_FAILURE)
+            && (binary.data == g_test.data)
+            && (nesla_image_put_binary(&g_test.image, 0, 0x8300, &binary) == NESLA_SUCCESS)
+            && !binary.data && !binary.length && (binary.descriptor == -1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_image_uninitialize(&g_test.image);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test image write, interleaving bank data with the binaries placed in it, in offset order.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_image_write(void)
+{
+    uint8_t *bank[3];
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT(nesla_test_initialize() == NESLA_SUCCESS)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_image_set_header(&g_test.image, HEADER_MAPPER, 0x21) == NESLA_SUCCESS)
+            && (nesla_image_set_header(&g_test.image, HEADER_MIRROR, 1) == NESLA_SUCCESS)
+            && (nesla_image_set_header(&g_test.image, HEADER_MIRROR, 2) == NESLA_FAILURE))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_put_binary(0, 0x8200, 0x30, 0x20) == NESLA_SUCCESS)
+            && (nesla_test_put_binary(0, 0x8000, 0x10, 0x10) == NESLA_SUCCESS)
+            && (nesla_image_put(&g_test.image, 0, 0x8100, g_test.data + 0x50, 4) == NESLA_SUCCESS)
+            && (nesla_test_put_binary(0, 0x8010, 0x60, 0x08) == NESLA_SUCCESS)
+            && (nesla_test_put_binary(1, 0xFFFA, 0x70, 6) == NESLA_SUCCESS)
+            && (nesla_test_put_binary(2, 0x0000, 0, TEST_CHARACTER_LENGTH) == NESLA_SUCCESS))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    memset(g_test.expected, 0xFF, sizeof(g_test.expected));
+    memcpy(g_test.expected, "NES\x1A\x02\x01\x11\x20", 8);
+    memset(g_test.expected + 8, 0, TEST_HEADER_LENGTH - 8);
+    bank[0] = g_test.expected + TEST_HEADER_LENGTH;
+    bank[1] = bank[0] + TEST_PROGRAM_LENGTH;
+    bank[2] = bank[1] + TEST_PROGRAM_LENGTH;
+    memcpy(bank[0] + 0x0200, g_test.data + 0x30, 0x20);
+    memcpy(bank[0] + 0x0000, g_test.data + 0x10, 0x10);
+    memcpy(bank[0] + 0x0100, g_test.data + 0x50, 4);
+    memcpy(bank[0] + 0x0010, g_test.data + 0x60, 0x08);
+    memcpy(bank[1] + 0x3FFA, g_test.data + 0x70, 6);
+    memcpy(bank[2], g_test.data, TEST_CHARACTER_LENGTH);
+
+    if(ASSERT((nesla_image_write(&g_test.image, &g_test.writer) == NESLA_SUCCESS)
+            && (g_test.length == TEST_OUTPUT_LENGTH)
+            && (g_test.length == nesla_image_get_size(&g_test.image))
+            && !memcmp(g_test.output, g_test.expected, sizeof(g_test.expected)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT(g_test.puts == (1 + 7 + 3 + 3))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_image_uninitialize(&g_test.image);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+int main(void)
+{
+    static const test TEST[] = {
+        nesla_test_image_put,
+        nesla_test_image_put_binary,
+        nesla_test_image_write,
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(int index = 0; index < TEST_COUNT(TEST); ++index) {
+
+        if(TEST[index]() == NESLA_FAILURE) {
+            result = NESLA_FAILURE;
+        }
+    }
+
+    return (int)result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,190 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file assemble.h
+ * @brief Common test assembly, of a source buffer through the assembler context handle.
+ */
+
+#ifndef NESLA_TEST_ASSEMBLE_H_
+#define NESLA_TEST_ASSEMBLE_H_
+
+#define TEST_HEADER_LENGTH 16           /*!< Image header length in bytes */
+#define TEST_PROGRAM_LENGTH 0x4000      /*!< Program bank length in bytes */
+#define TEST_FILL_MAX 0x10000           /*!< Maximum test source length with fill, in bytes */
+#define TEST_FILL_LINE 32               /*!< Fill bytes per .BYTE statement */
+#define TEST_SOURCE_MAX 8192            /*!< Maximum test source length in bytes */
+#define TEST_VECTORS ".ORG $FFFA\n.WORD reset\n.WORD reset\n.WORD reset\n"  /*!< Vectors, each at reset */
+
+/*!
+ * @struct nesla_test_assembly_t
+ * @brief Test assembly context.
+ */
+typedef struct {
+    nesla_context_t *context;           /*!< Assembler context handle */
+    uint8_t *output;                    /*!< Image buffer */
+    size_t length;                      /*!< Image buffer length in bytes */
+} nesla_test_assembly_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Release test assembly.
+ * @param[in,out] assembly Pointer to test assembly context
+ */
+static inline void nesla_test_release(nesla_test_assembly_t *assembly)
+{
+
+    if(assembly->context) {
+        nesla_context_release(assembly->context, assembly->output);
+        nesla_context_destroy(assembly->context);
+    }
+
+    memset(assembly, 0, sizeof(*assembly));
+}
+
+/*!
+ * @brief Assemble test source, releasing the previous test assembly.
+ * @param[in,out] assembly Pointer to test assembly context
+ * @param[in] source Constant pointer to source string
+ * @param[in] flags Assembly flags (nesla_flag_e bitmask)
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static inline nesla_error_e nesla_test_assemble(nesla_test_assembly_t *assembly, const char *source, uint32_t flags)
+{
+    nesla_source_t buffer = { "test.asm", (const uint8_t *)source, strlen(source), NULL, NULL, };
+
+    nesla_test_release(assembly);
+
+    if(nesla_context_create(&assembly->context, NULL) == NESLA_FAILURE) {
+        return NESLA_FAILURE;
+    }
+
+    nesla_context_set_flags(assembly->context, flags);
+
+    return nesla_context_assemble_buffer(assembly->context, &buffer, &assembly->output, &assembly->length);
+}
+
+/*!
+ * @brief Assemble formatted test source, releasing the previous test assembly.
+ * @param[in,out] assembly Pointer to test assembly context
+ * @param[in] flags Assembly flags (nesla_flag_e bitmask)
+ * @param[in] format Constant pointer to source format string
+ * @param[in] ... Source format arguments
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static inline nesla_error_e nesla_test_assemble_format(nesla_test_assembly_t *assembly, uint32_t flags, const char *format, ...)
+{
+    va_list arguments;
+    char source[TEST_SOURCE_MAX];
+
+    va_start(arguments, format);
+    vsnprintf(source, sizeof(source), format, arguments);
+    va_end(arguments);
+
+    return nesla_test_assemble(assembly, source, flags);
+}
+
+/*!
+ * @brief Assemble test source around a fill of zero bytes, written as .BYTE statements, releasing the previous test assembly.
+ * @param[in,out] assembly Pointer to test assembly context
+ * @param[in] flags Assembly flags (nesla_flag_e bitmask)
+ * @param[in] prefix Constant pointer to source string before the fill
+ * @param[in] fill Fill length in bytes
+ * @param[in] suffix Constant pointer to source string after the fill
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static inline nesla_error_e nesla_test_assemble_fill(nesla_test_assembly_t *assembly, uint32_t flags, const char *prefix, size_t fill,
+    const char *suffix)
+{
+    static char source[TEST_FILL_MAX];
+    size_t length = snprintf(source, sizeof(source), "%s", prefix);
+
+    for(size_t index = 0; index < fill; ++index) {
+        length += snprintf(source + length, sizeof(source) - length, "%s0%s", (index % TEST_FILL_LINE) ? "," : ".BYTE ",
+            (((index % TEST_FILL_LINE) == (TEST_FILL_LINE - 1)) || (index == (fill - 1))) ? "\n" : "");
+    }
+
+    snprintf(source + length, sizeof(source) - length, "%s", suffix);
+
+    return nesla_test_assemble(assembly, source, flags);
+}
+
+/*!
+ * @brief Count test assembly diagnostics containing a string.
+ * @param[in] assembly Constant pointer to test assembly context
+ * @param[in] level Diagnostic level
+ * @param[in] message Constant pointer to message substring
+ * @return Number of diagnostics kept, at the level, containing the string
+ */
+static inline size_t nesla_test_diagnostic(const nesla_test_assembly_t *assembly, nesla_diagnostic_e level, const char *message)
+{
+    size_t result = 0;
+
+    for(size_t index = 0; index < nesla_context_get_diagnostic_count(assembly->context, NESLA_DIAGNOSTIC_MAX); ++index) {
+        const nesla_diagnostic_t *diagnostic = nesla_context_get_diagnostic(assembly->context, index);
+
+        if((diagnostic->level == level) && strstr(diagnostic->message, message)) {
+            ++result;
+        }
+    }
+
+    return result;
+}
+
+/*!
+ * @brief Get test assembly program bank data.
+ * @param[in] assembly Constant pointer to test assembly context
+ * @param[in] bank Program bank index
+ * @param[in] address Address, mapped into the bank by its length
+ * @return Constant pointer to data, or NULL if the image is shorter
+ */
+static inline const uint8_t *nesla_test_get(const nesla_test_assembly_t *assembly, size_t bank, uint16_t address)
+{
+    size_t offset = TEST_HEADER_LENGTH + (bank * TEST_PROGRAM_LENGTH) + (address % TEST_PROGRAM_LENGTH);
+
+    return (assembly->output && (offset < assembly->length)) ? assembly->output + offset : NULL;
+}
+
+/*!
+ * @brief Compare test assembly program bank data.
+ * @param[in] assembly Constant pointer to test assembly context
+ * @param[in] bank Program bank index
+ * @param[in] address Address, mapped into the bank by its length
+ * @param[in] data Constant pointer to expected data
+ * @param[in] length Expected data length in bytes
+ * @return true if the data matches, false otherwise
+ */
+static inline bool nesla_test_match(const nesla_test_assembly_t *assembly, size_t bank, uint16_t address, const uint8_t *data,
+    size_t length)
+{
+    const uint8_t *actual = nesla_test_get(assembly, bank, address);
+
+    return actual && ((actual - assembly->output) + length <= assembly->length) && !memcmp(actual, data, length);
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* NESLA_TEST_ASSEMBLE_H_ */
@@ -0,0 +1,153 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file main.c
+ * @brief Hot leaf subroutine inlining tests.
+ */
+
+#include <inline.h>
+#include <test.h>
+#include <assemble.h>
+
+static nesla_test_assembly_t g_test = {};   /*!< Test assembly context */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Test inlining a call in a loop, with branches to the RTS retargeted past the copy, leaving a cold call alone.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_inline_call(void)
+{
+    static const char *SOURCE = ".PRG 1\n.BANK 0\n.ORG $C000\nreset:\nLDX #0\nloop:\nJSR sub\nDEX\nBNE loop\nJSR sub\nRTS\nsub:\n"
+        "LDA $0300\nBEQ _done\nSTA $0301\n_done:\nRTS\n" TEST_VECTORS;
+    static const uint8_t EXPECTED[] = {
+        0xA2, 0x00, 0xAD, 0x00, 0x03, 0xF0, 0x03, 0x8D, 0x01, 0x03, 0xCA, 0xD0, 0xF5, 0x20, 0x11, 0xC0, 0x60,
+        };
+    static const uint8_t EXPECTED_CALL[] = { 0xA2, 0x00, 0x20, 0x0C, 0xC0, 0xCA, 0xD0, 0xFA, };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, SOURCE, NESLA_FLAG_INLINE) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Call to sub inlined: +5 bytes, -12 cycles per call, ~8 calls") == 1)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "inlined") == 1)
+            && nesla_test_match(&g_test, 0, 0xC000, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble(&g_test, SOURCE, 0) == NESLA_SUCCESS)
+            && !nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "inlined")
+            && nesla_test_match(&g_test, 0, 0xC000, EXPECTED_CALL, sizeof(EXPECTED_CALL)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test inlining only while the code still fits before the next section in its bank.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_inline_fit(void)
+{
+    static const char *SOURCE = ".PRG 1\n.BANK 0\n.ORG $C000\nreset:\nLDX #0\nloop:\nJSR sub\nDEX\nBNE loop\nRTS\nsub:\nLDA $0300\n"
+        "STA $0301\nRTS\n.ORG $%04X\n.BYTE 1\n" TEST_VECTORS;
+    static const uint8_t EXPECTED[] = { 0xA2, 0x00, 0xAD, 0x00, 0x03, 0x8D, 0x01, 0x03, 0xCA, 0xD0, 0xF7, 0x60, };
+    static const uint8_t EXPECTED_CALL[] = { 0xA2, 0x00, 0x20, 0x09, 0xC0, 0xCA, 0xD0, 0xFA, 0x60, };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble_format(&g_test, NESLA_FLAG_INLINE, SOURCE, 0xC011) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE,
+                "Call to sub not inlined: +3 bytes do not fit before the next section") == 1)
+            && nesla_test_match(&g_test, 0, 0xC000, EXPECTED_CALL, sizeof(EXPECTED_CALL)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble_format(&g_test, NESLA_FLAG_INLINE, SOURCE, 0xC013) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Call to sub inlined: +3 bytes") == 1)
+            && nesla_test_match(&g_test, 0, 0xC000, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test calls left alone, between .NOOPT and .OPT, or into a subroutine that calls another.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_inline_skip(void)
+{
+    static const uint8_t EXPECTED[] = { 0xA2, 0x00, 0x20, 0x0C, 0xC0, 0xCA, 0xD0, 0xFA, 0x20, 0x10, 0xC0, 0x60, };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, ".PRG 1\n.BANK 0\n.ORG $C000\nreset:\nLDX #0\nloop:\n.NOOPT\nJSR sub\n.OPT\nDEX\nBNE loop\n"
+                ".HOT\nJSR outer\nRTS\nsub:\nLDA $0300\nRTS\nouter:\nJSR sub\nRTS\n" TEST_VECTORS, NESLA_FLAG_INLINE) == NESLA_SUCCESS)
+            && !nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "inlined")
+            && nesla_test_match(&g_test, 0, 0xC000, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+int main(void)
+{
+    static const test TEST[] = {
+        nesla_test_inline_call,
+        nesla_test_inline_fit,
+        nesla_test_inline_skip,
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(int index = 0; index < TEST_COUNT(TEST); ++index) {
+
+        if(TEST[index]() == NESLA_FAILURE) {
+            result = NESLA_FAILURE;
+        }
+    }
+
+    return (int)result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
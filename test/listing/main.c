@@ -0,0 +1,210 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file main.c
+ * @brief Assembly listing tests.
+ */
+
+#include <assembler.h>
+#include <test.h>
+
+#define TEST_LISTING_MAX 8192               /*!< Maximum test listing length in bytes */
+
+/*!
+ * @struct nesla_test_t
+ * @brief Test context.
+ */
+typedef struct {
+    nesla_context_t *context;               /*!< Assembler context handle */
+    nesla_assembler_t assembler;            /*!< Assembler context */
+    uint8_t *image;                         /*!< Image buffer */
+    char listing[TEST_LISTING_MAX];         /*!< Listing buffer */
+} nesla_test_t;
+
+static nesla_test_t g_test = {};            /*!< Test context */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Release test context.
+ */
+static void nesla_test_release(void)
+{
+
+    if(g_test.context) {
+        nesla_context_free(g_test.context, g_test.image);
+        nesla_assembler_uninitialize(&g_test.assembler);
+        nesla_context_destroy(g_test.context);
+    }
+
+    memset(&g_test, 0, sizeof(g_test));
+}
+
+/*!
+ * @brief Assemble test source and write its listing, once the image is written.
+ * @param[in] source Constant pointer to source string
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_listing(const char *source)
+{
+    size_t size;
+    nesla_writer_t writer = {};
+    nesla_source_t buffer = { "test.asm", (const uint8_t *)source, strlen(source), NULL, NULL, };
+    nesla_error_e result;
+
+    nesla_test_release();
+
+    if((result = nesla_context_create(&g_test.context, NULL)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if((result = nesla_assembler_initialize_buffer(&g_test.assembler, g_test.context, &buffer)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    size = nesla_assembler_get_size(&g_test.assembler);
+
+    if(!(g_test.image = nesla_context_allocate(g_test.context, size))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if((result = nesla_assembler_write_buffer(&g_test.assembler, g_test.image, size)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    if((result = nesla_writer_open_buffer(&writer, g_test.context, "test.lst", (uint8_t *)g_test.listing,
+            sizeof(g_test.listing) - 1)) == NESLA_FAILURE) {
+        goto exit;
+    }
+
+    result = nesla_listing_write(&g_test.assembler.encoder, &writer);
+    nesla_writer_close(&writer);
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Test listing cycles, of instructions, labels and blocks, with indexed reads and branches that can cross a page.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_listing_cycle(void)
+{
+    static const char *EXPECTED[] = {
+        "reset:                                                            ; 2 cycles, 1 instruction(s), to the next label\n",
+        "00:C000  A2 00        2             LDX   #$00                    ; test.asm:5\n",
+        "loop:                                                             ; 8-10 cycles, 3 instruction(s), to the next label\n",
+        "00:C002  BD F0 02     4-5    page?  LDA   $02F0,X                 ; test.asm:7\n",
+        "00:C006  D0 FA        2-3           BNE   loop                    ; test.asm:9\n",
+        "                                                                  ; block: 8-10 cycles, 3 instruction(s)\n",
+        "00:C100  D0 FB        2-4    page   BNE   back                    ; test.asm:15\n",
+        "00:C102  60           6             RTS                           ; test.asm:16\n",
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT(nesla_test_listing(".PRG 1\n.BANK 0\n.ORG $C000\nreset:\nLDX #0\nloop:\nLDA $02F0,X\nINX\nBNE loop\n.ORG $C0FD\nback:\n"
+            "INX\nNOP\nNOP\nBNE back\nRTS\n.ORG $FFFA\n.WORD reset\n.WORD reset\n.WORD reset\n") == NESLA_SUCCESS)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    for(size_t index = 0; index < TEST_COUNT(EXPECTED); ++index) {
+
+        if(ASSERT(strstr(g_test.listing, EXPECTED[index]))) {
+            result = NESLA_FAILURE;
+            goto exit;
+        }
+    }
+
+exit:
+    nesla_test_release();
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test listing data, as the .BYTE or .WORD items it emits, up to LISTING_DATA_MAX bytes per line.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_listing_data(void)
+{
+    static const char *EXPECTED[] = {
+        "00:C001  00 03 06 ...               .BYTE $00, $03, $06, $09      ; test.asm:6\n",
+        "00:C005  0C 0F                      .BYTE $0C, $0F                ; test.asm:6\n",
+        "00:C007  00 00 01 ...               .WORD $0000, $0101            ; test.asm:7\n",
+        "00:C00B  02 02                      .WORD $0202                   ; test.asm:7\n",
+        "00:C00D  07                         .BYTE $07                     ; test.asm:8\n",
+        "00:C00E  00 C0                      .WORD reset                   ; test.asm:9\n",
+        "00:FFFA  00 C0                      .WORD reset                   ; test.asm:11\n",
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT(nesla_test_listing(".PRG 1\n.BANK 0\n.ORG $C000\nreset:\nRTS\n.TABLE BYTE bytes 0, 5, \"I * 3\"\n"
+            ".TABLE WORD words 0, 2, \"I * $101\"\n.BYTE 7\n.WORD reset\n.ORG $FFFA\n.WORD reset\n.WORD reset\n.WORD reset\n")
+                == NESLA_SUCCESS)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    for(size_t index = 0; index < TEST_COUNT(EXPECTED); ++index) {
+
+        if(ASSERT(strstr(g_test.listing, EXPECTED[index]))) {
+            result = NESLA_FAILURE;
+            goto exit;
+        }
+    }
+
+exit:
+    nesla_test_release();
+    TEST_RESULT(result);
+
+    return result;
+}
+
+int main(void)
+{
+    static const test TEST[] = {
+        nesla_test_listing_cycle,
+        nesla_test_listing_data,
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(int index = 0; index < TEST_COUNT(TEST); ++index) {
+
+        if(TEST[index]() == NESLA_FAILURE) {
+            result = NESLA_FAILURE;
+        }
+    }
+
+    return (int)result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,169 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file main.c
+ * @brief Identical data block merge tests.
+ */
+
+#include <merge.h>
+#include <test.h>
+#include <assemble.h>
+
+#define TEST_TILE_COUNT 256                 /*!< Tile count per pattern table */
+#define TEST_TILE_LENGTH 16                 /*!< Tile length in bytes */
+
+static nesla_test_assembly_t g_test = {};   /*!< Test assembly context */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Test identical data blocks only merged into a copy in the same bank, or in the last (fixed) bank.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_merge_bank(void)
+{
+    static const uint8_t EXPECTED[] = { 0x01, 0x02, 0x03, 0x04, };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, ".PRG 3\n.BANK 0\n.ORG $8000\nzero:\n.BYTE 1, 2, 3, 4\n.BANK 1\n.ORG $8000\none:\n"
+                ".BYTE 1, 2, 3, 4\n.BANK 2\n.ORG $C000\nreset:\nLDA zero\nLDA one\nRTS\n" TEST_VECTORS, NESLA_FLAG_MERGE) == NESLA_SUCCESS)
+            && !nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Identical data merged")
+            && nesla_test_match(&g_test, 0, 0x8000, EXPECTED, sizeof(EXPECTED))
+            && nesla_test_match(&g_test, 1, 0x8000, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test identical data blocks merged, with their labels aliasing the earlier copy, and blocks left alone.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_merge_block(void)
+{
+    static const char *SOURCE = ".PRG 2\n.BANK 1\n.ORG $C000\nreset:\nLDA first\nLDA second\nLDA third\nLDA words2\nLDA banked\nRTS\n"
+        "first:\n.BYTE 1, 2, 3, 4\nsecond:\n.BYTE 1, 2\n_mid:\n.BYTE 3, 4\nthird:\n.BYTE 1, 2, 3\nwords1:\n.WORD reset, first\nwords2:\n"
+        ".WORD reset, first\n.NOOPT\nheld:\n.BYTE 1, 2, 3, 4\n.OPT\n.BANK 0\n.ORG $8000\nbanked:\n.BYTE 1, 2, 3, 4\n.BANK 1\n" TEST_VECTORS;
+    static const uint8_t EXPECTED[] = {
+        0xAD, 0x10, 0xC0, 0xAD, 0x10, 0xC0, 0xAD, 0x14, 0xC0, 0xAD, 0x17, 0xC0, 0xAD, 0x10, 0xC0, 0x60, 0x01, 0x02, 0x03, 0x04, 0x01,
+        0x02, 0x03, 0x00, 0xC0, 0x10, 0xC0, 0x01, 0x02, 0x03, 0x04, 0xFF,
+        };
+    static const uint8_t EXPECTED_BANK[] = { 0xFF, 0xFF, 0xFF, 0xFF, };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, SOURCE, NESLA_FLAG_MERGE) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Identical data merged: 3 block(s), 12 bytes") == 1)
+            && nesla_test_match(&g_test, 1, 0xC000, EXPECTED, sizeof(EXPECTED))
+            && nesla_test_match(&g_test, 0, 0x8000, EXPECTED_BANK, sizeof(EXPECTED_BANK)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble(&g_test, SOURCE, 0) == NESLA_SUCCESS)
+            && !nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Identical data merged")
+            && !nesla_test_match(&g_test, 1, 0xC000, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test identical tiles merged in each pattern table of a character bank, mapped to their first copy and left in place.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_merge_tile(void)
+{
+    static const char *SOURCE = ".PRG 1\n.CHR 1\n.BANK 0\n.ORG $C000\nreset:\nRTS\n" TEST_VECTORS ".BANK 1\n.ORG $0000\n"
+        ".BYTE 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1\n.BYTE 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2\n"
+        ".BYTE 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1\n.BYTE 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2\n";
+    static const uint8_t EXPECTED[] = { 0x01, 0x02, 0x01, 0x02, 0xFF, };
+    static const uint8_t EXPECTED_MAP[] = { 0x00, 0x01, 0x00, 0x01, 0x04, 0x04, };
+    const nesla_statistics_t *statistics;
+    const uint8_t *map;
+    size_t length = 0;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, SOURCE, NESLA_FLAG_TILE) == NESLA_SUCCESS)
+            && (statistics = nesla_context_get_statistics(g_test.context))
+            && (statistics->merged_tiles == 2)
+            && (map = nesla_context_get_map(g_test.context, &length))
+            && (length == 2 * TEST_TILE_COUNT)
+            && !memcmp(map, EXPECTED_MAP, sizeof(EXPECTED_MAP))
+            && (map[TEST_TILE_COUNT - 1] == 0x04)
+            && (map[TEST_TILE_COUNT] == 0x00))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    for(size_t tile = 0; tile < sizeof(EXPECTED); ++tile) {
+        const uint8_t *data = nesla_test_get(&g_test, 1, tile * TEST_TILE_LENGTH);
+
+        if(ASSERT(data && (data[0] == EXPECTED[tile]) && (data[TEST_TILE_LENGTH - 1] == EXPECTED[tile]))) {
+            result = NESLA_FAILURE;
+            goto exit;
+        }
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+int main(void)
+{
+    static const test TEST[] = {
+        nesla_test_merge_bank,
+        nesla_test_merge_block,
+        nesla_test_merge_tile,
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(int index = 0; index < TEST_COUNT(TEST); ++index) {
+
+        if(TEST[index]() == NESLA_FAILURE) {
+            result = NESLA_FAILURE;
+        }
+    }
+
+    return (int)result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,320 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file main.c
+ * @brief Public interface tests.
+ */
+
+#include <assembler.h>
+#include <test.h>
+#include <assemble.h>
+
+#define TEST_ERROR_COUNT 100                /*!< Errors in a source, past the diagnostics kept */
+#define TEST_NOTE_COUNT 40                  /*!< Notes in a source, past the notes and warnings kept */
+#define TEST_THREAD_COUNT 4                 /*!< Threads assembling at once */
+#define TEST_THREAD_RUNS 8                  /*!< Assemblies run by each thread */
+
+static const char *FAILING = ".PRG 1\n.BANK 0\n.ORG $C000\nreset:\nJMP missing\n" TEST_VECTORS;       /*!< Source failing to assemble */
+static const char *PASSING = ".PRG 1\n.BANK 0\n.ORG $C000\nreset:\nLDA #1\nRTS\n" TEST_VECTORS;     /*!< Source assembling */
+
+static nesla_test_assembly_t g_test = {};   /*!< Test assembly context */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Assemble test source with the legacy interface, checking the per-thread error string it leaves.
+ * @param[in] source Constant pointer to source string
+ * @return true if the error string is set only on failure, false otherwise
+ */
+static bool nesla_test_legacy(const char *source)
+{
+    uint8_t *output = NULL;
+    size_t length = 0;
+    nesla_source_t buffer = { "test.asm", (const uint8_t *)source, strlen(source), NULL, NULL, };
+    bool result = (nesla_buffer(&buffer, &output, &length) == NESLA_SUCCESS) ? !nesla_get_error()[0]
+        : (strstr(nesla_get_error(), "Undefined symbol: missing") != NULL);
+
+    free(output);
+
+    return result;
+}
+
+/*!
+ * @brief Assemble test sources in a thread, alternating between passing and failing, each with its own context handle.
+ * @param[in] context Pointer to thread index
+ * @return thrd_success if every assembly ends as expected, thrd_error otherwise
+ */
+static int nesla_test_thread(void *context)
+{
+    size_t thread = *(const size_t *)context;
+    nesla_test_assembly_t assembly = {};
+    int result = thrd_success;
+
+    for(size_t run = 0; run < TEST_THREAD_RUNS; ++run) {
+        bool failing = (thread + run) % 2;
+
+        if((nesla_test_assemble(&assembly, failing ? FAILING : PASSING, 0) != (failing ? NESLA_FAILURE : NESLA_SUCCESS))
+                || (nesla_test_diagnostic(&assembly, NESLA_DIAGNOSTIC_ERROR, "Undefined symbol: missing") != failing)
+                || !nesla_test_legacy(failing ? FAILING : PASSING)) {
+            result = thrd_error;
+            break;
+        }
+    }
+
+    nesla_test_release(&assembly);
+
+    return result;
+}
+
+/*!
+ * @brief Test context handles used in sequence, each keeping its own diagnostics and error until its next assembly.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_context_sequence(void)
+{
+    nesla_test_assembly_t other = {};
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, FAILING, 0) == NESLA_FAILURE)
+            && (nesla_test_assemble(&other, PASSING, 0) == NESLA_SUCCESS)
+            && !nesla_context_get_diagnostic_count(other.context, NESLA_DIAGNOSTIC_MAX)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, "Undefined symbol: missing") == 1)
+            && strstr(nesla_context_get_error(g_test.context), "Undefined symbol: missing (test.asm@5:5)"))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble(&g_test, PASSING, 0) == NESLA_SUCCESS)
+            && !nesla_context_get_diagnostic_count(g_test.context, NESLA_DIAGNOSTIC_MAX)
+            && !nesla_context_get_diagnostic_count(g_test.context, NESLA_DIAGNOSTIC_ERROR)
+            && nesla_test_match(&g_test, 0, 0xC000, other.output + TEST_HEADER_LENGTH, 3))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&other);
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test context handles used across threads at once, with the legacy error string kept per thread.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_context_thread(void)
+{
+    size_t index[TEST_THREAD_COUNT];
+    thrd_t thread[TEST_THREAD_COUNT];
+    size_t count = 0;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(; count < TEST_THREAD_COUNT; ++count) {
+        index[count] = count;
+
+        if(ASSERT(thrd_create(&thread[count], nesla_test_thread, &index[count]) == thrd_success)) {
+            result = NESLA_FAILURE;
+            break;
+        }
+    }
+
+    for(size_t joined = 0; joined < count; ++joined) {
+        int status = thrd_error;
+
+        if(ASSERT((thrd_join(thread[joined], &status) == thrd_success)
+                && (status == thrd_success))) {
+            result = NESLA_FAILURE;
+        }
+    }
+
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test diagnostics kept, up to CONTEXT_DIAGNOSTIC_MAX, with the assembly stopping once they are full.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_diagnostic_cap(void)
+{
+    size_t length;
+    static char source[TEST_SOURCE_MAX];
+    nesla_error_e result = NESLA_SUCCESS;
+
+    length = snprintf(source, sizeof(source), ".PRG 1\n.BANK 0\n.ORG $C000\nreset:\nRTS\n");
+
+    for(int index = 0; index < TEST_ERROR_COUNT; ++index) {
+        length += snprintf(source + length, sizeof(source) - length, "LDA #$1FF\n");
+    }
+
+    snprintf(source + length, sizeof(source) - length, TEST_VECTORS);
+
+    if(ASSERT((nesla_test_assemble(&g_test, source, 0) == NESLA_FAILURE)
+            && (nesla_context_get_diagnostic_count(g_test.context, NESLA_DIAGNOSTIC_MAX) == CONTEXT_DIAGNOSTIC_MAX)
+            && (nesla_context_get_diagnostic_count(g_test.context, NESLA_DIAGNOSTIC_ERROR) == CONTEXT_DIAGNOSTIC_MAX)
+            && (nesla_context_get_diagnostic(g_test.context, CONTEXT_DIAGNOSTIC_MAX - 1)->line == CONTEXT_DIAGNOSTIC_MAX + 5)
+            && !nesla_context_get_diagnostic(g_test.context, CONTEXT_DIAGNOSTIC_MAX)
+            && strstr(nesla_context_get_error(g_test.context), "Value too large: 511 (test.asm@6:6), and 63 more error(s)"))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test notes and warnings kept, up to CONTEXT_NOTE_MAX, leaving room for the errors reported after them.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_diagnostic_note(void)
+{
+    size_t length;
+    static char source[TEST_SOURCE_MAX];
+    nesla_error_e result = NESLA_SUCCESS;
+
+    length = snprintf(source, sizeof(source), ".PRG 1\n.BANK 0\n.ORG $C000\nreset:\nRTS\nsub:\nRTS\n");
+
+    for(int index = 0; index < TEST_NOTE_COUNT; ++index) {
+        length += snprintf(source + length, sizeof(source) - length, "tail%i:\nJSR sub\nRTS\n", index);
+    }
+
+    snprintf(source + length, sizeof(source) - length, "JMP missing\n" TEST_VECTORS);
+
+    if(ASSERT((nesla_test_assemble(&g_test, source, NESLA_FLAG_PEEPHOLE) == NESLA_FAILURE)
+            && (nesla_context_get_diagnostic_count(g_test.context, NESLA_DIAGNOSTIC_NOTE) == TEST_NOTE_COUNT)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Tail call rewritten as JMP") == CONTEXT_NOTE_MAX)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, "Undefined symbol: missing") == 1)
+            && (nesla_context_get_diagnostic_count(g_test.context, NESLA_DIAGNOSTIC_MAX) == CONTEXT_NOTE_MAX + 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test errors reported on each line, recovering at the next line, and summarized in the error string.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_diagnostic_recover(void)
+{
+    static const struct {
+        size_t line;
+        size_t column;
+        const char *message;
+    } EXPECTED[] = {
+        { 6, 6, "Value too large: 511", },
+        { 7, 1, "Unsupported token", },
+        { 5, 5, "Undefined symbol: missing", },
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, ".PRG 1\n.BANK 0\n.ORG $C000\nreset:\nJMP missing\nLDA #$1FF\nFOO\nLDA #1\n"
+                TEST_VECTORS, 0) == NESLA_FAILURE)
+            && (nesla_context_get_diagnostic_count(g_test.context, NESLA_DIAGNOSTIC_ERROR) == TEST_COUNT(EXPECTED))
+            && strstr(nesla_context_get_error(g_test.context), "Value too large: 511 (test.asm@6:6), and 2 more error(s)"))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    for(size_t index = 0; index < TEST_COUNT(EXPECTED); ++index) {
+        const nesla_diagnostic_t *diagnostic = nesla_context_get_diagnostic(g_test.context, index);
+
+        if(ASSERT(diagnostic
+                && (diagnostic->level == NESLA_DIAGNOSTIC_ERROR)
+                && (diagnostic->line == EXPECTED[index].line)
+                && (diagnostic->column == EXPECTED[index].column)
+                && strstr(diagnostic->message, EXPECTED[index].message))) {
+            result = NESLA_FAILURE;
+            goto exit;
+        }
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test legacy error string, set by a failing call and cleared by the next call that succeeds.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_legacy_error(void)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT(nesla_test_legacy(FAILING)
+            && nesla_get_error()[0]
+            && nesla_test_legacy(PASSING)
+            && !nesla_get_error()[0])) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    TEST_RESULT(result);
+
+    return result;
+}
+
+int main(void)
+{
+    static const test TEST[] = {
+        nesla_test_context_sequence,
+        nesla_test_context_thread,
+        nesla_test_diagnostic_cap,
+        nesla_test_diagnostic_note,
+        nesla_test_diagnostic_recover,
+        nesla_test_legacy_error,
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(int index = 0; index < TEST_COUNT(TEST); ++index) {
+
+        if(TEST[index]() == NESLA_FAILURE) {
+            result = NESLA_FAILURE;
+        }
+    }
+
+    return (int)result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,216 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file main.c
+ * @brief Opcode tests.
+ */
+
+#include <opcode.h>
+#include <test.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Test opcode decode.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_opcode_decode(void)
+{
+    size_t count = 0;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(int opcode = 0; opcode <= UINT8_MAX; ++opcode) {
+        nesla_mode_e mode;
+        nesla_instruction_e instruction;
+
+        if(nesla_opcode_decode(opcode, &instruction, &mode)) {
+            const nesla_opcode_t *entry = nesla_opcode_get(instruction, mode);
+
+            if(ASSERT(entry->valid && (entry->opcode == opcode))) {
+                result = NESLA_FAILURE;
+                goto exit;
+            }
+
+            ++count;
+        }
+    }
+
+    if(ASSERT(count == 151)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test opcode get.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_opcode_get(void)
+{
+    const nesla_opcode_t *entry;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT(((entry = nesla_opcode_get(INSTRUCTION_LDA, MODE_ABSOLUTE_X))->valid)
+            && (entry->opcode == 0xBD)
+            && (entry->length == 3)
+            && (entry->cycles == 4)
+            && (entry->penalty == PENALTY_PAGE))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT(((entry = nesla_opcode_get(INSTRUCTION_STA, MODE_INDIRECT_Y))->valid)
+            && (entry->opcode == 0x91)
+            && (entry->length == 2)
+            && (entry->cycles == 6)
+            && (entry->penalty == PENALTY_NONE))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT(((entry = nesla_opcode_get(INSTRUCTION_BNE, MODE_RELATIVE))->valid)
+            && (entry->opcode == 0xD0)
+            && (entry->length == 2)
+            && (entry->cycles == 2)
+            && (entry->penalty == PENALTY_BRANCH))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT(!nesla_opcode_get(INSTRUCTION_STA, MODE_IMMEDIATE)->valid
+            && !nesla_opcode_get(INSTRUCTION_JMP, MODE_ZERO_PAGE)->valid)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test opcode get instruction name.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_opcode_get_instruction(void)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT(!strcmp(nesla_opcode_get_instruction(INSTRUCTION_ADC), "ADC")
+            && !strcmp(nesla_opcode_get_instruction(INSTRUCTION_TYA), "TYA"))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test opcode get addressing mode name.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_opcode_get_mode(void)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT(!strcmp(nesla_opcode_get_mode(MODE_IMPLIED), "implied")
+            && !strcmp(nesla_opcode_get_mode(MODE_RELATIVE), "relative"))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test opcode invert.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_opcode_invert(void)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(nesla_instruction_e instruction = 0; instruction < INSTRUCTION_MAX; ++instruction) {
+        nesla_instruction_e inverse = nesla_opcode_invert(instruction);
+
+        if(!nesla_opcode_get(instruction, MODE_RELATIVE)->valid) {
+
+            if(ASSERT(inverse == INSTRUCTION_MAX)) {
+                result = NESLA_FAILURE;
+                goto exit;
+            }
+        } else if(ASSERT((inverse != instruction) && (nesla_opcode_invert(inverse) == instruction))) {
+            result = NESLA_FAILURE;
+            goto exit;
+        }
+    }
+
+    if(ASSERT(nesla_opcode_invert(INSTRUCTION_BNE) == INSTRUCTION_BEQ)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    TEST_RESULT(result);
+
+    return result;
+}
+
+int main(void)
+{
+    static const test TEST[] = {
+        nesla_test_opcode_decode,
+        nesla_test_opcode_get,
+        nesla_test_opcode_get_instruction,
+        nesla_test_opcode_get_mode,
+        nesla_test_opcode_invert,
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(int index = 0; index < TEST_COUNT(TEST); ++index) {
+
+        if(TEST[index]() == NESLA_FAILURE) {
+            result = NESLA_FAILURE;
+        }
+    }
+
+    return (int)result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
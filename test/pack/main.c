@@ -0,0 +1,357 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file main.c
+ * @brief Packed block compression tests.
+ */
+
+#include <pack.h>
+#include <test.h>
+#include <assemble.h>
+
+#define TEST_BLOCK_MAX 512                  /*!< Maximum test block length in bytes */
+
+static const char *MODE[] = { "RLE", "LZ", };   /*!< Compression mode names */
+
+static nesla_test_assembly_t g_test = {};   /*!< Test assembly context */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Assemble test source, with a single packed block placed at the start of the first bank.
+ * @param[in] mode Compression mode
+ * @param[in] data Constant pointer to block data
+ * @param[in] length Block data length in bytes
+ * @param[in] cache Constant pointer to compression cache directory, or NULL
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_assemble_block(uint8_t mode, const uint8_t *data, size_t length, const char *cache)
+{
+    static char source[TEST_SOURCE_MAX];
+    nesla_source_t buffer = { "test.asm", (const uint8_t *)source, 0, NULL, NULL, };
+    size_t used = snprintf(source, sizeof(source), ".PRG 2\n.BANK 0\n.ORG $8000\n.PACK %s block\n", MODE[mode]);
+
+    for(size_t index = 0; index < length; ++index) {
+        used += snprintf(source + used, sizeof(source) - used, "%s%u%s", (index % 16) ? "," : ".BYTE ", data[index],
+            (((index % 16) == 15) || (index == (length - 1))) ? "\n" : "");
+    }
+
+    snprintf(source + used, sizeof(source) - used, ".BANK 1\n.ORG $C000\nreset:\nLDX #block\nJSR UNPACK_%s\nRTS\n"
+        TEST_VECTORS, MODE[mode]);
+    buffer.length = strlen(source);
+    nesla_test_release(&g_test);
+
+    if(nesla_context_create(&g_test.context, NULL) == NESLA_FAILURE) {
+        return NESLA_FAILURE;
+    }
+
+    nesla_context_set_cache(g_test.context, cache);
+
+    return nesla_context_assemble_buffer(g_test.context, &buffer, &g_test.output, &g_test.length);
+}
+
+/*!
+ * @brief Decompress test block, at the start of the first bank, as the decompressor does.
+ * @param[in] mode Compression mode
+ * @param[in,out] output Pointer to decompressed data
+ * @param[in,out] length Pointer to decompressed data length in bytes
+ * @return true if the block decompressed within TEST_BLOCK_MAX bytes, false otherwise
+ */
+static bool nesla_test_unpack(uint8_t mode, uint8_t *output, size_t *length)
+{
+    const uint8_t *data = nesla_test_get(&g_test, 0, 0x8000);
+
+    *length = 0;
+
+    for(;;) {
+        uint8_t control = *data++;
+
+        if(!control) {
+            return true;
+        } else if(!(control & 0x80)) {
+
+            if((*length + control) > TEST_BLOCK_MAX) {
+                return false;
+            }
+
+            memcpy(output + *length, data, control);
+            data += control;
+            *length += control;
+        } else {
+            size_t count = (control & 0x7F) + ((mode == UNPACK_LZ) ? PACK_MATCH_MIN : 1), distance = *data++ + 1;
+
+            if(((*length + count) > TEST_BLOCK_MAX) || ((mode == UNPACK_LZ) && (distance > *length))) {
+                return false;
+            }
+
+            for(; count; --count, ++*length) {
+                output[*length] = (mode == UNPACK_LZ) ? output[*length - distance] : data[-1];
+            }
+        }
+    }
+}
+
+/*!
+ * @brief Compress test block, checking it decompresses to the block data, and is encoded as expected.
+ * @param[in] mode Compression mode
+ * @param[in] data Constant pointer to block data
+ * @param[in] length Block data length in bytes
+ * @param[in] expected Constant pointer to expected compressed data
+ * @param[in] expected_length Expected compressed data length in bytes
+ * @return true if the block matched, false otherwise
+ */
+static bool nesla_test_round_trip(uint8_t mode, const uint8_t *data, size_t length, const uint8_t *expected, size_t expected_length)
+{
+    size_t output_length;
+    uint8_t output[TEST_BLOCK_MAX];
+
+    return (nesla_test_assemble_block(mode, data, length, NULL) == NESLA_SUCCESS)
+        && nesla_test_match(&g_test, 0, 0x8000, expected, expected_length)
+        && nesla_test_unpack(mode, output, &output_length)
+        && (output_length == length)
+        && !memcmp(output, data, length);
+}
+
+/*!
+ * @brief Test packed block compression cache, read back only if it decompresses to the block data.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_pack_cache(void)
+{
+    FILE *file;
+    uint64_t hash = 0xCBF29CE484222325;
+    char directory[] = "/tmp/nesla_pack_XXXXXX", path[64] = {};
+    static const uint8_t CORRUPT[] = { 0x05, 0x01, 0x00, };
+    static const uint8_t DATA[] = { 1, 2, 3, 1, 2, 3, 1, 2, 3, 4, };
+    static const uint8_t EXPECTED[] = { 0x03, 0x01, 0x02, 0x03, 0x83, 0x02, 0x01, 0x04, 0x00, };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(size_t index = 0; index < sizeof(DATA); ++index) {
+        hash = (hash ^ DATA[index]) * 0x100000001B3;
+    }
+
+    if(ASSERT(mkdtemp(directory))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    snprintf(path, sizeof(path), "%s/%016" PRIx64 "-%zu.lz", directory, hash, sizeof(DATA));
+
+    if(ASSERT((nesla_test_assemble_block(UNPACK_LZ, DATA, sizeof(DATA), directory) == NESLA_SUCCESS)
+            && !nesla_context_get_statistics(g_test.context)->cached
+            && nesla_test_match(&g_test, 0, 0x8000, EXPECTED, sizeof(EXPECTED))
+            && !access(path, F_OK))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble_block(UNPACK_LZ, DATA, sizeof(DATA), directory) == NESLA_SUCCESS)
+            && (nesla_context_get_statistics(g_test.context)->cached == 1)
+            && nesla_test_match(&g_test, 0, 0x8000, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((file = fopen(path, "wb")) && (fwrite(CORRUPT, sizeof(*CORRUPT), sizeof(CORRUPT), file) == sizeof(CORRUPT))
+            && !fclose(file))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble_block(UNPACK_LZ, DATA, sizeof(DATA), directory) == NESLA_SUCCESS)
+            && !nesla_context_get_statistics(g_test.context)->cached
+            && nesla_test_match(&g_test, 0, 0x8000, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble_block(UNPACK_LZ, DATA, sizeof(DATA), directory) == NESLA_SUCCESS)
+            && (nesla_context_get_statistics(g_test.context)->cached == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    unlink(path);
+    rmdir(directory);
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test packed block compression of empty and single byte blocks.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_pack_empty(void)
+{
+    static const uint8_t DATA[] = { 42, };
+    static const uint8_t EXPECTED[] = { 0x01, 42, 0x00, };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(uint8_t mode = UNPACK_RLE; mode <= UNPACK_LZ; ++mode) {
+
+        if(ASSERT(nesla_test_round_trip(mode, DATA, sizeof(DATA), EXPECTED, sizeof(EXPECTED)))) {
+            result = NESLA_FAILURE;
+            goto exit;
+        }
+
+        if(ASSERT((nesla_test_assemble_block(mode, NULL, 0, NULL) == NESLA_FAILURE)
+                && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, "Empty packed block: block") == 1))) {
+            result = NESLA_FAILURE;
+            goto exit;
+        }
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test packed block LZ compression, of matches at the minimum and maximum length, and at the edge of the window.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_pack_lz(void)
+{
+    size_t length;
+    uint8_t data[TEST_BLOCK_MAX] = {}, expected[TEST_BLOCK_MAX] = {};
+    static const uint8_t SHORT[] = { 1, 2, 1, 2, };
+    static const uint8_t SHORT_EXPECTED[] = { 0x04, 1, 2, 1, 2, 0x00, };
+    static const uint8_t MINIMUM[] = { 1, 2, 3, 1, 2, 3, };
+    static const uint8_t MINIMUM_EXPECTED[] = { 0x03, 1, 2, 3, 0x80, 0x02, 0x00, };
+    static const uint8_t MAXIMUM_EXPECTED[] = { 0x01, 5, 0xFF, 0x00, 0x01, 5, 0x00, };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT(nesla_test_round_trip(UNPACK_LZ, SHORT, sizeof(SHORT), SHORT_EXPECTED, sizeof(SHORT_EXPECTED))
+            && nesla_test_round_trip(UNPACK_LZ, MINIMUM, sizeof(MINIMUM), MINIMUM_EXPECTED, sizeof(MINIMUM_EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    memset(data, 5, PACK_MATCH_MAX + 2);
+
+    if(ASSERT(nesla_test_round_trip(UNPACK_LZ, data, PACK_MATCH_MAX + 2, MAXIMUM_EXPECTED, sizeof(MAXIMUM_EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    for(length = 0; length < PACK_WINDOW; ++length) {
+        data[length] = length;
+    }
+
+    memcpy(data + length, data, PACK_MATCH_MIN);
+    length += PACK_MATCH_MIN;
+    expected[0] = PACK_LITERAL_MAX;
+    memcpy(expected + 1, data, PACK_LITERAL_MAX);
+    expected[PACK_LITERAL_MAX + 1] = PACK_LITERAL_MAX;
+    memcpy(expected + PACK_LITERAL_MAX + 2, data + PACK_LITERAL_MAX, PACK_LITERAL_MAX);
+    expected[(2 * PACK_LITERAL_MAX) + 2] = PACK_WINDOW - (2 * PACK_LITERAL_MAX);
+    memcpy(expected + (2 * PACK_LITERAL_MAX) + 3, data + (2 * PACK_LITERAL_MAX), PACK_WINDOW - (2 * PACK_LITERAL_MAX));
+    expected[PACK_WINDOW + 3] = 0x80;
+    expected[PACK_WINDOW + 4] = PACK_WINDOW - 1;
+    expected[PACK_WINDOW + 5] = 0x00;
+
+    if(ASSERT(nesla_test_round_trip(UNPACK_LZ, data, length, expected, PACK_WINDOW + 6))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    data[PACK_WINDOW] = 3;
+    memcpy(data + PACK_WINDOW + 1, data, PACK_MATCH_MIN);
+    ++length;
+    expected[(2 * PACK_LITERAL_MAX) + 2] = length - (2 * PACK_LITERAL_MAX);
+    memcpy(expected + (2 * PACK_LITERAL_MAX) + 3, data + (2 * PACK_LITERAL_MAX), length - (2 * PACK_LITERAL_MAX));
+    expected[length + 3] = 0x00;
+
+    if(ASSERT(nesla_test_round_trip(UNPACK_LZ, data, length, expected, length + 4))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test packed block RLE compression, of runs between literals, and runs too short or too long for a single packet.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_pack_rle(void)
+{
+    uint8_t data[TEST_BLOCK_MAX] = {};
+    static const uint8_t RUN[] = { 1, 2, 3, 3, 3, 3, 4, 4, 5, };
+    static const uint8_t RUN_EXPECTED[] = { 0x02, 1, 2, 0x83, 3, 0x03, 4, 4, 5, 0x00, };
+    static const uint8_t LONG_EXPECTED[] = { 0xFF, 7, 0x82, 7, 0x00, };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT(nesla_test_round_trip(UNPACK_RLE, RUN, sizeof(RUN), RUN_EXPECTED, sizeof(RUN_EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    memset(data, 7, PACK_RUN_MAX + PACK_RUN_MIN);
+
+    if(ASSERT(nesla_test_round_trip(UNPACK_RLE, data, PACK_RUN_MAX + PACK_RUN_MIN, LONG_EXPECTED, sizeof(LONG_EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+int main(void)
+{
+    static const test TEST[] = {
+        nesla_test_pack_cache,
+        nesla_test_pack_empty,
+        nesla_test_pack_lz,
+        nesla_test_pack_rle,
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(int index = 0; index < TEST_COUNT(TEST); ++index) {
+
+        if(TEST[index]() == NESLA_FAILURE) {
+            result = NESLA_FAILURE;
+        }
+    }
+
+    return (int)result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
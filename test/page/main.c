@@ -0,0 +1,157 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file main.c
+ * @brief Alignment and page crossing tests.
+ */
+
+#include <page.h>
+#include <test.h>
+#include <assemble.h>
+
+static nesla_test_assembly_t g_test = {};   /*!< Test assembly context */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Test alignment of code placed with .ORG, with the bytes skipped filled by relocatable sections, one kept within a page.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_page_align(void)
+{
+    static const uint8_t EXPECTED[] = {
+        0x20, 0x4C, 0xC0, 0xA2, 0x00, 0xBD, 0x00, 0xC1, 0xBD, 0x0C, 0xC0, 0x60, 0x00, 0x0C, 0x19, 0x25,
+        };
+    static const uint8_t EXPECTED_SECTION[] = { 0xA9, 0x01, 0x60, 0xFF, };
+    static const uint8_t EXPECTED_TABLE[] = { 0x01, 0x02, 0x03, 0x04, };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, ".PRG 1\n.BANK 0\n.ORG $C000\nreset:\nJSR sub\nLDX #0\nLDA table,X\nLDA sine,X\nRTS\n"
+                ".ALIGN 256\ntable:\n.BYTE 1, 2, 3, 4\n.RELOC\nsub:\nLDA #1\nRTS\n.RELOC\n.ALIGN PAGE\n"
+                ".TABLE BYTE sine 0, 63, \"SIN(I * 4, 127)\"\n.BANK 0\n" TEST_VECTORS, 0) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE,
+                "Page crossings: 0 branch(es), 0 indexed read(s) of a table crossing a page, 0 in or into aligned sections") == 1)
+            && nesla_test_match(&g_test, 0, 0xC000, EXPECTED, sizeof(EXPECTED))
+            && nesla_test_match(&g_test, 0, 0xC04C, EXPECTED_SECTION, sizeof(EXPECTED_SECTION))
+            && nesla_test_match(&g_test, 0, 0xC100, EXPECTED_TABLE, sizeof(EXPECTED_TABLE)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test page crossings reported, of taken branches and indexed reads of tables, in or into aligned sections.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_page_cross(void)
+{
+    static const uint8_t EXPECTED[] = { 0xBD, 0xFE, 0xC1, 0xCA, 0xD0, 0xFA, 0x60, };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, ".PRG 1\n.BANK 0\n.ORG $C000\nreset:\nJSR loop\nJSR back\nLDA cross,X\nRTS\n.RELOC\n"
+                ".ALIGN 256\nloop:\nLDA cross,X\nDEX\nBNE loop\nRTS\n.BANK 0\n.ORG $C1FE\ncross:\n.BYTE 1, 2, 3, 4\n.ORG $C2FC\n.ALIGN 4\n"
+                "back:\nNOP\nNOP\nNOP\nNOP\nBNE back\nRTS\n" TEST_VECTORS, 0) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_WARNING,
+                "Indexed read of a table crossing a page: $C1FE-$C201, +1 cycle") == 1)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_WARNING, "Branch crosses a page when taken: +1 cycle") == 1)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE,
+                "Page crossings: 1 branch(es), 2 indexed read(s) of a table crossing a page, 2 in or into aligned sections") == 1)
+            && nesla_test_match(&g_test, 0, 0xC100, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test alignments that are invalid, or can not be met.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_page_invalid(void)
+{
+    static const struct {
+        const char *source;
+        const char *message;
+    } INVALID[] = {
+        { ".ORG $C000\nreset:\nRTS\n.ALIGN 3\n", "Invalid alignment: 3", },
+        { ".ORG $C000\nreset:\nRTS\n.ALIGN $8000\n", "Invalid alignment: 32768", },
+        { ".ORG $C000\nreset:\nRTS\n.ALIGN FOO\n", "Unsupported alignment: FOO", },
+        { ".ORG $C000\nreset:\nRTS\n.ALIGN PAGE\n", "Page placement outside of a relocatable section", },
+        { ".ORG $C000\nreset:\nRTS\n.RELOC\nsection:\nRTS\n.ALIGN 256\n.BANK 0\n", "Alignment after the start of a relocatable section", },
+        { ".ORG $FFF0\nreset:\nRTS\n.ALIGN 256\n", "Origin overflow: FFF1, aligned to 256", },
+        { ".ORG $C000\nreset:\nRTS\n.RELOC\n.ALIGN PAGE\n.TABLE BYTE table 0, 256, \"0\"\n.BANK 0\n",
+            "Relocatable section kept within a page longer than a page: 257 bytes", },
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(size_t index = 0; index < TEST_COUNT(INVALID); ++index) {
+        if(ASSERT((nesla_test_assemble_format(&g_test, 0, ".PRG 1\n.BANK 0\n%s" TEST_VECTORS, INVALID[index].source) == NESLA_FAILURE)
+                && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, INVALID[index].message) == 1))) {
+            result = NESLA_FAILURE;
+            goto exit;
+        }
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+int main(void)
+{
+    static const test TEST[] = {
+        nesla_test_page_align,
+        nesla_test_page_cross,
+        nesla_test_page_invalid,
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(int index = 0; index < TEST_COUNT(TEST); ++index) {
+
+        if(TEST[index]() == NESLA_FAILURE) {
+            result = NESLA_FAILURE;
+        }
+    }
+
+    return (int)result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
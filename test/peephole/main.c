@@ -0,0 +1,162 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file main.c
+ * @brief Peephole optimizer tests.
+ */
+
+#include <common.h>
+#include <test.h>
+#include <assemble.h>
+
+#define TEST_NOP_COUNT 96                   /*!< Padding between a chained branch and its target, in bytes */
+#define TEST_INLINE_COUNT 8                 /*!< Hot call sites inlined ahead of a chained branch */
+
+static nesla_test_assembly_t g_test = {};   /*!< Test assembly context */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Test peephole jump chain retargeting undone, once inlining moves the branch out of range. The branch is back in range
+ *        of its original target, so it is not expanded with NESLA_FLAG_RELAX_BRANCH.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_peephole_chain_undone(void)
+{
+    size_t length = 0;
+    static char source[TEST_SOURCE_MAX] = {};
+    static const uint8_t EXPECTED[] = { 0xA2, 0x00, 0xD0, 0x78, };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    length += snprintf(source + length, sizeof(source) - length,
+        ".PRG 1\n.BANK 0\n.ORG $C000\nsub:\n%sRTS\nreset:\nLDX #0\nBNE hop\n",
+        "LDA $0300\nLDA $0300\nLDA $0300\nLDA $0300\nLDA $0300\n");
+
+    for(int index = 0; index < TEST_INLINE_COUNT; ++index) {
+        length += snprintf(source + length, sizeof(source) - length, ".HOT\nJSR sub\n");
+    }
+
+    length += snprintf(source + length, sizeof(source) - length, "hop:\nBNE far\n");
+
+    for(int index = 0; index < TEST_NOP_COUNT; ++index) {
+        length += snprintf(source + length, sizeof(source) - length, "NOP\n");
+    }
+
+    snprintf(source + length, sizeof(source) - length, "far:\nRTS\n" TEST_VECTORS);
+
+    if(ASSERT((nesla_test_assemble(&g_test, source, NESLA_FLAG_PEEPHOLE | NESLA_FLAG_INLINE) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Jump chain, BNE retargeted to far") == 1)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Jump chain undone, BNE out of range of far") == 1)
+            && nesla_test_match(&g_test, 0, 0xC010, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble(&g_test, source, NESLA_FLAG_PEEPHOLE | NESLA_FLAG_INLINE | NESLA_FLAG_RELAX_BRANCH) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Jump chain undone, BNE out of range of far") == 1)
+            && !nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Branch expanded")
+            && nesla_test_match(&g_test, 0, 0xC010, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble(&g_test, source, NESLA_FLAG_PEEPHOLE) == NESLA_SUCCESS)
+            && !nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Jump chain undone"))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test peephole optimization of jump chains, tail calls and redundant carry clears, outside of .NOOPT.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_peephole_optimize(void)
+{
+    static const char SOURCE[] =
+        ".PRG 1\n.BANK 0\n.ORG $C000\n"
+        "reset:\nLDX #0\nBNE hop\nJSR sub\nRTS\n"
+        "hop:\nBNE far\nCLC\nCLC\nSTA $10\nLDA $10\n.NOOPT\nCLC\nCLC\n.OPT\n"
+        "far:\nRTS\nsub:\nRTS\n"
+        TEST_VECTORS;
+    static const uint8_t EXPECTED[] = {
+        0xA2, 0x00, 0xD0, 0x0C, 0x4C, 0x11, 0xC0, 0xD0, 0x07, 0x18, 0x85, 0x10, 0xA5, 0x10, 0x18, 0x18, 0x60, 0x60,
+        };
+    static const uint8_t EXPECTED_NONE[] = {
+        0xA2, 0x00, 0xD0, 0x04, 0x20, 0x13, 0xC0, 0x60, 0xD0, 0x08, 0x18, 0x18, 0x85, 0x10, 0xA5, 0x10, 0x18, 0x18,
+        0x60, 0x60,
+        };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, SOURCE, NESLA_FLAG_PEEPHOLE) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Jump chain, BNE retargeted to far") == 1)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Tail call rewritten as JMP") == 1)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Redundant CLC removed") == 1)
+            && nesla_test_match(&g_test, 0, 0xC000, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble(&g_test, SOURCE, NESLA_FLAG_NONE) == NESLA_SUCCESS)
+            && !nesla_context_get_diagnostic_count(g_test.context, NESLA_DIAGNOSTIC_NOTE)
+            && nesla_test_match(&g_test, 0, 0xC000, EXPECTED_NONE, sizeof(EXPECTED_NONE)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+int main(void)
+{
+    static const test TEST[] = {
+        nesla_test_peephole_chain_undone,
+        nesla_test_peephole_optimize,
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(int index = 0; index < TEST_COUNT(TEST); ++index) {
+
+        if(TEST[index]() == NESLA_FAILURE) {
+            result = NESLA_FAILURE;
+        }
+    }
+
+    return (int)result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,206 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file main.c
+ * @brief Variable RAM placement tests.
+ */
+
+#include <ram.h>
+#include <test.h>
+#include <assemble.h>
+
+static nesla_test_assembly_t g_test = {};   /*!< Test assembly context */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Test variable placement, pointers in zero page first, then by references per byte, and the rest above zero page.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_ram_place(void)
+{
+    static const uint8_t EXPECTED[] = {
+        0xAD, 0x00, 0x02, 0xA5, 0x03, 0x85, 0x03, 0xB1, 0x00, 0x85, 0x01, 0xE6, 0x02, 0xE6, 0x02, 0xA5, 0x02, 0x60,
+        };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, ".PRG 1\n.RESV buf 200\n.RESV big 100\n.RESV ptr 2, ptr_hi\n.RESV count 1\n.BANK 0\n"
+                ".ORG $C000\nreset:\nLDA buf\nLDA big\nSTA big\nLDA (ptr),Y\nSTA ptr_hi\nINC count\nINC count\nLDA count\nRTS\n"
+                TEST_VECTORS, 0) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE,
+                "Variables placed: 4, 103 byte(s) in zero page, 200 byte(s) above") == 1)
+            && nesla_test_match(&g_test, 0, 0xC000, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test pointer variables, which must hold an address.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_ram_pointer(void)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, ".PRG 1\n.RESV p 1\n.BANK 0\n.ORG $C000\nreset:\nLDA (p),Y\nRTS\n" TEST_VECTORS, 0)
+                == NESLA_FAILURE)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, "Pointer variable too small: p") == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test variable placement in a RAM region, failing once the variables do not fit.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_ram_region(void)
+{
+    static const char *SOURCE = ".PRG 1\n.RESV $0300, $%04X\n.RESV a 3\n.RESV b 2\n.BANK 0\n.ORG $C000\nreset:\nLDA a\nLDA b\nRTS\n"
+        TEST_VECTORS;
+    static const uint8_t EXPECTED[] = { 0xAD, 0x02, 0x03, 0xAD, 0x00, 0x03, 0x60, };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble_format(&g_test, 0, SOURCE, 0x0304) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Variables placed: 2, 0 byte(s) in zero page, 5 byte(s) above") == 1)
+            && nesla_test_match(&g_test, 0, 0xC000, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble_format(&g_test, 0, SOURCE, 0x0303) == NESLA_FAILURE)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, "Out of RAM for variable: a (3 byte(s))") == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test structure of arrays (.SOA) layout, each field its own variable, with zero page and page kept fields.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_ram_structure(void)
+{
+    static const uint8_t EXPECTED[] = {
+        0xA2, 0x10, 0xB5, 0x30, 0xB5, 0x40, 0xB5, 0x10, 0xB5, 0x20, 0xB5, 0x00, 0xB5, 0x50, 0x60,
+        };
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, ".PRG 1\n.SOA obj 16 x, y, vx 2, state ZP, tile PAGE\n.BANK 0\n.ORG $C000\nreset:\n"
+                "LDX #obj_COUNT\nLDA obj_x,X\nLDA obj_y,X\nLDA obj_vx,X\nLDA obj_vx_HI,X\nLDA obj_state,X\nLDA obj_tile,X\nRTS\n"
+                TEST_VECTORS, 0) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE,
+                "Structure obj: 16 entries, 5 field(s), 6 byte(s) per entry, 96 byte(s) of RAM (16 in zero page)") == 1)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Variables placed: 5, 96 byte(s) in zero page, 0 byte(s) above") == 1)
+            && nesla_test_match(&g_test, 0, 0xC000, EXPECTED, sizeof(EXPECTED)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test structure of arrays (.SOA) that can not be laid out, or whose fields can not be placed as marked.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_ram_structure_invalid(void)
+{
+    static const struct {
+        const char *structure;
+        const char *message;
+    } INVALID[] = {
+        { "obj 0 x", "Invalid structure entry count: 0", },
+        { "obj 16 x 3", "Invalid field width: 3", },
+        { "obj 16 x FAST", "Unsupported field attribute: FAST", },
+        { "obj 200 x 2 PAGE", "Field larger than a page: x (400 byte(s))", },
+        { "obj 256 a ZP, b ZP", "Out of zero page for variable: obj_b (256 byte(s))", },
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(size_t index = 0; index < TEST_COUNT(INVALID); ++index) {
+        if(ASSERT((nesla_test_assemble_format(&g_test, 0, ".PRG 1\n.SOA %s\n.BANK 0\n.ORG $C000\nreset:\nRTS\n" TEST_VECTORS,
+                    INVALID[index].structure) == NESLA_FAILURE)
+                && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, INVALID[index].message) == 1))) {
+            result = NESLA_FAILURE;
+            goto exit;
+        }
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+int main(void)
+{
+    static const test TEST[] = {
+        nesla_test_ram_place,
+        nesla_test_ram_pointer,
+        nesla_test_ram_region,
+        nesla_test_ram_structure,
+        nesla_test_ram_structure_invalid,
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(int index = 0; index < TEST_COUNT(TEST); ++index) {
+
+        if(TEST[index]() == NESLA_FAILURE) {
+            result = NESLA_FAILURE;
+        }
+    }
+
+    return (int)result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,400 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file main.c
+ * @brief File reader tests.
+ */
+
+#include <common.h>
+#include <test.h>
+
+#define TEST_CHUNK_LENGTH 4096                              /*!< Reader chunk length in bytes */
+#define TEST_LENGTH ((3 * TEST_CHUNK_LENGTH) + 100)         /*!< File length in bytes */
+#define TEST_TOKEN_LENGTH 11                                /*!< Token length in bytes, so tokens span chunks */
+
+/*!
+ * @struct nesla_test_t
+ * @brief Test contexts.
+ */
+typedef struct {
+    nesla_reader_t reader;                  /*!< Reader context */
+    char path[32];                          /*!< File path */
+    uint8_t data[TEST_LENGTH];              /*!< File data */
+    uint8_t output[TEST_LENGTH];            /*!< Reader output */
+} nesla_test_t;
+
+static nesla_test_t g_test = { .reader.descriptor = -1, };  /*!< Test context */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+void *nesla_context_allocate(nesla_context_t *context, size_t length)
+{
+    return calloc(1, length);
+}
+
+void nesla_context_free(nesla_context_t *context, void *data)
+{
+    free(data);
+}
+
+nesla_list_entry_t *nesla_list_get_head(const nesla_list_t *list)
+{
+    return list->head;
+}
+
+size_t nesla_list_get_length(const nesla_list_t *list)
+{
+    return list->length;
+}
+
+nesla_list_entry_t *nesla_list_get_tail(const nesla_list_t *list)
+{
+    return list->tail;
+}
+
+nesla_error_e nesla_list_insert(nesla_list_t *list, nesla_context_t *context, nesla_list_entry_t *entry, void *data)
+{
+    nesla_list_entry_t *new_entry;
+
+    if(!(new_entry = calloc(1, sizeof(*new_entry)))) {
+        return NESLA_FAILURE;
+    }
+
+    new_entry->context = data;
+    new_entry->previous = entry;
+    new_entry->next = entry ? entry->next : list->head;
+    *(new_entry->next ? &new_entry->next->previous : &list->tail) = new_entry;
+    *(entry ? &entry->next : &list->head) = new_entry;
+    ++list->length;
+
+    return NESLA_SUCCESS;
+}
+
+void nesla_list_remove(nesla_list_t *list, nesla_context_t *context, nesla_list_entry_t *entry)
+{
+    *(entry->previous ? &entry->previous->next : &list->head) = entry->next;
+    *(entry->next ? &entry->next->previous : &list->tail) = entry->previous;
+    free(entry);
+    --list->length;
+}
+
+nesla_error_e nesla_set_error(nesla_context_t *context, const char *file, const char *function, int line, const char *format, ...)
+{
+    return NESLA_FAILURE;
+}
+
+/*!
+ * @brief Initialize test, writing a file of tokens that span chunks.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_initialize(void)
+{
+    int descriptor;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    nesla_reader_close(&g_test.reader);
+
+    if(g_test.path[0]) {
+        unlink(g_test.path);
+    }
+
+    memset(&g_test, 0, sizeof(g_test));
+    g_test.reader.descriptor = -1;
+    snprintf(g_test.path, sizeof(g_test.path), "/tmp/nesla_reader_XXXXXX");
+
+    for(size_t index = 0; index < TEST_LENGTH; index += TEST_TOKEN_LENGTH) {
+        char token[TEST_TOKEN_LENGTH + 1];
+
+        snprintf(token, sizeof(token), "LABEL_%04zu\n", index / TEST_TOKEN_LENGTH);
+        memcpy(g_test.data + index, token, ((TEST_LENGTH - index) < TEST_TOKEN_LENGTH) ? (TEST_LENGTH - index) : TEST_TOKEN_LENGTH);
+    }
+
+    if((descriptor = mkstemp(g_test.path)) < 0) {
+        g_test.path[0] = '\0';
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(write(descriptor, g_test.data, sizeof(g_test.data)) != sizeof(g_test.data)) {
+        result = NESLA_FAILURE;
+    }
+
+    if(close(descriptor)) {
+        result = NESLA_FAILURE;
+    }
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Uninitialize test, removing its file.
+ */
+static void nesla_test_uninitialize(void)
+{
+    nesla_reader_close(&g_test.reader);
+
+    if(g_test.path[0]) {
+        unlink(g_test.path);
+        g_test.path[0] = '\0';
+    }
+}
+
+/*!
+ * @brief Read test data a token at a time, so that reads span chunks.
+ * @param[in] offset Data offset in bytes
+ * @param[in] length Data length in bytes
+ * @return true if the data read matches, false otherwise
+ */
+static bool nesla_test_read(size_t offset, size_t length)
+{
+    bool result = true;
+
+    memset(g_test.output, 0, sizeof(g_test.output));
+
+    for(size_t index = offset; index < offset + length; index += TEST_TOKEN_LENGTH) {
+        size_t count = ((offset + length - index) < TEST_TOKEN_LENGTH) ? (offset + length - index) : TEST_TOKEN_LENGTH;
+
+        if(nesla_reader_get(&g_test.reader, g_test.output + index, count) == NESLA_FAILURE) {
+            result = false;
+            break;
+        }
+    }
+
+    return result && !memcmp(g_test.output + offset, g_test.data + offset, length);
+}
+
+/*!
+ * @brief Test reader get, across chunk boundaries and to the end of file.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_reader_get(void)
+{
+    uint8_t value;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_initialize() == NESLA_SUCCESS)
+            && (nesla_reader_open(&g_test.reader, NULL, g_test.path) == NESLA_SUCCESS))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT(nesla_test_read(0, TEST_LENGTH)
+            && (nesla_list_get_length(&g_test.reader.chunk) == 4))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_reader_get(&g_test.reader, &value, 1) == NESLA_FAILURE)
+            && (nesla_reader_get(&g_test.reader, &value, 1) == NESLA_FAILURE)
+            && !nesla_reader_is_failed(&g_test.reader))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_initialize() == NESLA_SUCCESS)
+            && (nesla_reader_open(&g_test.reader, NULL, g_test.path) == NESLA_SUCCESS))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_reader_get(&g_test.reader, g_test.output, TEST_CHUNK_LENGTH - 4) == NESLA_SUCCESS)
+            && (nesla_reader_get(&g_test.reader, g_test.output + TEST_CHUNK_LENGTH - 4, TEST_CHUNK_LENGTH + 8) == NESLA_SUCCESS)
+            && !memcmp(g_test.output, g_test.data, (2 * TEST_CHUNK_LENGTH) + 4)
+            && (nesla_reader_get(&g_test.reader, g_test.output, TEST_LENGTH) == NESLA_FAILURE))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_uninitialize();
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test reader get with a caller owned buffer, and open failing without one.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_reader_get_buffer(void)
+{
+    uint8_t value;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_initialize() == NESLA_SUCCESS)
+            && (nesla_reader_open_buffer(&g_test.reader, NULL, g_test.path, g_test.data, TEST_LENGTH) == NESLA_SUCCESS))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT(nesla_test_read(0, TEST_LENGTH)
+            && (nesla_reader_get(&g_test.reader, &value, 1) == NESLA_FAILURE)
+            && !nesla_reader_is_failed(&g_test.reader))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_reader_reset(&g_test.reader) == NESLA_SUCCESS)
+            && nesla_test_read(0, TEST_LENGTH)
+            && !nesla_list_get_length(&g_test.reader.chunk))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    nesla_reader_close(&g_test.reader);
+
+    if(ASSERT((nesla_reader_open_buffer(&g_test.reader, NULL, g_test.path, NULL, 0) == NESLA_FAILURE)
+            && (g_test.reader.descriptor == -1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_uninitialize();
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test reader get, failing on a file that cannot be read, and close leaving no descriptor to close again.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_reader_get_failed(void)
+{
+    uint8_t value;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_initialize() == NESLA_SUCCESS)
+            && (nesla_reader_open(&g_test.reader, NULL, "/tmp") == NESLA_SUCCESS))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_reader_get(&g_test.reader, &value, 1) == NESLA_FAILURE)
+            && nesla_reader_is_failed(&g_test.reader)
+            && (nesla_reader_get(&g_test.reader, &value, 1) == NESLA_FAILURE)
+            && !nesla_list_get_length(&g_test.reader.chunk))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    nesla_reader_close(&g_test.reader);
+    nesla_reader_close(&g_test.reader);
+
+    if(ASSERT((g_test.reader.descriptor == -1)
+            && (fcntl(STDIN_FILENO, F_GETFD) >= 0)
+            && (nesla_reader_open(&g_test.reader, NULL, "/tmp/nesla_reader_missing") == NESLA_FAILURE))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_uninitialize();
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test reader reset, back to the first chunk without reading the file again.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_reader_reset(void)
+{
+    size_t length;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_initialize() == NESLA_SUCCESS)
+            && (nesla_reader_open(&g_test.reader, NULL, g_test.path) == NESLA_SUCCESS)
+            && (nesla_reader_reset(&g_test.reader) == NESLA_SUCCESS)
+            && !nesla_list_get_length(&g_test.reader.chunk))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT(nesla_test_read(0, (2 * TEST_CHUNK_LENGTH) + TEST_TOKEN_LENGTH)
+            && ((length = nesla_list_get_length(&g_test.reader.chunk)) == 3))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_reader_reset(&g_test.reader) == NESLA_SUCCESS)
+            && (g_test.reader.entry == nesla_list_get_head(&g_test.reader.chunk))
+            && (g_test.reader.index == 0)
+            && (g_test.reader.length == TEST_CHUNK_LENGTH))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT(nesla_test_read(0, TEST_CHUNK_LENGTH + TEST_TOKEN_LENGTH)
+            && (nesla_list_get_length(&g_test.reader.chunk) == length))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT(nesla_test_read(TEST_CHUNK_LENGTH + TEST_TOKEN_LENGTH, TEST_LENGTH - TEST_CHUNK_LENGTH - TEST_TOKEN_LENGTH)
+            && (nesla_list_get_length(&g_test.reader.chunk) == 4))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_reader_reset(&g_test.reader) == NESLA_SUCCESS)
+            && nesla_test_read(0, TEST_LENGTH))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_uninitialize();
+    TEST_RESULT(result);
+
+    return result;
+}
+
+int main(void)
+{
+    static const test TEST[] = {
+        nesla_test_reader_get,
+        nesla_test_reader_get_buffer,
+        nesla_test_reader_get_failed,
+        nesla_test_reader_reset,
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(int index = 0; index < TEST_COUNT(TEST); ++index) {
+
+        if(TEST[index]() == NESLA_FAILURE) {
+            result = NESLA_FAILURE;
+        }
+    }
+
+    return (int)result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
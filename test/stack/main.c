@@ -0,0 +1,120 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file main.c
+ * @brief Hardware stack budget tests.
+ */
+
+#include <stack.h>
+#include <test.h>
+#include <assemble.h>
+
+#define TEST_VECTORS_HANDLER ".ORG $FFFA\n.WORD nmi\n.WORD reset\n.WORD irq\n" /*!< Vectors, one per handler */
+
+static nesla_test_assembly_t g_test = {};   /*!< Test assembly context */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Test stack budget, of the reset code interrupted by the IRQ handler, interrupted in turn by the NMI handler.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_stack_budget(void)
+{
+    static const char *SOURCE = ".PRG 1\n.STACK %u\n.BANK 0\n.ORG $C000\nreset:\nLDX #$FF\nTXS\nJSR sub\nloop:\nJMP loop\nsub:\nPHA\nPHA\n"
+        "PLA\nPLA\nRTS\nnmi:\nPHA\nJSR sub\nPLA\nRTI\nirq:\nRTI\n" TEST_VECTORS_HANDLER;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble_format(&g_test, 0, SOURCE, 15) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE,
+                "Stack budget: up to 15 of 15 bytes (reset 4, IRQ 3, NMI 8)") == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble_format(&g_test, 0, SOURCE, 14) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_WARNING,
+                "Stack budget exceeded: up to 15 of 14 bytes (reset 4, IRQ 3, NMI 8)") == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test stack budgets that can not be measured, through a loop that pushes on every pass, or recursion.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_stack_unmeasured(void)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, ".PRG 1\n.STACK 64\n.BANK 0\n.ORG $C000\nreset:\nPHA\nJMP reset\nnmi:\nirq:\nRTI\n"
+                TEST_VECTORS_HANDLER, 0) == NESLA_FAILURE)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, "Stack grows on each pass of the loop: 1 byte(s)") == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble(&g_test, ".PRG 1\n.STACK 64\n.BANK 0\n.ORG $C000\nreset:\nJSR sub\nnmi:\nirq:\nRTI\nsub:\nJSR sub\n"
+                "RTS\n" TEST_VECTORS_HANDLER, 0) == NESLA_FAILURE)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, "Recursive call: $C004") == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+int main(void)
+{
+    static const test TEST[] = {
+        nesla_test_stack_budget,
+        nesla_test_stack_unmeasured,
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(int index = 0; index < TEST_COUNT(TEST); ++index) {
+
+        if(TEST[index]() == NESLA_FAILURE) {
+            result = NESLA_FAILURE;
+        }
+    }
+
+    return (int)result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
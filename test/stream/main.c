@@ -102,7 +102,12 @@ const char *nesla_reader_get_path(const nesla_reader_t *reader)
     return g_test.reader.path;
 }
 
-nesla_error_e nesla_reader_open(nesla_reader_t *reader, const char *path)
+bool nesla_reader_is_failed(const nesla_reader_t *reader)
+{
+    return false;
+}
+
+nesla_error_e nesla_reader_open(nesla_reader_t *reader, nesla_context_t *context, const char *path)
 {
     nesla_error_e result = NESLA_SUCCESS;
 
@@ -120,6 +125,27 @@ exit:
     return result;
 }
 
+nesla_error_e nesla_reader_open_buffer(nesla_reader_t *reader, nesla_context_t *context, const char *path, const uint8_t *data,
+    size_t length)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if((reader != &g_test.stream.reader)
+            || (path == NULL)
+            || (data == NULL)
+            || (length != strlen((const char *)data))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    g_test.reader.data = (const char *)data;
+    g_test.reader.path = path;
+    g_test.reader.open = true;
+
+exit:
+    return result;
+}
+
 nesla_error_e nesla_reader_reset(nesla_reader_t *reader)
 {
     nesla_error_e result = NESLA_SUCCESS;
@@ -136,7 +162,7 @@ exit:
     return result;
 }
 
-nesla_error_e nesla_set_error(const char *file, const char *function, int line, const char *format, ...)
+nesla_error_e nesla_set_error(nesla_context_t *context, const char *file, const char *function, int line, const char *format, ...)
 {
     return NESLA_FAILURE;
 }
@@ -152,7 +178,7 @@ static nesla_error_e nesla_test_initialize(const char *path, const char *data)
     memset(&g_test, 0, sizeof(g_test));
     g_test.reader.data = data;
 
-    if((result = nesla_stream_initialize(&g_test.stream, path)) == NESLA_FAILURE) {
+    if((result = nesla_stream_initialize(&g_test.stream, NULL, path)) == NESLA_FAILURE) {
         goto exit;
     }
 
@@ -209,6 +235,37 @@ exit:
     return result;
 }
 
+/*!
+ * @brief Test stream get column.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_stream_get_column(void)
+{
+    size_t column = 1;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT(nesla_test_initialize(TEST_PATH, TEST_DATA) == NESLA_SUCCESS)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    for(size_t index = 0; index < strlen(TEST_DATA); ++index) {
+
+        if(ASSERT(nesla_stream_get_column(&g_test.stream) == column)) {
+            result = NESLA_FAILURE;
+            goto exit;
+        }
+
+        nesla_stream_next(&g_test.stream);
+        column = (TEST_DATA[index] == '\n') ? 1 : column + 1;
+    }
+
+exit:
+    TEST_RESULT(result);
+
+    return result;
+}
+
 /*!
  * @brief Test stream get line.
  * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
@@ -331,6 +388,46 @@ exit:
     return result;
 }
 
+/*!
+ * @brief Test stream initialization with a buffer.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_stream_initialize_buffer(void)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    memset(&g_test, 0, sizeof(g_test));
+
+    if(ASSERT(nesla_stream_initialize_buffer(&g_test.stream, NULL, TEST_PATH, (const uint8_t *)"", 0) == NESLA_FAILURE)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    memset(&g_test, 0, sizeof(g_test));
+
+    if(ASSERT(nesla_stream_initialize_buffer(&g_test.stream, NULL, TEST_PATH, (const uint8_t *)TEST_DATA, strlen(TEST_DATA))
+            == NESLA_SUCCESS)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((g_test.stream.character == TEST_DATA[0])
+            && (g_test.stream.line == 1)
+            && (strcmp(g_test.reader.data, TEST_DATA) == 0)
+            && (strcmp(g_test.reader.path, TEST_PATH) == 0)
+            && (g_test.reader.index == 1)
+            && (g_test.reader.open == true)
+            && (g_test.reader.reset == true))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    TEST_RESULT(result);
+
+    return result;
+}
+
 /*!
  * @brief Test stream next.
  * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
@@ -448,10 +545,12 @@ int main(void)
 {
     static const test TEST[] = {
         nesla_test_stream_get,
+        nesla_test_stream_get_column,
         nesla_test_stream_get_line,
         nesla_test_stream_get_path,
         nesla_test_stream_get_type,
         nesla_test_stream_initialize,
+        nesla_test_stream_initialize_buffer,
         nesla_test_stream_next,
         nesla_test_stream_reset,
         nesla_test_stream_uninitialize,
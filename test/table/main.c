@@ -0,0 +1,323 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file main.c
+ * @brief Hash table tests.
+ */
+
+#include <common.h>
+#include <test.h>
+
+#define TEST_COUNT_MAX 30000    /*!< Number of names inserted by bulk tests */
+
+/*!
+ * @struct nesla_test_t
+ * @brief Test contexts.
+ */
+typedef struct {
+    nesla_table_t table;                    /*!< Table context */
+    char name[TEST_COUNT_MAX][24];          /*!< Entry names */
+} nesla_test_t;
+
+static nesla_test_t g_test = {};            /*!< Test context */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+void *nesla_context_allocate(nesla_context_t *context, size_t length)
+{
+    return calloc(1, length);
+}
+
+void nesla_context_free(nesla_context_t *context, void *data)
+{
+    free(data);
+}
+
+nesla_error_e nesla_set_error(nesla_context_t *context, const char *file, const char *function, int line, const char *format, ...)
+{
+    return NESLA_FAILURE;
+}
+
+/*!
+ * @brief Initialize test, inserting a number of entries with a given scope.
+ * @param[in] count Number of entries
+ * @param[in] scope Entry scope
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_initialize(size_t count, uint32_t scope)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    nesla_table_free(&g_test.table, NULL);
+
+    for(size_t index = 0; index < count; ++index) {
+        const char *name = g_test.name[index];
+
+        snprintf(g_test.name[index], sizeof(*g_test.name), "L%zu", index);
+
+        if((result = nesla_table_insert(&g_test.table, NULL, name, nesla_table_hash(name, strlen(name)), scope, index)) == NESLA_FAILURE) {
+            goto exit;
+        }
+    }
+
+exit:
+    return result;
+}
+
+/*!
+ * @brief Test table find entry.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_table_find(void)
+{
+    nesla_table_entry_t *entry;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT(nesla_table_find(&g_test.table, "L0", nesla_table_hash("L0", 2), 0) == NULL)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT(nesla_test_initialize(TEST_COUNT_MAX, 0) == NESLA_SUCCESS)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    for(size_t index = 0; index < TEST_COUNT_MAX; ++index) {
+        const char *name = g_test.name[index];
+
+        if(ASSERT(((entry = nesla_table_find(&g_test.table, name, nesla_table_hash(name, strlen(name)), 0)) != NULL)
+                && (entry->value == index)
+                && (entry->name == name))) {
+            result = NESLA_FAILURE;
+            goto exit;
+        }
+    }
+
+    if(ASSERT((nesla_table_find(&g_test.table, "L0", nesla_table_hash("L0", 2), 1) == NULL)
+            && (nesla_table_find(&g_test.table, "M0", nesla_table_hash("M0", 2), 0) == NULL))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_table_free(&g_test.table, NULL);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test table free.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_table_free(void)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT(nesla_test_initialize(16, 0) == NESLA_SUCCESS)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    nesla_table_free(&g_test.table, NULL);
+
+    if(ASSERT((g_test.table.entry == NULL)
+            && (g_test.table.capacity == 0)
+            && (g_test.table.count == 0))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test table get entry count.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_table_get_count(void)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT(nesla_test_initialize(100, 0) == NESLA_SUCCESS)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT(nesla_table_get_count(&g_test.table) == 100)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_table_free(&g_test.table, NULL);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test table hash.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_table_hash(void)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_table_hash("", 0) == 0x811C9DC5)
+            && (nesla_table_hash("a", 1) == 0xE40C292C)
+            && (nesla_table_hash("foobar", 6) == 0xBF9CF968))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test table insert entry.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_table_insert(void)
+{
+    nesla_table_entry_t *entry;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT(nesla_test_initialize(TEST_COUNT_MAX, 0) == NESLA_SUCCESS)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_table_get_count(&g_test.table) == TEST_COUNT_MAX)
+            && !(g_test.table.capacity & (g_test.table.capacity - 1))
+            && ((g_test.table.count * 4) <= (g_test.table.capacity * 3)))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT(nesla_table_insert(&g_test.table, NULL, g_test.name[0], nesla_table_hash(g_test.name[0], strlen(g_test.name[0])), 1,
+            TEST_COUNT_MAX) == NESLA_SUCCESS)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT(((entry = nesla_table_find(&g_test.table, g_test.name[0], nesla_table_hash(g_test.name[0], strlen(g_test.name[0])), 1))
+            != NULL) && (entry->value == TEST_COUNT_MAX))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT(((entry = nesla_table_find(&g_test.table, g_test.name[0], nesla_table_hash(g_test.name[0], strlen(g_test.name[0])), 0))
+            != NULL) && (entry->value == 0))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_table_free(&g_test.table, NULL);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test table remove entry.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_table_remove(void)
+{
+    nesla_table_entry_t *entry;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT(nesla_test_initialize(TEST_COUNT_MAX, 0) == NESLA_SUCCESS)) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    for(size_t index = 0; index < TEST_COUNT_MAX; index += 2) {
+        const char *name = g_test.name[index];
+
+        if(ASSERT(nesla_table_remove(&g_test.table, name, nesla_table_hash(name, strlen(name)), 0))) {
+            result = NESLA_FAILURE;
+            goto exit;
+        }
+    }
+
+    if(ASSERT((nesla_table_get_count(&g_test.table) == (TEST_COUNT_MAX / 2))
+            && !nesla_table_remove(&g_test.table, g_test.name[0], nesla_table_hash(g_test.name[0], strlen(g_test.name[0])), 0))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    for(size_t index = 0; index < TEST_COUNT_MAX; ++index) {
+        const char *name = g_test.name[index];
+
+        entry = nesla_table_find(&g_test.table, name, nesla_table_hash(name, strlen(name)), 0);
+
+        if(ASSERT((index % 2) ? ((entry != NULL) && (entry->value == index)) : (entry == NULL))) {
+            result = NESLA_FAILURE;
+            goto exit;
+        }
+    }
+
+exit:
+    nesla_table_free(&g_test.table, NULL);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+int main(void)
+{
+    static const test TEST[] = {
+        nesla_test_table_find,
+        nesla_test_table_free,
+        nesla_test_table_get_count,
+        nesla_test_table_hash,
+        nesla_test_table_insert,
+        nesla_test_table_remove,
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(int index = 0; index < TEST_COUNT(TEST); ++index) {
+
+        if(TEST[index]() == NESLA_FAILURE) {
+            result = NESLA_FAILURE;
+        }
+    }
+
+    return (int)result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,159 @@
+/*
+ * NESLA
+ * Copyright (C) 2022 David Jolly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ * @file main.c
+ * @brief Handler cycle budget tests.
+ */
+
+#include <timing.h>
+#include <test.h>
+#include <assemble.h>
+
+#define TEST_VECTORS_HANDLER ".ORG $FFFA\n.WORD nmi\n.WORD reset\n.WORD reset\n" /*!< Vectors, with the NMI vector at nmi */
+
+static nesla_test_assembly_t g_test = {};   /*!< Test assembly context */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Test handler cycle budgets, of the NMI handler and of a labelled handler, through the subroutines called.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_timing_budget(void)
+{
+    static const char *SOURCE = ".PRG 1\n.BUDGET %u\n.BUDGET 12, reset\n.BANK 0\n.ORG $C000\nreset:\nRTS\nnmi:\nLDX #4\nloop:\nDEX\n"
+        ".LOOP 3\nBNE loop\nJSR sub\nRTI\nsub:\nLDA $2002\nRTS\n" TEST_VECTORS_HANDLER;
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble_format(&g_test, 0, SOURCE, 43) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Cycle budget: NMI handler takes up to 43 of 43 cycles") == 1)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Cycle budget: reset takes up to 6 of 12 cycles") == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble_format(&g_test, 0, SOURCE, 42) == NESLA_FAILURE)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR,
+                "Cycle budget exceeded: NMI handler takes up to 43 of 42 cycles") == 1)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Longest path through NMI handler ends here") == 1)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Cycle budget: reset takes up to 6 of 12 cycles") == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test handler cycle budget loops, bounded with .LOOP, with taken branches paying to cross a page.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_timing_loop(void)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, ".PRG 1\n.BUDGET 38\n.BANK 0\n.ORG $C0FC\nnmi:\nreset:\nLDX #4\nloop:\nDEX\nNOP\n.LOOP 3\n"
+                "BNE loop\nRTI\n" TEST_VECTORS_HANDLER, 0) == NESLA_SUCCESS)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_NOTE, "Cycle budget: NMI handler takes up to 38 of 38 cycles") == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble(&g_test, ".PRG 1\n.BUDGET 38\n.BANK 0\n.ORG $C0FC\nnmi:\nreset:\nLDX #4\nloop:\nDEX\nNOP\n"
+                "BNE loop\nRTI\n" TEST_VECTORS_HANDLER, 0) == NESLA_FAILURE)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, "Loop without a bound (.LOOP)") == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+/*!
+ * @brief Test handler cycle budgets that can not be measured, through recursion, indirect jumps or an undefined label.
+ * @return NESLA_FAILURE on failure, NESLA_SUCCESS otherwise
+ */
+static nesla_error_e nesla_test_timing_unmeasured(void)
+{
+    nesla_error_e result = NESLA_SUCCESS;
+
+    if(ASSERT((nesla_test_assemble(&g_test, ".PRG 1\n.BUDGET 100\n.BANK 0\n.ORG $C000\nnmi:\nreset:\nJSR sub\nRTI\nsub:\nJSR sub\nRTS\n"
+                TEST_VECTORS_HANDLER, 0) == NESLA_FAILURE)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, "Recursive call: $C004") == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble(&g_test, ".PRG 1\n.BUDGET 100\n.BANK 0\n.ORG $C000\nnmi:\nreset:\nJMP ($0200)\n" TEST_VECTORS_HANDLER, 0)
+                == NESLA_FAILURE)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, "Indirect jump target is unknown: ($0200)") == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+    if(ASSERT((nesla_test_assemble(&g_test, ".PRG 1\n.BUDGET 100, handler\n.BANK 0\n.ORG $C000\nnmi:\nreset:\nRTI\n"
+                TEST_VECTORS_HANDLER, 0) == NESLA_FAILURE)
+            && (nesla_test_diagnostic(&g_test, NESLA_DIAGNOSTIC_ERROR, "Undefined label: handler") == 1))) {
+        result = NESLA_FAILURE;
+        goto exit;
+    }
+
+exit:
+    nesla_test_release(&g_test);
+    TEST_RESULT(result);
+
+    return result;
+}
+
+int main(void)
+{
+    static const test TEST[] = {
+        nesla_test_timing_budget,
+        nesla_test_timing_loop,
+        nesla_test_timing_unmeasured,
+        };
+
+    nesla_error_e result = NESLA_SUCCESS;
+
+    for(int index = 0; index < TEST_COUNT(TEST); ++index) {
+
+        if(TEST[index]() == NESLA_FAILURE) {
+            result = NESLA_FAILURE;
+        }
+    }
+
+    return (int)result;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */